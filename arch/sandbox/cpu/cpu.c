@@ -7,6 +7,7 @@
 #include <errno.h>
 #include <libfdt.h>
 #include <os.h>
+#include <workq.h>
 #include <asm/io.h>
 #include <asm/state.h>
 #include <dm/root.h>
@@ -45,6 +46,21 @@ void __udelay(unsigned long usec)
 		os_usleep(usec);
 }
 
+#if CONFIG_IS_ENABLED(WORKQ)
+static void sandbox_workq_job(void *arg, int index)
+{
+	struct workq_job *job = (struct workq_job *)arg + index;
+
+	job->ret = job->func(job->arg);
+}
+
+/* Each host thread stands in for a CPU */
+void arch_workq_run(struct workq_job *jobs, int count, int cpus)
+{
+	os_run_parallel(sandbox_workq_job, jobs, count, cpus);
+}
+#endif
+
 int cleanup_before_linux(void)
 {
 	return 0;
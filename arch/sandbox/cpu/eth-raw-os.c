@@ -52,9 +52,13 @@ static int _raw_packet_start(const char *ifname, unsigned char *ethmac,
 		       strerror(errno));
 		return -errno;
 	}
-	/* Bind to the specified interface */
-	ret = setsockopt(priv->sd, SOL_SOCKET, SO_BINDTODEVICE, ifname,
-		   strlen(ifname) + 1);
+	/*
+	 * Bind to the specified interface. SO_BINDTODEVICE does not do this
+	 * for packet sockets, which then see the traffic of every interface.
+	 */
+	device->sll_protocol = htons(ETH_P_ALL);
+	ret = bind(priv->sd, (struct sockaddr *)device,
+		   sizeof(struct sockaddr_ll));
 	if (ret < 0) {
 		printf("Failed to bind to '%s': %d %s\n", ifname, errno,
 		       strerror(errno));
@@ -157,7 +161,7 @@ int sandbox_eth_raw_os_send(void *packet, int length,
 	int retval;
 	struct udphdr *udph = packet + sizeof(struct iphdr);
 
-	if (!priv->sd || !priv->device)
+	if (priv->sd < 0 || !priv->device)
 		return -EINVAL;
 
 	/*
@@ -219,15 +223,19 @@ int sandbox_eth_raw_os_send(void *packet, int length,
 int sandbox_eth_raw_os_recv(void *packet, int *length,
 			    const struct eth_sandbox_raw_priv *priv)
 {
+	struct sockaddr_ll saddr;
+	socklen_t saddr_size;
 	int retval;
-	int saddr_size;
 
-	if (!priv->sd || !priv->device)
+	if (priv->sd < 0 || !priv->device)
 		return -EINVAL;
-	saddr_size = sizeof(struct sockaddr);
-	retval = recvfrom(priv->sd, packet, 1536, 0,
-			  (struct sockaddr *)priv->device,
-			  (socklen_t *)&saddr_size);
+	do {
+		saddr_size = sizeof(saddr);
+		retval = recvfrom(priv->sd, packet, 1536, 0,
+				  (struct sockaddr *)&saddr, &saddr_size);
+		/* A packet socket also sees what we send, skip that */
+	} while (retval >= 0 && !priv->local &&
+		 saddr.sll_pkttype == PACKET_OUTGOING);
 	*length = 0;
 	if (retval >= 0) {
 		*length = retval;
@@ -239,8 +247,36 @@ int sandbox_eth_raw_os_recv(void *packet, int *length,
 	return -errno;
 }
 
+int sandbox_eth_raw_os_mcast(const unsigned char *enetaddr, int join,
+			     struct eth_sandbox_raw_priv *priv)
+{
+	struct sockaddr_ll *device = priv->device;
+	struct packet_mreq mr;
+	int ret;
+
+	if (priv->sd < 0 || !device)
+		return -EINVAL;
+	memset(&mr, 0, sizeof(mr));
+	mr.mr_ifindex = device->sll_ifindex;
+	mr.mr_type = PACKET_MR_MULTICAST;
+	mr.mr_alen = 6;
+	memcpy(mr.mr_address, enetaddr, 6);
+	ret = setsockopt(priv->sd, SOL_PACKET,
+			 join ? PACKET_ADD_MEMBERSHIP : PACKET_DROP_MEMBERSHIP,
+			 &mr, sizeof(mr));
+	if (ret < 0) {
+		printf("Failed to %s multicast group: %d %s\n",
+		       join ? "join" : "leave", errno, strerror(errno));
+		return -errno;
+	}
+	return 0;
+}
+
 void sandbox_eth_raw_os_stop(struct eth_sandbox_raw_priv *priv)
 {
+	/* Not started: the socket is not open, don't close stdin */
+	if (!priv->device)
+		return;
 	free(priv->device);
 	priv->device = NULL;
 	close(priv->sd);
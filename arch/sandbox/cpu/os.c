@@ -3,10 +3,12 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 
+#include <aio.h>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -50,6 +52,90 @@ ssize_t os_write(int fd, const void *buf, size_t count)
 	return write(fd, buf, count);
 }
 
+int os_aio_start(int fd, bool write, off_t offset, void *buf, size_t count,
+		 void **handlep)
+{
+	struct aiocb *cb;
+	int ret;
+
+	cb = os_malloc(sizeof(*cb));
+	if (!cb)
+		return -ENOMEM;
+	memset(cb, '\0', sizeof(*cb));
+	cb->aio_fildes = fd;
+	cb->aio_offset = offset;
+	cb->aio_buf = buf;
+	cb->aio_nbytes = count;
+	cb->aio_sigevent.sigev_notify = SIGEV_NONE;
+	ret = write ? aio_write(cb) : aio_read(cb);
+	if (ret) {
+		ret = -errno;
+		os_free(cb);
+		return ret;
+	}
+	*handlep = cb;
+
+	return 0;
+}
+
+ssize_t os_aio_finish(void *handle, bool wait)
+{
+	struct aiocb *cb = handle;
+	const struct aiocb *list[] = { cb };
+	ssize_t ret;
+	int err;
+
+	while ((err = aio_error(cb)) == EINPROGRESS) {
+		if (!wait)
+			return -EINPROGRESS;
+		aio_suspend(list, 1, NULL);
+	}
+	ret = aio_return(cb);
+	if (err)
+		ret = -err;
+	os_free(cb);
+
+	return ret;
+}
+
+struct os_parallel {
+	void (*func)(void *arg, int index);
+	void *arg;
+	int count;
+	int next;		/* Next index to hand out */
+};
+
+static void *os_parallel_worker(void *data)
+{
+	struct os_parallel *par = data;
+	int index;
+
+	while ((index = __atomic_fetch_add(&par->next, 1,
+					   __ATOMIC_RELAXED)) < par->count)
+		par->func(par->arg, index);
+
+	return NULL;
+}
+
+void os_run_parallel(void (*func)(void *arg, int index), void *arg,
+		     int count, int threads)
+{
+	struct os_parallel par = { func, arg, count, 0 };
+	pthread_t tid[threads];
+	int started, i;
+
+	/* Our own thread is one of the workers */
+	for (started = 0; started < threads - 1 && started < count - 1;
+	     started++) {
+		if (pthread_create(&tid[started], NULL, os_parallel_worker,
+				   &par))
+			break;
+	}
+	os_parallel_worker(&par);
+	for (i = 0; i < started; i++)
+		pthread_join(tid[i], NULL);
+}
+
 off_t os_lseek(int fd, off_t offset, int whence)
 {
 	if (whence == OS_SEEK_SET)
@@ -139,34 +225,41 @@ void os_tty_raw(int fd, bool allow_sigs)
 	atexit(os_fd_restore);
 }
 
+/*
+ * The header takes a whole page, so that blocks (in particular the emulated
+ * RAM) are page-aligned, as DMA buffers on a real board would be
+ */
 void *os_malloc(size_t length)
 {
+	int page_size = getpagesize();
 	struct os_mem_hdr *hdr;
 
-	hdr = mmap(NULL, length + sizeof(*hdr), PROT_READ | PROT_WRITE,
+	hdr = mmap(NULL, length + page_size, PROT_READ | PROT_WRITE,
 		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 	if (hdr == MAP_FAILED)
 		return NULL;
 	hdr->length = length;
 
-	return hdr + 1;
+	return (char *)hdr + page_size;
 }
 
 void os_free(void *ptr)
 {
-	struct os_mem_hdr *hdr = ptr;
+	int page_size = getpagesize();
+	struct os_mem_hdr *hdr;
 
-	hdr--;
-	if (ptr)
-		munmap(hdr, hdr->length + sizeof(*hdr));
+	if (ptr) {
+		hdr = (struct os_mem_hdr *)((char *)ptr - page_size);
+		munmap(hdr, hdr->length + page_size);
+	}
 }
 
 void *os_realloc(void *ptr, size_t length)
 {
-	struct os_mem_hdr *hdr = ptr;
+	struct os_mem_hdr *hdr;
 	void *buf = NULL;
 
-	hdr--;
+	hdr = (struct os_mem_hdr *)((char *)ptr - getpagesize());
 	if (length != 0) {
 		buf = os_malloc(length);
 		if (!buf)
@@ -0,0 +1,130 @@
+/*
+ * SHA-256 using the x86 SHA extensions of the host CPU
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <u-boot/sha256.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+
+static const uint32_t sha256_k[64] __attribute__((aligned(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static int have_sha_ni = -1;
+
+static int sha_ni_supported(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+	    !(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+		return 0;
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return 0;
+
+	return !!(ebx & bit_SHA);
+}
+
+/*
+ * Four rounds using message words 4 * i to 4 * i + 3. From round 16 on,
+ * these are first calculated from the previous sixteen words.
+ */
+#define SHA256_NI_ROUNDS(i) do {					\
+	if (i >= 4) {							\
+		tmp = _mm_sha256msg1_epu32(msg[i & 3], msg[(i + 1) & 3]); \
+		tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(msg[(i + 3) & 3], \
+							 msg[(i + 2) & 3], 4)); \
+		msg[i & 3] = _mm_sha256msg2_epu32(tmp, msg[(i + 3) & 3]); \
+	}								\
+	tmp = _mm_add_epi32(msg[i & 3],					\
+			    _mm_load_si128((__m128i *)&sha256_k[i * 4])); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, tmp);		\
+	tmp = _mm_shuffle_epi32(tmp, 0x0e);				\
+	state0 = _mm_sha256rnds2_epu32(state0, state1, tmp);		\
+} while (0)
+
+__attribute__((target("sha,ssse3,sse4.1")))
+static void sha256_ni_blocks(uint32_t state[8], const uint8_t *data,
+			     unsigned int blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+					    0x0405060700010203ULL);
+	__m128i state0, state1, abef, cdgh, msg[4], tmp;
+	int i;
+
+	/* The instructions want the state as ABEF and CDGH */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)&state[0]), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *)&state[4]),
+				   0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+	for (; blocks; blocks--, data += 64) {
+		abef = state0;
+		cdgh = state1;
+
+		for (i = 0; i < 4; i++)
+			msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(
+					(__m128i *)(data + i * 16)), mask);
+		SHA256_NI_ROUNDS(0);
+		SHA256_NI_ROUNDS(1);
+		SHA256_NI_ROUNDS(2);
+		SHA256_NI_ROUNDS(3);
+		SHA256_NI_ROUNDS(4);
+		SHA256_NI_ROUNDS(5);
+		SHA256_NI_ROUNDS(6);
+		SHA256_NI_ROUNDS(7);
+		SHA256_NI_ROUNDS(8);
+		SHA256_NI_ROUNDS(9);
+		SHA256_NI_ROUNDS(10);
+		SHA256_NI_ROUNDS(11);
+		SHA256_NI_ROUNDS(12);
+		SHA256_NI_ROUNDS(13);
+		SHA256_NI_ROUNDS(14);
+		SHA256_NI_ROUNDS(15);
+
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+	_mm_storeu_si128((__m128i *)&state[0], state0);
+	_mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+int sha256_arch_process(uint32_t state[8], const uint8_t *data,
+			unsigned int blocks)
+{
+	if (have_sha_ni < 0)
+		have_sha_ni = sha_ni_supported();
+	if (!have_sha_ni)
+		return -ENOSYS;
+	sha256_ni_blocks(state, data, blocks);
+
+	return 0;
+}
+#endif
@@ -36,5 +36,7 @@ int sandbox_eth_raw_os_send(void *packet, int length,
 int sandbox_eth_raw_os_recv(void *packet, int *length,
 			    const struct eth_sandbox_raw_priv *priv);
 void sandbox_eth_raw_os_stop(struct eth_sandbox_raw_priv *priv);
+int sandbox_eth_raw_os_mcast(const unsigned char *enetaddr, int join,
+			     struct eth_sandbox_raw_priv *priv);
 
 #endif /* __ETH_RAW_OS_H */
@@ -12,6 +12,25 @@
 
 void sandbox_eth_disable_response(int index, bool disable);
 
+/**
+ * sandbox_eth_tx_hand_f - Look at a packet sent by a sandbox device
+ *
+ * The handler can answer with sandbox_eth_recv_packet().
+ *
+ * @dev:	The Ethernet device
+ * @packet:	The packet, starting with the Ethernet header
+ * @length:	The length of the packet
+ * @return true if the packet was handled, false to give the usual mock
+ * responses to it
+ */
+typedef bool sandbox_eth_tx_hand_f(struct udevice *dev, void *packet,
+				   int length);
+
+void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler);
+
 void sandbox_eth_skip_timeout(void);
 
+int sandbox_eth_recv_packet(struct udevice *dev, const void *packet,
+			    int length);
+
 #endif /* __ETH_H */
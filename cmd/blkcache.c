@@ -14,30 +14,39 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
 	struct block_cache_stats stats;
+	unsigned lookups;
+
 	blkcache_stats(&stats);
+	lookups = stats.hits + stats.misses;
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
-	       "entries: %u\n"
+	       "hit rate: %u%%\n"
+	       "evictions: %u\n"
+	       "cached blocks: %u\n"
+	       "cached bytes: %lu\n"
 	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "max cache bytes: %lu\n",
+	       stats.hits, stats.misses,
+	       lookups ? stats.hits * 100 / lookups : 0,
+	       stats.evictions, stats.entries, stats.size,
+	       stats.max_blocks_per_entry, stats.max_size);
 	return 0;
 }
 
 static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
+	unsigned blocks_per_entry;
+	unsigned long max_size;
 	if (argc != 3)
 		return CMD_RET_USAGE;
 
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
-	max_entries = simple_strtoul(argv[2], 0, 0);
-	blkcache_configure(blocks_per_entry, max_entries);
-	printf("changed to max of %u entries of %u blocks each\n",
-	       max_entries, blocks_per_entry);
+	max_size = simple_strtoul(argv[2], 0, 0);
+	blkcache_configure(blocks_per_entry, max_size);
+	printf("cache size %lu bytes, reads of up to %u blocks cached\n",
+	       max_size, blocks_per_entry);
 	return 0;
 }
 
@@ -83,5 +92,6 @@ U_BOOT_CMD(
 	blkcache, 4, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure blocks entries\n"
+	"blkcache configure blocks size - cache reads of up to 'blocks' blocks\n"
+	"    in at most 'size' bytes (0 disables the cache)\n"
 );
@@ -9,6 +9,9 @@
 #include <common.h>
 #include <command.h>
 #include <fs.h>
+#include <image.h>
+#include <malloc.h>
+#include <mapmem.h>
 #include <efi_loader.h>
 
 static int do_size_wrapper(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
@@ -89,3 +92,87 @@ U_BOOT_CMD(
 	"fstype <interface> <dev>:<part> <varname>\n"
 	"- set environment variable to filesystem type\n"
 );
+
+#ifdef CONFIG_FIT_STREAM
+struct fitload_priv {
+	char *ifname;
+	char *dev_part;
+	char *filename;
+};
+
+static int fitload_read(struct fit_stream *stream, ulong offset, ulong size,
+			void *buf)
+{
+	struct fitload_priv *priv = stream->priv;
+	loff_t actread;
+
+	if (fs_set_blk_dev(priv->ifname, priv->dev_part, FS_TYPE_ANY) ||
+	    fs_read(priv->filename, map_to_sysmem(buf), offset, size,
+		    &actread) < 0)
+		return -EIO;
+
+	return actread == size ? 0 : -EIO;
+}
+
+static int do_fitload(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	static struct fitload_priv priv;
+	static struct fit_stream stream;
+	loff_t size, actread;
+	void *fit;
+	ulong addr;
+	char *ep;
+
+	if (argc != 5)
+		return CMD_RET_USAGE;
+	addr = simple_strtoul(argv[3], &ep, 16);
+	if (ep == argv[3] || *ep != '\0')
+		return CMD_RET_USAGE;
+
+	fit_stream_set(NULL);
+	free(priv.ifname);
+	free(priv.dev_part);
+	free(priv.filename);
+	priv.ifname = strdup(argv[1]);
+	priv.dev_part = strdup(argv[2]);
+	priv.filename = strdup(argv[4]);
+	if (!priv.ifname || !priv.dev_part || !priv.filename)
+		return CMD_RET_FAILURE;
+
+	if (fs_set_blk_dev(argv[1], argv[2], FS_TYPE_ANY) ||
+	    fs_size(argv[4], &size))
+		return CMD_RET_FAILURE;
+
+	/* Read the FIT structure only; image data is read when it is used */
+	stream.addr = addr;
+	stream.read = fitload_read;
+	stream.priv = &priv;
+	fit = map_sysmem(addr, 0);
+	if (fitload_read(&stream, 0, sizeof(struct fdt_header), fit) ||
+	    fdt_magic(fit) != FDT_MAGIC || fdt_totalsize(fit) > size ||
+	    fitload_read(&stream, 0, fdt_totalsize(fit), fit) ||
+	    fit_stream_set(&stream)) {
+		printf("** %s is not a FIT image **\n", argv[4]);
+		return CMD_RET_FAILURE;
+	}
+	actread = fdt_totalsize(fit);
+	printf("%llu of %llu bytes read\n", actread, size);
+
+	setenv_hex("fileaddr", addr);
+	setenv_hex("filesize", size);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	fitload,	5,	0,	do_fitload,
+	"load a FIT image, reading its images when they are used",
+	"<interface> <dev[:part]> <addr> <filename>\n"
+	"    - Load the structure of FIT image 'filename' from partition\n"
+	"      'part' on device type 'interface' instance 'dev' to address\n"
+	"      'addr' in memory. The data of images stored outside the\n"
+	"      structure (mkimage -E) is read and verified when bootm or\n"
+	"      other commands load them from this address."
+);
+#endif
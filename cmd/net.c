@@ -10,7 +10,9 @@
  */
 #include <common.h>
 #include <command.h>
+#include <dm.h>
 #include <net.h>
+#include <net/wget.h>
 
 static int netboot_common(enum proto_t, cmd_tbl_t *, int, char * const []);
 
@@ -110,6 +112,41 @@ U_BOOT_CMD(
 );
 #endif
 
+#if defined(CONFIG_CMD_WGET)
+static int do_wget(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int size;
+
+	if (argc < 2 || strcmp(argv[1], "-f")) {
+		if (argc > 3)
+			return CMD_RET_USAGE;
+		return netboot_common(WGET, cmdtp, argc, argv);
+	}
+
+	/* -f interface dev[:part] filename [[hostIPaddr:]path] */
+	if (argc < 5)
+		return CMD_RET_USAGE;
+	load_addr = getenv_hex("loadaddr", load_addr);
+	if (argc == 6)
+		copy_filename(net_boot_file_name, argv[5],
+			      sizeof(net_boot_file_name));
+	wget_set_file(argv[2], argv[3], argv[4]);
+	size = net_loop(WGET);
+	wget_set_file(NULL, NULL, NULL);
+
+	return size < 0 ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	wget,	6,	1,	do_wget,
+	"load a file via network using HTTP",
+	"[loadAddress] [[hostIPaddr:]path]\n"
+	"wget -f <interface> <dev[:part]> <filename> [[hostIPaddr:]path]\n"
+	"    - write the file to a filesystem as it arrives, using\n"
+	"      memory at $loadaddr as a buffer"
+);
+#endif
+
 static void netboot_update_env(void)
 {
 	char tmp[22];
@@ -442,3 +479,47 @@ U_BOOT_CMD(
 );
 
 #endif  /* CONFIG_CMD_LINK_LOCAL */
+
+#if defined(CONFIG_CMD_NET_STATS)
+static int do_net_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	struct eth_stats *stats;
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret;
+
+	ret = uclass_get(UCLASS_ETH, &uc);
+	if (ret)
+		return CMD_RET_FAILURE;
+
+	uclass_foreach_dev(dev, uc) {
+		if (!device_active(dev))
+			continue;
+		stats = eth_get_stats(dev);
+		printf("eth%d: %s\n", dev->seq, dev->name);
+		printf("  rx: %lu packets, %lu bytes, %lu dropped, %lu overruns\n",
+		       stats->rx_packets, stats->rx_bytes, stats->rx_dropped,
+		       stats->rx_overruns);
+		printf("  tx: %lu packets, %lu bytes\n", stats->tx_packets,
+		       stats->tx_bytes);
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_net(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	if (argc == 2 && !strcmp(argv[1], "stats"))
+		return do_net_stats(cmdtp, flag, argc, argv);
+
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	net,	2,	1,	do_net,
+	"network device information",
+	"stats - show the packet counters of each active Ethernet device"
+);
+
+#endif  /* CONFIG_CMD_NET_STATS */
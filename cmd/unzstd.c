@@ -0,0 +1,59 @@
+/*
+ * zstd uncompress command in U-Boot
+ *
+ * made from existing cmd/lzmadec.c file of U-Boot
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+
+static int do_unzstd(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	unsigned long src, dst;
+	size_t src_len, dst_len = ~0UL;
+	int ret;
+
+	/* By default the frame is the file loaded last */
+	src_len = getenv_hex("filesize", 0);
+	switch (argc) {
+	case 5:
+		src_len = simple_strtoul(argv[4], NULL, 16);
+		/* fall through */
+	case 4:
+		dst_len = simple_strtoul(argv[3], NULL, 16);
+		/* fall through */
+	case 3:
+		src = simple_strtoul(argv[1], NULL, 16);
+		dst = simple_strtoul(argv[2], NULL, 16);
+		break;
+	default:
+		return CMD_RET_USAGE;
+	}
+
+	if (!src_len) {
+		printf("zstd: source size unknown, set filesize or give srcsize\n");
+		return 1;
+	}
+
+	ret = zstd_decompress(map_sysmem(src, src_len), src_len,
+			      map_sysmem(dst, dst_len), &dst_len);
+	if (ret) {
+		printf("zstd: uncompress error %d\n", ret);
+		return 1;
+	}
+	printf("Uncompressed size: %lu = %#lX\n", (ulong)dst_len,
+	       (ulong)dst_len);
+	setenv_hex("filesize", dst_len);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	unzstd,    5,    1,    do_unzstd,
+	"zstd uncompress a memory region",
+	"srcaddr dstaddr [dstsize [srcsize]]\n"
+	"    - srcsize defaults to $filesize"
+);
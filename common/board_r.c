@@ -178,6 +178,10 @@ static int initr_reloc_global_data(void)
 	*/
 	gd->fdt_blob += gd->reloc_off;
 #endif
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+	/* The cache was allocated from the early malloc() pool */
+	gd->fdt_phandle_cache = NULL;
+#endif
 #ifdef CONFIG_EFI_LOADER
 	efi_runtime_relocate(gd->relocaddr, NULL);
 #endif
@@ -313,6 +317,10 @@ static int initr_dm(void)
 	gd->dm_root = NULL;
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
+#endif
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	/* The pre-reloc index was allocated from the early malloc() pool */
+	gd->dm_compat_index = NULL;
 #endif
 	ret = dm_init_and_scan(false);
 	if (ret)
@@ -355,6 +363,17 @@ static int initr_manual_reloc_cmdtable(void)
 }
 #endif
 
+#ifdef CONFIG_CMDLINE_INDEX
+static int initr_cmd_index(void)
+{
+	/* Without the index, commands are still found by a linear search */
+	if (cmd_index_init())
+		debug("%s: cannot allocate command index\n", __func__);
+
+	return 0;
+}
+#endif
+
 #if defined(CONFIG_MTD_NOR_FLASH)
 static int initr_flash(void)
 {
@@ -787,6 +806,9 @@ static init_fnc_t init_sequence_r[] = {
 #ifdef CONFIG_NEEDS_MANUAL_RELOC
 	initr_manual_reloc_cmdtable,
 #endif
+#ifdef CONFIG_CMDLINE_INDEX
+	initr_cmd_index,
+#endif
 #if defined(CONFIG_PPC) || defined(CONFIG_M68K) || defined(CONFIG_MIPS)
 	initr_trap,
 #endif
@@ -150,6 +150,18 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+void bootstage_accum_time(enum bootstage_id id, const char *name,
+			  uint32_t duration)
+{
+	struct bootstage_record *rec = &record[id];
+
+	/* A start time marks the record as accumulated in the report */
+	if (!rec->start_us)
+		rec->start_us = timer_get_boot_us();
+	rec->name = name;
+	rec->time_us += duration;
+}
+
 /**
  * Get a record name as a printable string
  *
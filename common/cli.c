@@ -135,8 +135,15 @@ int do_run(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			return 1;
 		}
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+		if (parse_string_cached(argv[i], arg, FLAG_PARSE_SEMICOLON |
+					FLAG_EXIT_FROM_LOOP |
+					FLAG_CONT_ON_NEWLINE) != 0)
+			return 1;
+#else
 		if (run_command(arg, flag | CMD_FLAG_ENV) != 0)
 			return 1;
+#endif
 	}
 	return 0;
 }
@@ -84,6 +84,7 @@
 #include <cli.h>
 #include <cli_hush.h>
 #include <command.h>        /* find_cmd */
+#include <environment.h>
 #ifndef CONFIG_SYS_PROMPT_HUSH_PS2
 #define CONFIG_SYS_PROMPT_HUSH_PS2	"> "
 #endif
@@ -1589,6 +1590,9 @@ static int run_pipe_real(struct pipe *pi)
 #endif
 		return rcode;
 	} else if (pi->num_progs == 1 && pi->progs[0].argv != NULL) {
+		/* the parsed command may be run again, so leave it unchanged */
+		int sp = child->sp;
+
 		for (i=0; is_assignment(child->argv[i]); i++) { /* nothing */ }
 		if (i!=0 && child->argv[i]==NULL) {
 			/* assignments, but no command: set the local environment */
@@ -1627,11 +1631,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1764,6 +1768,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *save_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1803,7 +1808,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					break;
 				}
 #endif
 				flag_restore = 0;
@@ -1832,6 +1838,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				save_pipe = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1903,7 +1910,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			break;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1923,6 +1931,14 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+	if (list) {
+		/* left a "for" loop early: put back its variable name */
+		while (*list)
+			free(*list++);
+		free(save_pipe->progs->argv[0]);
+		save_pipe->progs->argv[0] = save_name;
+		free(save_list);
+	}
 	return rcode;
 }
 
@@ -3284,6 +3300,230 @@ int parse_string_outer(const char *s, int flag)
 #endif
 }
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/*
+ * Parsed scripts from environment variables, most recently run first. An
+ * entry is dropped when its variable changes, through an environment
+ * callback. Its text is checked as well, since a variable can also lose
+ * its callback, e.g. when the whole environment is replaced.
+ */
+struct parse_cache {
+	char *name;		/* environment variable */
+	char *text;		/* its value when it was parsed */
+	struct pipe *list;	/* the parsed script */
+	int users;		/* number of runs in progress */
+	int stale;		/* free once no longer in use */
+	int hooked;		/* we set the callback of the variable */
+	struct parse_cache *next;
+};
+
+#define PARSE_CACHE_SIZE	32
+
+static struct parse_cache *parse_cache_head;
+static int parse_cache_count;
+
+static int on_hush_cache(const char *name, const char *value, enum env_op op,
+	int flags);
+
+static ENTRY *parse_cache_env(const char *name)
+{
+	ENTRY e, *ep;
+
+	e.key = name;
+	e.data = NULL;
+	hsearch_r(e, FIND, &ep, &env_htab, 0);
+
+	return ep;
+}
+
+static void parse_cache_free(struct parse_cache *pc)
+{
+	free_pipe_list(pc->list, 0);
+	free(pc->name);
+	free(pc->text);
+	free(pc);
+}
+
+/* unlink an entry, freeing it unless it is still running */
+static void parse_cache_drop(struct parse_cache **pcp)
+{
+	struct parse_cache *pc = *pcp;
+
+	*pcp = pc->next;
+	parse_cache_count--;
+	if (pc->hooked) {
+		ENTRY *ep = parse_cache_env(pc->name);
+
+		/* only remove the callback that parse_cache_add() set */
+		if (ep && ep->callback == on_hush_cache)
+			ep->callback = NULL;
+		pc->hooked = 0;
+	}
+	if (pc->users)
+		pc->stale = 1;
+	else
+		parse_cache_free(pc);
+}
+
+static int on_hush_cache(const char *name, const char *value, enum env_op op,
+	int flags)
+{
+	struct parse_cache **pcp;
+
+	for (pcp = &parse_cache_head; *pcp; pcp = &(*pcp)->next) {
+		if (!strcmp((*pcp)->name, name)) {
+			parse_cache_drop(pcp);
+			break;
+		}
+	}
+
+	return 0;
+}
+U_BOOT_ENV_CALLBACK(hush_cache, on_hush_cache);
+
+static struct parse_cache *parse_cache_find(const char *name, const char *s)
+{
+	struct parse_cache **pcp, *pc;
+
+	for (pcp = &parse_cache_head; *pcp; pcp = &(*pcp)->next) {
+		pc = *pcp;
+		if (strcmp(pc->name, name))
+			continue;
+		if (strcmp(pc->text, s)) {
+			parse_cache_drop(pcp);
+			return NULL;
+		}
+		/* move to the front */
+		*pcp = pc->next;
+		pc->next = parse_cache_head;
+		parse_cache_head = pc;
+		return pc;
+	}
+
+	return NULL;
+}
+
+/* parse a whole script, as parse_stream_outer() does, without running it */
+static struct pipe *parse_cache_parse(const char *s, int flag)
+{
+	struct p_context ctx;
+	o_string temp = NULL_O_STRING;
+	struct in_str input;
+	char *p;
+	int rcode;
+
+	p = xmalloc(strlen(s) + 2);
+	strcpy(p, s);
+	strcat(p, "\n");
+	setup_string_in_str(&input, p);
+	ctx.type = flag;
+	initialize_context(&ctx);
+	update_ifs_map();
+	if (!(flag & FLAG_PARSE_SEMICOLON) || (flag & FLAG_REPARSING))
+		mapset((uchar *)";$&|", 0);
+	input.promptmode = 1;
+	rcode = parse_stream(&temp, &ctx, &input, -1);
+	if (rcode != 1 && ctx.old_flag == 0) {
+		done_word(&temp, &ctx);
+		done_pipe(&ctx, PIPE_SEQ);
+	} else {
+		if (ctx.old_flag != 0)
+			free(ctx.stack);
+		free_pipe_list(ctx.list_head, 0);
+		ctx.list_head = NULL;
+	}
+	b_free(&temp);
+	free(p);
+
+	return ctx.list_head;
+}
+
+static struct parse_cache *parse_cache_add(const char *name, const char *s,
+					   int flag)
+{
+	struct parse_cache **pcp, **last = NULL;
+	struct parse_cache *pc;
+	ENTRY *ep;
+
+	/*
+	 * The callback is what tells us that the variable has changed, so
+	 * only cache variables which have no other callback. Ours is set
+	 * here and removed again when the entry is dropped.
+	 */
+	ep = parse_cache_env(name);
+	if (!ep || (ep->callback && ep->callback != on_hush_cache))
+		return NULL;
+
+	/* make room by dropping the least recently run entry not in use */
+	if (parse_cache_count >= PARSE_CACHE_SIZE) {
+		for (pcp = &parse_cache_head; *pcp; pcp = &(*pcp)->next) {
+			if (!(*pcp)->users)
+				last = pcp;
+		}
+		if (!last)
+			return NULL;
+		parse_cache_drop(last);
+	}
+
+	pc = xmalloc(sizeof(*pc));
+	pc->list = parse_cache_parse(s, flag);
+	if (!pc->list) {
+		free(pc);
+		return NULL;
+	}
+	pc->name = xstrdup(name);
+	pc->text = xstrdup(s);
+	pc->users = 0;
+	pc->stale = 0;
+	pc->hooked = !ep->callback;
+	pc->next = parse_cache_head;
+	parse_cache_head = pc;
+	parse_cache_count++;
+	ep->callback = on_hush_cache;
+
+	return pc;
+}
+
+int parse_string_cached(const char *name, const char *s, int flag)
+{
+	struct parse_cache *pc;
+	char *nocache_str;
+	int code;
+
+	if (!s)
+		return 1;
+	if (!*s)
+		return 0;
+
+	nocache_str = get_local_var("HUSH_NO_CACHE");
+	if (nocache_str != NULL && *nocache_str != '0' && *nocache_str != '\0')
+		return parse_string_outer(s, flag);
+	/* the parse depends on IFS, so only cache with the default one */
+	if (!(flag & FLAG_CONT_ON_NEWLINE) || getenv("IFS"))
+		return parse_string_outer(s, flag);
+
+	pc = parse_cache_find(name, s);
+	if (!pc)
+		pc = parse_cache_add(name, s, flag);
+	/* this also reports any syntax error */
+	if (!pc)
+		return parse_string_outer(s, flag);
+
+	pc->users++;
+	code = run_list_real(pc->list);
+	if (!--pc->users && pc->stale)
+		parse_cache_free(pc);
+
+	/* as parse_stream_outer() does after run_list() */
+	if (code == -2)
+		code = 0;
+	if (code == -1)
+		flag_repeat = 0;
+
+	return code != 0;
+}
+#endif /* CONFIG_HUSH_PARSE_CACHE */
+
 #ifndef __U_BOOT__
 static int parse_file_outer(FILE *f)
 #else
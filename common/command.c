@@ -12,8 +12,12 @@
 #include <common.h>
 #include <command.h>
 #include <console.h>
+#include <errno.h>
+#include <malloc.h>
 #include <linux/ctype.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /*
  * Use puts() instead of printf() to avoid printf buffer overflow
  * for long help messages
@@ -83,22 +87,28 @@ int _do_help(cmd_tbl_t *cmd_start, int cmd_items, cmd_tbl_t *cmdtp, int flag,
 }
 
 /* find command table entry for a command */
+/*
+ * Some commands allow length modifiers (like "cp.b");
+ * compare command name only until first dot.
+ */
+static int cmd_name_len(const char *cmd)
+{
+	const char *p = strchr(cmd, '.');
+
+	return p ? p - cmd : strlen(cmd);
+}
+
 cmd_tbl_t *find_cmd_tbl(const char *cmd, cmd_tbl_t *table, int table_len)
 {
 #ifdef CONFIG_CMDLINE
 	cmd_tbl_t *cmdtp;
 	cmd_tbl_t *cmdtp_temp = table;	/* Init value */
-	const char *p;
 	int len;
 	int n_found = 0;
 
 	if (!cmd)
 		return NULL;
-	/*
-	 * Some commands allow length modifiers (like "cp.b");
-	 * compare command name only until first dot.
-	 */
-	len = ((p = strchr(cmd, '.')) == NULL) ? strlen (cmd) : (p - cmd);
+	len = cmd_name_len(cmd);
 
 	for (cmdtp = table; cmdtp != table + table_len; cmdtp++) {
 		if (strncmp(cmd, cmdtp->name, len) == 0) {
@@ -117,10 +127,89 @@ cmd_tbl_t *find_cmd_tbl(const char *cmd, cmd_tbl_t *table, int table_len)
 	return NULL;	/* not found or ambiguous command */
 }
 
+#ifdef CONFIG_CMDLINE_INDEX
+/* Pointers to the linker-list commands, sorted by name */
+static cmd_tbl_t **cmd_index;
+static int cmd_index_count;
+
+static int cmd_index_cmp(const void *a, const void *b)
+{
+	cmd_tbl_t *cmd_a = *(cmd_tbl_t **)a;
+	cmd_tbl_t *cmd_b = *(cmd_tbl_t **)b;
+	int ret;
+
+	/* Keep duplicate names in table order, so the first one wins */
+	ret = strcmp(cmd_a->name, cmd_b->name);
+	if (!ret)
+		ret = cmd_a < cmd_b ? -1 : cmd_a > cmd_b;
+
+	return ret;
+}
+
+int cmd_index_init(void)
+{
+	cmd_tbl_t *start = ll_entry_start(cmd_tbl_t, cmd);
+	const int count = ll_entry_count(cmd_tbl_t, cmd);
+	cmd_tbl_t **index;
+	int i;
+
+	index = malloc(count * sizeof(*index));
+	if (!index)
+		return -ENOMEM;
+	for (i = 0; i < count; i++)
+		index[i] = start + i;
+	qsort(index, count, sizeof(*index), cmd_index_cmp);
+	free(cmd_index);
+	cmd_index = index;
+	cmd_index_count = count;
+
+	return 0;
+}
+
+/*
+ * Same result as find_cmd_tbl() on the command table, but by binary search.
+ * All the names starting with the command are next to each other in the
+ * index, and a full match comes first since it is the shortest.
+ */
+static cmd_tbl_t *find_cmd_index(const char *cmd)
+{
+	int len = cmd_name_len(cmd);
+	int low = 0, high = cmd_index_count;
+	cmd_tbl_t *cmdtp;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (strncmp(cmd_index[mid]->name, cmd, len) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if (low == cmd_index_count)
+		return NULL;
+	cmdtp = cmd_index[low];
+	if (strncmp(cmdtp->name, cmd, len))
+		return NULL;			/* not found */
+	if (len == strlen(cmdtp->name))
+		return cmdtp;			/* full match */
+	if (low + 1 < cmd_index_count &&
+	    !strncmp(cmd_index[low + 1]->name, cmd, len))
+		return NULL;			/* ambiguous command */
+
+	return cmdtp;				/* exactly one match */
+}
+#endif
+
 cmd_tbl_t *find_cmd(const char *cmd)
 {
 	cmd_tbl_t *start = ll_entry_start(cmd_tbl_t, cmd);
 	const int len = ll_entry_count(cmd_tbl_t, cmd);
+
+#ifdef CONFIG_CMDLINE_INDEX
+	/* The index is only built after relocation */
+	if (cmd && (gd->flags & GD_FLG_RELOC) && cmd_index)
+		return find_cmd_index(cmd);
+#endif
 	return find_cmd_tbl(cmd, start, len);
 }
 
@@ -439,8 +528,6 @@ int cmd_get_data_size(char* arg, int default_size)
 #endif
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
-DECLARE_GLOBAL_DATA_PTR;
-
 void fixup_cmdtable(cmd_tbl_t *cmdtp, int size)
 {
 	int	i;
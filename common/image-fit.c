@@ -17,6 +17,7 @@
 #include <linux/kconfig.h>
 #include <common.h>
 #include <errno.h>
+#include <hash.h>
 #include <mapmem.h>
 #include <asm/io.h>
 DECLARE_GLOBAL_DATA_PTR;
@@ -746,6 +747,33 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
 	return fit_image_get_address(fit, noffset, FIT_ENTRY_PROP, entry);
 }
 
+/**
+ * fit_get_full_size() - get the size of a FIT including its external data
+ *
+ * @fit: pointer to the FIT image header
+ * @return offset of the end of the last external image data, or the size of
+ * the FDT if that is larger
+ */
+static ulong fit_get_full_size(const void *fit)
+{
+	const void *data;
+	ulong end;
+	size_t size;
+	int images, noffset;
+
+	end = fit_get_size(fit);
+	images = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images < 0)
+		return end;
+	fdt_for_each_subnode(noffset, fit, images) {
+		if (!fit_image_get_data(fit, noffset, &data, &size) &&
+		    data - fit + size > end)
+			end = data - fit + size;
+	}
+
+	return end;
+}
+
 /**
  * fit_image_get_data - get data property and its size for a given component image node
  * @fit: pointer to the FIT format image header
@@ -755,7 +783,8 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
  *
  * fit_image_get_data() finds data property in a given component image node.
  * If the property is found its data start address and size are returned to
- * the caller.
+ * the caller. For external data, the address is where it would be if the
+ * whole FIT file were in memory.
  *
  * returns:
  *     0, on success
@@ -764,9 +793,24 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
 int fit_image_get_data(const void *fit, int noffset,
 		const void **data, size_t *size)
 {
-	int len;
+	int offset, len;
 
 	*data = fdt_getprop(fit, noffset, FIT_DATA_PROP, &len);
+	if (*data == NULL && !fit_image_get_data_size(fit, noffset, &len)) {
+		/* the data follows the FDT, as written by mkimage -E */
+		if (!fit_image_get_data_position(fit, noffset, &offset)) {
+			*data = fit + offset;
+		} else if (!fit_image_get_data_offset(fit, noffset, &offset)) {
+			*data = fit + ((fdt_totalsize(fit) + 3) & ~3) + offset;
+		} else {
+			fit_get_debug(fit, noffset, FIT_DATA_OFFSET_PROP,
+				      -FDT_ERR_NOTFOUND);
+			*size = 0;
+			return -1;
+		}
+		*size = len;
+		return 0;
+	}
 	if (*data == NULL) {
 		fit_get_debug(fit, noffset, FIT_DATA_PROP, len);
 		*size = 0;
@@ -801,6 +845,31 @@ int fit_image_get_data_offset(const void *fit, int noffset, int *data_offset)
 	return 0;
 }
 
+/**
+ * Get 'data-position' property from a given image node.
+ *
+ * @fit: pointer to the FIT image header
+ * @noffset: component image node offset
+ * @data_position: holds the data-position property
+ *
+ * returns:
+ *     0, on success
+ *     -ENOENT if the property could not be found
+ */
+int fit_image_get_data_position(const void *fit, int noffset,
+				int *data_position)
+{
+	const fdt32_t *val;
+
+	val = fdt_getprop(fit, noffset, FIT_DATA_POSITION_PROP, NULL);
+	if (!val)
+		return -ENOENT;
+
+	*data_position = fdt32_to_cpu(*val);
+
+	return 0;
+}
+
 /**
  * Get 'data-size' property from a given image node.
  *
@@ -1633,6 +1702,209 @@ static const char *fit_get_image_type_property(int type)
 	return "unknown";
 }
 
+#if !defined(USE_HOSTCC) && defined(CONFIG_FIT_STREAM)
+/* Read in chunks, hashing each one while it is still in the cache */
+#define FIT_STREAM_CHUNK	(1 << 20)
+#define FIT_STREAM_MAX_HASHES	4
+
+static struct fit_stream *fit_stream;
+
+int fit_stream_set(struct fit_stream *stream)
+{
+	const void *fit;
+
+	fit_stream = NULL;
+	if (!stream)
+		return 0;
+	fit = map_sysmem(stream->addr, 0);
+	if (fdt_check_header(fit))
+		return -EINVAL;
+	stream->hdr_size = fdt_totalsize(fit);
+	stream->hdr_crc = crc32(0, fit, stream->hdr_size);
+	fit_stream = stream;
+
+	return 0;
+}
+
+/**
+ * fit_image_get_stream() - check whether to read an image from the stream
+ *
+ * @fit:	FIT header in memory
+ * @addr:	Address of @fit
+ * @noffset:	Image node offset
+ * @offsetp:	Returns the offset of the image data in the FIT file
+ * @return stream to read the image from, or NULL if its data should be in
+ * memory already
+ */
+static struct fit_stream *fit_image_get_stream(const void *fit, ulong addr,
+					       int noffset, ulong *offsetp)
+{
+	const void *data;
+	size_t size;
+
+	if (!fit_stream || fit_stream->addr != addr ||
+	    fit_stream->hdr_size != fdt_totalsize(fit) ||
+	    fit_stream->hdr_crc != crc32(0, fit, fit_stream->hdr_size))
+		return NULL;
+	if (fdt_getprop(fit, noffset, FIT_DATA_PROP, NULL) ||
+	    fit_image_get_data(fit, noffset, &data, &size))
+		return NULL;
+	*offsetp = data - fit;
+
+	return fit_stream;
+}
+
+/**
+ * fit_image_stream_whole() - check if an image must be read before use
+ *
+ * Images are normally verified as they are read, which is possible when all
+ * their hashes have a progressive implementation. Signatures are checked
+ * over the whole image data, as is any board post-processing.
+ *
+ * @fit:	FIT header in memory
+ * @noffset:	Image node offset
+ * @verify:	true if the image is to be verified
+ * @return true if the image data must be read in full before it is used
+ */
+static bool fit_image_stream_whole(const void *fit, int noffset, bool verify)
+{
+	struct hash_algo *algo;
+	const char *name;
+	char *algo_name;
+	int count = 0;
+	int node;
+
+#ifdef CONFIG_FIT_IMAGE_POST_PROCESS
+	return true;
+#endif
+	if (!verify)
+		return false;
+	fdt_for_each_subnode(node, fit, noffset) {
+		name = fit_get_name(fit, node, NULL);
+		if (IMAGE_ENABLE_VERIFY &&
+		    !strncmp(name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME)))
+			return true;
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, node, &algo_name) ||
+		    hash_progressive_lookup_algo(algo_name, &algo) ||
+		    ++count > FIT_STREAM_MAX_HASHES)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * fit_image_stream() - read an image from the stream, hashing it as it goes
+ *
+ * @fit:	FIT header in memory
+ * @noffset:	Image node offset
+ * @stream:	Stream to read from
+ * @offset:	Offset of the image data in the FIT file
+ * @size:	Size of the image data
+ * @dst:	Where to put the data
+ * @verify:	true to check the image's hashes
+ * @return 0 if OK, -EACCES if a hash did not match, other -ve on error
+ */
+static int fit_image_stream(const void *fit, int noffset,
+			    struct fit_stream *stream, ulong offset, ulong size,
+			    void *dst, bool verify)
+{
+	struct {
+		struct hash_algo *algo;
+		void *ctx;
+		int noffset;
+	} hash[FIT_STREAM_MAX_HASHES];
+	uint8_t value[FIT_MAX_HASH_LEN];
+	uint8_t *fit_value;
+	int fit_value_len;
+	int count = 0, ret = 0, i;
+	char *algo_name;
+	ulong pos, chunk;
+	int node, ignore;
+
+	if (verify) {
+		fdt_for_each_subnode(node, fit, noffset) {
+			if (strncmp(fit_get_name(fit, node, NULL),
+				    FIT_HASH_NODENAME,
+				    strlen(FIT_HASH_NODENAME)))
+				continue;
+			if (IMAGE_ENABLE_IGNORE) {
+				fit_image_hash_get_ignore(fit, node, &ignore);
+				if (ignore)
+					continue;
+			}
+			fit_image_hash_get_algo(fit, node, &algo_name);
+			hash_progressive_lookup_algo(algo_name,
+						     &hash[count].algo);
+			if (hash[count].algo->hash_init(hash[count].algo,
+							&hash[count].ctx)) {
+				printf("Can't start %s hash\n",
+				       hash[count].algo->name);
+				ret = -ENOMEM;
+				break;
+			}
+			hash[count++].noffset = node;
+		}
+	}
+
+	for (pos = 0; !ret && pos < size; pos += chunk) {
+		chunk = min(size - pos, (ulong)FIT_STREAM_CHUNK);
+		ret = stream->read(stream, offset + pos, chunk, dst + pos);
+		if (ret)
+			break;
+		for (i = 0; i < count; i++) {
+			hash[i].algo->hash_update(hash[i].algo, hash[i].ctx,
+						  dst + pos, chunk,
+						  pos + chunk == size);
+		}
+	}
+
+	/* Finish every hash, to free its context, even after an error */
+	for (i = 0; i < count; i++) {
+		hash[i].algo->hash_finish(hash[i].algo, hash[i].ctx, value,
+					  sizeof(value));
+		if (ret)
+			continue;
+		printf("%s", hash[i].algo->name);
+		if (fit_image_hash_get_value(fit, hash[i].noffset, &fit_value,
+					     &fit_value_len) ||
+		    fit_value_len != hash[i].algo->digest_size ||
+		    memcmp(value, fit_value, fit_value_len)) {
+			printf(" error!\nBad hash value for '%s' hash node in '%s' image node\n",
+			       fit_get_name(fit, hash[i].noffset, NULL),
+			       fit_get_name(fit, noffset, NULL));
+			ret = -EACCES;
+			continue;
+		}
+		puts("+ ");
+	}
+
+	return ret;
+}
+#else
+static inline struct fit_stream *fit_image_get_stream(const void *fit,
+						      ulong addr, int noffset,
+						      ulong *offsetp)
+{
+	return NULL;
+}
+
+static inline bool fit_image_stream_whole(const void *fit, int noffset,
+					  bool verify)
+{
+	return false;
+}
+
+static inline int fit_image_stream(const void *fit, int noffset,
+				   struct fit_stream *stream, ulong offset,
+				   ulong size, void *dst, bool verify)
+{
+	return -ENOSYS;
+}
+#endif
+
 int fit_image_load(bootm_headers_t *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, int image_type, int bootstage_id,
@@ -1651,6 +1923,10 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 	uint8_t os_arch;
 #endif
 	const char *prop_name;
+	struct fit_stream *stream;
+	ulong stream_offset = 0;
+	bool stream_verify;
+	bool loaded = false;
 	int ret;
 
 	fit = map_sysmem(addr, 0);
@@ -1719,7 +1995,26 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 
 	printf("   Trying '%s' %s subimage\n", fit_uname, prop_name);
 
-	ret = fit_image_select(fit, noffset, images->verify);
+	/*
+	 * If the FIT was loaded by fitload, external image data is read only
+	 * when it is needed, and verified as it is read. If the image has
+	 * to be checked as a whole, read it into place now.
+	 */
+	stream = fit_image_get_stream(fit, addr, noffset, &stream_offset);
+	stream_verify = images->verify;
+	if (stream && fit_image_stream_whole(fit, noffset, stream_verify)) {
+		if (fit_image_get_data(fit, noffset, &buf, &size) ||
+		    fit_image_stream(fit, noffset, stream, stream_offset, size,
+				     (void *)buf, false)) {
+			printf("Could not read %s subimage data!\n",
+			       prop_name);
+			bootstage_error(bootstage_id + BOOTSTAGE_SUB_GET_DATA);
+			return -EIO;
+		}
+		stream = NULL;
+	}
+
+	ret = fit_image_select(fit, noffset, images->verify && !stream);
 	if (ret) {
 		bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
 		return ret;
@@ -1789,7 +2084,7 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 	len = (ulong)size;
 
 	/* verify that image data is a proper FDT blob */
-	if (image_type == IH_TYPE_FLATDT && fdt_check_header(buf)) {
+	if (image_type == IH_TYPE_FLATDT && !stream && fdt_check_header(buf)) {
 		puts("Subimage data is not a FDT");
 		return -ENOEXEC;
 	}
@@ -1826,7 +2121,7 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 		 * make sure we don't overwrite initial image
 		 */
 		image_start = addr;
-		image_end = addr + fit_get_size(fit);
+		image_end = addr + fit_get_full_size(fit);
 
 		load_end = load + len;
 		if (image_type != IH_TYPE_KERNEL &&
@@ -1839,8 +2134,47 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 		       prop_name, data, load);
 
 		dst = map_sysmem(load, len);
-		memmove(dst, buf, len);
+		if (!stream)
+			memmove(dst, buf, len);
 		data = load;
+		loaded = true;
+	}
+
+	if (stream) {
+		/*
+		 * An uncompressed kernel can be read straight to its load
+		 * address, where bootm will find it without copying it again.
+		 * Anything else goes where it would be in the complete FIT.
+		 */
+		if (!loaded && image_type == IH_TYPE_KERNEL &&
+		    fit_image_check_comp(fit, noffset, IH_COMP_NONE) &&
+		    !fit_image_get_load(fit, noffset, &load) &&
+		    (load >= addr + fit_get_full_size(fit) ||
+		     load + len <= addr))
+			data = load;
+
+		if (stream_verify)
+			puts("   Verifying Hash Integrity while loading ... ");
+		ret = fit_image_stream(fit, noffset, stream, stream_offset,
+				       len, map_sysmem(data, len),
+				       stream_verify);
+		if (ret) {
+			if (ret == -EACCES)
+				puts("Bad Data Hash\n");
+			else
+				printf("Could not read %s subimage data!\n",
+				       prop_name);
+			bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
+			return ret;
+		}
+		if (stream_verify)
+			puts("OK\n");
+
+		if (image_type == IH_TYPE_FLATDT &&
+		    fdt_check_header(map_sysmem(data, len))) {
+			puts("Subimage data is not a FDT");
+			return -ENOEXEC;
+		}
 	}
 	bootstage_mark(bootstage_id + BOOTSTAGE_SUB_LOAD);
 
@@ -433,6 +433,92 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	return ops->erase(dev, start, blkcnt);
 }
 
+static void blk_req_finish(struct blk_req *req, long result)
+{
+	req->result = result;
+	req->done = true;
+	if (req->complete)
+		req->complete(req);
+}
+
+void blk_req_done(struct blk_req *req, long result)
+{
+	struct blk_desc *desc = req->desc;
+
+	/*
+	 * Drivers complete overlapping requests in the order submitted, so a
+	 * read cannot fill the cache with blocks a write in flight replaces
+	 */
+	if (req->op == BLK_REQ_READ && result == req->blkcnt)
+		blkcache_fill(desc->if_type, desc->devnum, req->start,
+			      req->blkcnt, desc->blksz, req->buffer);
+	blk_req_finish(req, result);
+}
+
+int blk_submit(struct blk_desc *desc, struct blk_req *req)
+{
+	struct udevice *dev = desc->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	long ret;
+
+	req->desc = desc;
+	req->done = false;
+	if (req->op == BLK_REQ_READ) {
+		if (blkcache_read(desc->if_type, desc->devnum, req->start,
+				  req->blkcnt, desc->blksz, req->buffer)) {
+			blk_req_finish(req, req->blkcnt);
+			return 0;
+		}
+	} else {
+		blkcache_invalidate(desc->if_type, desc->devnum);
+	}
+	if (ops->submit) {
+		ret = ops->submit(dev, req);
+		/* reads the driver waited for may have refilled the cache */
+		if (req->op == BLK_REQ_WRITE)
+			blkcache_invalidate(desc->if_type, desc->devnum);
+		return ret;
+	}
+
+	/* The driver cannot queue requests, so carry this one out now */
+	if (req->op == BLK_REQ_READ && ops->read)
+		ret = ops->read(dev, req->start, req->blkcnt, req->buffer);
+	else if (req->op == BLK_REQ_WRITE && ops->write)
+		ret = ops->write(dev, req->start, req->blkcnt, req->buffer);
+	else
+		ret = -ENOSYS;
+	blk_req_done(req, ret);
+
+	return 0;
+}
+
+int blk_poll(struct blk_desc *desc, bool wait)
+{
+	struct udevice *dev = desc->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+
+	if (!ops->poll)
+		return 0;
+
+	return ops->poll(dev, wait);
+}
+
+long blk_wait(struct blk_req *req)
+{
+	int ret;
+
+	while (!req->done) {
+		ret = blk_poll(req->desc, true);
+		if (ret < 0)
+			return ret;
+		/* nothing was in flight, so the request cannot complete */
+		if (!ret && !req->done)
+			return -EIO;
+	}
+
+	return req->result;
+}
+
 int blk_prepare_device(struct udevice *dev)
 {
 	struct blk_desc *desc = dev_get_uclass_platdata(dev);
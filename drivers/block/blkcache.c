@@ -12,157 +12,246 @@
 #include <linux/ctype.h>
 #include <linux/list.h>
 
+/*
+ * The cache holds individual blocks, looked up through a hash table keyed
+ * on (iftype, devnum, lba). All cached blocks are also kept on a circular
+ * list which is scanned by a CLOCK hand to pick eviction victims once the
+ * byte budget is used up: blocks that were hit since the hand last passed
+ * get a second chance, everything else is recycled.
+ */
 struct block_cache_node {
+	struct hlist_node hash;
 	struct list_head lh;
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
+	lbaint_t lba;
 	unsigned long blksz;
-	char *cache;
+	bool referenced;
+	char cache[0];
 };
 
+/* Hash table size limits, in buckets */
+#define BLKCACHE_MIN_HASH_BITS	4
+#define BLKCACHE_MAX_HASH_BITS	12
+
 static LIST_HEAD(block_cache);
+static struct list_head *clock_hand = &block_cache;
+static struct hlist_head *block_cache_hash;
+static unsigned int hash_bits;
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 2,
-	.max_entries = 32
+	.max_blocks_per_entry = CONFIG_BLOCK_CACHE_MAX_BLOCKS,
+	.max_size = CONFIG_BLOCK_CACHE_SIZE,
 };
 
+static unsigned int cache_hash(int iftype, int devnum, lbaint_t lba)
+{
+	u32 key;
+
+	key = (u32)lba ^ (u32)((u64)lba >> 32);
+	key ^= ((u32)iftype << 24) ^ ((u32)devnum << 16);
+
+	return (key * 0x9e370001U) >> (32 - hash_bits);
+}
+
+static int cache_init(void)
+{
+	unsigned long buckets;
+	unsigned int i;
+
+	if (block_cache_hash)
+		return 0;
+
+	/* aim for chains of about two 512-byte blocks when full */
+	buckets = max(_stats.max_size / 1024, 1UL);
+	hash_bits = fls(buckets - 1);
+	hash_bits = clamp(hash_bits, (unsigned int)BLKCACHE_MIN_HASH_BITS,
+			  (unsigned int)BLKCACHE_MAX_HASH_BITS);
+
+	block_cache_hash = malloc(sizeof(*block_cache_hash) << hash_bits);
+	if (!block_cache_hash)
+		return -ENOMEM;
+	for (i = 0; i < (1U << hash_bits); i++)
+		INIT_HLIST_HEAD(&block_cache_hash[i]);
+
+	return 0;
+}
+
 static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+					   lbaint_t lba, unsigned long blksz)
 {
 	struct block_cache_node *node;
+	struct hlist_node *pos;
+	struct hlist_head *head;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
+	head = &block_cache_hash[cache_hash(iftype, devnum, lba)];
+	hlist_for_each_entry(node, pos, head, hash)
+		if ((node->lba == lba) &&
 		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
+		    (node->iftype == iftype) &&
+		    (node->blksz == blksz))
 			return node;
-		}
-	return 0;
+
+	return NULL;
+}
+
+static void cache_unlink(struct block_cache_node *node)
+{
+	if (clock_hand == &node->lh)
+		clock_hand = node->lh.next;
+	list_del(&node->lh);
+	hlist_del(&node->hash);
+	_stats.entries--;
+	_stats.size -= node->blksz;
+}
+
+/* advance the CLOCK hand until it finds a block without a recent hit */
+static struct block_cache_node *cache_evict(void)
+{
+	struct block_cache_node *node;
+
+	for (;;) {
+		if (clock_hand == &block_cache)
+			clock_hand = clock_hand->next;
+		node = list_entry(clock_hand, struct block_cache_node, lh);
+		clock_hand = clock_hand->next;
+		if (!node->referenced)
+			break;
+		node->referenced = false;
+	}
+
+	debug("drop: lba " LBAF "\n", node->lba);
+	cache_unlink(node);
+	_stats.evictions++;
+
+	return node;
+}
+
+static struct block_cache_node *cache_alloc(unsigned long blksz)
+{
+	struct block_cache_node *node = NULL;
+
+	if (blksz > _stats.max_size)
+		return NULL;
+
+	while (_stats.size + blksz > _stats.max_size) {
+		free(node);
+		node = cache_evict();
+		if (node->blksz == blksz &&
+		    _stats.size + blksz <= _stats.max_size)
+			return node;
+	}
+	free(node);
+
+	return malloc(sizeof(*node) + blksz);
+}
+
+static void cache_flush(void)
+{
+	struct block_cache_node *node, *n;
+
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
+		cache_unlink(node);
+		free(node);
+	}
+	clock_hand = &block_cache;
 }
 
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	struct block_cache_node *node;
+	lbaint_t i;
+
+	/* reads this big are never filled, so don't count them as misses */
+	if (!block_cache_hash || blkcnt > _stats.max_blocks_per_entry)
+		return 0;
+
+	for (i = 0; i < blkcnt; i++) {
+		node = cache_find(iftype, devnum, start + i, blksz);
+		if (!node) {
+			debug("miss: start " LBAF ", count " LBAFU "\n",
+			      start, blkcnt);
+			++_stats.misses;
+			return 0;
+		}
+		node->referenced = true;
+		memcpy(buffer + i * blksz, node->cache, blksz);
 	}
 
-	debug("miss: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
-	++_stats.misses;
-	return 0;
+	debug("hit: start " LBAF ", count " LBAFU "\n", start, blkcnt);
+	++_stats.hits;
+	return 1;
 }
 
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
 	struct block_cache_node *node;
+	lbaint_t i;
 
 	/* don't cache big stuff */
 	if (blkcnt > _stats.max_blocks_per_entry)
 		return;
 
-	if (_stats.max_entries == 0)
+	if (_stats.max_size == 0 || cache_init())
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
-	}
+	debug("fill: start " LBAF ", count " LBAFU "\n", start, blkcnt);
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
+	for (i = 0; i < blkcnt; i++) {
+		node = cache_find(iftype, devnum, start + i, blksz);
+		if (!node) {
+			node = cache_alloc(blksz);
+			if (!node)
+				return;
+			node->iftype = iftype;
+			node->devnum = devnum;
+			node->lba = start + i;
+			node->blksz = blksz;
+			node->referenced = false;
+			hlist_add_head(&node->hash, &block_cache_hash[
+				       cache_hash(iftype, devnum, start + i)]);
+			/* new blocks are the last ones the hand will visit */
+			list_add_tail(&node->lh, clock_hand);
+			_stats.entries++;
+			_stats.size += blksz;
 		}
+		memcpy(node->cache, buffer + i * blksz, blksz);
 	}
-
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
-
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
 		if ((node->iftype == iftype) &&
 		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
+			cache_unlink(node);
 			free(node);
-			--_stats.entries;
 		}
 	}
 }
 
-void blkcache_configure(unsigned blocks, unsigned entries)
+void blkcache_configure(unsigned blocks, unsigned long size)
 {
-	struct block_cache_node *node;
 	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries)) {
-		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
-		_stats.entries = 0;
+	    (size != _stats.max_size)) {
+		/* invalidate cache, the hash table is resized on next fill */
+		cache_flush();
+		free(block_cache_hash);
+		block_cache_hash = NULL;
 	}
 
 	_stats.max_blocks_per_entry = blocks;
-	_stats.max_entries = entries;
+	_stats.max_size = size;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
@@ -170,4 +259,5 @@ void blkcache_stats(struct block_cache_stats *stats)
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
 }
@@ -30,6 +30,39 @@ static struct host_block_dev *find_host_device(int dev)
 #endif
 
 #ifdef CONFIG_BLK
+/* Smallest request passed to the host's AIO, see host_block_submit() */
+#define HOST_AIO_MIN_BYTES	(64 << 10)
+
+static int host_block_poll(struct udevice *dev, bool wait);
+
+/*
+ * The host gives no ordering between AIO requests, so before a transfer
+ * starts, wait for any request in flight which it overlaps, unless both
+ * are reads
+ */
+static int host_block_order(struct udevice *dev, enum blk_req_op op,
+			    lbaint_t start, lbaint_t blkcnt)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+	struct blk_req *req;
+	int ret;
+
+retry:
+	list_for_each_entry(req, &host_dev->reqs, node) {
+		if (op == BLK_REQ_READ && req->op == BLK_REQ_READ)
+			continue;
+		if (start < req->start + req->blkcnt &&
+		    req->start < start + blkcnt) {
+			ret = host_block_poll(dev, true);
+			if (ret < 0)
+				return ret;
+			goto retry;
+		}
+	}
+
+	return 0;
+}
+
 static unsigned long host_block_read(struct udevice *dev,
 				     unsigned long start, lbaint_t blkcnt,
 				     void *buffer)
@@ -37,6 +70,8 @@ static unsigned long host_block_read(struct udevice *dev,
 	struct host_block_dev *host_dev = dev_get_priv(dev);
 	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
 
+	if (host_block_order(dev, BLK_REQ_READ, start, blkcnt))
+		return -1;
 #else
 static unsigned long host_block_read(struct blk_desc *block_dev,
 				     unsigned long start, lbaint_t blkcnt,
@@ -67,6 +102,9 @@ static unsigned long host_block_write(struct udevice *dev,
 {
 	struct host_block_dev *host_dev = dev_get_priv(dev);
 	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+
+	if (host_block_order(dev, BLK_REQ_WRITE, start, blkcnt))
+		return -1;
 #else
 static unsigned long host_block_write(struct blk_desc *block_dev,
 				      unsigned long start, lbaint_t blkcnt,
@@ -88,6 +126,95 @@ static unsigned long host_block_write(struct blk_desc *block_dev,
 }
 
 #ifdef CONFIG_BLK
+static int host_block_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	int ret;
+
+	ret = host_block_order(dev, req->op, req->start, req->blkcnt);
+	if (ret)
+		return ret;
+
+	/*
+	 * Handing a request to a host AIO thread costs more than copying a
+	 * small one from the host's page cache, so do those at once. They
+	 * still complete from host_block_poll().
+	 */
+	if (req->blkcnt * block_dev->blksz < HOST_AIO_MIN_BYTES) {
+		if (req->op == BLK_REQ_WRITE)
+			req->result = host_block_write(dev, req->start,
+						       req->blkcnt,
+						       req->buffer);
+		else
+			req->result = host_block_read(dev, req->start,
+						      req->blkcnt,
+						      req->buffer);
+		if (req->result < 0)
+			req->result = -EIO;
+		req->drv_priv = NULL;
+	} else {
+		ret = os_aio_start(host_dev->fd, req->op == BLK_REQ_WRITE,
+				   req->start * block_dev->blksz, req->buffer,
+				   req->blkcnt * block_dev->blksz,
+				   &req->drv_priv);
+		if (ret)
+			return ret;
+	}
+	list_add_tail(&req->node, &host_dev->reqs);
+
+	return 0;
+}
+
+static int host_block_poll(struct udevice *dev, bool wait)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct blk_req *req, *next;
+	LIST_HEAD(done);
+	ssize_t len;
+	int count = 0;
+
+	list_for_each_entry_safe(req, next, &host_dev->reqs, node) {
+		/* If asked to wait, wait for the oldest request only */
+		if (req->drv_priv) {
+			len = os_aio_finish(req->drv_priv, wait && !count);
+			if (len == -EINPROGRESS)
+				continue;
+			req->result = len < 0 ? len : len / block_dev->blksz;
+		}
+		list_move_tail(&req->node, &done);
+		count++;
+	}
+
+	/* Completion functions may submit or wait for other requests */
+	list_for_each_entry_safe(req, next, &done, node) {
+		list_del(&req->node);
+		blk_req_done(req, req->result);
+	}
+
+	return count;
+}
+
+static int host_block_probe(struct udevice *dev)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+
+	INIT_LIST_HEAD(&host_dev->reqs);
+
+	return 0;
+}
+
+static int host_block_remove(struct udevice *dev)
+{
+	struct host_block_dev *host_dev = dev_get_priv(dev);
+
+	while (!list_empty(&host_dev->reqs))
+		host_block_poll(dev, true);
+
+	return 0;
+}
+
 int host_dev_bind(int devnum, char *filename)
 {
 	struct host_block_dev *host_dev;
@@ -221,12 +348,16 @@ int host_get_dev_err(int devnum, struct blk_desc **blk_devp)
 static const struct blk_ops sandbox_host_blk_ops = {
 	.read	= host_block_read,
 	.write	= host_block_write,
+	.submit	= host_block_submit,
+	.poll	= host_block_poll,
 };
 
 U_BOOT_DRIVER(sandbox_host_blk) = {
 	.name		= "sandbox_host_blk",
 	.id		= UCLASS_BLK,
 	.ops		= &sandbox_host_blk_ops,
+	.probe		= host_block_probe,
+	.remove		= host_block_remove,
 	.priv_auto_alloc_size	= sizeof(struct host_block_dev),
 };
 #else
@@ -72,7 +72,7 @@ int device_unbind(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
-	if (dev->flags & DM_FLAG_ACTIVATED)
+	if (dev->flags & (DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING))
 		return -EINVAL;
 
 	if (!(dev->flags & DM_FLAG_BOUND))
@@ -159,6 +159,12 @@ int device_remove(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	/* Let a pending probe finish, so the driver sees a normal remove */
+	if ((dev->flags & DM_FLAG_PROBE_PENDING) && device_probe(dev))
+		return 0;
+#endif
+
 	if (!(dev->flags & DM_FLAG_ACTIVATED))
 		return 0;
 
@@ -10,6 +10,8 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
+#include <watchdog.h>
 #include <asm/io.h>
 #include <fdtdec.h>
 #include <fdt_support.h>
@@ -264,7 +266,37 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+/* Undoes the work of a probe which failed */
+static void device_probe_undo(struct udevice *dev)
+{
+	dev->flags &= ~(DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING);
+
+	dev->seq = -1;
+	device_free(dev);
+}
+
+/* Completes a probe once the driver's probe() work has finished */
+static int device_probe_finish(struct udevice *dev)
+{
+	int ret;
+
+	ret = uclass_post_probe_device(dev);
+	if (ret) {
+		if (device_remove(dev)) {
+			dm_warn("%s: Device '%s' failed to remove on error path\n",
+				__func__, dev->name);
+		}
+		device_probe_undo(dev);
+		return ret;
+	}
+
+	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
+		pinctrl_select_state(dev, "default");
+
+	return 0;
+}
+
+int device_probe_start(struct udevice *dev)
 {
 	const struct driver *drv;
 	int size = 0;
@@ -274,7 +306,7 @@ int device_probe(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
-	if (dev->flags & DM_FLAG_ACTIVATED)
+	if (dev->flags & (DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING))
 		return 0;
 
 	drv = dev->driver;
@@ -323,7 +355,7 @@ int device_probe(struct udevice *dev)
 		 * (e.g. PCI bridge devices). Test the flags again
 		 * so that we don't mess up the device.
 		 */
-		if (dev->flags & DM_FLAG_ACTIVATED)
+		if (dev->flags & (DM_FLAG_ACTIVATED | DM_FLAG_PROBE_PENDING))
 			return 0;
 	}
 
@@ -369,28 +401,167 @@ int device_probe(struct udevice *dev)
 		}
 	}
 
-	ret = uclass_post_probe_device(dev);
-	if (ret)
-		goto fail_uclass;
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	if (drv->probe_complete) {
+		/* Not active until probe_complete() says the device is ready */
+		dev->flags &= ~DM_FLAG_ACTIVATED;
+		dev->flags |= DM_FLAG_PROBE_PENDING;
+		dev->probe_start = get_timer(0);
+		return 0;
+	}
+#endif
 
-	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
-		pinctrl_select_state(dev, "default");
+	return device_probe_finish(dev);
+fail:
+	device_probe_undo(dev);
 
-	return 0;
-fail_uclass:
-	if (device_remove(dev)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+int device_probe_poll(struct udevice *dev)
+{
+	int ret;
+
+	if (!(dev->flags & DM_FLAG_PROBE_PENDING))
+		return 0;
+
+	ret = dev->driver->probe_complete(dev);
+	if (ret == -EAGAIN) {
+		if (get_timer(dev->probe_start) < CONFIG_DM_PROBE_ASYNC_TIMEOUT)
+			return ret;
+		dm_warn("%s: Device '%s' did not become ready\n", __func__,
+			dev->name);
+		/* Let the driver stop whatever probe() started */
+		if (dev->driver->remove)
+			dev->driver->remove(dev);
+		ret = -ETIMEDOUT;
 	}
-fail:
-	dev->flags &= ~DM_FLAG_ACTIVATED;
 
-	dev->seq = -1;
-	device_free(dev);
+	if (ret) {
+		device_probe_undo(dev);
+		return ret;
+	}
+	dev->flags &= ~DM_FLAG_PROBE_PENDING;
+	dev->flags |= DM_FLAG_ACTIVATED;
+
+	return device_probe_finish(dev);
+}
+
+static int device_probe_wait(struct udevice *dev)
+{
+	int ret;
+
+	while ((ret = device_probe_poll(dev)) == -EAGAIN)
+		WATCHDOG_RESET();
 
 	return ret;
 }
 
+/*
+ * Polls pending parents and starts the outermost parent which is not yet
+ * probed, returning true while the device must wait for one of them
+ */
+static bool device_parent_pending(struct udevice *dev)
+{
+	struct udevice *top = NULL;
+
+	for (dev = dev->parent; dev; dev = dev->parent) {
+		if (device_probe_poll(dev) == -EAGAIN)
+			return true;
+		if (!(dev->flags & DM_FLAG_ACTIVATED))
+			top = dev;
+	}
+	/* On error, probing the device itself reports the failure */
+	if (!top || device_probe_start(top))
+		return false;
+
+	return top->flags & DM_FLAG_PROBE_PENDING;
+}
+
+enum probe_list_state {
+	PROBE_LIST_WAITING,
+	PROBE_LIST_PENDING,
+	PROBE_LIST_DONE,
+};
+
+struct probe_list_entry {
+	enum probe_list_state state;
+	ulong start_us;
+};
+
+int device_probe_list(struct udevice **devs, int count)
+{
+	struct probe_list_entry *entries;
+	int remaining = count;
+	uint32_t busy = 0;
+	int ret = 0;
+	int err, i;
+
+	entries = calloc(count, sizeof(*entries));
+	if (!entries)
+		return -ENOMEM;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DM_PROBE, "dm_probe_list");
+	while (remaining) {
+		for (i = 0; i < count; i++) {
+			struct probe_list_entry *entry = &entries[i];
+			struct udevice *dev = devs[i];
+
+			switch (entry->state) {
+			case PROBE_LIST_WAITING:
+				if (device_parent_pending(dev))
+					continue;
+				entry->start_us = timer_get_us();
+				err = device_probe_start(dev);
+				if (!err &&
+				    (dev->flags & DM_FLAG_PROBE_PENDING)) {
+					entry->state = PROBE_LIST_PENDING;
+					continue;
+				}
+				break;
+			case PROBE_LIST_PENDING:
+				err = device_probe_poll(dev);
+				if (err == -EAGAIN)
+					continue;
+				break;
+			default:
+				continue;
+			}
+
+			busy += timer_get_us() - entry->start_us;
+			entry->state = PROBE_LIST_DONE;
+			remaining--;
+			if (err && !ret)
+				ret = err;
+		}
+		WATCHDOG_RESET();
+	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_PROBE);
+	bootstage_accum_time(BOOTSTAGE_ID_ACCUM_DM_PROBE_BUSY,
+			     "dm_probe_list_busy", busy);
+	free(entries);
+
+	return ret;
+}
+#else
+static inline int device_probe_wait(struct udevice *dev)
+{
+	return 0;
+}
+#endif
+
+int device_probe(struct udevice *dev)
+{
+	int ret;
+
+	ret = device_probe_start(dev);
+	if (ret)
+		return ret;
+
+	return device_probe_wait(dev);
+}
+
 void *dev_get_platdata(struct udevice *dev)
 {
 	if (!dev) {
@@ -9,6 +9,8 @@
 #include <mapmem.h>
 #include <dm/root.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static void show_devices(struct udevice *dev, int depth, int last_flag)
 {
 	int i, is_last;
@@ -94,3 +96,15 @@ void dm_dump_uclass(void)
 		puts("\n");
 	}
 }
+
+#if CONFIG_IS_ENABLED(DM_STATS)
+void dm_dump_stats(void)
+{
+	printf("uclass lookups:    %lu\n", gd->uclass_lookups);
+	printf("uclass list steps: %lu\n", gd->uclass_list_steps);
+	printf("uclass table:      %s\n",
+	       CONFIG_IS_ENABLED(DM_UCLASS_TABLE) ? "enabled" : "disabled");
+	gd->uclass_lookups = 0;
+	gd->uclass_list_steps = 0;
+}
+#endif
@@ -16,8 +16,11 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 struct driver *lists_driver_lookup_name(const char *name)
 {
 	struct driver *drv =
@@ -126,11 +129,139 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
-		   struct udevice **devp)
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+/*
+ * The index is an open-addressed hash table holding, for each compatible
+ * string, the first driver in the linker list which declares it. Slots
+ * hold 16-bit indices rather than pointers to keep the table small, since
+ * before relocation it comes out of the early malloc() pool.
+ */
+#define COMPAT_INDEX_EMPTY	0xffff
+
+struct dm_compat_slot {
+	u16 drv;	/* Index into the driver linker list */
+	u16 match;	/* Index into that driver's of_match table */
+};
+
+struct dm_compat_index {
+	struct driver *driver;	/* Start of the driver linker list */
+	unsigned int mask;	/* Number of slots - 1 */
+	struct dm_compat_slot slot[0];
+};
+
+static unsigned int compat_hash(const char *compat)
+{
+	unsigned int hash = 5381;
+
+	while (*compat)
+		hash = hash * 33 + (unsigned char)*compat++;
+
+	return hash;
+}
+
+static struct dm_compat_index *compat_index_build(struct driver *driver,
+						  int n_ents)
+{
+	struct dm_compat_index *index;
+	const struct udevice_id *of_match;
+	struct dm_compat_slot *slot;
+	struct driver *entry;
+	unsigned int count = 0, size, h;
+	int j;
+
+	if (n_ents >= COMPAT_INDEX_EMPTY)
+		return NULL;
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_match = entry->of_match;
+		     of_match && of_match->compatible; of_match++)
+			count++;
+	}
+
+	/* keep the table at most half full so probe chains stay short */
+	size = 1 << fls(max(count * 2, 16U) - 1);
+	index = malloc(sizeof(*index) + size * sizeof(*slot));
+	if (!index)
+		return NULL;
+	index->driver = driver;
+	index->mask = size - 1;
+	memset(index->slot, 0xff, size * sizeof(*slot));
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		of_match = entry->of_match;
+		for (j = 0; of_match && of_match[j].compatible; j++) {
+			const char *compat = of_match[j].compatible;
+
+			h = compat_hash(compat) & index->mask;
+			for (slot = &index->slot[h];
+			     slot->drv != COMPAT_INDEX_EMPTY;
+			     slot = &index->slot[h]) {
+				/* the first driver declaring it wins */
+				if (!strcmp(index->driver[slot->drv].of_match[
+					    slot->match].compatible, compat))
+					break;
+				h = (h + 1) & index->mask;
+			}
+			if (slot->drv == COMPAT_INDEX_EMPTY) {
+				slot->drv = entry - driver;
+				slot->match = j;
+			}
+		}
+	}
+	dm_dbg("Indexed %u compatible strings in %u slots\n", count, size);
+
+	return index;
+}
+
+static struct driver *compat_index_lookup(struct dm_compat_index *index,
+					  const char *compat,
+					  const struct udevice_id **of_idp)
+{
+	const struct udevice_id *of_match;
+	struct dm_compat_slot *slot;
+	struct driver *entry;
+	unsigned int h;
+
+	h = compat_hash(compat) & index->mask;
+	for (slot = &index->slot[h];
+	     slot->drv != COMPAT_INDEX_EMPTY;
+	     slot = &index->slot[h]) {
+		entry = &index->driver[slot->drv];
+		of_match = &entry->of_match[slot->match];
+		if (!strcmp(of_match->compatible, compat)) {
+			*of_idp = of_match;
+			return entry;
+		}
+		h = (h + 1) & index->mask;
+	}
+
+	return NULL;
+}
+#endif
+
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **of_idp)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	if (!gd->dm_compat_index)
+		gd->dm_compat_index = compat_index_build(driver, n_ents);
+	if (gd->dm_compat_index)
+		return compat_index_lookup(gd->dm_compat_index, compat, of_idp);
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
+		   struct udevice **devp)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -166,13 +297,8 @@ int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
 		dm_dbg("   - attempt to match compatible string '%s'\n",
 		       compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_driver_lookup_compat(compat, &id);
+		if (!entry)
 			continue;
 
 		dm_dbg("   - found match at '%s'\n", entry->name);
@@ -154,6 +154,9 @@ int dm_init(void)
 		return -EINVAL;
 	}
 	INIT_LIST_HEAD(&DM_UCLASS_ROOT_NON_CONST);
+#if CONFIG_IS_ENABLED(DM_UCLASS_TABLE)
+	memset(gd->uclass_table, '\0', sizeof(gd->uclass_table));
+#endif
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 	fix_drivers();
@@ -247,6 +250,9 @@ __weak int dm_scan_other(bool pre_reloc_only)
 
 int dm_init_and_scan(bool pre_reloc_only)
 {
+	enum bootstage_id stage = pre_reloc_only ? BOOTSTAGE_ID_ACCUM_DM_F :
+				  BOOTSTAGE_ID_ACCUM_DM_R;
+	bool timed;
 	int ret;
 
 	ret = dm_init();
@@ -261,7 +267,18 @@ int dm_init_and_scan(bool pre_reloc_only)
 	}
 
 	if (CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)) {
+		/*
+		 * Before relocation a driver model timer only works once it
+		 * has been bound, unless the board provides an early timer
+		 */
+		timed = !pre_reloc_only || !IS_ENABLED(CONFIG_TIMER) ||
+			IS_ENABLED(CONFIG_TIMER_EARLY);
+		if (timed)
+			bootstage_start(stage, pre_reloc_only ? "dm_scan_fdt_f" :
+					"dm_scan_fdt_r");
 		ret = dm_scan_fdt(gd->fdt_blob, pre_reloc_only);
+		if (timed)
+			bootstage_accum(stage);
 		if (ret) {
 			debug("dm_scan_fdt() failed: %d\n", ret);
 			return ret;
@@ -25,12 +25,17 @@ struct uclass *uclass_find(enum uclass_id key)
 
 	if (!gd->dm_root)
 		return NULL;
-	/*
-	 * TODO(sjg@chromium.org): Optimise this, perhaps moving the found
-	 * node to the start of the list, or creating a linear array mapping
-	 * id to node.
-	 */
+#if CONFIG_IS_ENABLED(DM_STATS)
+	gd->uclass_lookups++;
+#endif
+#if CONFIG_IS_ENABLED(DM_UCLASS_TABLE)
+	if (key >= 0 && key < UCLASS_COUNT)
+		return gd->uclass_table[key];
+#endif
 	list_for_each_entry(uc, &gd->uclass_root, sibling_node) {
+#if CONFIG_IS_ENABLED(DM_STATS)
+		gd->uclass_list_steps++;
+#endif
 		if (uc->uc_drv->id == key)
 			return uc;
 	}
@@ -38,6 +43,19 @@ struct uclass *uclass_find(enum uclass_id key)
 	return NULL;
 }
 
+/**
+ * uclass_set_table() - Update the id-indexed uclass table
+ * @id: Id of uclass to update
+ * @uc: New uclass for this id, or NULL if it is being removed
+ */
+static void uclass_set_table(enum uclass_id id, struct uclass *uc)
+{
+#if CONFIG_IS_ENABLED(DM_UCLASS_TABLE)
+	if (id >= 0 && id < UCLASS_COUNT)
+		gd->uclass_table[id] = uc;
+#endif
+}
+
 /**
  * uclass_add() - Create new uclass in list
  * @id: Id number to create
@@ -79,6 +97,7 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	INIT_LIST_HEAD(&uc->sibling_node);
 	INIT_LIST_HEAD(&uc->dev_head);
 	list_add(&uc->sibling_node, &DM_UCLASS_ROOT_NON_CONST);
+	uclass_set_table(id, uc);
 
 	if (uc_drv->init) {
 		ret = uc_drv->init(uc);
@@ -95,6 +114,7 @@ fail:
 		uc->priv = NULL;
 	}
 	list_del(&uc->sibling_node);
+	uclass_set_table(id, NULL);
 fail_mem:
 	free(uc);
 
@@ -128,6 +148,7 @@ int uclass_destroy(struct uclass *uc)
 	if (uc_drv->destroy)
 		uc_drv->destroy(uc);
 	list_del(&uc->sibling_node);
+	uclass_set_table(uc_drv->id, NULL);
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
 	free(uc);
@@ -293,32 +314,19 @@ static int uclass_find_device_by_phandle(enum uclass_id id,
 					 const char *name,
 					 struct udevice **devp)
 {
-	struct udevice *dev;
-	struct uclass *uc;
 	int find_phandle;
-	int ret;
+	int node;
 
 	*devp = NULL;
 	find_phandle = fdtdec_get_int(gd->fdt_blob, dev_of_offset(parent), name,
 				      -1);
 	if (find_phandle <= 0)
 		return -ENOENT;
-	ret = uclass_get(id, &uc);
-	if (ret)
-		return ret;
-
-	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
-		uint phandle;
-
-		phandle = fdt_get_phandle(gd->fdt_blob, dev_of_offset(dev));
-
-		if (phandle == find_phandle) {
-			*devp = dev;
-			return 0;
-		}
-	}
+	node = fdtdec_node_offset_by_phandle(gd->fdt_blob, find_phandle);
+	if (node < 0)
+		return -ENODEV;
 
-	return -ENODEV;
+	return uclass_find_device_by_of_offset(id, node, devp);
 }
 #endif
 
@@ -457,6 +465,37 @@ int uclass_next_device(struct udevice **devp)
 	return uclass_get_device_tail(dev, ret, devp);
 }
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+int uclass_probe_all(enum uclass_id id)
+{
+	struct udevice **devs, *dev;
+	struct uclass *uc;
+	int count = 0;
+	int ret;
+
+	ret = uclass_get(id, &uc);
+	if (ret)
+		return ret;
+
+	/* Probing may bind more devices, so work from a snapshot */
+	list_for_each_entry(dev, &uc->dev_head, uclass_node)
+		count++;
+	if (!count)
+		return 0;
+	devs = malloc(count * sizeof(*devs));
+	if (!devs)
+		return -ENOMEM;
+	count = 0;
+	list_for_each_entry(dev, &uc->dev_head, uclass_node)
+		devs[count++] = dev;
+
+	ret = device_probe_list(devs, count);
+	free(devs);
+
+	return ret;
+}
+#endif
+
 int uclass_bind_device(struct udevice *dev)
 {
 	struct uclass *uc;
@@ -134,11 +134,27 @@ static void sb_eth_raw_stop(struct udevice *dev)
 	sandbox_eth_raw_os_stop(priv);
 }
 
+#ifdef CONFIG_MCAST_TFTP
+static int sb_eth_raw_mcast(struct udevice *dev, const u8 *enetaddr, int join)
+{
+	struct eth_sandbox_raw_priv *priv = dev_get_priv(dev);
+
+	/* The localhost interface only sees packets for 127.0.0.1 */
+	if (priv->local)
+		return -ENOSYS;
+
+	return sandbox_eth_raw_os_mcast(enetaddr, join, priv);
+}
+#endif
+
 static const struct eth_ops sb_eth_raw_ops = {
 	.start			= sb_eth_raw_start,
 	.send			= sb_eth_raw_send,
 	.recv			= sb_eth_raw_recv,
 	.stop			= sb_eth_raw_stop,
+#ifdef CONFIG_MCAST_TFTP
+	.mcast			= sb_eth_raw_mcast,
+#endif
 };
 
 static int sb_eth_raw_ofdata_to_platdata(struct udevice *dev)
@@ -11,6 +11,7 @@
 #include <dm.h>
 #include <malloc.h>
 #include <net.h>
+#include <asm/eth.h>
 #include <asm/test.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -18,19 +19,32 @@ DECLARE_GLOBAL_DATA_PTR;
 /**
  * struct eth_sandbox_priv - memory for sandbox mock driver
  *
+ * The receive ring works like the DMA ring of a real controller: received
+ * packets are written to the next free buffer, handed to the network stack
+ * in place by recv() and given back to the "hardware" by free_pkt().
+ *
  * fake_host_hwaddr: MAC address of mocked machine
  * fake_host_ipaddr: IP address of mocked machine
- * recv_packet_buffer: buffer of the packet returned as received
- * recv_packet_length: length of the packet returned as received
+ * rx_buf: PKTBUFSRX receive buffers of PKTSIZE_ALIGN bytes each
+ * rx_len: length of the packet in each buffer
+ * rx_head: next buffer to receive into
+ * rx_tail: next buffer to pass to the network stack
+ * rx_ready: number of received packets not yet passed to the stack
+ * rx_used: number of buffers received into and not yet freed
  */
 struct eth_sandbox_priv {
 	uchar fake_host_hwaddr[ARP_HLEN];
 	struct in_addr fake_host_ipaddr;
-	uchar *recv_packet_buffer;
-	int recv_packet_length;
+	uchar *rx_buf;
+	int rx_len[PKTBUFSRX];
+	int rx_head;
+	int rx_tail;
+	int rx_ready;
+	int rx_used;
 };
 
 static bool disabled[8] = {false};
+static sandbox_eth_tx_hand_f *tx_handler[8];
 static bool skip_timeout;
 
 /*
@@ -44,6 +58,17 @@ void sandbox_eth_disable_response(int index, bool disable)
 	disabled[index] = disable;
 }
 
+/*
+ * sandbox_eth_set_tx_handler()
+ *
+ * index - The alias index (also DM seq number)
+ * handler - Called with each sent packet before the mock responses, or NULL
+ */
+void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler)
+{
+	tx_handler[index] = handler;
+}
+
 /*
  * sandbox_eth_skip_timeout()
  *
@@ -54,6 +79,63 @@ void sandbox_eth_skip_timeout(void)
 	skip_timeout = true;
 }
 
+/*
+ * sb_eth_rx_get_buf()
+ *
+ * Returns the next free receive buffer, or NULL if the ring is full. The
+ * packet is lost in that case, as it would be by a real controller.
+ */
+static uchar *sb_eth_rx_get_buf(struct udevice *dev)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct eth_stats *stats;
+
+	if (priv->rx_used == PKTBUFSRX) {
+		debug("eth_sandbox: receive ring full\n");
+		stats = eth_get_stats(dev);
+		stats->rx_dropped++;
+		stats->rx_overruns++;
+		return NULL;
+	}
+
+	return priv->rx_buf + priv->rx_head * PKTSIZE_ALIGN;
+}
+
+/* Marks the buffer from sb_eth_rx_get_buf() as holding a packet */
+static void sb_eth_rx_put_buf(struct udevice *dev, int length)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	priv->rx_len[priv->rx_head] = length;
+	priv->rx_head = (priv->rx_head + 1) % PKTBUFSRX;
+	priv->rx_ready++;
+	priv->rx_used++;
+}
+
+/*
+ * sandbox_eth_recv_packet()
+ *
+ * Puts a packet in the receive ring of a device, as if it arrived on the wire
+ *
+ * dev - The Ethernet device
+ * packet - The packet, starting with the Ethernet header
+ * length - The length of the packet
+ * returns 0 if queued, -ENOBUFS if the receive ring is full
+ */
+int sandbox_eth_recv_packet(struct udevice *dev, const void *packet,
+			    int length)
+{
+	uchar *buf;
+
+	buf = sb_eth_rx_get_buf(dev);
+	if (!buf)
+		return -ENOBUFS;
+	memcpy(buf, packet, min(length, PKTSIZE));
+	sb_eth_rx_put_buf(dev, min(length, PKTSIZE));
+
+	return 0;
+}
+
 static int sb_eth_start(struct udevice *dev)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
@@ -63,7 +145,10 @@ static int sb_eth_start(struct udevice *dev)
 	fdtdec_get_byte_array(gd->fdt_blob, dev_of_offset(dev),
 			      "fake-host-hwaddr", priv->fake_host_hwaddr,
 			      ARP_HLEN);
-	priv->recv_packet_buffer = net_rx_packets[0];
+	priv->rx_head = 0;
+	priv->rx_tail = 0;
+	priv->rx_ready = 0;
+	priv->rx_used = 0;
 	return 0;
 }
 
@@ -78,6 +163,10 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 	    disabled[dev->seq])
 		return 0;
 
+	if (dev->seq >= 0 && dev->seq < ARRAY_SIZE(tx_handler) &&
+	    tx_handler[dev->seq] && tx_handler[dev->seq](dev, packet, length))
+		return 0;
+
 	if (ntohs(eth->et_protlen) == PROT_ARP) {
 		struct arp_hdr *arp = packet + ETHER_HDR_SIZE;
 
@@ -88,14 +177,15 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 			/* store this as the assumed IP of the fake host */
 			priv->fake_host_ipaddr = net_read_ip(&arp->ar_tpa);
 			/* Formulate a fake response */
-			eth_recv = (void *)priv->recv_packet_buffer;
+			eth_recv = (void *)sb_eth_rx_get_buf(dev);
+			if (!eth_recv)
+				return 0;
 			memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
 			memcpy(eth_recv->et_src, priv->fake_host_hwaddr,
 			       ARP_HLEN);
 			eth_recv->et_protlen = htons(PROT_ARP);
 
-			arp_recv = (void *)priv->recv_packet_buffer +
-				ETHER_HDR_SIZE;
+			arp_recv = (void *)eth_recv + ETHER_HDR_SIZE;
 			arp_recv->ar_hrd = htons(ARP_ETHER);
 			arp_recv->ar_pro = htons(PROT_IP);
 			arp_recv->ar_hln = ARP_HLEN;
@@ -107,8 +197,7 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 			memcpy(&arp_recv->ar_tha, &arp->ar_sha, ARP_HLEN);
 			net_copy_ip(&arp_recv->ar_tpa, &arp->ar_spa);
 
-			priv->recv_packet_length = ETHER_HDR_SIZE +
-				ARP_HDR_SIZE;
+			sb_eth_rx_put_buf(dev, ETHER_HDR_SIZE + ARP_HDR_SIZE);
 		}
 	} else if (ntohs(eth->et_protlen) == PROT_IP) {
 		struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
@@ -122,11 +211,11 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 				struct icmp_hdr *icmpr;
 
 				/* reply to the ping */
-				memcpy(priv->recv_packet_buffer, packet,
-				       length);
-				eth_recv = (void *)priv->recv_packet_buffer;
-				ipr = (void *)priv->recv_packet_buffer +
-					ETHER_HDR_SIZE;
+				eth_recv = (void *)sb_eth_rx_get_buf(dev);
+				if (!eth_recv)
+					return 0;
+				memcpy(eth_recv, packet, length);
+				ipr = (void *)eth_recv + ETHER_HDR_SIZE;
 				icmpr = (struct icmp_hdr *)&ipr->udp_src;
 				memcpy(eth_recv->et_dest, eth->et_src,
 				       ARP_HLEN);
@@ -145,7 +234,7 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 				icmpr->checksum = compute_ip_checksum(icmpr,
 					ICMP_HDR_SIZE);
 
-				priv->recv_packet_length = length;
+				sb_eth_rx_put_buf(dev, length);
 			}
 		}
 	}
@@ -162,18 +251,29 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 		skip_timeout = false;
 	}
 
-	if (priv->recv_packet_length) {
-		int lcl_recv_packet_length = priv->recv_packet_length;
+	if (priv->rx_ready) {
+		int length = priv->rx_len[priv->rx_tail];
 
-		debug("eth_sandbox: received packet %d\n",
-		      priv->recv_packet_length);
-		priv->recv_packet_length = 0;
-		*packetp = priv->recv_packet_buffer;
-		return lcl_recv_packet_length;
+		debug("eth_sandbox: received packet %d\n", length);
+		*packetp = priv->rx_buf + priv->rx_tail * PKTSIZE_ALIGN;
+		priv->rx_tail = (priv->rx_tail + 1) % PKTBUFSRX;
+		priv->rx_ready--;
+		return length;
 	}
 	return 0;
 }
 
+static int sb_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	/* Buffers are freed in the order they were received */
+	if (length > 0 && priv->rx_used > priv->rx_ready)
+		priv->rx_used--;
+
+	return 0;
+}
+
 static void sb_eth_stop(struct udevice *dev)
 {
 	debug("eth_sandbox: Stop\n");
@@ -192,12 +292,28 @@ static const struct eth_ops sb_eth_ops = {
 	.start			= sb_eth_start,
 	.send			= sb_eth_send,
 	.recv			= sb_eth_recv,
+	.free_pkt		= sb_eth_free_pkt,
 	.stop			= sb_eth_stop,
 	.write_hwaddr		= sb_eth_write_hwaddr,
 };
 
+static int sb_eth_probe(struct udevice *dev)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	priv->rx_buf = memalign(PKTALIGN, PKTBUFSRX * PKTSIZE_ALIGN);
+	if (!priv->rx_buf)
+		return -ENOMEM;
+
+	return 0;
+}
+
 static int sb_eth_remove(struct udevice *dev)
 {
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	free(priv->rx_buf);
+
 	return 0;
 }
 
@@ -219,6 +335,7 @@ U_BOOT_DRIVER(eth_sandbox) = {
 	.id	= UCLASS_ETH,
 	.of_match = sb_eth_ids,
 	.ofdata_to_platdata = sb_eth_ofdata_to_platdata,
+	.probe	= sb_eth_probe,
 	.remove	= sb_eth_remove,
 	.ops	= &sb_eth_ops,
 	.priv_auto_alloc_size = sizeof(struct eth_sandbox_priv),
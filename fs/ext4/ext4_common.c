@@ -1509,14 +1509,66 @@ void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 
 #endif
 
+/*
+ * Extent tree blocks read while mapping file blocks, one per tree level
+ * below the root in the inode. Mapping a file run by run walks the same
+ * index and leaf blocks over and over, so keep the last block seen at each
+ * level and only go to the device when the walk moves to a different one.
+ */
+#define EXT4_EXTENT_MAX_DEPTH	5
+
+static struct ext4_extent_cache {
+	unsigned long long blknr;	/* 0 if nothing cached */
+	char *buf;
+} ext4fs_extent_cache[EXT4_EXTENT_MAX_DEPTH];
+static int ext4fs_extent_cache_blksz;
+
+static void ext4fs_extent_cache_free(void)
+{
+	int i;
+
+	for (i = 0; i < EXT4_EXTENT_MAX_DEPTH; i++) {
+		free(ext4fs_extent_cache[i].buf);
+		ext4fs_extent_cache[i].buf = NULL;
+		ext4fs_extent_cache[i].blknr = 0;
+	}
+	ext4fs_extent_cache_blksz = 0;
+}
+
+static char *ext4fs_extent_cache_read(int level, unsigned long long block,
+				      int blksz, int log2_blksz)
+{
+	struct ext4_extent_cache *cache = &ext4fs_extent_cache[level];
+
+	if (blksz != ext4fs_extent_cache_blksz) {
+		ext4fs_extent_cache_free();
+		ext4fs_extent_cache_blksz = blksz;
+	}
+	if (!cache->buf) {
+		cache->buf = zalloc(blksz);
+		if (!cache->buf)
+			return NULL;
+	}
+	if (cache->blknr == block)
+		return cache->buf;
+
+	cache->blknr = 0;
+	if (!ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
+			    cache->buf))
+		return NULL;
+	cache->blknr = block;
+
+	return cache->buf;
+}
+
 static struct ext4_extent_header *ext4fs_get_extent_block
-	(struct ext2_data *data, char *buf,
-		struct ext4_extent_header *ext_block,
+	(struct ext2_data *data, struct ext4_extent_header *ext_block,
 		uint32_t fileblock, int log2_blksz)
 {
 	struct ext4_extent_idx *index;
 	unsigned long long block;
 	int blksz = EXT2_BLOCK_SIZE(data);
+	int level = 0;
 	int i;
 
 	while (1) {
@@ -1534,20 +1586,77 @@ static struct ext4_extent_header *ext4fs_get_extent_block
 				break;
 		} while (fileblock >= le32_to_cpu(index[i].ei_block));
 
-		if (--i < 0)
+		if (--i < 0 || level >= EXT4_EXTENT_MAX_DEPTH)
 			return NULL;
 
 		block = le16_to_cpu(index[i].ei_leaf_hi);
 		block = (block << 32) + le32_to_cpu(index[i].ei_leaf_lo);
 
-		if (ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
-				   buf))
-			ext_block = (struct ext4_extent_header *)buf;
-		else
+		ext_block = (struct ext4_extent_header *)
+			ext4fs_extent_cache_read(level++, block, blksz,
+						 log2_blksz);
+		if (!ext_block)
 			return NULL;
 	}
 }
 
+/*
+ * Map up to maxblocks file blocks from fileblock on through the extent
+ * tree. Returns the number of blocks mapped contiguously and sets *blknr
+ * to the first physical block, or to 0 for a hole.
+ */
+static int ext4fs_map_extent(struct ext2_inode *inode, int fileblock,
+			     int maxblocks, long int *blknr)
+{
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	long int startblock, endblock;
+	unsigned long long start;
+	int log2_blksz;
+	int i;
+
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+		- get_fs()->dev_desc->log2blksz;
+
+	ext_block = ext4fs_get_extent_block(ext4fs_root,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		startblock = le32_to_cpu(extent[i].ee_block);
+		endblock = startblock + le16_to_cpu(extent[i].ee_len);
+
+		if (startblock > fileblock) {
+			/* Sparse file */
+			*blknr = 0;
+			return min_t(long int, startblock - fileblock,
+				     maxblocks);
+
+		} else if (fileblock < endblock) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			*blknr = (fileblock - startblock) + start;
+			return min_t(long int, endblock - fileblock,
+				     maxblocks);
+		}
+	}
+
+	/*
+	 * Past the last extent of this leaf. A hole up to the next leaf would
+	 * need another walk, so just report a single block.
+	 */
+	*blknr = 0;
+	return 1;
+}
+
 static int ext4fs_blockgroup
 	(struct ext2_data *data, int group, struct ext2_block_group *blkgrp)
 {
@@ -1610,53 +1719,17 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		long int startblock, endblock;
-		char *buf = zalloc(blksz);
-		if (!buf)
-			return -ENOMEM;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i;
-		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, buf,
-						(struct ext4_extent_header *)
-						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			free(buf);
-			return -EINVAL;
-		}
-
-		extent = (struct ext4_extent *)(ext_block + 1);
-
-		for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
-			startblock = le32_to_cpu(extent[i].ee_block);
-			endblock = startblock + le16_to_cpu(extent[i].ee_len);
-
-			if (startblock > fileblock) {
-				/* Sparse file */
-				free(buf);
-				return 0;
-
-			} else if (fileblock < endblock) {
-				start = le16_to_cpu(extent[i].ee_start_hi);
-				start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-				free(buf);
-				return (fileblock - startblock) + start;
-			}
-		}
+		status = ext4fs_map_extent(inode, fileblock, 1, &blknr);
+		if (status < 0)
+			return status;
 
-		free(buf);
-		return 0;
+		return blknr;
 	}
 
 	/* Direct blocks. */
@@ -1944,6 +2017,42 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	return blknr;
 }
 
+/**
+ * read_allocated_run() - map a run of contiguous file blocks
+ *
+ * @inode:	inode of the file
+ * @fileblock:	first file block to map
+ * @maxblocks:	maximum number of blocks to map
+ * @blknr:	returns the filesystem block holding @fileblock, or 0 if the
+ *		run is a hole
+ * @return number of blocks (at least 1) from @fileblock on which are
+ * stored contiguously from @blknr (or are all holes), or -ve on error
+ */
+int read_allocated_run(struct ext2_inode *inode, int fileblock, int maxblocks,
+		       long int *blknr)
+{
+	long int next;
+	int run;
+
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)
+		return ext4fs_map_extent(inode, fileblock, maxblocks, blknr);
+
+	/* indirect blocks are cached, so just look at each block in turn */
+	*blknr = read_allocated_block(inode, fileblock);
+	if (*blknr < 0)
+		return *blknr;
+
+	for (run = 1; run < maxblocks; run++) {
+		next = read_allocated_block(inode, fileblock + run);
+		if (next < 0)
+			return next;
+		if (*blknr ? next != *blknr + run : next != 0)
+			break;
+	}
+
+	return run;
+}
+
 /**
  * ext4fs_reinit_global() - Reinitialize values of ext4 write implementation's
  *			    global pointers
@@ -1976,6 +2085,7 @@ void ext4fs_reinit_global(void)
 		ext4fs_indir3_size = 0;
 		ext4fs_indir3_blkno = -1;
 	}
+	ext4fs_extent_cache_free();
 }
 void ext4fs_close(void)
 {
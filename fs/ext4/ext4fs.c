@@ -45,12 +45,15 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
+ *
+ * Blocks are mapped a run at a time, so a file stored in a few extents is
+ * read with a few large ext4fs_devread() calls.
  */
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		loff_t len, char *buf, loff_t *actread)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
+	int i, run;
 	lbaint_t blockcnt;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
@@ -70,61 +73,55 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
-		lbaint_t blknr;
-		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
+	for (i = lldiv(pos, blocksize); i < blockcnt; i += run) {
+		long int blknr;
+		loff_t runstart = (loff_t)blocksize * i;
+		loff_t runend;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
-		if (blknr < 0)
+		int runlen;
+
+		run = read_allocated_run(&(node->inode), i, blockcnt - i,
+					 &blknr);
+		if (run < 0)
 			return -1;
 
-		blknr = blknr << log2_fs_blocksize;
+		runend = (loff_t)blocksize * (i + run);
 
 		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		if (runend > len + pos)
+			runend = len + pos;
 
 		/* First block. */
-		if (i == lldiv(pos, blocksize)) {
-			skipfirst = blockoff;
-			blockend -= skipfirst;
+		if (runstart < pos) {
+			skipfirst = pos - runstart;
+			runstart = pos;
 		}
+		runlen = runend - runstart;
+
 		if (blknr) {
-			int status;
+			lbaint_t sector = (lbaint_t)blknr << log2_fs_blocksize;
 
-			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
-				} else {	/* spill */
+			if (previous_block_number != -1 &&
+			    delayed_next == sector) {
+				delayed_extent += runlen;
+				delayed_next += (lbaint_t)run << log2_fs_blocksize;
+			} else {
+				if (previous_block_number != -1) {
+					/* spill */
 					status = ext4fs_devread(delayed_start,
 							delayed_skipfirst,
 							delayed_extent,
 							delayed_buf);
 					if (status == 0)
 						return -1;
-					previous_block_number = blknr;
-					delayed_start = blknr;
-					delayed_extent = blockend;
-					delayed_skipfirst = skipfirst;
-					delayed_buf = buf;
-					delayed_next = blknr +
-						(blockend >> log2blksz);
 				}
-			} else {
-				previous_block_number = blknr;
-				delayed_start = blknr;
-				delayed_extent = blockend;
+				previous_block_number = sector;
+				delayed_start = sector;
+				delayed_extent = runlen;
 				delayed_skipfirst = skipfirst;
 				delayed_buf = buf;
-				delayed_next = blknr +
-					(blockend >> log2blksz);
+				delayed_next = sector +
+					((lbaint_t)run << log2_fs_blocksize);
 			}
 		} else {
 			if (previous_block_number != -1) {
@@ -137,9 +134,9 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 					return -1;
 				previous_block_number = -1;
 			}
-			memset(buf, 0, blocksize - skipfirst);
+			memset(buf, 0, runlen);
 		}
-		buf += blocksize - skipfirst;
+		buf += runlen;
 	}
 	if (previous_block_number != -1) {
 		/* spill */
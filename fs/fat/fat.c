@@ -12,6 +12,7 @@
 #include <common.h>
 #include <blk.h>
 #include <config.h>
+#include <div64.h>
 #include <exports.h>
 #include <fat.h>
 #include <asm/byteorder.h>
@@ -60,6 +61,37 @@ static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 	return ret;
 }
 
+/*
+ * Start reading 'nr_blocks' blocks at 'block' into 'buf' using 'req', which
+ * must then be passed to disk_read_finish(). Return 0 on success.
+ */
+static int disk_read_start(__u32 block, __u32 nr_blocks, void *buf,
+			   struct blk_req *req)
+{
+	if (!cur_dev)
+		return -1;
+
+	req->op = BLK_REQ_READ;
+	req->start = cur_part_info.start + block;
+	req->blkcnt = nr_blocks;
+	req->buffer = buf;
+	req->complete = NULL;
+
+	return blk_submit(cur_dev, req);
+}
+
+/* Wait for a read started by disk_read_start(), returning as disk_read() */
+static int disk_read_finish(struct blk_req *req)
+{
+	long ret;
+
+	ret = blk_wait(req);
+	if (ret < 0 || (req->blkcnt && ret == 0))
+		return -1;
+
+	return ret;
+}
+
 int fat_set_blk_dev(struct blk_desc *dev_desc, disk_partition_t *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
@@ -162,22 +194,98 @@ static void get_name(dir_entry *dirent, char *s_name)
 	downcase(s_name);
 }
 
-static int flush_dirty_fat_buffer(fsdata *mydata);
+static int flush_fat_window(fsdata *mydata, struct fat_window *win);
 #if !defined(CONFIG_FAT_WRITE)
 /* Stub for read only operation */
-int flush_dirty_fat_buffer(fsdata *mydata)
+int flush_fat_window(fsdata *mydata, struct fat_window *win)
 {
 	(void)(mydata);
+	(void)(win);
 	return 0;
 }
 #endif
 
+/*
+ * Allocate the FAT cache, once mydata->sect_size is known.
+ * Return 0 on success, -1 otherwise.
+ */
+static int init_fat_cache(fsdata *mydata)
+{
+	struct fat_window *win;
+	int i;
+
+	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN,
+				  FATBUFSIZE * FATBUFWINDOWS);
+	if (mydata->fatbuf == NULL) {
+		debug("Error: allocating memory\n");
+		return -1;
+	}
+
+	for (i = 0; i < FATBUFWINDOWS; i++) {
+		win = &mydata->fatwin[i];
+		win->buf = mydata->fatbuf + i * FATBUFSIZE;
+		win->num = -1;
+		win->dirty = 0;
+		win->last_used = 0;
+	}
+	mydata->fatwin_clock = 0;
+
+	return 0;
+}
+
+/*
+ * Get window 'bufnum' of the FAT into the cache. A chain which jumps back
+ * and forth between a few areas of the FAT stays in the cache, so the
+ * least recently used window is the one replaced (and written back if it
+ * has been modified).
+ * Return the window, or NULL on failure.
+ */
+static struct fat_window *get_fat_window(fsdata *mydata, __u32 bufnum)
+{
+	struct fat_window *win, *lru = NULL;
+	__u32 getsize = FATBUFBLOCKS;
+	__u32 fatlength = mydata->fatlength;
+	__u32 startblock = bufnum * FATBUFBLOCKS;
+	int i;
+
+	for (i = 0; i < FATBUFWINDOWS; i++) {
+		win = &mydata->fatwin[i];
+		if (win->num == (int)bufnum)
+			goto found;
+		if (!lru || win->last_used < lru->last_used)
+			lru = win;
+	}
+	win = lru;
+
+	/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+	if (startblock + getsize > fatlength)
+		getsize = fatlength - startblock;
+
+	startblock += mydata->fat_sect;	/* Offset from start of disk */
+
+	/* Write back the window to the disk */
+	if (flush_fat_window(mydata, win) < 0)
+		return NULL;
+
+	if (disk_read(startblock, getsize, win->buf) < 0) {
+		debug("Error reading FAT blocks\n");
+		win->num = -1;
+		return NULL;
+	}
+	win->num = bufnum;
+found:
+	win->last_used = ++mydata->fatwin_clock;
+
+	return win;
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
  */
 static __u32 get_fatent(fsdata *mydata, __u32 entry)
 {
+	struct fat_window *win;
 	__u32 bufnum;
 	__u32 offset, off8;
 	__u32 ret = 0x00;
@@ -209,42 +317,23 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	debug("FAT%d: entry: 0x%08x = %d, offset: 0x%04x = %d\n",
 	       mydata->fatsize, entry, entry, offset, offset);
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
-
-		/* Write back the fatbuf to the disk */
-		if (flush_dirty_fat_buffer(mydata) < 0)
-			return -1;
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return ret;
-		}
-		mydata->fatbufnum = bufnum;
-	}
+	/* Read the block of FAT entries into the cache, if needed */
+	win = get_fat_window(mydata, bufnum);
+	if (!win)
+		return ret;
 
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
 	case 32:
-		ret = FAT2CPU32(((__u32 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU32(((__u32 *)win->buf)[offset]);
 		break;
 	case 16:
-		ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU16(((__u16 *)win->buf)[offset]);
 		break;
 	case 12:
 		off8 = (offset * 3) / 2;
-		/* fatbut + off8 may be unaligned, read in byte granularity */
-		ret = mydata->fatbuf[off8] + (mydata->fatbuf[off8 + 1] << 8);
+		/* buf + off8 may be unaligned, read in byte granularity */
+		ret = win->buf[off8] + (win->buf[off8 + 1] << 8);
 
 		if (offset & 0x1)
 			ret >>= 4;
@@ -319,6 +408,26 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/*
+ * Find the run of consecutive clusters starting at 'clustnum', of at most
+ * 'max' clusters, and store the cluster which follows it in the chain in
+ * *nextp (which is an end-of-chain or invalid entry if there is none).
+ * Return the number of clusters in the run.
+ */
+static __u32 get_cluster_run(fsdata *mydata, __u32 clustnum, __u32 max,
+			     __u32 *nextp)
+{
+	__u32 count = 1;
+	__u32 next;
+
+	while ((next = get_fatent(mydata, clustnum + count - 1)) ==
+	       clustnum + count && count < max)
+		count++;
+	*nextp = next;
+
+	return count;
+}
+
 /*
  * Read at most 'maxsize' bytes from 'pos' in the file associated with 'dentptr'
  * into 'buffer'.
@@ -333,8 +442,11 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
+	__u32 count, left, newclust, nsect = 0;
+	struct blk_req req;
 	loff_t actsize;
+	bool async;
+	int ret;
 
 	*gotsize = 0;
 	debug("Filesize: %llu bytes\n", filesize);
@@ -349,24 +461,21 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 	debug("%llu bytes\n", filesize);
 
-	actsize = bytesperclust;
-
-	/* go to cluster at pos */
-	while (actsize <= pos) {
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
+	/* go to cluster at pos, a run of clusters at a time */
+	while (pos >= bytesperclust) {
+		count = get_cluster_run(mydata, curclust,
+					lldiv(pos, bytesperclust), &newclust);
+		if (CHECK_CLUST(newclust, mydata->fatsize)) {
+			debug("curclust: 0x%x\n", newclust);
 			debug("Invalid FAT entry\n");
 			return 0;
 		}
-		actsize += bytesperclust;
+		actsize = (loff_t)count * bytesperclust;
+		filesize -= actsize;
+		pos -= actsize;
+		curclust = newclust;
 	}
 
-	/* actsize > pos */
-	actsize -= bytesperclust;
-	filesize -= actsize;
-	pos -= actsize;
-
 	/* align to beginning of next cluster if any */
 	if (pos) {
 		actsize = min(filesize, (loff_t)bytesperclust);
@@ -391,49 +500,54 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
+	/*
+	 * Read each run of consecutive clusters with a single disk read. All
+	 * runs but the last are whole clusters, so if the buffer is aligned
+	 * they are read asynchronously while the next run is looked up.
+	 */
+	count = get_cluster_run(mydata, curclust,
+				lldiv(filesize + bytesperclust - 1,
+				      bytesperclust),
+				&newclust);
 	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return 0;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
+		actsize = min(filesize, (loff_t)count * bytesperclust);
+		async = actsize < filesize &&
+			!((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1));
+		if (async) {
+			nsect = count * mydata->clust_size;
+			ret = disk_read_start(mydata->data_begin +
+					      curclust * mydata->clust_size,
+					      nsect, buffer, &req);
+		} else {
+			ret = get_cluster(mydata, curclust, buffer, actsize);
 		}
-
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		if (ret != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
-		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		filesize -= actsize;
+		if (filesize) {
+			curclust = newclust;
+			left = lldiv(filesize + bytesperclust - 1,
+				     bytesperclust);
+			if (!CHECK_CLUST(curclust, mydata->fatsize))
+				count = get_cluster_run(mydata, curclust, left,
+							&newclust);
+		}
+		if (async && disk_read_finish(&req) != nsect) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
-		*gotsize += (int)actsize;
-		filesize -= actsize;
+		*gotsize += actsize;
+		if (!filesize)
+			return 0;
 		buffer += actsize;
 
-		curclust = get_fatent(mydata, endclust);
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			printf("Invalid FAT entry\n");
 			return 0;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
 	} while (1);
 }
 
@@ -872,13 +986,8 @@ int do_fat_read_at(const char *filename, loff_t pos, void *buffer,
 					(mydata->clust_size * 2);
 	}
 
-	mydata->fatbufnum = -1;
-	mydata->fat_dirty = 0;
-	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
-		debug("Error: allocating memory\n");
+	if (init_fat_cache(mydata))
 		return -1;
-	}
 
 	if (vfat_enabled)
 		debug("VFAT Support enabled\n");
@@ -22,6 +22,7 @@
 
 #ifndef __ASSEMBLY__
 #include <membuff.h>
+#include <dm/uclass-id.h>
 #include <linux/list.h>
 
 typedef struct global_data {
@@ -64,6 +65,16 @@ typedef struct global_data {
 	struct udevice	*dm_root;	/* Root instance for Driver Model */
 	struct udevice	*dm_root_f;	/* Pre-relocation root instance */
 	struct list_head uclass_root;	/* Head of core tree */
+#if CONFIG_IS_ENABLED(DM_UCLASS_TABLE)
+	struct uclass	*uclass_table[UCLASS_COUNT];	/* Uclasses by id */
+#endif
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	struct dm_compat_index *dm_compat_index; /* Compatible -> driver */
+#endif
+#if CONFIG_IS_ENABLED(DM_STATS)
+	unsigned long	uclass_lookups;	/* Calls to uclass_find() */
+	unsigned long	uclass_list_steps; /* Uclass list nodes walked */
+#endif
 #endif
 #ifdef CONFIG_TIMER
 	struct udevice	*timer;		/* Timer instance for Driver Model */
@@ -72,6 +83,9 @@ typedef struct global_data {
 	const void *fdt_blob;		/* Our device tree, NULL if none */
 	void *new_fdt;			/* Relocated FDT */
 	unsigned long fdt_size;		/* Space reserved for relocated FDT */
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+	struct fdtdec_phandle_cache *fdt_phandle_cache; /* Phandle -> node */
+#endif
 	struct jt_funcs *jt;		/* jump table */
 	char env_buf[32];		/* buffer for getenv() before reloc. */
 #ifdef CONFIG_TRACE
@@ -8,6 +8,8 @@
 #ifndef BLK_H
 #define BLK_H
 
+#include <linux/list.h>
+
 #ifdef CONFIG_SYS_64BIT_LBA
 typedef uint64_t lbaint_t;
 #define LBAFlength "ll"
@@ -134,10 +136,12 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * Changing either parameter discards the current contents of the cache.
+ *
+ * @param blocks - largest read (in blocks) that is added to the cache
+ * @param size - maximum number of bytes of block data to cache, 0 to disable
  */
-void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_configure(unsigned blocks, unsigned long size);
 
 /*
  * statistics of the block cache
@@ -145,9 +149,11 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
-	unsigned entries; /* current entry count */
+	unsigned evictions;
+	unsigned entries; /* current count of cached blocks */
 	unsigned max_blocks_per_entry;
-	unsigned max_entries;
+	unsigned long size; /* bytes of block data currently cached */
+	unsigned long max_size;
 };
 
 /**
@@ -174,6 +180,46 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
 
+enum blk_req_op {
+	BLK_REQ_READ,
+	BLK_REQ_WRITE,
+};
+
+/**
+ * struct blk_req - an asynchronous block I/O request
+ *
+ * The submitter fills in the fields up to @priv and passes the request to
+ * blk_submit(). The request must stay in place until it has completed.
+ *
+ * @op:		BLK_REQ_READ or BLK_REQ_WRITE
+ * @start:	Start block number (0=first)
+ * @blkcnt:	Number of blocks
+ * @buffer:	Buffer to read into, or to write from
+ * @complete:	Called when the request completes, or NULL. This happens
+ *		within blk_submit() if the device cannot queue requests,
+ *		otherwise within blk_poll() or blk_wait()
+ * @priv:	Private data for the submitter
+ * @desc:	Block device the request was submitted to
+ * @result:	Number of blocks transferred, or -ve error number, once @done
+ * @done:	true once the request has completed
+ * @node:	For use by the driver while the request is in flight
+ * @drv_priv:	For use by the driver while the request is in flight
+ */
+struct blk_req {
+	enum blk_req_op op;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	void (*complete)(struct blk_req *req);
+	void *priv;
+
+	struct blk_desc *desc;
+	long result;
+	bool done;
+	struct list_head node;
+	void *drv_priv;
+};
+
 #ifdef CONFIG_BLK
 struct udevice;
 
@@ -235,6 +281,33 @@ struct blk_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
+
+	/**
+	 * submit() - start an asynchronous read or write
+	 *
+	 * The driver queues the request and later completes it by calling
+	 * blk_req_done() from its poll() method. A request which overlaps
+	 * one in flight, where either is a write, must take effect after
+	 * it: the driver may wait for the earlier one here. If this is NULL,
+	 * requests are carried out synchronously with read() and write().
+	 *
+	 * @dev:	Device to read from or write to
+	 * @req:	Request to start
+	 * @return 0 if OK, -ve on error (the request is then not queued)
+	 */
+	int (*submit)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * poll() - complete finished requests
+	 *
+	 * Calls blk_req_done() for each queued request which has finished.
+	 *
+	 * @dev:	Device to check
+	 * @wait:	true to wait until at least one request has finished,
+	 *		if any are queued
+	 * @return number of requests completed, or -ve on error
+	 */
+	int (*poll)(struct udevice *dev, bool wait);
 };
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
@@ -252,6 +325,51 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+/**
+ * blk_submit() - Start an asynchronous read or write
+ *
+ * Reads found in the block cache, and all requests to devices which cannot
+ * queue them, are carried out and completed before this returns.
+ *
+ * @desc:	Block device to read from or write to
+ * @req:	Request to start, see struct blk_req
+ * @return 0 if OK (the request then always completes), -ve on error
+ */
+int blk_submit(struct blk_desc *desc, struct blk_req *req);
+
+/**
+ * blk_poll() - Complete finished requests on a block device
+ *
+ * This calls the completion function of each request which has finished.
+ *
+ * @desc:	Block device to check
+ * @wait:	true to wait until at least one request has finished, if
+ *		any are in flight
+ * @return number of requests completed, or -ve on error
+ */
+int blk_poll(struct blk_desc *desc, bool wait);
+
+/**
+ * blk_wait() - Wait for a request to complete
+ *
+ * Other requests on the same device may complete while waiting.
+ *
+ * @req:	Request to wait for, which must have been submitted
+ * @return number of blocks transferred, or -ve error number
+ */
+long blk_wait(struct blk_req *req);
+
+/**
+ * blk_req_done() - Complete a request
+ *
+ * This is called by drivers from their poll() method. It updates the block
+ * cache and calls the completion function of the request.
+ *
+ * @req:	Request which has finished
+ * @result:	Number of blocks transferred, or -ve error number
+ */
+void blk_req_done(struct blk_req *req, long result);
+
 /**
  * blk_get_device() - Find and probe a block device ready for use
  *
@@ -407,6 +525,33 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
+/* Legacy block devices cannot queue requests: carry them out at once */
+static inline int blk_submit(struct blk_desc *desc, struct blk_req *req)
+{
+	req->desc = desc;
+	if (req->op == BLK_REQ_READ)
+		req->result = blk_dread(desc, req->start, req->blkcnt,
+					req->buffer);
+	else
+		req->result = blk_dwrite(desc, req->start, req->blkcnt,
+					 req->buffer);
+	req->done = true;
+	if (req->complete)
+		req->complete(req);
+
+	return 0;
+}
+
+static inline int blk_poll(struct blk_desc *desc, bool wait)
+{
+	return 0;
+}
+
+static inline long blk_wait(struct blk_req *req)
+{
+	return req->done ? req->result : -EIO;
+}
+
 /**
  * struct blk_driver - Driver for block interface types
  *
@@ -199,6 +199,10 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_SPI,
 	BOOTSTAGE_ID_ACCUM_DECOMP,
 	BOOTSTAGE_ID_FPGA_INIT,
+	BOOTSTAGE_ID_ACCUM_DM_F,
+	BOOTSTAGE_ID_ACCUM_DM_R,
+	BOOTSTAGE_ID_ACCUM_DM_PROBE,
+	BOOTSTAGE_ID_ACCUM_DM_PROBE_BUSY,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -299,6 +303,20 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * Add time to a bootstage activity
+ *
+ * This is for activities which the caller times itself, for example
+ * because several of them overlap and so cannot be bracketed by
+ * bootstage_start() and bootstage_accum().
+ *
+ * @param id		Bootstage id to record this time against
+ * @param name		Textual name to display for this id in the report
+ * @param duration	Time to add, in microseconds
+ */
+void bootstage_accum_time(enum bootstage_id id, const char *name,
+			  uint32_t duration);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
@@ -381,6 +399,11 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline void bootstage_accum_time(enum bootstage_id id,
+					const char *name, uint32_t duration)
+{
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
@@ -17,6 +17,20 @@ extern int u_boot_hush_start(void);
 extern int parse_string_outer(const char *, int);
 extern int parse_file_outer(void);
 
+/**
+ * parse_string_cached() - Run a script held in an environment variable
+ *
+ * This is parse_string_outer() for scripts which are parsed as a whole
+ * (FLAG_CONT_ON_NEWLINE). The parsed script is kept, so running the same
+ * variable again skips parsing until the variable changes.
+ *
+ * @name:	Name of the environment variable
+ * @s:		Its value, the script to run
+ * @flag:	Parse flags, including FLAG_CONT_ON_NEWLINE
+ * @return 0 on success, 1 on failure
+ */
+int parse_string_cached(const char *name, const char *s, int flag);
+
 int set_local_var(const char *s, int flg_export);
 void unset_local_var(const char *name);
 char *get_local_var(const char *s);
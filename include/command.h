@@ -56,6 +56,17 @@ int _do_help (cmd_tbl_t *cmd_start, int cmd_items, cmd_tbl_t * cmdtp, int
 cmd_tbl_t *find_cmd(const char *cmd);
 cmd_tbl_t *find_cmd_tbl (const char *cmd, cmd_tbl_t *table, int table_len);
 
+/**
+ * cmd_index_init() - Build the index used by find_cmd()
+ *
+ * This sorts the command table by name so that find_cmd() can use a binary
+ * search rather than comparing against every command. Until it is called,
+ * or if it fails, find_cmd() searches the table in order.
+ *
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int cmd_index_init(void);
+
 extern int cmd_usage(const cmd_tbl_t *cmdtp);
 
 #ifdef CONFIG_AUTO_COMPLETE
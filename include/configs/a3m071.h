@@ -71,7 +71,6 @@
 						"8M(install)"
 
 #define CONFIG_LZO			/* needed for UBI */
-#define CONFIG_RBTREE			/* needed for UBI */
 #define CONFIG_CMD_MTDPARTS
 #define CONFIG_CMD_UBIFS
 
@@ -245,7 +245,6 @@
 /*
  * UBIFS
  */
-#define CONFIG_RBTREE
 #define CONFIG_LZO
 
 /*
@@ -55,7 +55,6 @@
 #ifdef CONFIG_CMD_NAND
 #define CONFIG_CMD_UBIFS
 #define CONFIG_CMD_MTDPARTS
-#define CONFIG_RBTREE
 #define CONFIG_LZO
 #define CONFIG_MTD_DEVICE
 #define CONFIG_MTD_PARTITIONS
@@ -220,7 +220,6 @@
 #define CONFIG_CMD_MTDPARTS
 #define CONFIG_MTD_PARTITIONS
 #define CONFIG_MTD_DEVICE
-#define CONFIG_RBTREE
 #define CONFIG_CMD_UBIFS
 
 #define CONFIG_HW_WATCHDOG
@@ -100,7 +100,6 @@
 #define CONFIG_MTD_DEVICE
 #define CONFIG_CMD_MTDPARTS
 #define CONFIG_MTD_PARTITIONS
-#define CONFIG_RBTREE
 #define CONFIG_LZO
 #define CONFIG_CMD_UBIFS
 #endif
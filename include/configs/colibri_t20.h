@@ -68,7 +68,6 @@
 /* UBI */
 #define CONFIG_CMD_UBIFS	/* increases size by almost 60 KB */
 #define CONFIG_LZO
-#define CONFIG_RBTREE
 
 /* Debug commands */
 
@@ -191,7 +191,6 @@
 #define MTDPARTS_DEFAULT	"mtdparts=atmel_nand:-(root)"
 #endif
 #define CONFIG_LZO
-#define CONFIG_RBTREE
 
 /* Boot command */
 #define CONFIG_CMDLINE_TAG
@@ -167,7 +167,6 @@
 
 /* UBI */
 # define CONFIG_CMD_UBIFS
-# define CONFIG_RBTREE
 # define CONFIG_LZO
 
 # define CONFIG_APBH_DMA
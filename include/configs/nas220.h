@@ -108,7 +108,6 @@
 #define CONFIG_JFFS2_NAND
 #define CONFIG_JFFS2_LZO
 #define CONFIG_CMD_UBIFS
-#define CONFIG_RBTREE
 #define CONFIG_MTD_DEVICE               /* needed for mtdparts commands */
 #define CONFIG_MTD_PARTITIONS
 #define CONFIG_CMD_MTDPARTS
@@ -75,7 +75,6 @@
 #define CONFIG_NAND_OMAP_GPMC
 
 #define CONFIG_CMD_UBIFS		/* Read-only UBI volume operations */
-#define CONFIG_RBTREE			/* required by CONFIG_CMD_UBI */
 #define CONFIG_LZO			/* required by CONFIG_CMD_UBIFS */
 
 #define CONFIG_SYS_NAND_ADDR		NAND_BASE /* physical address */
@@ -286,7 +286,6 @@ unsigned int cm_get_qspi_controller_clk_hz(void);
 /* UBI and UBIFS support */
 #if defined(CONFIG_CMD_SF) || defined(CONFIG_CMD_NAND)
 #define CONFIG_CMD_UBIFS
-#define CONFIG_RBTREE
 #define CONFIG_LZO
 #endif
 
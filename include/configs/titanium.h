@@ -194,7 +194,6 @@
 #define CONFIG_LZO
 #define CONFIG_MTD_DEVICE
 #define CONFIG_MTD_PARTITIONS
-#define CONFIG_RBTREE
 #define CONFIG_CMD_MTDPARTS
 #define CONFIG_CMD_UBIFS
 
@@ -45,7 +45,6 @@
 
 /* UBI */
 #define CONFIG_CMD_UBIFS
-#define CONFIG_RBTREE
 #define CONFIG_LZO
 
 /* Dynamic MTD partition support */
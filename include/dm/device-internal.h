@@ -89,6 +89,51 @@ int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
  */
 int device_probe(struct udevice *dev);
 
+/**
+ * device_probe_start() - Start probing a device
+ *
+ * This is device_probe() except that it does not wait for a driver with a
+ * probe_complete() method to finish: the device is then left with
+ * DM_FLAG_PROBE_PENDING set, but not DM_FLAG_ACTIVATED, and
+ * device_probe_poll() finishes the probe.
+ * Parents are still probed fully first. Calling device_probe() on a pending
+ * device waits for it.
+ *
+ * @dev: Pointer to device to probe
+ * @return 0 if OK (the probe may still be pending), -ve on error
+ */
+int device_probe_start(struct udevice *dev);
+
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+/**
+ * device_probe_poll() - Check whether a pending probe has finished
+ *
+ * Calls the driver's probe_complete() method and, once that reports the
+ * device ready, finishes the probe as device_probe() would.
+ *
+ * @dev: Device whose probe was started with device_probe_start()
+ * @return 0 if the device is probed (or was not pending), -EAGAIN if it is
+ * still pending, -ETIMEDOUT if it was pending for longer than
+ * CONFIG_DM_PROBE_ASYNC_TIMEOUT, other -ve error if the probe failed
+ */
+int device_probe_poll(struct udevice *dev);
+
+/**
+ * device_probe_list() - Probe several devices, overlapping their probes
+ *
+ * Starts each device once none of its parents has a pending probe, then
+ * polls the pending ones until all are done. The elapsed time is added to
+ * the "dm_probe_list" bootstage record and the sum of the time each device
+ * took to "dm_probe_list_busy", so the difference shows the overlap.
+ *
+ * @devs: Devices to probe
+ * @count: Number of devices
+ * @return 0 if all were probed, else the first error seen (all devices are
+ * still tried)
+ */
+int device_probe_list(struct udevice **devs, int count);
+#endif
+
 /**
  * device_remove() - Remove a device, de-activating it
  *
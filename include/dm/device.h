@@ -46,6 +46,12 @@ struct driver_info;
 
 #define DM_FLAG_OF_PLATDATA		(1 << 8)
 
+/*
+ * Device probe() has returned but probe_complete() has not yet reported the
+ * device ready. DM_FLAG_ACTIVATED is clear until it does
+ */
+#define DM_FLAG_PROBE_PENDING		(1 << 9)
+
 /**
  * struct udevice - An instance of a driver
  *
@@ -87,6 +93,8 @@ struct driver_info;
  *		When CONFIG_DEVRES is enabled, devm_kmalloc() and friends will
  *		add to this list. Memory so-allocated will be freed
  *		automatically when the device is removed / unbound
+ * @probe_start: get_timer() value when probe() returned, while the probe is
+ *		pending (DM_FLAG_PROBE_PENDING)
  */
 struct udevice {
 	const struct driver *driver;
@@ -110,6 +118,9 @@ struct udevice {
 #ifdef CONFIG_DEVRES
 	struct list_head devres_head;
 #endif
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	ulong probe_start;
+#endif
 };
 
 /* Maximum sequence number supported */
@@ -166,6 +177,14 @@ struct udevice_id {
  * for each.
  * @bind: Called to bind a device to its driver
  * @probe: Called to probe a device, i.e. activate it
+ * @probe_complete: If set, called after @probe until it returns something
+ * other than -EAGAIN. This lets @probe start slow hardware work and return,
+ * so that other devices can be probed while it runs. Return 0 once the
+ * device is ready, -EAGAIN while it is not, or another -ve error if the
+ * probe failed, having released anything @probe set up. If the device is
+ * not ready within CONFIG_DM_PROBE_ASYNC_TIMEOUT milliseconds the probe
+ * fails with -ETIMEDOUT and @remove is called to stop the work @probe
+ * started. Needs CONFIG_DM_PROBE_ASYNC.
  * @remove: Called to remove a device, i.e. de-activate it
  * @unbind: Called to unbind a device from its driver
  * @ofdata_to_platdata: Called before probe to decode device tree data
@@ -199,6 +218,9 @@ struct driver {
 	const struct udevice_id *of_match;
 	int (*bind)(struct udevice *dev);
 	int (*probe)(struct udevice *dev);
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	int (*probe_complete)(struct udevice *dev);
+#endif
 	int (*remove)(struct udevice *dev);
 	int (*unbind)(struct udevice *dev);
 	int (*ofdata_to_platdata)(struct udevice *dev);
@@ -32,6 +32,20 @@ struct driver *lists_driver_lookup_name(const char *name);
  */
 struct uclass_driver *lists_uclass_lookup(enum uclass_id id);
 
+/**
+ * lists_driver_lookup_compat() - Find the driver for a compatible string
+ *
+ * This returns the first driver in the linker list whose of_match table
+ * contains @compat. With CONFIG_DM_COMPAT_INDEX this goes through a hash
+ * index which is built on the first call.
+ *
+ * @compat: Compatible string to look up
+ * @of_idp: Returns the matching entry of the driver's of_match table
+ * @return pointer to driver, or NULL if not found
+ */
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **of_idp);
+
 /**
  * lists_bind_drivers() - search for and bind all drivers to parent
  *
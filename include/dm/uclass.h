@@ -252,6 +252,20 @@ int uclass_first_device_err(enum uclass_id id, struct udevice **devp);
  */
 int uclass_next_device(struct udevice **devp);
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+/**
+ * uclass_probe_all() - Probe all devices in a uclass
+ *
+ * The devices are probed with device_probe_list(), so drivers which finish
+ * their probe in the background run at the same time.
+ *
+ * @id: ID of uclass to probe
+ * @return 0 if OK, -ve on error (the first error seen; all devices are
+ * still tried)
+ */
+int uclass_probe_all(enum uclass_id id);
+#endif
+
 /**
  * uclass_resolve_seq() - Resolve a device's sequence number
  *
@@ -10,6 +10,48 @@
 #include <part_efi.h>
 #include <efi_api.h>
 
+/*
+ * The memory map and the block I/O read-ahead are declared in all builds so
+ * that their unit tests can be built on sandbox, where EFI_LOADER is not
+ * available.
+ */
+extern unsigned int __efi_runtime_start, __efi_runtime_stop;
+
+/* Generic EFI memory allocator, call this to get memory */
+void *efi_alloc(uint64_t len, int memory_type);
+/* More specific EFI memory allocator, called by EFI payloads */
+efi_status_t efi_allocate_pages(int type, int memory_type, unsigned long pages,
+				uint64_t *memory);
+/* EFI memory free function. */
+efi_status_t efi_free_pages(uint64_t memory, unsigned long pages);
+/* EFI memory allocator for small allocations */
+efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
+			       void **buffer);
+/* EFI pool memory free function. */
+efi_status_t efi_free_pool(void *buffer);
+/* Returns the EFI memory map */
+efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
+				struct efi_mem_desc *memory_map,
+				unsigned long *map_key,
+				unsigned long *descriptor_size,
+				uint32_t *descriptor_version);
+/* Adds a range into the EFI memory map */
+uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
+			    bool overlap_only_ram);
+/* Called by board init to initialize the EFI memory map */
+int efi_memory_init(void);
+
+struct efi_disk_ra;
+/* Finds or sets up the read-ahead window of a block device, NULL if none */
+struct efi_disk_ra *efi_disk_ra_get(const struct blk_desc *desc);
+/* Drops the blocks held by a window, e.g. after a write; ra may be NULL */
+void efi_disk_ra_invalidate(struct efi_disk_ra *ra);
+/* Drops the blocks held by all windows */
+void efi_disk_ra_invalidate_all(void);
+/* Reads blocks, through the window if ra is not NULL and they fit in it */
+ulong efi_disk_ra_read(struct efi_disk_ra *ra, struct blk_desc *desc,
+		       lbaint_t lba, lbaint_t blocks, void *buffer);
+
 /* No need for efi loader support in SPL */
 #if defined(CONFIG_EFI_LOADER) && !defined(CONFIG_SPL_BUILD)
 
@@ -33,7 +75,6 @@ extern const efi_guid_t efi_guid_console_control;
 extern const efi_guid_t efi_guid_device_path;
 extern const efi_guid_t efi_guid_loaded_image;
 
-extern unsigned int __efi_runtime_start, __efi_runtime_stop;
 extern unsigned int __efi_runtime_rel_start, __efi_runtime_rel_stop;
 
 /*
@@ -114,29 +155,6 @@ void efi_runtime_relocate(ulong offset, struct efi_mem_desc *map);
 /* Call this to set the current device name */
 void efi_set_bootdev(const char *dev, const char *devnr, const char *path);
 
-/* Generic EFI memory allocator, call this to get memory */
-void *efi_alloc(uint64_t len, int memory_type);
-/* More specific EFI memory allocator, called by EFI payloads */
-efi_status_t efi_allocate_pages(int type, int memory_type, unsigned long pages,
-				uint64_t *memory);
-/* EFI memory free function. */
-efi_status_t efi_free_pages(uint64_t memory, unsigned long pages);
-/* EFI memory allocator for small allocations */
-efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
-			       void **buffer);
-/* EFI pool memory free function. */
-efi_status_t efi_free_pool(void *buffer);
-/* Returns the EFI memory map */
-efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
-				struct efi_mem_desc *memory_map,
-				unsigned long *map_key,
-				unsigned long *descriptor_size,
-				uint32_t *descriptor_version);
-/* Adds a range into the EFI memory map */
-uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
-			    bool overlap_only_ram);
-/* Called by board init to initialize the EFI memory map */
-int efi_memory_init(void);
 /* Adds new or overrides configuration table entry to the system table */
 efi_status_t efi_install_configuration_table(const efi_guid_t *guid, void *table);
 
@@ -28,6 +28,7 @@
 			 sizeof(dir_entry))
 
 #define FATBUFBLOCKS	6
+#define FATBUFWINDOWS	4	/* Number of FATBUFBLOCKS windows cached */
 #define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
@@ -160,6 +161,16 @@ typedef struct dir_slot {
 	__u8	name11_12[4];	/* Last 2 characters in name */
 } dir_slot;
 
+/*
+ * A window of FATBUFBLOCKS sectors of the FAT, as cached by get_fatent()
+ */
+struct fat_window {
+	__u8	*buf;		/* FAT sectors */
+	int	num;		/* Window number, -1 if unused */
+	__u8	dirty;		/* Set if buf has been modified */
+	__u32	last_used;	/* Value of fatwin_clock when last used */
+};
+
 /*
  * Private filesystem parameters
  *
@@ -167,16 +178,16 @@ typedef struct dir_slot {
  * (see FAT32 accesses)
  */
 typedef struct {
-	__u8	*fatbuf;	/* Current FAT buffer */
+	__u8	*fatbuf;	/* Buffer for all FAT windows */
 	int	fatsize;	/* Size of FAT in bits */
 	__u32	fatlength;	/* Length of FAT in sectors */
 	__u16	fat_sect;	/* Starting sector of the FAT */
-	__u8	fat_dirty;      /* Set if fatbuf has been modified */
 	__u32	rootdir_sect;	/* Start sector of root directory */
 	__u16	sect_size;	/* Size of sectors in bytes */
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
-	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	struct fat_window fatwin[FATBUFWINDOWS];	/* FAT cache */
+	__u32	fatwin_clock;	/* Incremented on each FAT cache access */
 } fsdata;
 
 typedef int	(file_detectfs_func)(void);
@@ -652,6 +652,34 @@ const char *fdtdec_get_compatible(enum fdt_compat_id id);
  */
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name);
 
+/**
+ * Find the node with a given phandle
+ *
+ * This is equivalent to fdt_node_offset_by_phandle(), but for the control
+ * device tree (gd->fdt_blob) it goes through the phandle cache when
+ * CONFIG_OF_PHANDLE_CACHE is enabled. The cache is built on first use.
+ * Each hit is checked against the blob and a miss falls back to a scan of
+ * the blob. The cache is rebuilt, in place where possible, on a mismatch
+ * or when the scan finds a phandle it lacks, so it stays correct if the
+ * blob is modified.
+ *
+ * @param blob		FDT blob
+ * @param phandle	phandle to look for
+ * @return node offset if found, -FDT_ERR_NOTFOUND if not found, other
+ *	-ve FDT_ERR_... value on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
+/**
+ * Mark the phandle cache of the control device tree as stale
+ *
+ * Lookups check the cache against the blob, but calling this after
+ * changing the control device tree avoids a stale lookup. The cache is
+ * rebuilt on the next lookup, reusing its memory if the table still fits.
+ * It does nothing if CONFIG_OF_PHANDLE_CACHE is not enabled.
+ */
+void fdtdec_phandle_cache_invalidate(void);
+
 /**
  * Look up a property in a node and return its contents in an integer
  * array of given length. The property must have at least enough data for
@@ -292,6 +292,7 @@ enum {
 	IH_COMP_LZMA,			/* lzma  Compression Used	*/
 	IH_COMP_LZO,			/* lzo   Compression Used	*/
 	IH_COMP_LZ4,			/* lz4   Compression Used	*/
+	IH_COMP_ZSTD,			/* zstd  Compression Used	*/
 
 	IH_COMP_COUNT,
 };
@@ -634,6 +635,41 @@ int fit_image_load(bootm_headers_t *images, ulong addr,
 		   enum fit_load_op load_op, ulong *datap, ulong *lenp);
 
 #ifndef USE_HOSTCC
+/**
+ * struct fit_stream - source for FIT images which are only partly in memory
+ *
+ * A FIT built with external data (mkimage -E) can be used without reading
+ * the whole file first: only the FDT part needs to be in memory, and
+ * fit_image_load() reads each sub-image it needs from the stream, hashing it
+ * as it goes, directly to its destination.
+ *
+ * @addr:	Address of the FIT header (the FDT part) in memory
+ * @read:	Read @size bytes from offset @offset in the FIT file into @buf,
+ *		returning 0 on success or a -ve error code
+ * @priv:	Private data for @read
+ * @hdr_size:	Size of the FIT header, set by fit_stream_set()
+ * @hdr_crc:	CRC32 of the FIT header, set by fit_stream_set()
+ */
+struct fit_stream {
+	ulong addr;
+	int (*read)(struct fit_stream *stream, ulong offset, ulong size,
+		    void *buf);
+	void *priv;
+	ulong hdr_size;
+	uint32_t hdr_crc;
+};
+
+/**
+ * fit_stream_set() - set the source of external data for a FIT in memory
+ *
+ * The stream is only used while the FIT header at @stream->addr is left
+ * unchanged, so loading something else there makes it inactive.
+ *
+ * @stream:	Stream to use, or NULL for none
+ * @return 0 if OK, -EINVAL if there is no valid FIT at @stream->addr
+ */
+int fit_stream_set(struct fit_stream *stream);
+
 /**
  * fit_get_node_from_config() - Look up an image a FIT by type
  *
@@ -867,6 +903,7 @@ int bootz_setup(ulong image, ulong *start, ulong *end);
 /* image node */
 #define FIT_DATA_PROP		"data"
 #define FIT_DATA_OFFSET_PROP	"data-offset"
+#define FIT_DATA_POSITION_PROP	"data-position"
 #define FIT_DATA_SIZE_PROP	"data-size"
 #define FIT_TIMESTAMP_PROP	"timestamp"
 #define FIT_DESC_PROP		"description"
@@ -947,6 +984,8 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry);
 int fit_image_get_data(const void *fit, int noffset,
 				const void **data, size_t *size);
 int fit_image_get_data_offset(const void *fit, int noffset, int *data_offset);
+int fit_image_get_data_position(const void *fit, int noffset,
+				int *data_position);
 int fit_image_get_data_size(const void *fit, int noffset, int *data_size);
 
 int fit_image_hash_get_algo(const void *fit, int noffset, char **algo);
@@ -11,6 +11,7 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 
+/* Regions held in struct lmb_region itself; more are allocated as needed */
 #define MAX_LMB_REGIONS 8
 
 struct lmb_property {
@@ -18,10 +19,16 @@ struct lmb_property {
 	phys_size_t size;
 };
 
+/*
+ * Regions are kept sorted by base address and never overlap or touch, so
+ * the one covering an address can be found by binary search.
+ */
 struct lmb_region {
 	unsigned long cnt;
+	unsigned long max;
 	phys_size_t size;
-	struct lmb_property region[MAX_LMB_REGIONS+1];
+	struct lmb_property *region;
+	struct lmb_property initial[MAX_LMB_REGIONS];
 };
 
 struct lmb {
@@ -32,6 +39,16 @@ struct lmb {
 extern struct lmb lmb;
 
 extern void lmb_init(struct lmb *lmb);
+
+/**
+ * lmb_exit() - Release the region storage allocated for an lmb
+ *
+ * lmb_init() does not free storage from an earlier use of @lmb, so call
+ * this before reusing or discarding it. A zeroed @lmb is left alone.
+ *
+ * @lmb:	lmb to release
+ */
+void lmb_exit(struct lmb *lmb);
 extern long lmb_add(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align);
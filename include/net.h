@@ -32,6 +32,8 @@
 
 #ifdef CONFIG_SYS_RX_ETH_BUFFER
 # define PKTBUFSRX	CONFIG_SYS_RX_ETH_BUFFER
+#elif defined(CONFIG_NET_RX_RING_SIZE)
+# define PKTBUFSRX	CONFIG_NET_RX_RING_SIZE
 #else
 # define PKTBUFSRX	4
 #endif
@@ -103,6 +105,32 @@ struct eth_pdata {
 	int max_speed;
 };
 
+/**
+ * struct eth_stats - Packet counters of an Ethernet device
+ *
+ * The uclass counts the packets passed to and from the network stack, and
+ * the network stack counts those it discards as truncated or corrupt. A
+ * driver adds the packets it loses itself, see eth_get_stats().
+ *
+ * @rx_packets: Packets passed to the network stack
+ * @rx_bytes: Bytes in those packets
+ * @rx_dropped: Packets lost or discarded: those passed to the network stack
+ *	with a truncated header or a bad IP or UDP checksum, plus those the
+ *	driver lost, including the ones counted in @rx_overruns
+ * @rx_overruns: Packets the driver lost because every receive buffer was in
+ *	use
+ * @tx_packets: Packets sent
+ * @tx_bytes: Bytes in those packets
+ */
+struct eth_stats {
+	ulong rx_packets;
+	ulong rx_bytes;
+	ulong rx_dropped;
+	ulong rx_overruns;
+	ulong tx_packets;
+	ulong tx_bytes;
+};
+
 enum eth_recv_flags {
 	/*
 	 * Check hardware device for new packets (otherwise only return those
@@ -160,6 +188,18 @@ struct udevice *eth_get_dev(void); /* get the current device */
 struct udevice *eth_get_dev_by_name(const char *devname);
 unsigned char *eth_get_ethaddr(void); /* get the current device MAC */
 
+/**
+ * eth_get_stats() - Get the packet counters of an Ethernet device
+ *
+ * Drivers add the packets they lose to rx_dropped, and those lost to a full
+ * receive ring to rx_overruns as well. The other counters are kept by the
+ * uclass and the network stack.
+ *
+ * @dev:	Ethernet device
+ * @return pointer to the counters, which are zeroed when the device is probed
+ */
+struct eth_stats *eth_get_stats(struct udevice *dev);
+
 /* Used only when NetConsole is enabled */
 int eth_is_active(struct udevice *dev); /* Test device for active state */
 int eth_init_state_only(void); /* Set active state */
@@ -542,7 +582,7 @@ extern int		net_restart_wrap;	/* Tried all network devices */
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL
+	TFTPSRV, TFTPPUT, LINKLOCAL, WGET
 };
 
 extern char	net_boot_file_name[1024];/* Boot File name */
@@ -664,6 +704,17 @@ static inline void net_send_packet(uchar *pkt, int len)
 	(void) eth_send(pkt, len);
 }
 
+/*
+ * Transmit "net_tx_packet", which holds a complete IP packet, performing ARP
+ * request if needed (ether will be populated)
+ *
+ * @param ether Raw packet buffer
+ * @param dest IP address to send the packet to
+ * @param pkt_size Length of the packet, including the Ethernet header
+ * @return 0 if transmitted, 1 if waiting for the ARP reply
+ */
+int net_send_ip_packet(uchar *ether, struct in_addr dest, int pkt_size);
+
 /*
  * Transmit "net_tx_packet" as UDP packet, performing ARP request if needed
  *  (ether will be populated)
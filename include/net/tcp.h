@@ -0,0 +1,127 @@
+/*
+ * Minimal TCP client
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+#define IPPROTO_TCP	6	/* Transmission Control Protocol	*/
+
+/*
+ *	Internet Protocol (IP) + TCP header. The sequence and acknowledgment
+ *	numbers are not 32-bit aligned in a received frame, use the
+ *	unaligned accessors on them.
+ */
+struct ip_tcp_hdr {
+	u8		ip_hl_v;	/* header length and version	*/
+	u8		ip_tos;		/* type of service		*/
+	u16		ip_len;		/* total length			*/
+	u16		ip_id;		/* identification		*/
+	u16		ip_off;		/* fragment offset field	*/
+	u8		ip_ttl;		/* time to live			*/
+	u8		ip_p;		/* protocol			*/
+	u16		ip_sum;		/* checksum			*/
+	struct in_addr	ip_src;		/* Source IP address		*/
+	struct in_addr	ip_dst;		/* Destination IP address	*/
+	u16		tcp_src;	/* TCP source port		*/
+	u16		tcp_dst;	/* TCP destination port		*/
+	u32		tcp_seq;	/* Sequence number		*/
+	u32		tcp_ack;	/* Acknowledgment number	*/
+	u8		tcp_hlen;	/* Header length in words << 4	*/
+	u8		tcp_flags;	/* Control bits			*/
+	u16		tcp_win;	/* Receive window		*/
+	u16		tcp_xsum;	/* Checksum			*/
+	u16		tcp_urg;	/* Urgent pointer		*/
+};
+
+#define IP_TCP_HDR_SIZE		(sizeof(struct ip_tcp_hdr))
+#define TCP_HDR_SIZE		(IP_TCP_HDR_SIZE - IP_HDR_SIZE)
+
+#define TCP_FIN		0x01
+#define TCP_SYN		0x02
+#define TCP_RST		0x04
+#define TCP_PSH		0x08
+#define TCP_ACK		0x10
+
+enum tcp_event {
+	TCP_EVENT_CONNECTED,	/* Handshake done, data can be sent */
+	TCP_EVENT_CLOSED,	/* The peer has sent all its data */
+	TCP_EVENT_RESET,	/* Connection refused or reset by the peer */
+	TCP_EVENT_TIMEOUT,	/* The peer stopped responding */
+	TCP_EVENT_FINISHED,	/* Both sides closed, our FIN acknowledged */
+};
+
+/**
+ * tcp_rx_handler - Receive data from the connection
+ *
+ * Data is passed up in order, each byte once.
+ *
+ * @data:	Received bytes
+ * @len:	Number of bytes
+ */
+typedef void tcp_rx_handler(const uchar *data, unsigned int len);
+
+/**
+ * tcp_event_handler - Be told about a change in the connection state
+ *
+ * @event:	What happened
+ */
+typedef void tcp_event_handler(enum tcp_event event);
+
+/**
+ * tcp_connect() - Open a connection
+ *
+ * Sends the SYN and returns; @event is called with TCP_EVENT_CONNECTED
+ * once the server has answered. Only one connection is open at a time, an
+ * earlier one is forgotten. The retransmission timer uses the net_loop()
+ * timeout handler, so the caller must not set its own.
+ *
+ * @dest:	Server IP address
+ * @dport:	Server port
+ * @rx:		Handler for received data
+ * @event:	Handler for state changes
+ * @return 0 if OK, -ENOMEM if the receive buffer cannot be allocated
+ */
+int tcp_connect(struct in_addr dest, int dport, tcp_rx_handler *rx,
+		tcp_event_handler *event);
+
+/**
+ * tcp_send() - Queue data to send on the connection
+ *
+ * @data:	Bytes to send
+ * @len:	Number of bytes
+ * @return number of bytes queued, which is less than @len if the send
+ * buffer is full, or -ENOTCONN if the connection is not open
+ */
+int tcp_send(const void *data, int len);
+
+/**
+ * tcp_close() - Close the connection once queued data has been sent
+ *
+ * Data can still be received until the peer closes its side. @event is
+ * called with TCP_EVENT_FINISHED once both sides have closed.
+ */
+void tcp_close(void);
+
+/**
+ * tcp_abort() - Drop the connection, sending a reset to the peer
+ *
+ * net_loop() calls this when it ends, so that a connection never outlives
+ * the command which opened it. A connection which has finished closing is
+ * dropped without a reset.
+ */
+void tcp_abort(void);
+
+/**
+ * tcp_receive() - Handle a received TCP segment
+ *
+ * Segments which do not belong to the open connection are ignored.
+ *
+ * @tcp:	IP packet holding the segment
+ * @len:	Length of the IP packet
+ */
+void tcp_receive(struct ip_tcp_hdr *tcp, unsigned int len);
+
+#endif /* __TCP_H__ */
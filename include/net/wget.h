@@ -0,0 +1,30 @@
+/*
+ * HTTP/1.1 download over TCP
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __WGET_H__
+#define __WGET_H__
+
+#define HTTP_SERVICE_PORT	80
+
+/* wget.c */
+void wget_start(void);	/* Begin HTTP GET */
+
+/**
+ * wget_set_file() - Write the next download to a file
+ *
+ * Instead of being kept in memory, the file is written through fs_write()
+ * as it arrives, using CONFIG_WGET_FS_BUF_SIZE bytes at the load address as
+ * a buffer. Only filesystems which can write at an offset can take a file
+ * larger than the buffer.
+ *
+ * @ifname:	Interface name, e.g. "mmc"
+ * @dev_part:	Device and partition, e.g. "0:1"
+ * @filename:	File to write, or NULL to load into memory again
+ */
+void wget_set_file(const char *ifname, const char *dev_part,
+		   const char *filename);
+
+#endif /* __WGET_H__ */
@@ -92,6 +92,52 @@ int os_close(int fd);
  */
 int os_unlink(const char *pathname);
 
+/**
+ * Start an asynchronous read or write on a file
+ *
+ * This uses the host's POSIX AIO, so the transfer runs on a host thread.
+ *
+ * \param fd		File descriptor as returned by os_open()
+ * \param write		true to write to the file, false to read from it
+ * \param offset	Offset into the file in bytes
+ * \param buf		Buffer to read into or write from
+ * \param count		Number of bytes to transfer
+ * \param handlep	Returns the handle to pass to os_aio_finish()
+ * \return 0 if OK, -ve error number on error
+ */
+int os_aio_start(int fd, bool write, off_t offset, void *buf, size_t count,
+		 void **handlep);
+
+/**
+ * Check whether an asynchronous read or write has finished
+ *
+ * Once the transfer has finished the handle is freed.
+ *
+ * \param handle	Handle returned by os_aio_start()
+ * \param wait		true to wait for the transfer to finish
+ * \return number of bytes transferred, -EINPROGRESS if the transfer is
+ * still running (only if !wait), or other -ve error number
+ */
+ssize_t os_aio_finish(void *handle, bool wait);
+
+/**
+ * Run a function for each index in a range, on several host threads
+ *
+ * The indexes are handed out one at a time to whichever thread is free, so
+ * func() must not touch any U-Boot state other than what arg points to: in
+ * particular it must not print or allocate memory. This returns when every
+ * call has finished. If threads cannot be created, fewer are used.
+ *
+ * \param func		Function to call, with arg and an index from 0 to
+ *			count - 1
+ * \param arg		Argument to pass to func
+ * \param count		Number of calls to make
+ * \param threads	Maximum number of threads to use, including the
+ *			calling one
+ */
+void os_run_parallel(void (*func)(void *arg, int index), void *arg,
+		     int count, int threads);
+
 /**
  * Access to the OS exit() system call
  *
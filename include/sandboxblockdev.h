@@ -13,6 +13,9 @@ struct host_block_dev {
 #endif
 	char *filename;
 	int fd;
+#ifdef CONFIG_BLK
+	struct list_head reqs;	/* Requests in flight (struct blk_req) */
+#endif
 };
 
 int host_dev_bind(int dev, char *filename);
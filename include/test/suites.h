@@ -8,8 +8,15 @@
 #ifndef __TEST_SUITES_H__
 #define __TEST_SUITES_H__
 
+int do_ut_cmd_lookup(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[]);
+int do_ut_crc32(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_dm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_efi_disk(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_efi_memory(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[]);
 int do_ut_env(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_lmb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_time(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
@@ -19,6 +19,22 @@ void sha256_starts(sha256_context * ctx);
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length);
 void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 
+/**
+ * sha256_arch_process() - hash whole blocks using CPU-specific instructions
+ *
+ * Architectures with SHA-256 instructions can provide this to take over
+ * from the generic C code. It should check at run time that the CPU
+ * actually implements them.
+ *
+ * @state:	Hash state to update (sha256_context.state)
+ * @data:	Input data, which need not be aligned
+ * @blocks:	Number of 64-byte blocks to process
+ * @return 0 if the blocks were processed, -ENOSYS if the generic code
+ * should be used instead
+ */
+int sha256_arch_process(uint32_t state[8], const uint8_t *data,
+			unsigned int blocks);
+
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
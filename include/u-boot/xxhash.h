@@ -0,0 +1,33 @@
+/*
+ * xxHash - Extremely Fast Hash algorithm
+ * Copyright (C) 2012-2016, Yann Collet.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+ BSD-2-Clause
+ */
+
+#ifndef _XXHASH_H
+#define _XXHASH_H
+
+#include <linux/types.h>
+
+/**
+ * xxh32() - calculate the 32-bit xxHash of a buffer
+ *
+ * @input:	Data to hash
+ * @length:	Number of bytes to hash
+ * @seed:	Seed value, 0 for the value used by the LZ4 and zstd formats
+ * @return 32-bit hash
+ */
+uint32_t xxh32(const void *input, size_t length, uint32_t seed);
+
+/**
+ * xxh64() - calculate the 64-bit xxHash of a buffer
+ *
+ * @input:	Data to hash
+ * @length:	Number of bytes to hash
+ * @seed:	Seed value, 0 for the value used by the zstd format
+ * @return 64-bit hash
+ */
+uint64_t xxh64(const void *input, size_t length, uint64_t seed);
+
+#endif /* _XXHASH_H */
@@ -0,0 +1,74 @@
+/*
+ * Running independent jobs on several CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __WORKQ_H
+#define __WORKQ_H
+
+/**
+ * struct workq_job - one job for workq_run()
+ *
+ * The job function may run on another CPU at the same time as other jobs.
+ * It must only use the memory that @arg gives it, must not call into
+ * drivers and must not print or allocate memory.
+ *
+ * @func:	Function to run
+ * @arg:	Argument to pass to @func
+ * @ret:	Set to the return value of @func
+ */
+struct workq_job {
+	int (*func)(void *arg);
+	void *arg;
+	int ret;
+};
+
+/**
+ * workq_run() - Run jobs, in parallel where the architecture allows
+ *
+ * This returns when all the jobs have finished. If the architecture has no
+ * arch_workq_run(), or only one CPU is in use, the jobs run one after
+ * another on this CPU.
+ *
+ * @jobs:	Jobs to run
+ * @count:	Number of jobs
+ * @return 0 if all jobs returned 0, else the return value of the first
+ * job, in array order, that failed
+ */
+int workq_run(struct workq_job *jobs, int count);
+
+/**
+ * workq_cpus() - Get the number of CPUs workq_run() uses
+ *
+ * Callers can use this to decide how to split up their work.
+ *
+ * @return number of CPUs, 1 if jobs do not run in parallel
+ */
+int workq_cpus(void);
+
+/**
+ * workq_set_cpus() - Set the number of CPUs workq_run() uses
+ *
+ * This is mostly useful for comparing the speed of code with and without
+ * parallel jobs. It is limited to CONFIG_WORKQ_CPUS.
+ *
+ * @cpus:	Number of CPUs to use
+ * @return previous number of CPUs
+ */
+int workq_set_cpus(int cpus);
+
+/**
+ * arch_workq_run() - Run jobs on several CPUs
+ *
+ * Architectures which can run code on other CPUs provide this. The default
+ * runs the jobs one after another. This must set the @ret member of every
+ * job.
+ *
+ * @jobs:	Jobs to run
+ * @count:	Number of jobs
+ * @cpus:	Maximum number of CPUs to use, including this one
+ */
+void arch_workq_run(struct workq_job *jobs, int count, int cpus);
+
+#endif
@@ -33,6 +33,8 @@ struct efi_disk_obj {
 	lbaint_t offset;
 	/* Internal block device */
 	const struct blk_desc *desc;
+	/* Read-ahead state, NULL if disabled */
+	struct efi_disk_ra *ra;
 };
 
 static efi_status_t EFIAPI efi_disk_open_block(void *handle,
@@ -93,10 +95,12 @@ static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 	if (buffer_size & (blksz - 1))
 		return EFI_EXIT(EFI_DEVICE_ERROR);
 
-	if (direction == EFI_DISK_READ)
-		n = blk_dread(desc, lba, blocks, buffer);
-	else
+	if (direction == EFI_DISK_READ) {
+		n = efi_disk_ra_read(diskobj->ra, desc, lba, blocks, buffer);
+	} else {
+		efi_disk_ra_invalidate(diskobj->ra);
 		n = blk_dwrite(desc, lba, blocks, buffer);
+	}
 
 	/* We don't do interrupts, so check for timers cooperatively */
 	efi_timer_check();
@@ -220,6 +224,7 @@ static void efi_disk_add_dev(const char *name,
 	diskobj->dev_index = dev_index;
 	diskobj->offset = offset;
 	diskobj->desc = desc;
+	diskobj->ra = efi_disk_ra_get(desc);
 
 	/* Fill in EFI IO Media info (for read/write callbacks) */
 	diskobj->media.removable_media = desc->removable;
@@ -288,7 +293,14 @@ int efi_disk_register(void)
 	int disks = 0;
 #ifdef CONFIG_BLK
 	struct udevice *dev;
+#else
+	int i, if_type;
+#endif
 
+	/* The disks may have been written since the last EFI payload ran */
+	efi_disk_ra_invalidate_all();
+
+#ifdef CONFIG_BLK
 	for (uclass_first_device(UCLASS_BLK, &dev);
 	     dev;
 	     uclass_next_device(&dev)) {
@@ -307,8 +319,6 @@ int efi_disk_register(void)
 						  desc->devnum, dev->name);
 	}
 #else
-	int i, if_type;
-
 	/* Search for all available disk devices */
 	for (if_type = 0; if_type < IF_TYPE_COUNT; if_type++) {
 		const struct blk_driver *cur_drvr;
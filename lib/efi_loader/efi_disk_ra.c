@@ -0,0 +1,108 @@
+/*
+ *  EFI block I/O read-ahead
+ *
+ *  SPDX-License-Identifier:     GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <efi_loader.h>
+#include <malloc.h>
+
+/*
+ * Read-ahead state of a block device, shared by all EFI disks on it so that
+ * a write through one of them is seen by the others.
+ */
+struct efi_disk_ra {
+	struct efi_disk_ra *next;
+	const struct blk_desc *desc;
+	/* Buffer holding up to window blocks */
+	void *buf;
+	lbaint_t window;
+	/* Blocks held in buf, starting at block start */
+	lbaint_t start;
+	lbaint_t count;
+};
+
+static struct efi_disk_ra *efi_disk_ra_list;
+
+struct efi_disk_ra *efi_disk_ra_get(const struct blk_desc *desc)
+{
+	struct efi_disk_ra *ra;
+	lbaint_t window;
+
+	if (!desc->blksz)
+		return NULL;
+	window = CONFIG_EFI_LOADER_DISK_READAHEAD * 1024 / desc->blksz;
+
+	if (!window)
+		return NULL;
+
+	for (ra = efi_disk_ra_list; ra; ra = ra->next) {
+		if (ra->desc == desc)
+			break;
+	}
+
+	if (!ra) {
+		ra = calloc(1, sizeof(*ra));
+		if (!ra)
+			return NULL;
+		ra->desc = desc;
+		ra->next = efi_disk_ra_list;
+		efi_disk_ra_list = ra;
+	} else if (ra->window == window) {
+		return ra;
+	}
+
+	/* New, or the descriptor now belongs to a device with another blksz */
+	free(ra->buf);
+	ra->count = 0;
+	ra->window = 0;
+	ra->buf = memalign(ARCH_DMA_MINALIGN, window * desc->blksz);
+	if (!ra->buf)
+		return NULL;
+	ra->window = window;
+
+	return ra;
+}
+
+void efi_disk_ra_invalidate(struct efi_disk_ra *ra)
+{
+	if (ra)
+		ra->count = 0;
+}
+
+void efi_disk_ra_invalidate_all(void)
+{
+	struct efi_disk_ra *ra;
+
+	for (ra = efi_disk_ra_list; ra; ra = ra->next)
+		ra->count = 0;
+}
+
+ulong efi_disk_ra_read(struct efi_disk_ra *ra, struct blk_desc *desc,
+		       lbaint_t lba, lbaint_t blocks, void *buffer)
+{
+	lbaint_t count;
+
+	if (!ra || blocks >= ra->window)
+		return blk_dread(desc, lba, blocks, buffer);
+
+	if (lba < ra->start || lba + blocks > ra->start + ra->count) {
+		ra->count = 0;
+		/* Past the end, let the device report the error */
+		if (lba >= desc->lba)
+			return blk_dread(desc, lba, blocks, buffer);
+		count = min(ra->window, desc->lba - lba);
+		if (count < blocks ||
+		    blk_dread(desc, lba, count, ra->buf) != count)
+			return blk_dread(desc, lba, blocks, buffer);
+		ra->start = lba;
+		ra->count = count;
+	}
+
+	memcpy(buffer, ra->buf + (lba - ra->start) * desc->blksz,
+	       blocks * desc->blksz);
+
+	return blocks;
+}
@@ -11,23 +11,28 @@
 #include <malloc.h>
 #include <asm/global_data.h>
 #include <libfdt_env.h>
-#include <linux/list_sort.h>
+#include <linux/list.h>
+#include <linux/rbtree_augmented.h>
 #include <inttypes.h>
 #include <watchdog.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/*
+ * The memory map is a red-black tree of non-overlapping entries sorted by
+ * address. Each node also records the largest free (conventional memory)
+ * entry in its subtree, so that allocations can skip subtrees which have
+ * no room.
+ */
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
 	struct efi_mem_desc desc;
+	u64 max_free;		/* Largest free entry in this subtree, pages */
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/* This tree contains all memory map items */
+static struct rb_root efi_mem = RB_ROOT;
+static int efi_mem_count;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -40,6 +45,9 @@ void *efi_bounce_buffer;
  * EFI requires 8 byte alignment for pool allocations, so we can
  * prepend each allocation with an 64 bit header tracking the
  * allocation size, and hand out the remainder to the caller.
+ *
+ * Small requests instead get a slot in a pool page, see efi_pool_alloc().
+ * Their header holds 0.
  */
 struct efi_pool_allocation {
 	u64 num_pages;
@@ -47,113 +55,188 @@ struct efi_pool_allocation {
 };
 
 /*
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * A page shared by small pool allocations of one memory type and size
+ * class. The slots follow this header; slots are never page aligned, page
+ * allocations always are, which tells efi_free_pool() which it was given.
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+struct efi_pool_page {
+	struct list_head link;	/* In efi_pool_partial while a slot is free */
+	void *free;		/* First free slot, linked through their data */
+	u32 memory_type;
+	u16 class;
+	u16 used;
+};
+
+#define EFI_POOL_MIN_SHIFT	6	/* Smallest slot is 64 bytes */
+#define EFI_POOL_CLASSES	5	/* Largest slot is 1024 bytes */
+#define EFI_POOL_SLOTS_START	ALIGN(sizeof(struct efi_pool_page), 8)
+
+/* Pool pages with free slots, by memory type and size class */
+static struct list_head efi_pool_partial[EFI_MAX_MEMORY_TYPE][EFI_POOL_CLASSES];
+
+static u64 efi_mem_end(struct efi_mem_desc *desc)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
+	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
+}
 
-	if (mema->desc.physical_start == memb->desc.physical_start)
+static u64 efi_mem_free_pages(struct efi_mem_list *mem)
+{
+	if (mem->desc.type != EFI_CONVENTIONAL_MEMORY)
 		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+
+	return mem->desc.num_pages;
 }
 
-static void efi_mem_sort(void)
+static u64 efi_mem_compute_max(struct efi_mem_list *mem)
 {
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
+	u64 max_free = efi_mem_free_pages(mem);
+	struct efi_mem_list *child;
+
+	if (mem->node.rb_left) {
+		child = rb_entry(mem->node.rb_left, struct efi_mem_list, node);
+		max_free = max(max_free, child->max_free);
+	}
+	if (mem->node.rb_right) {
+		child = rb_entry(mem->node.rb_right, struct efi_mem_list, node);
+		max_free = max(max_free, child->max_free);
+	}
+
+	return max_free;
 }
 
-/*
- * Unmaps all memory occupied by the carve_desc region from the
- * list entry pointed to by map.
- *
- * Returns EFI_CARVE_NO_OVERLAP if the regions don't overlap.
- * Returns EFI_CARVE_OVERLAPS_NONRAM if the carve and map overlap,
- *    and the map contains anything but free ram.
- *    (only when overlap_only_ram is true)
- * Returns EFI_CARVE_LOOP_AGAIN if the mapping list should be traversed
- *    again, as it has been altered
- * Returns the number of overlapping pages. The pages are removed from
- *     the mapping list.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to readd the already carved out pages to the mapping.
- */
-static int efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+RB_DECLARE_CALLBACKS(static, efi_mem_cb, struct efi_mem_list, node, u64,
+		     max_free, efi_mem_compute_max)
+
+static struct efi_mem_list *efi_mem_next(struct efi_mem_list *mem)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
+	struct rb_node *node = rb_next(&mem->node);
+
+	return node ? rb_entry(node, struct efi_mem_list, node) : NULL;
+}
+
+/* Returns the entry holding addr, or else the first one above it */
+static struct efi_mem_list *efi_mem_lookup(u64 addr)
+{
+	struct rb_node *node = efi_mem.rb_node;
+	struct efi_mem_list *found = NULL;
+
+	while (node) {
+		struct efi_mem_list *mem;
+
+		mem = rb_entry(node, struct efi_mem_list, node);
+		if (addr < mem->desc.physical_start) {
+			found = mem;
+			node = node->rb_left;
+		} else if (addr < efi_mem_end(&mem->desc)) {
+			return mem;
 		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+			node = node->rb_right;
 		}
+	}
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+	return found;
+}
+
+static void efi_mem_insert(struct efi_mem_list *mem)
+{
+	struct rb_node **link = &efi_mem.rb_node, *parent = NULL;
+	u64 start = mem->desc.physical_start;
+	u64 max_free = efi_mem_free_pages(mem);
+
+	while (*link) {
+		struct efi_mem_list *entry;
+
+		parent = *link;
+		entry = rb_entry(parent, struct efi_mem_list, node);
+		entry->max_free = max(entry->max_free, max_free);
+		if (start < entry->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
 	}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+	mem->max_free = max_free;
+	rb_link_node(&mem->node, parent, link);
+	rb_insert_augmented(&mem->node, &efi_mem, &efi_mem_cb);
+	efi_mem_count++;
+}
+
+static void efi_mem_remove(struct efi_mem_list *mem)
+{
+	rb_erase_augmented(&mem->node, &efi_mem, &efi_mem_cb);
+	efi_mem_count--;
+	free(mem);
+}
+
+/* Sets the range of an entry, which must stay between its neighbours */
+static void efi_mem_resize(struct efi_mem_list *mem, u64 start, u64 end)
+{
+	mem->desc.physical_start = start;
+	mem->desc.virtual_start = start;
+	mem->desc.num_pages = (end - start) >> EFI_PAGE_SHIFT;
+	efi_mem_cb_propagate(&mem->node, NULL);
+}
+
+/*
+ * Unmaps [start, end) from all entries, trimming, splitting or removing
+ * those it overlaps.
+ */
+static void efi_mem_carve_out(u64 start, u64 end)
+{
+	struct efi_mem_list *mem, *next, *tail;
+
+	for (mem = efi_mem_lookup(start);
+	     mem && mem->desc.physical_start < end; mem = next) {
+		u64 map_start = mem->desc.physical_start;
+		u64 map_end = efi_mem_end(&mem->desc);
+
+		next = efi_mem_next(mem);
+		if (map_start < start && map_end > end) {
+			/* [ mem | carve | tail ] */
+			tail = calloc(1, sizeof(*tail));
+			tail->desc = mem->desc;
+			efi_mem_resize(tail, end, map_end);
+			efi_mem_resize(mem, map_start, start);
+			efi_mem_insert(tail);
+			break;
+		} else if (map_start < start) {
+			efi_mem_resize(mem, map_start, start);
+		} else if (map_end > end) {
+			efi_mem_resize(mem, end, map_end);
+		} else {
+			efi_mem_remove(mem);
+		}
+	}
+}
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+/* Returns true if [start, end) is entirely covered by free RAM */
+static bool efi_mem_is_free(u64 start, u64 end)
+{
+	struct efi_mem_list *mem = efi_mem_lookup(start);
+	u64 addr = start;
+
+	for (; mem && addr < end; mem = efi_mem_next(mem)) {
+		if (mem->desc.physical_start > addr ||
+		    mem->desc.type != EFI_CONVENTIONAL_MEMORY)
+			return false;
+		addr = efi_mem_end(&mem->desc);
+	}
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+	return addr >= end;
+}
 
-	return EFI_CARVE_LOOP_AGAIN;
+static bool efi_mem_can_merge(struct efi_mem_list *mem,
+			      struct efi_mem_desc *desc)
+{
+	return mem && mem->desc.type == EFI_CONVENTIONAL_MEMORY &&
+	       mem->desc.attribute == desc->attribute;
 }
 
 uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 			    bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	struct efi_mem_list *newlist, *prev, *next;
+	uint64_t end = start + (pages << EFI_PAGE_SHIFT);
 
 	debug("%s: 0x%" PRIx64 " 0x%" PRIx64 " %d %s\n", __func__,
 	      start, pages, memory_type, overlap_only_ram ? "yes" : "no");
@@ -161,6 +244,14 @@ uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 	if (!pages)
 		return start;
 
+	/*
+	 * The user requested to only have RAM overlaps, but the range holds
+	 * something else or is not fully mapped. Error out, leaving the map
+	 * as it was.
+	 */
+	if (overlap_only_ram && !efi_mem_is_free(start, end))
+		return 0;
+
 	newlist = calloc(1, sizeof(*newlist));
 	newlist->desc.type = memory_type;
 	newlist->desc.physical_start = start;
@@ -181,100 +272,81 @@ uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			int r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return 0;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
+	efi_mem_carve_out(start, end);
 
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return 0;
+	if (memory_type != EFI_CONVENTIONAL_MEMORY) {
+		efi_mem_insert(newlist);
+		return start;
 	}
 
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/* Merge free memory with free neighbours */
+	prev = start ? efi_mem_lookup(start - 1) : NULL;
+	if (prev && efi_mem_end(&prev->desc) != start)
+		prev = NULL;
+	next = efi_mem_lookup(end);
+	if (next && next->desc.physical_start != end)
+		next = NULL;
+	if (!efi_mem_can_merge(prev, &newlist->desc))
+		prev = NULL;
+	if (!efi_mem_can_merge(next, &newlist->desc))
+		next = NULL;
+
+	if (prev && next) {
+		end = efi_mem_end(&next->desc);
+		efi_mem_remove(next);
+		efi_mem_resize(prev, prev->desc.physical_start, end);
+	} else if (prev) {
+		efi_mem_resize(prev, prev->desc.physical_start, end);
+	} else if (next) {
+		efi_mem_resize(next, start, efi_mem_end(&next->desc));
+	} else {
+		efi_mem_insert(newlist);
+		return start;
+	}
+	free(newlist);
 
 	return start;
 }
 
-static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
+/* Returns the highest free address of len bytes below max_addr, or 0 */
+static uint64_t efi_mem_find_free(struct rb_node *node, uint64_t len,
+				  uint64_t max_addr)
 {
-	struct list_head *lhandle;
-
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
-
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
-
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
-
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
-
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
-
-		/* Return the highest address in this map within bounds */
-		return ret;
+	uint64_t pages = len >> EFI_PAGE_SHIFT;
+
+	while (node) {
+		struct efi_mem_list *lmem;
+		struct efi_mem_desc *desc;
+		uint64_t curmax, ret;
+
+		lmem = rb_entry(node, struct efi_mem_list, node);
+		desc = &lmem->desc;
+		if (lmem->max_free < pages)
+			return 0;
+
+		/* Take the highest address, so look above this entry first */
+		if (desc->physical_start < max_addr) {
+			ret = efi_mem_find_free(node->rb_right, len, max_addr);
+			if (ret)
+				return ret;
+
+			/* We only take memory from free RAM */
+			curmax = min(max_addr, efi_mem_end(desc));
+			if (desc->type == EFI_CONVENTIONAL_MEMORY &&
+			    curmax - desc->physical_start >= len)
+				return curmax - len;
+		}
+		node = node->rb_left;
 	}
 
 	return 0;
 }
 
+static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
+{
+	return efi_mem_find_free(efi_mem.rb_node, len, max_addr);
+}
+
 efi_status_t efi_allocate_pages(int type, int memory_type,
 				unsigned long pages, uint64_t *memory)
 {
@@ -343,7 +415,6 @@ efi_status_t efi_free_pages(uint64_t memory, unsigned long pages)
 	uint64_t r = 0;
 
 	r = efi_add_memory_map(memory, pages, EFI_CONVENTIONAL_MEMORY, false);
-	/* Merging of adjacent free regions is missing */
 
 	if (r == memory)
 		return EFI_SUCCESS;
@@ -351,11 +422,93 @@ efi_status_t efi_free_pages(uint64_t memory, unsigned long pages)
 	return EFI_NOT_FOUND;
 }
 
+/*
+ * Hands out a slot from a pool page of the right memory type and size
+ * class, setting aside a new page if none has a free slot. Returns NULL if
+ * the request is too large for a slot or no page is available.
+ */
+static struct efi_pool_allocation *efi_pool_alloc(int pool_type,
+						  unsigned long size)
+{
+	unsigned long need = size + sizeof(struct efi_pool_allocation);
+	struct efi_pool_allocation *alloc;
+	struct efi_pool_page *page;
+	struct list_head *head;
+	efi_physical_addr_t t;
+	unsigned long slot_size;
+	char *slot;
+	int class;
+
+	if (pool_type < 0 || pool_type >= EFI_MAX_MEMORY_TYPE)
+		return NULL;
+	for (class = 0; class < EFI_POOL_CLASSES; class++) {
+		if (need <= 1UL << (EFI_POOL_MIN_SHIFT + class))
+			break;
+	}
+	if (class == EFI_POOL_CLASSES)
+		return NULL;
+	slot_size = 1UL << (EFI_POOL_MIN_SHIFT + class);
+
+	head = &efi_pool_partial[pool_type][class];
+	if (!head->next)
+		INIT_LIST_HEAD(head);
+	if (list_empty(head)) {
+		if (efi_allocate_pages(0, pool_type, 1, &t) != EFI_SUCCESS)
+			return NULL;
+		page = (void *)(uintptr_t)t;
+		page->free = NULL;
+		page->memory_type = pool_type;
+		page->class = class;
+		page->used = 0;
+		for (slot = (char *)page + EFI_POOL_SLOTS_START;
+		     slot + slot_size <= (char *)page + EFI_PAGE_SIZE;
+		     slot += slot_size) {
+			alloc = (void *)slot;
+			*(void **)alloc->data = page->free;
+			page->free = alloc;
+		}
+		list_add(&page->link, head);
+	}
+
+	page = list_first_entry(head, struct efi_pool_page, link);
+	alloc = page->free;
+	page->free = *(void **)alloc->data;
+	page->used++;
+	if (!page->free)
+		list_del(&page->link);
+	alloc->num_pages = 0;
+
+	return alloc;
+}
+
+static efi_status_t efi_pool_free(struct efi_pool_allocation *alloc)
+{
+	struct efi_pool_page *page;
+
+	page = (void *)((uintptr_t)alloc & ~EFI_PAGE_MASK);
+	if (alloc->num_pages || !page->used)
+		return EFI_INVALID_PARAMETER;
+
+	if (!page->free)
+		list_add(&page->link,
+			 &efi_pool_partial[page->memory_type][page->class]);
+	*(void **)alloc->data = page->free;
+	page->free = alloc;
+	if (--page->used)
+		return EFI_SUCCESS;
+
+	/* Last slot in use, give the page back */
+	list_del(&page->link);
+
+	return efi_free_pages((uintptr_t)page, 1);
+}
+
 efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
 			       void **buffer)
 {
 	efi_status_t r;
 	efi_physical_addr_t t;
+	struct efi_pool_allocation *alloc;
 	u64 num_pages = (size + sizeof(u64) + EFI_PAGE_MASK) >> EFI_PAGE_SHIFT;
 
 	if (size == 0) {
@@ -363,10 +516,16 @@ efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
 		return EFI_SUCCESS;
 	}
 
+	alloc = efi_pool_alloc(pool_type, size);
+	if (alloc) {
+		*buffer = alloc->data;
+		return EFI_SUCCESS;
+	}
+
 	r = efi_allocate_pages(0, pool_type, num_pages, &t);
 
 	if (r == EFI_SUCCESS) {
-		struct efi_pool_allocation *alloc = (void *)(uintptr_t)t;
+		alloc = (void *)(uintptr_t)t;
 		alloc->num_pages = num_pages;
 		*buffer = alloc->data;
 	}
@@ -380,8 +539,9 @@ efi_status_t efi_free_pool(void *buffer)
 	struct efi_pool_allocation *alloc;
 
 	alloc = container_of(buffer, struct efi_pool_allocation, data);
-	/* Sanity check, was the supplied address returned by allocate_pool */
-	assert(((uintptr_t)alloc & EFI_PAGE_MASK) == 0);
+	/* Slots in pool pages are never page aligned */
+	if ((uintptr_t)alloc & EFI_PAGE_MASK)
+		return efi_pool_free(alloc);
 
 	r = efi_free_pages((uintptr_t)alloc, alloc->num_pages);
 
@@ -395,13 +555,10 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 			       uint32_t *descriptor_version)
 {
 	ulong map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	int map_entries = efi_mem_count;
+	struct rb_node *node;
 	unsigned long provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
 	map_size = map_entries * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
@@ -415,16 +572,13 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 	if (provided_map_size < map_size)
 		return EFI_BUFFER_TOO_SMALL;
 
-	/* Copy list into array */
+	/* Copy tree into array, in ascending order */
 	if (memory_map) {
-		/* Return the list in ascending order */
-		memory_map = &memory_map[map_entries - 1];
-		list_for_each(lhandle, &efi_mem) {
+		for (node = rb_first(&efi_mem); node; node = rb_next(node)) {
 			struct efi_mem_list *lmem;
 
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			*memory_map = lmem->desc;
-			memory_map--;
+			lmem = rb_entry(node, struct efi_mem_list, node);
+			*memory_map++ = lmem->desc;
 		}
 	}
 
@@ -11,6 +11,7 @@
 #include <libfdt.h>
 #include <fdt_support.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <asm/sections.h>
 #include <linux/ctype.h>
 
@@ -608,6 +609,138 @@ int fdtdec_prepare_fdt(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+/*
+ * Node offsets in the control device tree, indexed by phandle. dtc numbers
+ * phandles from 1 without gaps, so a plain array does the job. If the
+ * phandles are too sparse for that, max_phandle is 0 and lookups scan the
+ * blob as before.
+ *
+ * The table is allocated once and refilled in place when the blob changes,
+ * since before relocation free() does not give memory back. It is only
+ * reallocated if the blob gains phandles beyond its size.
+ */
+struct fdtdec_phandle_cache {
+	const void *blob;	/* Blob the cache was built for, NULL if stale */
+	uint32_t max_phandle;	/* Highest phandle in offset[], or 0 */
+	uint32_t size;		/* Number of entries in offset[] */
+	int offset[0];		/* Node offset for each phandle, -1 if none */
+};
+
+static bool phandle_cache_can_alloc(void)
+{
+#ifdef CONFIG_SYS_MALLOC_F_LEN
+	return true;
+#else
+	return gd->flags & GD_FLG_FULL_MALLOC_INIT;
+#endif
+}
+
+/*
+ * (Re)build the cache for 'blob' in gd->fdt_phandle_cache, if there is
+ * memory for it, and return the offset of the node with 'phandle' found
+ * while doing so.
+ */
+static int phandle_cache_build(const void *blob, uint32_t phandle)
+{
+	struct fdtdec_phandle_cache *cache = gd->fdt_phandle_cache;
+	uint32_t ph, max_phandle = 0, count = 0;
+	int offset, found = -FDT_ERR_NOTFOUND;
+
+	for (offset = fdt_next_node(blob, -1, NULL);
+	     offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		ph = fdt_get_phandle(blob, offset);
+		if (!ph || ph == (uint32_t)-1)
+			continue;
+		if (ph == phandle && found < 0)
+			found = offset;
+		max_phandle = max(max_phandle, ph);
+		count++;
+	}
+	if (offset != -FDT_ERR_NOTFOUND)
+		return offset;	/* error from fdt_next_node() */
+
+	if (max_phandle > count * 2 + 16)
+		max_phandle = 0;
+	if (!cache || cache->size < max_phandle + 1) {
+		free(cache);
+		gd->fdt_phandle_cache = NULL;
+		cache = malloc(sizeof(*cache) +
+			       (max_phandle + 1) * sizeof(int));
+		if (!cache)
+			return found;
+		cache->size = max_phandle + 1;
+		gd->fdt_phandle_cache = cache;
+	}
+	cache->blob = blob;
+	cache->max_phandle = max_phandle;
+	memset(cache->offset, 0xff, (max_phandle + 1) * sizeof(int));
+
+	for (offset = fdt_next_node(blob, -1, NULL);
+	     offset >= 0 && max_phandle;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		ph = fdt_get_phandle(blob, offset);
+		/* like fdt_node_offset_by_phandle(), the first node wins */
+		if (ph && ph <= max_phandle && cache->offset[ph] < 0)
+			cache->offset[ph] = offset;
+	}
+	debug("%s: %u phandles, max %u\n", __func__, count, max_phandle);
+
+	return found;
+}
+#endif
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+	struct fdtdec_phandle_cache *cache = gd->fdt_phandle_cache;
+	int offset, ret;
+
+	if (blob != gd->fdt_blob || !phandle || phandle == (uint32_t)-1 ||
+	    !phandle_cache_can_alloc())
+		return fdt_node_offset_by_phandle(blob, phandle);
+
+	if (cache && cache->blob == blob) {
+		if (!cache->max_phandle)
+			return fdt_node_offset_by_phandle(blob, phandle);
+		offset = phandle <= cache->max_phandle ?
+			cache->offset[phandle] : -1;
+		if (offset >= 0) {
+			if (fdt_get_phandle(blob, offset) == phandle)
+				return offset;
+			/* The blob has changed since the cache was built */
+		} else {
+			/*
+			 * Not in the table: only rebuild it if the blob has
+			 * gained the phandle since, so that looking up a
+			 * missing phandle does not rebuild it every time
+			 */
+			offset = fdt_node_offset_by_phandle(blob, phandle);
+			if (offset < 0)
+				return offset;
+		}
+	}
+
+	ret = fdt_check_header(blob);
+	if (ret)
+		return ret;
+
+	return phandle_cache_build(blob, phandle);
+#else
+	return fdt_node_offset_by_phandle(blob, phandle);
+#endif
+}
+
+void fdtdec_phandle_cache_invalidate(void)
+{
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+	/* Keep the memory, so that the next build can reuse it */
+	if (gd->fdt_phandle_cache)
+		gd->fdt_phandle_cache->blob = NULL;
+#endif
+}
+
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 {
 	const u32 *phandle;
@@ -618,7 +751,7 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -746,8 +879,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_node_offset_by_phandle(blob,
+								     phandle);
 				if (!node) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
@@ -14,6 +14,7 @@
 #include <memalign.h>
 #include <u-boot/zlib.h>
 #include <div64.h>
+#include <linux/math64.h>
 
 #define HEADER0			'\x1f'
 #define HEADER1			'\x8b'
@@ -72,9 +73,12 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 }
 
 #ifdef CONFIG_CMD_UNZIP
+static ulong gzwrite_start;
+
 __weak
 void gzwrite_progress_init(u64 expectedsize)
 {
+	gzwrite_start = get_timer(0);
 	putc('\n');
 }
 
@@ -94,9 +98,18 @@ void gzwrite_progress_finish(int returnval,
 			     u32 expected_crc,
 			     u32 calculated_crc)
 {
+	ulong time = get_timer(gzwrite_start);
+
 	if (0 == returnval) {
 		printf("\n\t%llu bytes, crc 0x%08x\n",
 		       total_bytes, calculated_crc);
+		printf("\t%llu bytes written in %lu ms", total_bytes, time);
+		if (time > 0) {
+			puts(" (");
+			print_size(div_u64(total_bytes, time) * 1000, "/s");
+			puts(")");
+		}
+		putc('\n');
 	} else {
 		printf("\n\tuncompressed %llu of %llu\n"
 		       "\tcrcs == 0x%08x/0x%08x\n",
@@ -195,6 +208,11 @@ int gzwrite(unsigned char *src, int len,
 	s.next_in = src + i;
 	s.avail_in = payload_size+8;
 	writebuf = (unsigned char *)malloc_cache_aligned(szwritebuf);
+	if (!writebuf) {
+		printf("%s: out of memory\n", __func__);
+		r = -1;
+		goto out;
+	}
 
 	/* decompress until deflate stream ends or end of file */
 	do {
@@ -235,6 +253,13 @@ int gzwrite(unsigned char *src, int len,
 					 szexpected);
 			blocks_written = blk_dwrite(dev, outblock,
 						    writeblocks, writebuf);
+			if (blocks_written != writeblocks) {
+				printf("%s: writing " LBAFU " blocks at "
+				       LBAFU ": %lu\n", __func__, writeblocks,
+				       outblock, blocks_written);
+				r = -1;
+				goto out;
+			}
 			outblock += blocks_written;
 			if (ctrlc()) {
 				puts("abort\n");
@@ -8,7 +8,9 @@
  */
 
 #include <common.h>
+#include <errno.h>
 #include <lmb.h>
+#include <malloc.h>
 
 #define LMB_ALLOC_ANYWHERE	0
 
@@ -41,135 +43,138 @@ void lmb_dump_all(struct lmb *lmb)
 #endif /* DEBUG */
 }
 
-static long lmb_addrs_overlap(phys_addr_t base1,
-		phys_size_t size1, phys_addr_t base2, phys_size_t size2)
+/*
+ * Last address in a region. Using this rather than base + size keeps the
+ * comparisons right for a region which ends at the top of the address space.
+ */
+static phys_addr_t lmb_last(struct lmb_property *r)
 {
-	return ((base1 < (base2+size2)) && (base2 < (base1+size1)));
+	return r->base + r->size - 1;
 }
 
-static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
-		phys_addr_t base2, phys_size_t size2)
+/*
+ * Return the index of the first region which ends at or above @base - 1,
+ * i.e. the first one that could overlap or touch a region starting at
+ * @base, or rgn->cnt if there is none.
+ */
+static unsigned long lmb_search(struct lmb_region *rgn, phys_addr_t base)
 {
-	if (base2 == base1 + size1)
-		return 1;
-	else if (base1 == base2 + size2)
-		return -1;
+	unsigned long lo = 0, hi = rgn->cnt;
 
-	return 0;
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
+
+		if (base && lmb_last(&rgn->region[mid]) < base - 1)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+/* Make room for one more region, moving off the initial array if needed */
+static int lmb_grow(struct lmb_region *rgn)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
+	unsigned long max = rgn->max * 2;
+	struct lmb_property *region;
+
+	if (rgn->region == rgn->initial) {
+		region = malloc(max * sizeof(*region));
+		if (region)
+			memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	} else {
+		region = realloc(rgn->region, max * sizeof(*region));
+	}
+	if (!region)
+		return -ENOMEM;
+	rgn->region = region;
+	rgn->max = max;
 
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+	return 0;
 }
 
-static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+static long lmb_insert_region(struct lmb_region *rgn, unsigned long i,
+			      phys_addr_t base, phys_size_t size)
 {
-	unsigned long i;
+	if (rgn->cnt == rgn->max && lmb_grow(rgn))
+		return -1;
 
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-	}
-	rgn->cnt--;
+	memmove(&rgn->region[i + 1], &rgn->region[i],
+		(rgn->cnt - i) * sizeof(*rgn->region));
+	rgn->region[i].base = base;
+	rgn->region[i].size = size;
+	rgn->cnt++;
+
+	return 0;
 }
 
-/* Assumption: base addr of region 1 < base addr of region 2 */
-static void lmb_coalesce_regions(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+static void lmb_remove_regions(struct lmb_region *rgn, unsigned long r,
+			       unsigned long count)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
-	lmb_remove_region(rgn, r2);
+	memmove(&rgn->region[r], &rgn->region[r + count],
+		(rgn->cnt - r - count) * sizeof(*rgn->region));
+	rgn->cnt -= count;
 }
 
-void lmb_init(struct lmb *lmb)
+static void lmb_init_region(struct lmb_region *rgn)
 {
-	/* Create a dummy zero size LMB which will get coalesced away later.
-	 * This simplifies the lmb_add() code below...
-	 */
-	lmb->memory.region[0].base = 0;
-	lmb->memory.region[0].size = 0;
-	lmb->memory.cnt = 1;
-	lmb->memory.size = 0;
-
-	/* Ditto. */
-	lmb->reserved.region[0].base = 0;
-	lmb->reserved.region[0].size = 0;
-	lmb->reserved.cnt = 1;
-	lmb->reserved.size = 0;
+	rgn->region = rgn->initial;
+	rgn->max = MAX_LMB_REGIONS;
+	rgn->cnt = 0;
+	rgn->size = 0;
 }
 
-/* This routine called with relocation disabled. */
-static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
+void lmb_init(struct lmb *lmb)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
-
-	if ((rgn->cnt == 1) && (rgn->region[0].size == 0)) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		return 0;
-	}
+	lmb_init_region(&lmb->memory);
+	lmb_init_region(&lmb->reserved);
+}
 
-	/* First try and coalesce this LMB with another. */
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
+static void lmb_exit_region(struct lmb_region *rgn)
+{
+	if (rgn->region && rgn->region != rgn->initial)
+		free(rgn->region);
+	lmb_init_region(rgn);
+}
 
-		if ((rgnbase == base) && (rgnsize == size))
-			/* Already have this region, so we're done */
-			return 0;
+void lmb_exit(struct lmb *lmb)
+{
+	lmb_exit_region(&lmb->memory);
+	lmb_exit_region(&lmb->reserved);
+}
 
-		adjacent = lmb_addrs_adjacent(base,size,rgnbase,rgnsize);
-		if ( adjacent > 0 ) {
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-		else if ( adjacent < 0 ) {
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-	}
+/*
+ * Add a region, merging it with any it overlaps or touches. Returns the
+ * number of existing regions it was merged with, or -1 if the region could
+ * not be stored.
+ */
+static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
+{
+	phys_addr_t last = base + size - 1;
+	unsigned long i, j;
 
-	if ((i < rgn->cnt-1) && lmb_regions_adjacent(rgn, i, i+1) ) {
-		lmb_coalesce_regions(rgn, i, i+1);
-		coalesced++;
-	}
+	if (!size)
+		return 0;
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= MAX_LMB_REGIONS)
-		return -1;
+	i = lmb_search(rgn, base);
+	for (j = i; j < rgn->cnt; j++) {
+		phys_addr_t rgnbase = rgn->region[j].base;
 
-	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i+1].base = rgn->region[i].base;
-			rgn->region[i+1].size = rgn->region[i].size;
-		} else {
-			rgn->region[i+1].base = base;
-			rgn->region[i+1].size = size;
+		if (rgnbase && rgnbase - 1 > last)
 			break;
-		}
-	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
 	}
+	if (j == i)
+		return lmb_insert_region(rgn, i, base, size);
 
-	rgn->cnt++;
+	/* Regions i to j - 1 overlap or touch the new one, so merge them */
+	base = min(base, rgn->region[i].base);
+	last = max(last, lmb_last(&rgn->region[j - 1]));
+	rgn->region[i].base = base;
+	rgn->region[i].size = last - base + 1;
+	lmb_remove_regions(rgn, i + 1, j - i - 1);
 
-	return 0;
+	return j - i;
 }
 
 /* This routine may be called with relocation disabled. */
@@ -180,43 +185,56 @@ long lmb_add(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	return lmb_add_region(_rgn, base, size);
 }
 
-long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
+/* Return the index of a region overlapping (base, size), or -1 if none */
+static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
+				phys_size_t size)
 {
-	struct lmb_region *rgn = &(lmb->reserved);
-	phys_addr_t rgnbegin, rgnend;
-	phys_addr_t end = base + size;
-	int i;
+	unsigned long i;
 
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	if (!size)
+		return -1;
 
-	/* Find the region where (base, size) belongs to */
-	for (i=0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size;
+	i = lmb_search(rgn, base);
+	/* Skip a region which only ends just below base */
+	if (i < rgn->cnt && base && lmb_last(&rgn->region[i]) == base - 1)
+		i++;
+	if (i < rgn->cnt && rgn->region[i].base <= base + size - 1)
+		return i;
 
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	return -1;
+}
+
+long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
+{
+	struct lmb_region *rgn = &(lmb->reserved);
+	phys_addr_t rgnbegin, rgnlast;
+	phys_addr_t last = base + size - 1;
+	long i;
 
-	/* Didn't find the region */
-	if (i == rgn->cnt)
+	/* Find the region where (base, size) belongs to */
+	i = lmb_overlaps_region(rgn, base, size);
+	if (i < 0)
+		return -1;
+	rgnbegin = rgn->region[i].base;
+	rgnlast = lmb_last(&rgn->region[i]);
+	if (base < rgnbegin || last > rgnlast)
 		return -1;
 
 	/* Check to see if we are removing entire region */
-	if ((rgnbegin == base) && (rgnend == end)) {
-		lmb_remove_region(rgn, i);
+	if ((rgnbegin == base) && (rgnlast == last)) {
+		lmb_remove_regions(rgn, i, 1);
 		return 0;
 	}
 
 	/* Check to see if region is matching at the front */
 	if (rgnbegin == base) {
-		rgn->region[i].base = end;
+		rgn->region[i].base = last + 1;
 		rgn->region[i].size -= size;
 		return 0;
 	}
 
 	/* Check to see if the region is matching at the end */
-	if (rgnend == end) {
+	if (rgnlast == last) {
 		rgn->region[i].size -= size;
 		return 0;
 	}
@@ -226,7 +244,7 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	 * beginging of the hole and add the region after hole.
 	 */
 	rgn->region[i].size = base - rgn->region[i].base;
-	return lmb_add_region(rgn, end, rgnend - end);
+	return lmb_insert_region(rgn, i + 1, last + 1, rgnlast - last);
 }
 
 long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
@@ -236,22 +254,6 @@ long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	return lmb_add_region(_rgn, base, size);
 }
 
-static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
-				phys_size_t size)
-{
-	unsigned long i;
-
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if ( lmb_addrs_overlap(base,size,rgnbase,rgnsize) ) {
-			break;
-		}
-	}
-
-	return (i < rgn->cnt) ? i : -1;
-}
-
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
 {
 	return lmb_alloc_base(lmb, size, align, LMB_ALLOC_ANYWHERE);
@@ -324,15 +326,7 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
-
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return 1;
-	}
-	return 0;
+	return lmb_overlaps_region(&lmb->reserved, addr, 1) >= 0;
 }
 
 __weak void board_lmb_reserve(struct lmb *lmb)
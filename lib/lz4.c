@@ -97,6 +97,10 @@ FORCE_INLINE int LZ4_decompress_generic(
     const int safeDecode = (endOnInput==endOnInputSize);
     const int checkOffset = ((safeDecode) && (dictSize < (int)(64 KB)));
 
+    /* Limits for the shortcut below, from later releases */
+    const BYTE* const shortiend = iend - 14 /*maxLL*/ - 2 /*offset*/;
+    BYTE* const shortoend = oend - 14 /*maxLL*/ - 18 /*maxML*/;
+
 
     /* Special cases */
     if ((partialDecoding) && (oexit> oend-MFLIMIT)) oexit = oend-MFLIMIT;                         /* targetOutputSize too high => decode everything */
@@ -113,7 +117,44 @@ FORCE_INLINE int LZ4_decompress_generic(
 
         /* get literal length */
         token = *ip++;
-        if ((length=(token>>ML_BITS)) == RUN_MASK)
+        length = token>>ML_BITS;
+
+        /*
+         * A two-stage shortcut for the most common case: up to 14 literals
+         * and a match of up to 18 bytes which does not overlap itself.
+         * Copy a fixed 16 bytes of literals and 18 bytes of match rather
+         * than the exact lengths. The check on entry leaves room for both.
+         */
+        if ((endOnInput) && (!partialDecoding) && (length != RUN_MASK)
+            && likely((ip < shortiend) & (op <= shortoend)))
+        {
+            size_t offset;
+
+            /* Copy the literals */
+            LZ4_copy8(op, ip);
+            LZ4_copy8(op+8, ip+8);
+            op += length; ip += length;
+
+            /* Decode the match, which the slow path can use if need be */
+            length = token & ML_MASK;
+            offset = LZ4_readLE16(ip); ip+=2;
+            match = op - offset;
+
+            if ((length != ML_MASK) && (offset >= 8)
+                && (dict==withPrefix64k || match >= lowPrefix))
+            {
+                LZ4_copy8(op, match);
+                LZ4_copy8(op+8, match+8);
+                /* bytes, as they may have just been written as a U64 */
+                op[16] = match[16];
+                op[17] = match[17];
+                op += length + MINMATCH;
+                continue;
+            }
+            goto _copy_match;
+        }
+
+        if (length == RUN_MASK)
         {
             unsigned s;
             do
@@ -151,10 +192,12 @@ FORCE_INLINE int LZ4_decompress_generic(
 
         /* get offset */
         match = cpy - LZ4_readLE16(ip); ip+=2;
-        if ((checkOffset) && (unlikely(match < lowLimit))) goto _output_error;   /* Error : offset outside destination buffer */
 
         /* get matchlength */
         length = token & ML_MASK;
+
+_copy_match:
+        if ((checkOffset) && (unlikely(match < lowLimit))) goto _output_error;   /* Error : offset outside destination buffer */
         if (length == ML_MASK)
         {
             unsigned s;
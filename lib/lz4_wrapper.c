@@ -8,6 +8,10 @@
 #include <compiler.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
+#include <malloc.h>
+#include <workq.h>
+#include <asm/unaligned.h>
+#include <u-boot/xxhash.h>
 
 static u16 LZ4_readLE16(const void *src) { return le16_to_cpu(*(u16 *)src); }
 static void LZ4_copy4(void *dst, const void *src) { *(u32 *)dst = *(u32 *)src; }
@@ -21,7 +25,10 @@ typedef uint64_t U64;
 
 #define FORCE_INLINE static inline __attribute__((always_inline))
 
-/* Unaltered (except removing unrelated code) from github.com/Cyan4973/lz4. */
+/*
+ * From github.com/Cyan4973/lz4, with unrelated code removed and the
+ * decoding shortcut of later releases added.
+ */
 #include "lz4.c"	/* #include for inlining, do not link! */
 
 #define LZ4F_MAGIC 0x184D2204
@@ -31,7 +38,8 @@ struct lz4_frame_header {
 	union {
 		u8 flags;
 		struct {
-			u8 reserved0:2;
+			u8 has_dict_id:1;
+			u8 reserved0:1;
 			u8 has_content_checksum:1;
 			u8 has_content_size:1;
 			u8 has_block_checksum:1;
@@ -48,6 +56,7 @@ struct lz4_frame_header {
 		};
 	};
 	/* + u64 content_size iff has_content_size is set */
+	/* + u32 dict_id iff has_dict_id is set */
 	/* + u8 header_checksum */
 } __packed;
 
@@ -63,43 +72,53 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
-int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
-{
-	const void *end = dst + *dstn;
-	const void *in = src;
-	void *out = dst;
-	int has_block_checksum;
-	int ret;
-	*dstn = 0;
+/* After the end mark: + u32 content_checksum iff has_content_checksum */
 
-	{ /* With in-place decompression the header may become invalid later. */
-		const struct lz4_frame_header *h = in;
+/* Output size of every block but the last, for block size id 4 to 7 */
+#define LZ4F_BLOCK_SIZE(id)	(1 << (2 * (id) + 8))
 
-		if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
-			return -EINVAL;	/* input overrun */
+/**
+ * struct lz4_part - a run of blocks decoded by lz4_decode_blocks()
+ *
+ * @in:		Header of the first block, updated as blocks are decoded
+ * @in_end:	End of the input
+ * @out:	Output for the first block, updated as blocks are decoded
+ * @end:	End of the output buffer
+ * @prefix:	Start of the output of the frame, which matches may refer to
+ *		if the blocks are linked; NULL if they are independent
+ * @blocks:	Number of blocks to decode, or -1 to decode up to the end mark
+ * @block_size:	If not 0, each block except the last block of the frame
+ *		must decode to exactly this size
+ * @has_block_checksum: Each block is followed by a checksum
+ */
+struct lz4_part {
+	const void *in;
+	const void *in_end;
+	void *out;
+	const void *end;
+	const void *prefix;
+	int blocks;
+	size_t block_size;
+	int has_block_checksum;
+};
 
-		/* We assume there's always only a single, standard frame. */
-		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
-			return -EPROTONOSUPPORT;	/* unknown format */
-		if (h->reserved0 || h->reserved1 || h->reserved2)
-			return -EINVAL;	/* reserved must be zero */
-		if (!h->independent_blocks)
-			return -EPROTONOSUPPORT; /* we can't support this yet */
-		has_block_checksum = h->has_block_checksum;
-
-		in += sizeof(*h);
-		if (h->has_content_size)
-			in += sizeof(u64);
-		in += sizeof(u8);
-	}
+/* Returns 0 when all blocks are done or the end mark is reached */
+static int lz4_decode_blocks(struct lz4_part *p)
+{
+	const void *in = p->in;
+	void *out = p->out;
+	int ret = 0;
+	int i;
 
-	while (1) {
+	for (i = 0; i != p->blocks; i++) {
 		struct lz4_block_header b;
+		ptrdiff_t avail = p->end - out;
+		size_t size;
 
 		b.raw = le32_to_cpu(*(u32 *)in);
 		in += sizeof(struct lz4_block_header);
 
-		if (in - src + b.size > srcn) {
+		if (b.size > p->in_end - in) {
 			ret = -EINVAL;		/* input overrun */
 			break;
 		}
@@ -109,8 +128,24 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 			break;
 		}
 
+		if (p->has_block_checksum) {
+			if (b.size + sizeof(u32) > p->in_end - in) {
+				ret = -EINVAL;	/* input overrun */
+				break;
+			}
+			if (get_unaligned_le32(in + b.size) !=
+			    xxh32(in, b.size, 0)) {
+				ret = -EPROTO;	/* block checksum error */
+				break;
+			}
+		}
+
+		/* Keep parts decoded at the same time apart */
+		if (p->block_size)
+			avail = min(avail, (ptrdiff_t)p->block_size);
+
 		if (b.not_compressed) {
-			size_t size = min((ptrdiff_t)b.size, end - out);
+			size = min((ptrdiff_t)b.size, avail);
 			memcpy(out, in, size);
 			out += size;
 			if (size < b.size) {
@@ -120,20 +155,192 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		} else {
 			/* constant folding essential, do not touch params! */
 			ret = LZ4_decompress_generic(in, out, b.size,
-					end - out, endOnInputSize,
-					full, 0, noDict, out, NULL, 0);
+					avail, endOnInputSize,
+					full, 0, noDict,
+					p->prefix ? p->prefix : out, NULL, 0);
 			if (ret < 0) {
 				ret = -EPROTO;	/* decompression error */
 				break;
 			}
-			out += ret;
+			size = ret;
+			ret = 0;
+			out += size;
 		}
 
 		in += b.size;
-		if (has_block_checksum)
+		if (p->has_block_checksum)
 			in += sizeof(u32);
+
+		/* Only the last block of the frame may be short */
+		if (p->block_size && size != p->block_size && *(u32 *)in) {
+			ret = -EAGAIN;
+			break;
+		}
+	}
+
+	p->in = in;
+	p->out = out;
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(WORKQ)
+static int lz4_decode_part(void *arg)
+{
+	return lz4_decode_blocks(arg);
+}
+
+/*
+ * With independent blocks, every block but the last decodes to the maximum
+ * block size, so its place in the output is known before the blocks in
+ * front of it are decoded. The blocks are split into one run per CPU.
+ *
+ * On success this updates frame as lz4_decode_blocks() would. It returns
+ * -EAGAIN if the frame is not suitable, or anything goes wrong, leaving
+ * the caller to decode it one block at a time. That also gives the same
+ * error and output size as before for a bad frame.
+ */
+static int lz4_decode_parallel(struct lz4_part *frame, int block_size_id)
+{
+	const void *in = frame->in, *in_end = frame->in_end;
+	void *dst = frame->out;
+	const void *end = frame->end;
+	size_t block_size = LZ4F_BLOCK_SIZE(block_size_id);
+	int has_block_checksum = frame->has_block_checksum;
+	struct workq_job *jobs;
+	struct lz4_part *parts;
+	const void *p;
+	int nblocks, nparts;
+	int i, block, ret;
+
+	if (block_size_id < 4 || workq_cpus() < 2)
+		return -EAGAIN;
+	/* In-place decompression needs the blocks decoded in order */
+	if (in < end && in_end > dst)
+		return -EAGAIN;
+
+	/* Find the number of blocks, walking the block headers */
+	nblocks = 0;
+	for (p = in; p + sizeof(u32) <= in_end && *(u32 *)p; nblocks++) {
+		p += sizeof(u32) + (le32_to_cpu(*(u32 *)p) & 0x7fffffff);
+		if (has_block_checksum)
+			p += sizeof(u32);
 	}
+	if (nblocks < 2 || p + sizeof(u32) > in_end)
+		return -EAGAIN;
+
+	nparts = min(nblocks, workq_cpus());
+	parts = malloc(nparts * (sizeof(*parts) + sizeof(*jobs)));
+	if (!parts)
+		return -EAGAIN;
+	jobs = (struct workq_job *)(parts + nparts);
+
+	p = in;
+	block = 0;
+	for (i = 0; i < nparts; i++) {
+		struct lz4_part *part = &parts[i];
+		int next = (i + 1) * nblocks / nparts;
+
+		*part = *frame;
+		part->in = p;
+		part->out = dst + block * block_size;
+		part->blocks = next - block;
+		part->block_size = block_size;
+		jobs[i].func = lz4_decode_part;
+		jobs[i].arg = part;
+
+		for (; block < next; block++) {
+			p += sizeof(u32) + (le32_to_cpu(*(u32 *)p) &
+					    0x7fffffff);
+			if (has_block_checksum)
+				p += sizeof(u32);
+		}
+	}
+
+	/* The output of the last block must fit in the buffer */
+	ret = -EAGAIN;
+	if (parts[nparts - 1].out < end) {
+		ret = workq_run(jobs, nparts);
+		if (!ret) {
+			frame->in = p + sizeof(u32);
+			frame->out = parts[nparts - 1].out;
+		} else {
+			debug("%s: parallel decode failed (%d)\n", __func__,
+			      ret);
+			ret = -EAGAIN;
+		}
+	}
+	free(parts);
 
-	*dstn = out - dst;
 	return ret;
 }
+#endif
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	struct lz4_part part;
+	int has_content_checksum;
+	int has_content_size;
+	u64 content_size = 0;
+	int block_size_id __maybe_unused;
+	int ret;
+
+	part.in = src;
+	part.in_end = src + srcn;
+	part.out = dst;
+	part.end = dst + *dstn;
+	part.blocks = -1;
+	part.block_size = 0;
+
+	{ /* With in-place decompression the header may become invalid later. */
+		const struct lz4_frame_header *h = part.in;
+
+		if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
+			return -EINVAL;	/* input overrun */
+
+		/* We assume there's always only a single, standard frame. */
+		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
+			return -EPROTONOSUPPORT;	/* unknown format */
+		if (h->reserved0 || h->reserved1 || h->reserved2)
+			return -EINVAL;	/* reserved must be zero */
+		if (h->has_dict_id)
+			return -EPROTONOSUPPORT; /* we have no dictionaries */
+		part.prefix = h->independent_blocks ? NULL : dst;
+		part.has_block_checksum = h->has_block_checksum;
+		has_content_checksum = h->has_content_checksum;
+		has_content_size = h->has_content_size;
+		block_size_id = h->max_block_size;
+
+		part.in += sizeof(*h);
+		if (has_content_size) {
+			content_size = get_unaligned_le64(part.in);
+			part.in += sizeof(u64);
+		}
+		if (*(u8 *)part.in !=
+		    (u8)(xxh32(&h->flags, part.in - (void *)&h->flags, 0) >> 8))
+			return -EPROTO;	/* header checksum error */
+		part.in += sizeof(u8);
+	}
+
+	ret = -EAGAIN;
+#if CONFIG_IS_ENABLED(WORKQ)
+	if (!part.prefix)
+		ret = lz4_decode_parallel(&part, block_size_id);
+#endif
+	if (ret == -EAGAIN)
+		ret = lz4_decode_blocks(&part);
+	*dstn = part.out - dst;
+	if (ret)
+		return ret;
+
+	if (has_content_size && *dstn != content_size)
+		return -EPROTO;	/* wrong content size */
+	if (has_content_checksum) {
+		if (part.in + sizeof(u32) > part.in_end)
+			return -EINVAL;	/* input overrun */
+		if (get_unaligned_le32(part.in) != xxh32(dst, *dstn, 0))
+			return -EPROTO;	/* content checksum error */
+	}
+
+	return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Running independent jobs on several CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <workq.h>
+
+static int workq_ncpus = CONFIG_WORKQ_CPUS;
+
+static void workq_run_serial(struct workq_job *jobs, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		jobs[i].ret = jobs[i].func(jobs[i].arg);
+}
+
+__weak void arch_workq_run(struct workq_job *jobs, int count, int cpus)
+{
+	workq_run_serial(jobs, count);
+}
+
+int workq_run(struct workq_job *jobs, int count)
+{
+	int i;
+
+	if (count > 1 && workq_ncpus > 1)
+		arch_workq_run(jobs, count, workq_ncpus);
+	else
+		workq_run_serial(jobs, count);
+
+	for (i = 0; i < count; i++) {
+		if (jobs[i].ret)
+			return jobs[i].ret;
+	}
+
+	return 0;
+}
+
+int workq_cpus(void)
+{
+	return workq_ncpus;
+}
+
+int workq_set_cpus(int cpus)
+{
+	int old = workq_ncpus;
+
+	workq_ncpus = clamp(cpus, 1, CONFIG_WORKQ_CPUS);
+
+	return old;
+}
@@ -0,0 +1,1089 @@
+/*
+ * Zstandard (zstd) decompression
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * This is a compact one-shot decoder for the format described in RFC 8478.
+ * The whole output is kept in the destination buffer, so the window never
+ * needs to be copied: matches are resolved directly against the data
+ * already decompressed. Dictionaries are not supported.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <u-boot/xxhash.h>
+#include <asm/unaligned.h>
+#include <linux/compiler.h>
+
+#define ZSTD_MAGIC		0xfd2fb528
+#define ZSTD_MAGIC_SKIP		0x184d2a50	/* low four bits are free */
+#define ZSTD_MAGIC_SKIP_MASK	0xfffffff0
+
+#define ZSTD_BLOCK_SIZE_MAX	(128 * 1024)
+
+enum zstd_block_type {
+	ZSTD_BLOCK_RAW,
+	ZSTD_BLOCK_RLE,
+	ZSTD_BLOCK_COMPRESSED,
+	ZSTD_BLOCK_RESERVED,
+};
+
+enum zstd_lit_type {
+	ZSTD_LIT_RAW,
+	ZSTD_LIT_RLE,
+	ZSTD_LIT_COMPRESSED,
+	ZSTD_LIT_TREELESS,
+};
+
+enum zstd_seq_mode {
+	ZSTD_SEQ_PREDEFINED,
+	ZSTD_SEQ_RLE,
+	ZSTD_SEQ_FSE,
+	ZSTD_SEQ_REPEAT,
+};
+
+#define HUF_MAX_BITS		11
+#define HUF_MAX_SYMBOLS		256
+
+#define FSE_MAX_LOG		9
+#define FSE_MAX_SYMBOLS		53
+#define FSE_WEIGHT_MAX_LOG	6
+
+#define LL_MAX_LOG		9
+#define ML_MAX_LOG		9
+#define OF_MAX_LOG		8
+#define LL_MAX_CODE		35
+#define ML_MAX_CODE		52
+#define OF_MAX_CODE		31
+
+struct fse_entry {
+	u8 symbol;
+	u8 bits;
+	u16 base;
+};
+
+struct fse_table {
+	int log;		/* accuracy log, -1 if not set up */
+	struct fse_entry entry[1 << FSE_MAX_LOG];
+};
+
+struct huf_table {
+	int max_bits;		/* 0 if not set up */
+	u8 symbol[1 << HUF_MAX_BITS];
+	u8 bits[1 << HUF_MAX_BITS];
+};
+
+/* decoder state, which persists across the blocks of a frame */
+struct zstd_ctx {
+	u8 *frame;		/* start of the current frame's output */
+	u32 rep[3];		/* repeat offsets */
+	struct huf_table huf;
+	struct fse_table ll;
+	struct fse_table of;
+	struct fse_table ml;
+	u8 literals[ZSTD_BLOCK_SIZE_MAX];
+};
+
+static const s16 ll_default_norm[LL_MAX_CODE + 1] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+	-1, -1, -1, -1
+};
+
+static const s16 ml_default_norm[ML_MAX_CODE + 1] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+	-1, -1, -1, -1, -1
+};
+
+static const s16 of_default_norm[29] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1
+};
+
+static const u32 ll_base[LL_MAX_CODE + 1] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+	8192, 16384, 32768, 65536
+};
+
+static const u8 ll_bits[LL_MAX_CODE + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+	13, 14, 15, 16
+};
+
+static const u32 ml_base[ML_MAX_CODE + 1] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+	4099, 8195, 16387, 32771, 65539
+};
+
+static const u8 ml_bits[ML_MAX_CODE + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16
+};
+
+static inline int highbit(u32 val)
+{
+	return fls(val) - 1;
+}
+
+/* Read @bits (at most 32) bits of a little-endian bitstream at bit @pos */
+static inline u32 bits_peek(const u8 *src, size_t len, size_t pos, int bits)
+{
+	size_t byte = pos >> 3;
+	u64 val;
+	int i;
+
+	if (byte + 8 <= len) {
+		val = get_unaligned_le64(src + byte);
+	} else {
+		val = 0;
+		for (i = 0; byte + i < len; i++)
+			val |= (u64)src[byte + i] << (8 * i);
+	}
+
+	return (val >> (pos & 7)) & ((1ULL << bits) - 1);
+}
+
+/*
+ * Entropy-coded streams are read backwards, starting from the highest bit
+ * below the end marker (the highest set bit of the last byte). Reading past
+ * the start returns zero bits, which the callers use to check that a stream
+ * was consumed exactly.
+ */
+struct bstream {
+	const u8 *src;
+	size_t len;
+	long pos;		/* number of bits not read yet */
+};
+
+static int bstream_init(struct bstream *bs, const u8 *src, size_t len)
+{
+	if (!len || !src[len - 1])
+		return -EPROTO;
+	bs->src = src;
+	bs->len = len;
+	bs->pos = (len - 1) * 8 + highbit(src[len - 1]);
+
+	return 0;
+}
+
+static inline u32 bstream_read(struct bstream *bs, int bits)
+{
+	bs->pos -= bits;
+	if (bs->pos >= 0)
+		return bits_peek(bs->src, bs->len, bs->pos, bits);
+	if (bits + bs->pos <= 0)
+		return 0;
+
+	return bits_peek(bs->src, bs->len, 0, bits + bs->pos) << -bs->pos;
+}
+
+/**
+ * fse_read_header() - read the normalised counts of an FSE table
+ *
+ * @src:	Table description
+ * @len:	Number of bytes available at @src
+ * @norm:	Returns the normalised count of each symbol
+ * @max_symbol:	Largest symbol allowed in the table
+ * @max_log:	Largest accuracy log allowed
+ * @nsymbolsp:	Returns the number of symbols in the table
+ * @logp:	Returns the accuracy log
+ * @return number of bytes used by the description, or -ve on error
+ */
+static int fse_read_header(const u8 *src, size_t len, s16 *norm,
+			   int max_symbol, int max_log, int *nsymbolsp,
+			   int *logp)
+{
+	size_t pos = 0;
+	int remaining, symbol = 0, log;
+
+	if (!len)
+		return -EINVAL;
+	log = (src[0] & 0xf) + 5;
+	if (log > max_log)
+		return -EPROTO;
+	pos = 4;
+
+	remaining = 1 << log;
+	while (remaining > 0 && symbol <= max_symbol) {
+		int bits = highbit(remaining + 1) + 1;
+		u32 lower_mask = (1 << (bits - 1)) - 1;
+		u32 threshold = (1 << bits) - 1 - (remaining + 1);
+		u32 val;
+		int prob;
+
+		if (pos + bits - 1 > len * 8)
+			return -EINVAL;
+		val = bits_peek(src, len, pos, bits);
+		if ((val & lower_mask) < threshold) {
+			val &= lower_mask;
+			pos += bits - 1;
+		} else {
+			if (val > lower_mask)
+				val -= threshold;
+			pos += bits;
+			if (pos > len * 8)
+				return -EINVAL;
+		}
+
+		/* a count of -1 marks a 'less than one' probability */
+		prob = (int)val - 1;
+		remaining -= prob < 0 ? -prob : prob;
+		norm[symbol++] = prob;
+
+		/* a zero count is followed by 2-bit repeat flags */
+		if (!prob) {
+			int repeat, i;
+
+			do {
+				if (pos + 2 > len * 8)
+					return -EINVAL;
+				repeat = bits_peek(src, len, pos, 2);
+				pos += 2;
+				for (i = 0; i < repeat; i++) {
+					if (symbol > max_symbol)
+						return -EPROTO;
+					norm[symbol++] = 0;
+				}
+			} while (repeat == 3);
+		}
+	}
+	if (remaining)
+		return -EPROTO;
+
+	*nsymbolsp = symbol;
+	*logp = log;
+
+	return (pos + 7) / 8;
+}
+
+/**
+ * fse_build() - build an FSE decoding table from normalised counts
+ *
+ * @table:	Table to fill in
+ * @norm:	Normalised count of each symbol
+ * @nsymbols:	Number of symbols
+ * @log:	Accuracy log of the table
+ * @return 0 if OK, -EPROTO if the counts do not describe a valid table
+ */
+static int fse_build(struct fse_table *table, const s16 *norm, int nsymbols,
+		     int log)
+{
+	u16 next[FSE_MAX_SYMBOLS];
+	int size = 1 << log;
+	int high = size - 1;
+	int step = (size >> 1) + (size >> 3) + 3;
+	int mask = size - 1;
+	int pos = 0;
+	int s, i;
+
+	/* 'less than one' symbols take the cells at the top of the table */
+	for (s = 0; s < nsymbols; s++) {
+		if (norm[s] == -1) {
+			table->entry[high--].symbol = s;
+			next[s] = 1;
+		} else {
+			next[s] = norm[s];
+		}
+	}
+
+	for (s = 0; s < nsymbols; s++) {
+		for (i = 0; i < norm[s]; i++) {
+			table->entry[pos].symbol = s;
+			do {
+				pos = (pos + step) & mask;
+			} while (pos > high);
+		}
+	}
+	if (pos)
+		return -EPROTO;
+
+	for (i = 0; i < size; i++) {
+		struct fse_entry *entry = &table->entry[i];
+		u16 state = next[entry->symbol]++;
+
+		entry->bits = log - highbit(state);
+		entry->base = (state << entry->bits) - size;
+	}
+	table->log = log;
+
+	return 0;
+}
+
+static void fse_build_rle(struct fse_table *table, u8 symbol)
+{
+	table->entry[0].symbol = symbol;
+	table->entry[0].bits = 0;
+	table->entry[0].base = 0;
+	table->log = 0;
+}
+
+static inline u8 fse_peek(const struct fse_table *table, u16 state)
+{
+	return table->entry[state].symbol;
+}
+
+static inline void fse_update(const struct fse_table *table, u16 *state,
+			      struct bstream *bs)
+{
+	const struct fse_entry *entry = &table->entry[*state];
+
+	*state = entry->base + bstream_read(bs, entry->bits);
+}
+
+/**
+ * huf_read_weights() - read the weights of a Huffman tree description
+ *
+ * @src:	Tree description, starting with its header byte
+ * @len:	Number of bytes available at @src
+ * @weights:	Returns the weight of each symbol but the last
+ * @nweightsp:	Returns the number of weights read
+ * @return number of bytes used by the description, or -ve on error
+ */
+static int huf_read_weights(const u8 *src, size_t len, u8 *weights,
+			    int *nweightsp)
+{
+	struct fse_table *table;
+	s16 norm[HUF_MAX_BITS + 2];
+	struct bstream bs;
+	int header, hlen, nsymbols, log, n, i;
+	u16 state1, state2;
+	int ret;
+
+	if (!len)
+		return -EINVAL;
+	header = src[0];
+
+	/* values of 128 and over give the number of 4-bit weights + 127 */
+	if (header >= 128) {
+		n = header - 127;
+		if (1 + (n + 1) / 2 > len)
+			return -EINVAL;
+		for (i = 0; i < n; i++)
+			weights[i] = i & 1 ? src[1 + i / 2] & 0xf :
+				     src[1 + i / 2] >> 4;
+		*nweightsp = n;
+
+		return 1 + (n + 1) / 2;
+	}
+
+	/* otherwise the weights are FSE-compressed into @header bytes */
+	if (1 + header > len)
+		return -EINVAL;
+	src++;
+	hlen = fse_read_header(src, header, norm, HUF_MAX_BITS + 1,
+			       FSE_WEIGHT_MAX_LOG, &nsymbols, &log);
+	if (hlen < 0)
+		return hlen;
+
+	/* only a small table is needed here, keep it off the stack */
+	table = malloc(offsetof(struct fse_table, entry[1 << log]));
+	if (!table)
+		return -ENOMEM;
+	ret = fse_build(table, norm, nsymbols, log);
+	if (!ret)
+		ret = bstream_init(&bs, src + hlen, header - hlen);
+	if (ret)
+		goto out;
+
+	/* two interleaved states, until the stream runs out */
+	state1 = bstream_read(&bs, log);
+	state2 = bstream_read(&bs, log);
+	for (n = 0; ; ) {
+		if (n + 2 > HUF_MAX_SYMBOLS - 1) {
+			ret = -EPROTO;
+			goto out;
+		}
+		weights[n++] = fse_peek(table, state1);
+		fse_update(table, &state1, &bs);
+		if (bs.pos < 0) {
+			weights[n++] = fse_peek(table, state2);
+			break;
+		}
+		weights[n++] = fse_peek(table, state2);
+		fse_update(table, &state2, &bs);
+		if (bs.pos < 0) {
+			weights[n++] = fse_peek(table, state1);
+			break;
+		}
+	}
+	*nweightsp = n;
+	ret = 1 + header;
+out:
+	free(table);
+
+	return ret;
+}
+
+/**
+ * huf_build() - build a Huffman decoding table from a tree description
+ *
+ * @table:	Table to fill in
+ * @src:	Tree description
+ * @len:	Number of bytes available at @src
+ * @return number of bytes used by the description, or -ve on error
+ */
+static int huf_build(struct huf_table *table, const u8 *src, size_t len)
+{
+	u8 weights[HUF_MAX_SYMBOLS];
+	u16 rank[HUF_MAX_BITS + 1];
+	u32 total = 0, rest;
+	int nweights = 0, max_bits, desc_len, used;
+	int i, w;
+
+	desc_len = huf_read_weights(src, len, weights, &nweights);
+	if (desc_len < 0)
+		return desc_len;
+
+	for (i = 0; i < nweights; i++) {
+		if (weights[i] > HUF_MAX_BITS)
+			return -EPROTO;
+		if (weights[i])
+			total += 1 << (weights[i] - 1);
+	}
+	if (!total)
+		return -EPROTO;
+
+	/* the weight of the last symbol is implied by the others */
+	max_bits = highbit(total) + 1;
+	if (max_bits > HUF_MAX_BITS)
+		return -EPROTO;
+	rest = (1 << max_bits) - total;
+	if (rest & (rest - 1))
+		return -EPROTO;
+	weights[nweights++] = highbit(rest) + 1;
+
+	/*
+	 * Canonical codes: the longest codes (lowest weights) come first,
+	 * and symbols of equal length are in increasing order. Each symbol
+	 * fills 2^(weight - 1) consecutive table cells.
+	 */
+	memset(rank, '\0', sizeof(rank));
+	for (i = 0; i < nweights; i++)
+		rank[weights[i]]++;
+	for (w = 1, used = 0; w <= max_bits; w++) {
+		int count = rank[w] << (w - 1);
+
+		rank[w] = used;
+		used += count;
+	}
+
+	for (i = 0; i < nweights; i++) {
+		int weight = weights[i];
+		int cells, pos;
+
+		if (!weight)
+			continue;
+		cells = 1 << (weight - 1);
+		pos = rank[weight];
+		memset(&table->symbol[pos], i, cells);
+		memset(&table->bits[pos], max_bits + 1 - weight, cells);
+		rank[weight] += cells;
+	}
+	table->max_bits = max_bits;
+
+	return desc_len;
+}
+
+/* Decode one Huffman-coded stream of exactly @count literals */
+static int huf_decode(const struct huf_table *table, const u8 *src,
+		      size_t len, u8 *out, size_t count)
+{
+	int max_bits = table->max_bits;
+	u32 mask = (1 << max_bits) - 1;
+	struct bstream bs;
+	u32 state;
+	int ret;
+
+	ret = bstream_init(&bs, src, len);
+	if (ret)
+		return ret;
+
+	state = bstream_read(&bs, max_bits);
+	while (count--) {
+		int bits = table->bits[state];
+
+		*out++ = table->symbol[state];
+		state = ((state << bits) | bstream_read(&bs, bits)) & mask;
+	}
+
+	/* the last symbol must end exactly at the start of the stream */
+	return bs.pos == -max_bits ? 0 : -EPROTO;
+}
+
+/**
+ * decode_literals() - decode the literals section of a compressed block
+ *
+ * @ctx:	Decoder context
+ * @src:	Block contents
+ * @len:	Block size
+ * @litp:	Returns a pointer to the literals
+ * @nlitp:	Returns the number of literals
+ * @return number of bytes used by the literals section, or -ve on error
+ */
+static int decode_literals(struct zstd_ctx *ctx, const u8 *src, size_t len,
+			   const u8 **litp, size_t *nlitp)
+{
+	size_t regen, csize, hlen, used;
+	int type, format;
+	int nstreams;
+	int ret;
+
+	if (!len)
+		return -EINVAL;
+	type = src[0] & 3;
+	format = (src[0] >> 2) & 3;
+	if (type == ZSTD_LIT_RAW || type == ZSTD_LIT_RLE) {
+		switch (format) {
+		case 0:
+		case 2:
+			hlen = 1;
+			regen = src[0] >> 3;
+			break;
+		case 1:
+			hlen = 2;
+			if (len < hlen)
+				return -EINVAL;
+			regen = (src[0] >> 4) + (src[1] << 4);
+			break;
+		default:
+			hlen = 3;
+			if (len < hlen)
+				return -EINVAL;
+			regen = (src[0] >> 4) + (src[1] << 4) + (src[2] << 12);
+			break;
+		}
+		if (regen > ZSTD_BLOCK_SIZE_MAX)
+			return -EPROTO;
+		*nlitp = regen;
+
+		if (type == ZSTD_LIT_RLE) {
+			if (len < hlen + 1)
+				return -EINVAL;
+			memset(ctx->literals, src[hlen], regen);
+			*litp = ctx->literals;
+			return hlen + 1;
+		}
+		if (len < hlen + regen)
+			return -EINVAL;
+		*litp = src + hlen;
+		return hlen + regen;
+	}
+
+	/* Huffman-coded, in one or four streams */
+	nstreams = format ? 4 : 1;
+	hlen = 3 + (format == 3 ? 2 : format == 2 ? 1 : 0);
+	if (len < hlen)
+		return -EINVAL;
+	switch (format) {
+	case 0:
+	case 1: {
+		u32 val = src[0] | src[1] << 8 | src[2] << 16;
+
+		regen = (val >> 4) & 0x3ff;
+		csize = val >> 14;
+		break;
+	}
+	case 2: {
+		u32 val = get_unaligned_le32(src);
+
+		regen = (val >> 4) & 0x3fff;
+		csize = val >> 18;
+		break;
+	}
+	default: {
+		u32 val = get_unaligned_le32(src);
+
+		regen = (val >> 4) & 0x3ffff;
+		csize = (val >> 22) + ((u32)src[4] << 10);
+		break;
+	}
+	}
+	if (regen > ZSTD_BLOCK_SIZE_MAX)
+		return -EPROTO;
+	if (len < hlen + csize)
+		return -EINVAL;
+	used = hlen + csize;
+	src += hlen;
+
+	if (type == ZSTD_LIT_COMPRESSED) {
+		ret = huf_build(&ctx->huf, src, csize);
+		if (ret < 0)
+			return ret;
+		src += ret;
+		csize -= ret;
+	} else if (!ctx->huf.max_bits) {
+		/* treeless literals reuse the previous block's tree */
+		return -EPROTO;
+	}
+
+	if (nstreams == 1) {
+		ret = huf_decode(&ctx->huf, src, csize, ctx->literals, regen);
+	} else {
+		size_t size[4], part = (regen + 3) / 4;
+		u8 *out = ctx->literals;
+		int i;
+
+		/* a jump table gives the sizes of the first three streams */
+		if (csize < 6)
+			return -EPROTO;
+		size[0] = get_unaligned_le16(src);
+		size[1] = get_unaligned_le16(src + 2);
+		size[2] = get_unaligned_le16(src + 4);
+		if (size[0] + size[1] + size[2] > csize - 6 || part * 3 > regen)
+			return -EPROTO;
+		size[3] = csize - 6 - size[0] - size[1] - size[2];
+		src += 6;
+		for (i = 0, ret = 0; i < 4 && !ret; i++) {
+			size_t count = i < 3 ? part : regen - part * 3;
+
+			ret = huf_decode(&ctx->huf, src, size[i], out, count);
+			src += size[i];
+			out += count;
+		}
+	}
+	if (ret)
+		return ret;
+	*litp = ctx->literals;
+	*nlitp = regen;
+
+	return used;
+}
+
+/**
+ * read_seq_table() - set up the decoding table for one sequence field
+ *
+ * @table:	Table to set up
+ * @mode:	Compression mode of the field (enum zstd_seq_mode)
+ * @src:	Table description, if any
+ * @len:	Number of bytes available at @src
+ * @def_norm:	Predefined distribution of the field
+ * @def_nsymbols: Number of symbols in @def_norm
+ * @def_log:	Accuracy log of the predefined distribution
+ * @max_symbol:	Largest code of the field
+ * @max_log:	Largest accuracy log allowed for the field
+ * @return number of bytes used from @src, or -ve on error
+ */
+static int read_seq_table(struct fse_table *table, int mode, const u8 *src,
+			  size_t len, const s16 *def_norm, int def_nsymbols,
+			  int def_log, int max_symbol, int max_log)
+{
+	s16 norm[FSE_MAX_SYMBOLS];
+	int nsymbols, log, used;
+	int ret;
+
+	switch (mode) {
+	case ZSTD_SEQ_PREDEFINED:
+		return fse_build(table, def_norm, def_nsymbols, def_log);
+	case ZSTD_SEQ_RLE:
+		if (!len)
+			return -EINVAL;
+		if (src[0] > max_symbol)
+			return -EPROTO;
+		fse_build_rle(table, src[0]);
+		return 1;
+	case ZSTD_SEQ_FSE:
+		used = fse_read_header(src, len, norm, max_symbol, max_log,
+				       &nsymbols, &log);
+		if (used < 0)
+			return used;
+		ret = fse_build(table, norm, nsymbols, log);
+		return ret ? ret : used;
+	default:
+		/* repeat the table of the previous block */
+		return table->log < 0 ? -EPROTO : 0;
+	}
+}
+
+/* Copy a match, which may overlap the bytes it produces */
+static inline void copy_match(u8 *out, const u8 *match, size_t len,
+			      size_t offset)
+{
+	if (offset >= len) {
+		memcpy(out, match, len);
+		return;
+	}
+	if (offset >= 8) {
+		for (; len >= 8; len -= 8, out += 8, match += 8)
+			memcpy(out, match, 8);
+	}
+	while (len--)
+		*out++ = *match++;
+}
+
+/**
+ * decode_sequences() - decode and execute the sequences section of a block
+ *
+ * @ctx:	Decoder context
+ * @src:	Sequences section
+ * @len:	Size of the sequences section
+ * @lit:	Literals of the block
+ * @nlit:	Number of literals
+ * @outp:	Output pointer, updated with the data produced
+ * @oend:	End of the output buffer
+ * @return 0 if OK, -ve on error
+ */
+static int decode_sequences(struct zstd_ctx *ctx, const u8 *src, size_t len,
+			    const u8 *lit, size_t nlit, u8 **outp, u8 *oend)
+{
+	const u8 *lit_end = lit + nlit;
+	u16 ll_state = 0, of_state = 0, ml_state = 0;
+	u8 *out = *outp;
+	struct bstream bs;
+	size_t pos;
+	u32 nseq, i;
+	int modes;
+	int ret;
+
+	if (!len)
+		return -EINVAL;
+	nseq = src[0];
+	if (nseq < 128) {
+		pos = 1;
+	} else if (nseq < 255) {
+		if (len < 2)
+			return -EINVAL;
+		nseq = ((nseq - 128) << 8) + src[1];
+		pos = 2;
+	} else {
+		if (len < 3)
+			return -EINVAL;
+		nseq = src[1] + (src[2] << 8) + 0x7f00;
+		pos = 3;
+	}
+
+	if (nseq) {
+		if (pos >= len)
+			return -EINVAL;
+		modes = src[pos++];
+		if (modes & 3)
+			return -EPROTO;
+
+		ret = read_seq_table(&ctx->ll, modes >> 6, src + pos,
+				     len - pos, ll_default_norm,
+				     ARRAY_SIZE(ll_default_norm), 6,
+				     LL_MAX_CODE, LL_MAX_LOG);
+		if (ret < 0)
+			return ret;
+		pos += ret;
+		ret = read_seq_table(&ctx->of, (modes >> 4) & 3, src + pos,
+				     len - pos, of_default_norm,
+				     ARRAY_SIZE(of_default_norm), 5,
+				     OF_MAX_CODE, OF_MAX_LOG);
+		if (ret < 0)
+			return ret;
+		pos += ret;
+		ret = read_seq_table(&ctx->ml, (modes >> 2) & 3, src + pos,
+				     len - pos, ml_default_norm,
+				     ARRAY_SIZE(ml_default_norm), 6,
+				     ML_MAX_CODE, ML_MAX_LOG);
+		if (ret < 0)
+			return ret;
+		pos += ret;
+
+		ret = bstream_init(&bs, src + pos, len - pos);
+		if (ret)
+			return ret;
+		ll_state = bstream_read(&bs, ctx->ll.log);
+		of_state = bstream_read(&bs, ctx->of.log);
+		ml_state = bstream_read(&bs, ctx->ml.log);
+	}
+
+	for (i = 0; i < nseq; i++) {
+		u8 ll_code = fse_peek(&ctx->ll, ll_state);
+		u8 of_code = fse_peek(&ctx->of, of_state);
+		u8 ml_code = fse_peek(&ctx->ml, ml_state);
+		u32 offset, ml, ll;
+
+		offset = (1U << of_code) + bstream_read(&bs, of_code);
+		ml = ml_base[ml_code] + bstream_read(&bs, ml_bits[ml_code]);
+		ll = ll_base[ll_code] + bstream_read(&bs, ll_bits[ll_code]);
+
+		/*
+		 * Offset values 1-3 select one of the last three offsets,
+		 * shifted by one when there are no literals
+		 */
+		if (offset > 3) {
+			offset -= 3;
+			ctx->rep[2] = ctx->rep[1];
+			ctx->rep[1] = ctx->rep[0];
+			ctx->rep[0] = offset;
+		} else {
+			int idx = offset - 1 + !ll;
+
+			if (idx) {
+				offset = idx < 3 ? ctx->rep[idx] :
+					 ctx->rep[0] - 1;
+				if (idx > 1)
+					ctx->rep[2] = ctx->rep[1];
+				ctx->rep[1] = ctx->rep[0];
+				ctx->rep[0] = offset;
+			} else {
+				offset = ctx->rep[0];
+			}
+		}
+
+		if (i + 1 < nseq) {
+			fse_update(&ctx->ll, &ll_state, &bs);
+			fse_update(&ctx->ml, &ml_state, &bs);
+			fse_update(&ctx->of, &of_state, &bs);
+		}
+
+		if (ll > lit_end - lit) {
+			ret = -EPROTO;
+			goto out;
+		}
+		if (ll > oend - out) {
+			ret = -ENOBUFS;
+			goto out;
+		}
+		memcpy(out, lit, ll);
+		out += ll;
+		lit += ll;
+
+		if (!offset || offset > out - ctx->frame) {
+			ret = -EPROTO;
+			goto out;
+		}
+		if (ml > oend - out) {
+			ret = -ENOBUFS;
+			goto out;
+		}
+		copy_match(out, out - offset, ml, offset);
+		out += ml;
+	}
+	if (nseq && bs.pos) {
+		ret = -EPROTO;
+		goto out;
+	}
+
+	/* the literals left over follow the last sequence */
+	if (lit_end - lit > oend - out) {
+		ret = -ENOBUFS;
+		goto out;
+	}
+	memcpy(out, lit, lit_end - lit);
+	out += lit_end - lit;
+	ret = 0;
+out:
+	*outp = out;
+
+	return ret;
+}
+
+/* Start a new frame: no tables and the initial repeat offsets */
+static void ctx_reset(struct zstd_ctx *ctx, u8 *frame)
+{
+	ctx->frame = frame;
+	ctx->rep[0] = 1;
+	ctx->rep[1] = 4;
+	ctx->rep[2] = 8;
+	ctx->huf.max_bits = 0;
+	ctx->ll.log = -1;
+	ctx->of.log = -1;
+	ctx->ml.log = -1;
+}
+
+/**
+ * decode_frame() - decode a zstd frame
+ *
+ * @ctxp:	Decoder context, allocated on the first compressed block
+ * @src:	Frame, starting with its magic number
+ * @len:	Number of bytes available at @src
+ * @outp:	Output pointer, updated with the data produced
+ * @oend:	End of the output buffer
+ * @return number of bytes in the frame, or -ve on error
+ */
+static int decode_frame(struct zstd_ctx **ctxp, const u8 *src, size_t len,
+			u8 **outp, u8 *oend)
+{
+	static const u8 did_size[] = { 0, 1, 2, 4 };
+	static const u8 fcs_size[] = { 0, 2, 4, 8 };
+	struct zstd_ctx *ctx = *ctxp;
+	u8 *frame = *outp;
+	bool has_checksum, has_fcs, last;
+	u64 fcs = 0;
+	size_t pos;
+	int fhd, size;
+	int ret = 0;
+
+	if (len < 6)
+		return -EINVAL;
+	fhd = src[4];
+	if (fhd & 0x08)
+		return -EINVAL;		/* reserved bit */
+	has_checksum = fhd & 0x04;
+	pos = 5;
+	if (!(fhd & 0x20))
+		pos++;			/* window descriptor */
+
+	size = did_size[fhd & 3];
+	if (pos + size > len)
+		return -EINVAL;
+	if (size && bits_peek(src, len, pos * 8, size * 8))
+		return -EPROTONOSUPPORT;	/* dictionaries */
+	pos += size;
+
+	/* a single-segment frame always has a content size */
+	size = fcs_size[fhd >> 6];
+	if (!size && (fhd & 0x20))
+		size = 1;
+	has_fcs = size;
+	if (pos + size > len)
+		return -EINVAL;
+	switch (size) {
+	case 1:
+		fcs = src[pos];
+		break;
+	case 2:
+		fcs = get_unaligned_le16(src + pos) + 256;
+		break;
+	case 4:
+		fcs = get_unaligned_le32(src + pos);
+		break;
+	case 8:
+		fcs = get_unaligned_le64(src + pos);
+		break;
+	}
+	pos += size;
+	if (has_fcs && fcs > oend - frame)
+		return -ENOBUFS;
+
+	if (ctx)
+		ctx_reset(ctx, frame);
+
+	do {
+		u32 header;
+		int type;
+
+		if (pos + 3 > len)
+			return -EINVAL;
+		header = src[pos] | src[pos + 1] << 8 | src[pos + 2] << 16;
+		pos += 3;
+		last = header & 1;
+		type = (header >> 1) & 3;
+		size = header >> 3;
+		if (size > ZSTD_BLOCK_SIZE_MAX)
+			return -EPROTO;
+
+		switch (type) {
+		case ZSTD_BLOCK_RAW:
+			if (pos + size > len)
+				return -EINVAL;
+			if (size > oend - *outp)
+				return -ENOBUFS;
+			memcpy(*outp, src + pos, size);
+			*outp += size;
+			pos += size;
+			break;
+		case ZSTD_BLOCK_RLE:
+			if (pos + 1 > len)
+				return -EINVAL;
+			if (size > oend - *outp)
+				return -ENOBUFS;
+			memset(*outp, src[pos], size);
+			*outp += size;
+			pos++;
+			break;
+		case ZSTD_BLOCK_COMPRESSED: {
+			const u8 *lit = NULL;
+			size_t nlit = 0;
+
+			if (pos + size > len)
+				return -EINVAL;
+			if (!ctx) {
+				ctx = malloc(sizeof(*ctx));
+				if (!ctx)
+					return -ENOMEM;
+				*ctxp = ctx;
+				ctx_reset(ctx, frame);
+			}
+			ret = decode_literals(ctx, src + pos, size, &lit, &nlit);
+			if (ret < 0)
+				return ret;
+			ret = decode_sequences(ctx, src + pos + ret, size - ret,
+					       lit, nlit, outp, oend);
+			if (ret)
+				return ret;
+			pos += size;
+			break;
+		}
+		default:
+			return -EPROTO;
+		}
+	} while (!last);
+
+	if (has_fcs && *outp - frame != fcs)
+		return -EPROTO;
+	if (has_checksum) {
+		if (pos + 4 > len)
+			return -EINVAL;
+		if (get_unaligned_le32(src + pos) !=
+		    (u32)xxh64(frame, *outp - frame, 0))
+			return -EPROTO;
+		pos += 4;
+	}
+
+	return pos;
+}
+
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	struct zstd_ctx *ctx = NULL;
+	bool frames = false;
+	const u8 *in = src;
+	u8 *out = dst;
+	u8 *oend;
+	int ret = 0;
+
+	/* callers may pass ~0 as the size when they do not know it */
+	oend = out + min3(*dstn, (size_t)~(uintptr_t)dst, (size_t)LONG_MAX);
+
+	/*
+	 * Frames and skippable frames may be concatenated. Anything else
+	 * after the first frame is taken as trailing padding and ignored.
+	 */
+	if (!srcn)
+		ret = -EINVAL;
+	while (srcn) {
+		u32 magic;
+
+		if (srcn < 8) {
+			ret = frames ? 0 : -EINVAL;
+			break;
+		}
+		magic = get_unaligned_le32(in);
+		if ((magic & ZSTD_MAGIC_SKIP_MASK) == ZSTD_MAGIC_SKIP) {
+			u32 size = get_unaligned_le32(in + 4);
+
+			if (size > srcn - 8) {
+				ret = -EINVAL;
+				break;
+			}
+			ret = 8 + size;
+		} else if (magic == ZSTD_MAGIC) {
+			ret = decode_frame(&ctx, in, srcn, &out, oend);
+			if (ret < 0)
+				break;
+			frames = true;
+		} else {
+			/* unknown format */
+			ret = frames ? 0 : -EPROTONOSUPPORT;
+			break;
+		}
+		in += ret;
+		srcn -= ret;
+		ret = 0;
+	}
+	free(ctx);
+	*dstn = out - (u8 *)dst;
+
+	return ret;
+}
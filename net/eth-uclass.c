@@ -20,9 +20,11 @@ DECLARE_GLOBAL_DATA_PTR;
  * struct eth_device_priv - private structure for each Ethernet device
  *
  * @state: The state of the Ethernet MAC driver (defined by enum eth_state_t)
+ * @stats: Packet counters
  */
 struct eth_device_priv {
 	enum eth_state_t state;
+	struct eth_stats stats;
 };
 
 /**
@@ -74,6 +76,13 @@ struct udevice *eth_get_dev(void)
 	return uc_priv->current;
 }
 
+struct eth_stats *eth_get_stats(struct udevice *dev)
+{
+	struct eth_device_priv *priv = dev->uclass_priv;
+
+	return &priv->stats;
+}
+
 /*
  * Typically this will just store a device pointer.
  * In case it was not probed, we will attempt to do so.
@@ -342,6 +351,11 @@ int eth_send(void *packet, int length)
 	if (ret < 0) {
 		/* We cannot completely return the error at present */
 		debug("%s: send() returned error %d\n", __func__, ret);
+	} else {
+		struct eth_stats *stats = eth_get_stats(current);
+
+		stats->tx_packets++;
+		stats->tx_bytes += length;
 	}
 	return ret;
 }
@@ -349,6 +363,7 @@ int eth_send(void *packet, int length)
 int eth_rx(void)
 {
 	struct udevice *current;
+	struct eth_stats *stats;
 	uchar *packet;
 	int flags;
 	int ret;
@@ -361,13 +376,21 @@ int eth_rx(void)
 	if (!device_active(current))
 		return -EINVAL;
 
-	/* Process up to 32 packets at one time */
+	/*
+	 * Process up to a full receive ring, or 32 packets, at one time. The
+	 * packets are handled in the driver's buffers, which are only given
+	 * back to it by free_pkt() once the stack is done with them.
+	 */
+	stats = eth_get_stats(current);
 	flags = ETH_RECV_CHECK_DEVICE;
-	for (i = 0; i < 32; i++) {
+	for (i = 0; i < max(PKTBUFSRX, 32); i++) {
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
-		if (ret > 0)
+		if (ret > 0) {
+			stats->rx_packets++;
+			stats->rx_bytes += ret;
 			net_process_received_packet(packet, ret);
+		}
 		if (ret >= 0 && eth_get_ops(current)->free_pkt)
 			eth_get_ops(current)->free_pkt(current, packet, ret);
 		if (ret <= 0)
@@ -382,6 +405,30 @@ int eth_rx(void)
 	return ret;
 }
 
+#ifdef CONFIG_MCAST_TFTP
+/* Join (join=1) or leave (join=0) the multicast group of mcast_ip */
+int eth_mcast_join(struct in_addr mcast_ip, int join)
+{
+	struct udevice *current;
+	u8 mcast_mac[ARP_HLEN];
+	u32 ip = ntohl(mcast_ip.s_addr);
+
+	current = eth_get_dev();
+	if (!current || !eth_get_ops(current)->mcast)
+		return -ENOSYS;
+
+	/* 01:00:5e followed by the low 23 bits of the group address */
+	mcast_mac[0] = 0x01;
+	mcast_mac[1] = 0x00;
+	mcast_mac[2] = 0x5e;
+	mcast_mac[3] = (ip >> 16) & 0x7f;
+	mcast_mac[4] = (ip >> 8) & 0xff;
+	mcast_mac[5] = ip & 0xff;
+
+	return eth_get_ops(current)->mcast(current, mcast_mac, join);
+}
+#endif
+
 int eth_initialize(void)
 {
 	int num_devices = 0;
@@ -78,16 +78,28 @@
  *			- own IP address
  *	We want:	- network time
  *	Next step:	none
+ *
+ * WGET:
+ *
+ *	Prerequisites:	- own ethernet address
+ *			- own IP address
+ *			- HTTP server IP address
+ *			- path of the file on the server
+ *	We want:	- load the file, over TCP
+ *	Next step:	none
  */
 
 
 #include <common.h>
 #include <command.h>
 #include <console.h>
+#include <dm.h>
 #include <environment.h>
 #include <errno.h>
 #include <net.h>
+#include <net/tcp.h>
 #include <net/tftp.h>
+#include <net/wget.h>
 #if defined(CONFIG_LED_STATUS)
 #include <miiphy.h>
 #include <status_led.h>
@@ -357,6 +369,10 @@ static void net_clear_handlers(void)
 
 static void net_cleanup_loop(void)
 {
+#ifdef CONFIG_PROT_TCP
+	/* Reset a connection left open, before the interface goes down */
+	tcp_abort();
+#endif
 	net_clear_handlers();
 }
 
@@ -508,6 +524,11 @@ restart:
 		case LINKLOCAL:
 			link_local_start();
 			break;
+#endif
+#if defined(CONFIG_CMD_WGET)
+		case WGET:
+			wget_start();
+			break;
 #endif
 		default:
 			break;
@@ -803,6 +824,11 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 	net_set_udp_header(pkt, dest, dport, sport, payload_len);
 	pkt_hdr_size = eth_hdr_size + IP_UDP_HDR_SIZE;
 
+	return net_send_ip_packet(ether, dest, pkt_hdr_size + payload_len);
+}
+
+int net_send_ip_packet(uchar *ether, struct in_addr dest, int pkt_size)
+{
 	/* if MAC address was not discovered yet, do an ARP request */
 	if (memcmp(ether, net_null_ethaddr, 6) == 0) {
 		debug_cond(DEBUG_DEV_PKT, "sending ARP for %pI4\n", &dest);
@@ -812,7 +838,7 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 		arp_wait_packet_ethaddr = ether;
 
 		/* size of the waiting packet */
-		arp_wait_tx_packet_size = pkt_hdr_size + payload_len;
+		arp_wait_tx_packet_size = pkt_size;
 
 		/* and do the ARP request */
 		arp_wait_try = 1;
@@ -820,9 +846,9 @@ int net_send_udp_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 		arp_request();
 		return 1;	/* waiting */
 	} else {
-		debug_cond(DEBUG_DEV_PKT, "sending UDP to %pI4/%pM\n",
+		debug_cond(DEBUG_DEV_PKT, "sending IP to %pI4/%pM\n",
 			   &dest, ether);
-		net_send_packet(net_tx_packet, pkt_hdr_size + payload_len);
+		net_send_packet(net_tx_packet, pkt_size);
 		return 0;	/* transmitted */
 	}
 }
@@ -1026,6 +1052,17 @@ static void receive_icmp(struct ip_udp_hdr *ip, int len,
 	}
 }
 
+/* Counts a frame which the current device received truncated or corrupt */
+static void net_rx_dropped(void)
+{
+#ifdef CONFIG_DM_ETH
+	struct udevice *dev = eth_get_dev();
+
+	if (dev && device_active(dev))
+		eth_get_stats(dev)->rx_dropped++;
+#endif
+}
+
 void net_process_received_packet(uchar *in_packet, int len)
 {
 	struct ethernet_hdr *et;
@@ -1045,8 +1082,10 @@ void net_process_received_packet(uchar *in_packet, int len)
 	et = (struct ethernet_hdr *)in_packet;
 
 	/* too small packet? */
-	if (len < ETHER_HDR_SIZE)
+	if (len < ETHER_HDR_SIZE) {
+		net_rx_dropped();
 		return;
+	}
 
 #if defined(CONFIG_API) || defined(CONFIG_EFI_LOADER)
 	if (push_packet) {
@@ -1091,8 +1130,10 @@ void net_process_received_packet(uchar *in_packet, int len)
 		debug_cond(DEBUG_NET_PKT, "VLAN packet received\n");
 
 		/* too small packet? */
-		if (len < VLAN_ETHER_HDR_SIZE)
+		if (len < VLAN_ETHER_HDR_SIZE) {
+			net_rx_dropped();
 			return;
+		}
 
 		/* if no VLAN active */
 		if ((ntohs(net_our_vlan) & VLAN_IDMASK) == VLAN_NONE
@@ -1143,11 +1184,13 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (len < IP_UDP_HDR_SIZE) {
 			debug("len bad %d < %lu\n", len,
 			      (ulong)IP_UDP_HDR_SIZE);
+			net_rx_dropped();
 			return;
 		}
 		/* Check the packet length */
 		if (len < ntohs(ip->ip_len)) {
 			debug("len bad %d < %d\n", len, ntohs(ip->ip_len));
+			net_rx_dropped();
 			return;
 		}
 		len = ntohs(ip->ip_len);
@@ -1163,6 +1206,7 @@ void net_process_received_packet(uchar *in_packet, int len)
 		/* Check the Checksum of the header */
 		if (!ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
 			debug("checksum bad\n");
+			net_rx_dropped();
 			return;
 		}
 		/* If it is not for us, ignore it */
@@ -1170,7 +1214,7 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (net_ip.s_addr && dst_ip.s_addr != net_ip.s_addr &&
 		    dst_ip.s_addr != 0xFFFFFFFF) {
 #ifdef CONFIG_MCAST_TFTP
-			if (net_mcast_addr != dst_ip)
+			if (net_mcast_addr.s_addr != dst_ip.s_addr)
 #endif
 				return;
 		}
@@ -1208,6 +1252,11 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (ip->ip_p == IPPROTO_ICMP) {
 			receive_icmp(ip, len, src_ip, et);
 			return;
+#ifdef CONFIG_PROT_TCP
+		} else if (ip->ip_p == IPPROTO_TCP) {
+			tcp_receive((struct ip_tcp_hdr *)ip, len);
+			return;
+#endif
 		} else if (ip->ip_p != IPPROTO_UDP) {	/* Only UDP packets */
 			return;
 		}
@@ -1253,6 +1302,7 @@ void net_process_received_packet(uchar *in_packet, int len)
 			if ((xsum != 0x00000000) && (xsum != 0x0000ffff)) {
 				printf(" UDP wrong checksum %08lx %08x\n",
 				       xsum, ntohs(ip->udp_xsum));
+				net_rx_dropped();
 				return;
 			}
 		}
@@ -1309,6 +1359,9 @@ static int net_check_prereq(enum proto_t protocol)
 #endif
 #if defined(CONFIG_CMD_NFS)
 	case NFS:
+#endif
+#if defined(CONFIG_CMD_WGET)
+	case WGET:
 #endif
 		/* Fall through */
 	case TFTPGET:
@@ -42,15 +42,47 @@
 # define NFS_TIMEOUT CONFIG_NFS_TIMEOUT
 #endif
 
+#ifdef CONFIG_NFS_READ_WINDOW
+# define NFS_READ_WINDOW CONFIG_NFS_READ_WINDOW
+#else
+# define NFS_READ_WINDOW 1
+#endif
+#if defined(CONFIG_NFS3_READ_SIZE) && CONFIG_NFS3_READ_SIZE > 0
+# define NFS3_READ_SIZE CONFIG_NFS3_READ_SIZE
+#else
+# define NFS3_READ_SIZE NFS_READ_SIZE
+#endif
+
+/* Read reply up to the data: RPC header, status, NFSv3 attributes, count */
+#define NFS_READ_REPLY_HDR_LEN	(6 * 4 + 26 * 4)
+
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
+static int nfs_offset = -1;	/* Next file offset to request */
 static ulong nfs_timeout = NFS_TIMEOUT;
 
+/*
+ * An outstanding READ request. Replies may come back in any order; each is
+ * stored at its own offset and each request has its own retry timer.
+ */
+struct nfs_read_slot {
+	unsigned long id;	/* RPC id of the request, 0 if free */
+	int offset;
+	int len;
+	ulong sent;		/* get_timer() when the request was sent */
+	int retries;
+};
+
+static struct nfs_read_slot nfs_read_slots[NFS_READ_WINDOW];
+static int nfs_read_size;	/* Bytes asked for by each READ */
+static int nfs_file_size;	/* File size, -1 until it is known */
+static ulong nfs_read_total;	/* Bytes received, for the progress hashes */
+static ulong nfs_hash_next;
+static int nfs_hash_count;
+
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
 static int filefh3_length;	/* (variable) length of filefh when NFSv3 */
@@ -78,6 +110,8 @@ static char nfs_path_buff[2048];
 #define NFSV3_FLAG 1 << 1
 static char supported_nfs_versions = NFSV2_FLAG | NFSV3_FLAG;
 
+static void nfs_timeout_handler(void);
+
 static inline int store_block(uchar *src, unsigned offset, unsigned len)
 {
 	ulong newsize = offset + len;
@@ -386,6 +420,120 @@ static void nfs_read_req(int offset, int readlen)
 	rpc_req(PROG_NFS, NFS_READ, data, len);
 }
 
+static void nfs_read_send(struct nfs_read_slot *slot)
+{
+	nfs_read_req(slot->offset, slot->len);
+	slot->id = rpc_id;
+	slot->sent = get_timer(0);
+}
+
+static void nfs_read_reset(void)
+{
+	memset(nfs_read_slots, '\0', sizeof(nfs_read_slots));
+}
+
+static bool nfs_read_past_end(int offset)
+{
+	return nfs_file_size >= 0 && offset >= nfs_file_size;
+}
+
+/* Sends READ requests until the window is full or the whole file is asked */
+static void nfs_read_fill(void)
+{
+	struct nfs_read_slot *slot;
+
+	for (slot = nfs_read_slots;
+	     slot < nfs_read_slots + NFS_READ_WINDOW; slot++) {
+		if (slot->id)
+			continue;
+		if (nfs_read_past_end(nfs_offset))
+			break;
+		slot->offset = nfs_offset;
+		slot->len = nfs_read_size;
+		slot->retries = 0;
+		nfs_offset += nfs_read_size;
+		nfs_read_send(slot);
+	}
+}
+
+static struct nfs_read_slot *nfs_read_find(unsigned long id)
+{
+	struct nfs_read_slot *slot;
+
+	for (slot = nfs_read_slots;
+	     slot < nfs_read_slots + NFS_READ_WINDOW; slot++) {
+		if (id && slot->id == id)
+			return slot;
+	}
+
+	return NULL;
+}
+
+static ulong nfs_read_deadline(struct nfs_read_slot *slot)
+{
+	return nfs_timeout + NFS_TIMEOUT * slot->retries;
+}
+
+/* Arms the net timeout for the request which expires first */
+static bool nfs_read_set_timer(void)
+{
+	struct nfs_read_slot *slot;
+	ulong left, wait = ~0UL;
+
+	for (slot = nfs_read_slots;
+	     slot < nfs_read_slots + NFS_READ_WINDOW; slot++) {
+		ulong elapsed = get_timer(slot->sent);
+
+		if (!slot->id)
+			continue;
+		left = nfs_read_deadline(slot);
+		left = elapsed < left ? left - elapsed : 1;
+		wait = min(wait, left);
+	}
+	if (wait == ~0UL)
+		return false;
+	net_set_timeout_handler(wait, nfs_timeout_handler);
+
+	return true;
+}
+
+/* Sends the requests whose timer expired again */
+static void nfs_read_timeout(void)
+{
+	struct nfs_read_slot *slot;
+
+	for (slot = nfs_read_slots;
+	     slot < nfs_read_slots + NFS_READ_WINDOW; slot++) {
+		if (!slot->id ||
+		    get_timer(slot->sent) < nfs_read_deadline(slot))
+			continue;
+		if (++slot->retries > NFS_RETRY_COUNT) {
+			puts("\nRetry count exceeded; starting again\n");
+			net_start_again();
+			return;
+		}
+		puts("T ");
+		nfs_read_send(slot);
+	}
+	nfs_read_set_timer();
+}
+
+static void nfs_read_start(void)
+{
+	nfs_read_reset();
+	nfs_offset = 0;
+	nfs_file_size = -1;
+	nfs_read_total = 0;
+	nfs_hash_next = 0;
+	nfs_hash_count = 0;
+	if (supported_nfs_versions & NFSV2_FLAG)
+		nfs_read_size = NFS_READ_SIZE;
+	else
+		nfs_read_size = NFS3_READ_SIZE;
+	nfs_read_fill();
+	nfs_read_set_timer();
+}
+
 /**************************************************************************
 RPC request dispatcher
 **************************************************************************/
@@ -416,7 +564,7 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_fill();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -577,8 +725,26 @@ static int nfs_lookup_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
-static int nfs3_get_attributes_offset(uint32_t *data)
+/* Number of whole words after the RPC header in a reply of len bytes */
+static int nfs_reply_words(unsigned len)
+{
+	unsigned hdr = offsetof(struct rpc_t, u.reply.data);
+
+	return len > hdr ? (len - hdr) / 4 : 0;
+}
+
+/*
+ * Returns the offset, in words, of the last word of the post-op attributes
+ * of an NFSv3 reply of len bytes, or -1 if the reply is too short to hold
+ * them
+ */
+static int nfs3_get_attributes_offset(uint32_t *data, unsigned len)
 {
+	int words = nfs_reply_words(len);
+
+	if (words < 2)
+		return -1;
+
 	if (ntohl(data[1]) != 0) {
 		/* 'attributes_follow' flag is TRUE,
 		 * so we have attributes on 21 dwords */
@@ -597,7 +763,7 @@ static int nfs3_get_attributes_offset(uint32_t *data)
 			mtime;	64 bits value,
 			ctime;	64 bits value,
 		*/
-		return 22;
+		return words > 22 ? 22 : -1;
 	} else {
 		/* 'attributes_follow' flag is FALSE,
 		 * so we don't have any attributes */
@@ -610,9 +776,12 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	struct rpc_t rpc_pkt;
 	int rlen;
 	int nfsv3_data_offset = 0;
+	int pathlen = 0;
 
 	debug("%s\n", __func__);
 
+	if (len > sizeof(rpc_pkt) || nfs_reply_words(len) < 1)
+		return -NFS_RPC_DROP;
 	memcpy((unsigned char *)&rpc_pkt, pkt, len);
 
 	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
@@ -628,43 +797,67 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 
 	if (!(supported_nfs_versions & NFSV2_FLAG)) { /* NFSV3_FLAG */
 		nfsv3_data_offset =
-			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
+			nfs3_get_attributes_offset(rpc_pkt.u.reply.data, len);
+		if (nfsv3_data_offset < 0)
+			return -NFS_RPC_DROP;
 	}
+	if (2 + nfsv3_data_offset > nfs_reply_words(len))
+		return -NFS_RPC_DROP;
 
 	/* new path length */
 	rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
+	if (rlen > (nfs_reply_words(len) - 2 - nfsv3_data_offset) * 4)
+		return -NFS_RPC_DROP;
+	if (rlen <= 0)
+		return -NFS_RPC_ERR;
 
-	if (*((char *)&(rpc_pkt.u.reply.data[2 + nfsv3_data_offset])) != '/') {
-		int pathlen;
-
+	/* A relative link is appended to the directory */
+	if (*((char *)&(rpc_pkt.u.reply.data[2 + nfsv3_data_offset])) != '/')
+		pathlen = strlen(nfs_path) + 1;
+	if (pathlen + rlen >= sizeof(nfs_path_buff))
+		return -NFS_RPC_ERR;
+	if (pathlen)
 		strcat(nfs_path, "/");
-		pathlen = strlen(nfs_path);
-		memcpy(nfs_path + pathlen,
-		       (uchar *)&(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]),
-		       rlen);
-		nfs_path[pathlen + rlen] = 0;
-	} else {
-		memcpy(nfs_path,
-		       (uchar *)&(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]),
-		       rlen);
-		nfs_path[rlen] = 0;
-	}
+
+	memcpy(nfs_path + pathlen,
+	       (uchar *)&(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]), rlen);
+	nfs_path[pathlen + rlen] = 0;
+
 	return 0;
 }
 
+static void nfs_show_progress(void)
+{
+	/* One hash for every five NFSv2 sized reads */
+	while (nfs_hash_next <= nfs_read_total) {
+		if (nfs_hash_count && !(nfs_hash_count % HASHES_PER_LINE))
+			puts("\n\t ");
+		putc('#');
+		nfs_hash_count++;
+		nfs_hash_next += NFS_READ_SIZE / 2 * 10;
+	}
+}
+
 static int nfs_read_reply(uchar *pkt, unsigned len)
 {
+	struct nfs_read_slot *slot;
 	struct rpc_t rpc_pkt;
+	unsigned data_off;
+	uint32_t *data_ptr;
+	int eof = 0;
 	int rlen;
-	uchar *data_ptr;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	if (nfs_reply_words(len) < 1)
+		return -NFS_RPC_DROP;
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	/* The data is stored straight from the packet, copy the rest */
+	memcpy(&rpc_pkt.u.data[0], pkt,
+	       min_t(unsigned, len, NFS_READ_REPLY_HDR_LEN));
+
+	slot = nfs_read_find(ntohl(rpc_pkt.u.reply.id));
+	if (!slot)
 		return -NFS_RPC_DROP;
 
 	if (rpc_pkt.u.reply.rstatus  ||
@@ -678,31 +871,52 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
-
 	if (supported_nfs_versions & NFSV2_FLAG) {
+		/* Status, file attributes and data length, then the data */
+		if (nfs_reply_words(len) < 19)
+			return -NFS_RPC_DROP;
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
-		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
+		data_ptr = &rpc_pkt.u.reply.data[19];
+		/* The size from the file attributes */
+		nfs_file_size = ntohl(rpc_pkt.u.reply.data[6]);
 	} else {  /* NFSV3_FLAG */
 		int nfsv3_data_offset =
-			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
+			nfs3_get_attributes_offset(rpc_pkt.u.reply.data, len);
 
+		/* Count, EOF flag and data length, then the data */
+		if (nfsv3_data_offset < 0 ||
+		    4 + nfsv3_data_offset > nfs_reply_words(len))
+			return -NFS_RPC_DROP;
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
-		/* Skip unused values :
-			EOF:		32 bits value,
-			data_size:	32 bits value,
-		*/
-		data_ptr = (uchar *)
-			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
+		/* EOF flag, then skip data_size */
+		eof = ntohl(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]);
+		data_ptr = &rpc_pkt.u.reply.data[4 + nfsv3_data_offset];
 	}
 
-	if (store_block(data_ptr, nfs_offset, rlen))
-			return -9999;
+	/* Let the timer send truncated or oversized replies again */
+	data_off = (uchar *)data_ptr - rpc_pkt.u.data;
+	if (rlen < 0 || rlen > slot->len || data_off + rlen > len)
+		return -NFS_RPC_DROP;
+	if (eof)
+		nfs_file_size = slot->offset + rlen;
+
+	if (rlen && store_block(pkt + data_off, slot->offset, rlen))
+		return -9999;
+	nfs_read_total += rlen;
+	nfs_show_progress();
+
+	/* Ask for the rest of a short read which did not end the file */
+	slot->offset += rlen;
+	slot->len -= rlen;
+	if (!rlen && !nfs_read_past_end(slot->offset))
+		nfs_file_size = slot->offset;
+	if (slot->len && !nfs_read_past_end(slot->offset)) {
+		slot->retries = 0;
+		nfs_read_send(slot);
+	} else {
+		slot->id = 0;
+	}
 
 	return rlen;
 }
@@ -712,6 +926,10 @@ Interfaces of U-BOOT
 **************************************************************************/
 static void nfs_timeout_handler(void)
 {
+	if (nfs_state == STATE_READ_REQ) {
+		nfs_read_timeout();
+		return;
+	}
 	if (++nfs_timeout_count > NFS_RETRY_COUNT) {
 		puts("\nRetry count exceeded; starting again\n");
 		net_start_again();
@@ -796,9 +1014,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			nfs_send();
+			nfs_read_start();
 		}
 		break;
 
@@ -822,19 +1038,28 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 	case STATE_READ_REQ:
 		rlen = nfs_read_reply(pkt, len);
-		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen == -NFS_RPC_DROP)
+			break;
+		if (rlen >= 0) {
+			/* Keep the window full until the whole file is in */
+			nfs_read_fill();
+			if (nfs_read_set_timer())
+				break;
+			nfs_download_state = NETLOOP_SUCCESS;
+			nfs_state = STATE_UMOUNT_REQ;
+			net_set_timeout_handler(nfs_timeout,
+						nfs_timeout_handler);
 			nfs_send();
-		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
+			break;
+		}
+		nfs_read_reset();
+		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
+		if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
-			if (rlen < 0)
-				debug("NFS READ error (%d)\n", rlen);
+			debug("NFS READ error (%d)\n", rlen);
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		}
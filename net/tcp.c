@@ -0,0 +1,698 @@
+/*
+ * Minimal TCP client
+ *
+ * One connection at a time, opened by U-Boot. Received data is passed up
+ * in order; segments which arrive ahead of a gap are kept in a receive
+ * buffer, so a lost packet costs one retransmission instead of the rest of
+ * the window. The receive window is that whole buffer and is advertised
+ * with window scaling, which lets a server keep the link busy on paths
+ * with a long round-trip time.
+ *
+ * On the sending side the peer's window is honoured, lost segments are
+ * found by the retransmission timer (RFC 6298) or, sooner, by three
+ * duplicate ACKs (fast retransmit, RFC 5681). There is no congestion
+ * control: U-Boot only sends short requests.
+ *
+ * A connection lasts no longer than the net_loop() which opened it. After
+ * a clean close it sits in TIME_WAIT, where a retransmitted FIN is ACKed
+ * again, until the loop ends; the next connection then uses another port.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <asm/unaligned.h>
+
+#define TCP_MSS			1460	/* Largest segment for a 1500 MTU */
+#define TCP_MSS_DEFAULT		536	/* If the peer does not say */
+#define TCP_SEND_BUF		2048
+#define TCP_OOO_RANGES		8	/* Gaps we keep track of */
+#define TCP_DUPACKS		3	/* Duplicate ACKs meaning a loss */
+#define TCP_RETRIES		8	/* Timeouts in a row before giving up */
+#define TCP_MAX_SHIFT		14	/* Largest window scale (RFC 7323) */
+
+/* Retransmission timeout, ms */
+#define TCP_RTO_INIT		1000
+#define TCP_RTO_MIN		200
+#define TCP_RTO_MAX		16000
+/* Time to wait for a retransmitted FIN after both sides closed, ms */
+#define TCP_TIME_WAIT_LEN	(2 * TCP_RTO_MAX)
+
+#define TCPOPT_EOL		0
+#define TCPOPT_NOP		1
+#define TCPOPT_MSS		2
+#define TCPOPT_WSCALE		3
+
+enum tcp_state {
+	TCP_CLOSED,
+	TCP_SYN_SENT,
+	TCP_ESTABLISHED,
+	TCP_FIN_WAIT_1,		/* We have closed, FIN not acknowledged yet */
+	TCP_FIN_WAIT_2,		/* We have closed, peer has not */
+	TCP_CLOSE_WAIT,		/* Peer has closed, we have not */
+	TCP_CLOSING,		/* Both closed, our FIN not acknowledged */
+	TCP_LAST_ACK,		/* Peer closed first, our FIN not acked */
+	TCP_TIME_WAIT,		/* Finished, ACKing a retransmitted FIN */
+};
+
+/* Sequence numbers [start, end) received ahead of rcv_nxt */
+struct tcp_range {
+	u32 start;
+	u32 end;
+};
+
+static struct tcp_conn {
+	enum tcp_state state;
+	struct in_addr ip;
+	uchar ethaddr[ARP_HLEN];
+	u16 sport;
+	u16 dport;
+	tcp_rx_handler *rx;
+	tcp_event_handler *event;
+
+	/* Sending: sbuf holds the data from snd_una on */
+	u32 iss;
+	u32 snd_una;
+	u32 snd_nxt;
+	u32 snd_wnd;
+	u8 snd_shift;
+	u16 snd_mss;
+	uchar sbuf[TCP_SEND_BUF];
+	u32 slen;
+	bool fin_queued;	/* FIN to send, or sent and not acknowledged */
+	int dupacks;
+	int retries;		/* Timeouts since the connection moved on */
+
+	/* Round-trip time, ms, timed on one segment at a time */
+	bool rtt_timing;
+	u32 rtt_seq;
+	ulong rtt_start;
+	ulong srtt;
+	ulong rttvar;
+	ulong rto;
+
+	/* Receiving: rbuf[rhead] holds the byte at rcv_nxt */
+	u32 rcv_nxt;
+	u8 rcv_shift;
+	uchar *rbuf;
+	u32 rsize;
+	u32 rhead;
+	struct tcp_range ooo[TCP_OOO_RANGES];
+	int ooo_count;
+	bool rcv_fin;		/* FIN received ahead of a gap, at fin_seq */
+	u32 fin_seq;
+} tcp;
+
+/* Source port of the last connection, not to be used by the next one */
+static u16 tcp_last_sport;
+
+static void tcp_timeout(void);
+
+static inline bool tcp_before(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
+
+static inline bool tcp_after(u32 a, u32 b)
+{
+	return (s32)(b - a) < 0;
+}
+
+static unsigned int tcp_checksum(struct ip_tcp_hdr *hdr, int len)
+{
+	struct {
+		struct in_addr src;
+		struct in_addr dst;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} pseudo;
+
+	net_copy_ip(&pseudo.src, &hdr->ip_src);
+	net_copy_ip(&pseudo.dst, &hdr->ip_dst);
+	pseudo.zero = 0;
+	pseudo.proto = IPPROTO_TCP;
+	pseudo.len = htons(len);
+
+	return add_ip_checksums(sizeof(pseudo),
+				compute_ip_checksum(&pseudo, sizeof(pseudo)),
+				compute_ip_checksum(&hdr->tcp_src, len));
+}
+
+static u16 tcp_window(bool syn)
+{
+	/* The window in a SYN is never scaled */
+	return min_t(u32, tcp.rsize >> (syn ? 0 : tcp.rcv_shift), 0xffff);
+}
+
+static void tcp_send_segment(u8 flags, u32 seq, const uchar *data, int len)
+{
+	struct ip_tcp_hdr *hdr;
+	int eth_hdr_size;
+	int hlen = TCP_HDR_SIZE;
+	uchar *opt;
+
+	eth_hdr_size = net_set_ether(net_tx_packet, tcp.ethaddr, PROT_IP);
+	hdr = (struct ip_tcp_hdr *)(net_tx_packet + eth_hdr_size);
+	if (flags & TCP_SYN) {
+		opt = (uchar *)hdr + IP_TCP_HDR_SIZE;
+		opt[0] = TCPOPT_MSS;
+		opt[1] = 4;
+		put_unaligned_be16(TCP_MSS, opt + 2);
+		opt[4] = TCPOPT_NOP;
+		opt[5] = TCPOPT_WSCALE;
+		opt[6] = 3;
+		opt[7] = tcp.rcv_shift;
+		hlen += 8;
+	}
+	memcpy((uchar *)hdr + IP_HDR_SIZE + hlen, data, len);
+
+	net_set_ip_header((uchar *)hdr, tcp.ip, net_ip);
+	hdr->ip_len = htons(IP_HDR_SIZE + hlen + len);
+	hdr->ip_p = IPPROTO_TCP;
+	hdr->ip_sum = compute_ip_checksum(hdr, IP_HDR_SIZE);
+
+	hdr->tcp_src = htons(tcp.sport);
+	hdr->tcp_dst = htons(tcp.dport);
+	put_unaligned_be32(seq, &hdr->tcp_seq);
+	put_unaligned_be32(flags & TCP_ACK ? tcp.rcv_nxt : 0, &hdr->tcp_ack);
+	hdr->tcp_hlen = hlen << 2;
+	hdr->tcp_flags = flags;
+	hdr->tcp_win = htons(tcp_window(flags & TCP_SYN));
+	hdr->tcp_xsum = 0;
+	hdr->tcp_urg = 0;
+	hdr->tcp_xsum = tcp_checksum(hdr, hlen + len);
+
+	net_send_ip_packet(tcp.ethaddr, tcp.ip,
+			   eth_hdr_size + IP_HDR_SIZE + hlen + len);
+}
+
+static void tcp_send_ack(void)
+{
+	tcp_send_segment(TCP_ACK, tcp.snd_nxt, NULL, 0);
+}
+
+/* The timeout backs off exponentially while nothing happens */
+static void tcp_set_timer(void)
+{
+	net_set_timeout_handler(min(tcp.rto << min(tcp.retries, 8),
+				    (ulong)TCP_RTO_MAX), tcp_timeout);
+}
+
+/* No more data moves on the connection */
+static bool tcp_finished(void)
+{
+	return tcp.state == TCP_CLOSED || tcp.state == TCP_TIME_WAIT;
+}
+
+static void tcp_set_state(enum tcp_state state, int event)
+{
+	tcp.state = state;
+	if (state == TCP_TIME_WAIT)
+		net_set_timeout_handler(TCP_TIME_WAIT_LEN, tcp_timeout);
+	else if (state == TCP_CLOSED)
+		net_set_timeout_handler(0, NULL);
+	if (tcp_finished()) {
+		free(tcp.rbuf);
+		tcp.rbuf = NULL;
+	}
+	if (event >= 0)
+		tcp.event(event);
+}
+
+/* Send what the peer's window allows, and a FIN once the data is gone */
+static void tcp_output(void)
+{
+	u32 off, len, limit;
+	bool sending = tcp.snd_nxt != tcp.snd_una;
+
+	while (!tcp_finished() && tcp.state != TCP_SYN_SENT) {
+		off = tcp.snd_nxt - tcp.snd_una;
+		if (off < tcp.slen) {
+			limit = tcp.snd_una + tcp.snd_wnd - tcp.snd_nxt;
+			if ((s32)limit <= 0)
+				break;
+			len = min3(tcp.slen - off, (u32)tcp.snd_mss, limit);
+			tcp_send_segment(TCP_ACK | (off + len == tcp.slen ?
+					 TCP_PSH : 0), tcp.snd_nxt,
+					 tcp.sbuf + off, len);
+		} else if (tcp.fin_queued && off == tcp.slen) {
+			tcp_send_segment(TCP_FIN | TCP_ACK, tcp.snd_nxt,
+					 NULL, 0);
+			len = 1;
+		} else {
+			break;
+		}
+		if (!tcp.rtt_timing) {
+			tcp.rtt_timing = true;
+			tcp.rtt_seq = tcp.snd_nxt;
+			tcp.rtt_start = get_timer(0);
+		}
+		tcp.snd_nxt += len;
+	}
+	if (!sending && tcp.snd_nxt != tcp.snd_una)
+		tcp_set_timer();
+}
+
+/* Resend the oldest unacknowledged segment */
+static void tcp_retransmit(void)
+{
+	/* Karn's algorithm: never time a retransmitted segment */
+	tcp.rtt_timing = false;
+	if (tcp.state == TCP_SYN_SENT) {
+		tcp_send_segment(TCP_SYN, tcp.iss, NULL, 0);
+	} else if (tcp.slen) {
+		tcp_send_segment(TCP_ACK | TCP_PSH, tcp.snd_una, tcp.sbuf,
+				 min_t(u32, tcp.slen, tcp.snd_mss));
+	} else if (tcp.fin_queued) {
+		tcp_send_segment(TCP_FIN | TCP_ACK, tcp.snd_una, NULL, 0);
+	}
+}
+
+static void tcp_timeout(void)
+{
+	if (tcp.state == TCP_TIME_WAIT) {
+		tcp_set_state(TCP_CLOSED, -1);
+		return;
+	}
+	if (++tcp.retries > TCP_RETRIES) {
+		tcp_set_state(TCP_CLOSED, TCP_EVENT_TIMEOUT);
+		return;
+	}
+	if (tcp.snd_nxt != tcp.snd_una) {
+		tcp_retransmit();
+	} else {
+		/* Idle: repeat our ACK in case the peer is waiting for it */
+		tcp_send_ack();
+	}
+	tcp_set_timer();
+}
+
+static void tcp_update_rtt(ulong rtt)
+{
+	ulong delta;
+
+	if (!tcp.srtt) {
+		tcp.srtt = rtt ? rtt : 1;
+		tcp.rttvar = rtt / 2;
+	} else {
+		delta = tcp.srtt > rtt ? tcp.srtt - rtt : rtt - tcp.srtt;
+		tcp.rttvar = (3 * tcp.rttvar + delta) / 4;
+		tcp.srtt = (7 * tcp.srtt + rtt) / 8;
+	}
+	tcp.rto = clamp(tcp.srtt + 4 * tcp.rttvar, (ulong)TCP_RTO_MIN,
+			(ulong)TCP_RTO_MAX);
+}
+
+/* Handle an ACK, returning true if it acknowledged something new */
+static bool tcp_ack(u32 ack, u16 win)
+{
+	u32 acked, data;
+	bool progress = false;
+
+	if (tcp_after(ack, tcp.snd_una) && !tcp_after(ack, tcp.snd_nxt)) {
+		acked = ack - tcp.snd_una;
+		data = min_t(u32, acked, tcp.slen);
+		tcp.slen -= data;
+		memmove(tcp.sbuf, tcp.sbuf + data, tcp.slen);
+		tcp.snd_una = ack;
+		tcp.dupacks = 0;
+		if (tcp.rtt_timing && tcp_after(ack, tcp.rtt_seq)) {
+			tcp.rtt_timing = false;
+			tcp_update_rtt(get_timer(tcp.rtt_start));
+		}
+		progress = true;
+
+		/* Our FIN is acknowledged */
+		if (tcp.fin_queued && ack == tcp.snd_nxt && acked > data) {
+			tcp.fin_queued = false;
+			if (tcp.state == TCP_FIN_WAIT_1)
+				tcp_set_state(TCP_FIN_WAIT_2, -1);
+			else if (tcp.state == TCP_CLOSING)
+				tcp_set_state(TCP_TIME_WAIT,
+					      TCP_EVENT_FINISHED);
+			else if (tcp.state == TCP_LAST_ACK)
+				tcp_set_state(TCP_CLOSED, TCP_EVENT_FINISHED);
+		}
+	} else if (ack == tcp.snd_una && tcp.snd_nxt != tcp.snd_una &&
+		   win << tcp.snd_shift == tcp.snd_wnd) {
+		if (++tcp.dupacks == TCP_DUPACKS)
+			tcp_retransmit();
+	}
+	tcp.snd_wnd = win << tcp.snd_shift;
+
+	return progress;
+}
+
+/* Copy received bytes to the receive buffer, which may wrap */
+static void tcp_rbuf_put(u32 seq, const uchar *data, u32 len)
+{
+	u32 pos = (tcp.rhead + (seq - tcp.rcv_nxt)) % tcp.rsize;
+	u32 n = min(len, tcp.rsize - pos);
+
+	memcpy(tcp.rbuf + pos, data, n);
+	memcpy(tcp.rbuf, data + n, len - n);
+}
+
+/* Remember that [start, end) has been received ahead of rcv_nxt */
+static void tcp_ooo_add(u32 start, u32 end)
+{
+	struct tcp_range *r = tcp.ooo;
+	int i, j;
+
+	for (i = 0; i < tcp.ooo_count && tcp_before(r[i].end, start); i++)
+		;
+	if (i == tcp.ooo_count || tcp_before(end, r[i].start)) {
+		/* Not touching a known range; forget it if out of room */
+		if (tcp.ooo_count == TCP_OOO_RANGES)
+			return;
+		memmove(&r[i + 1], &r[i], (tcp.ooo_count - i) * sizeof(*r));
+		r[i].start = start;
+		r[i].end = end;
+		tcp.ooo_count++;
+		return;
+	}
+
+	/* Merge with every range it touches */
+	if (tcp_before(start, r[i].start))
+		r[i].start = start;
+	for (j = i; j + 1 < tcp.ooo_count && !tcp_before(end, r[j + 1].start);
+	     j++)
+		;
+	r[i].end = tcp_after(end, r[j].end) ? end : r[j].end;
+	memmove(&r[i + 1], &r[j + 1], (tcp.ooo_count - j - 1) * sizeof(*r));
+	tcp.ooo_count -= j - i;
+}
+
+static void tcp_deliver(const uchar *data, u32 len)
+{
+	tcp.rcv_nxt += len;
+	tcp.rhead = (tcp.rhead + len) % tcp.rsize;
+	tcp.rx(data, len);
+}
+
+/* Pass up data buffered beyond a gap which has just been filled */
+static void tcp_ooo_deliver(void)
+{
+	struct tcp_range *r = tcp.ooo;
+	u32 len, n;
+
+	while (tcp.ooo_count && !tcp_after(r[0].start, tcp.rcv_nxt) &&
+	       tcp.state != TCP_CLOSED) {
+		if (tcp_after(r[0].end, tcp.rcv_nxt)) {
+			len = r[0].end - tcp.rcv_nxt;
+			n = min(len, tcp.rsize - tcp.rhead);
+			tcp_deliver(tcp.rbuf + tcp.rhead, n);
+			if (len > n && tcp.state != TCP_CLOSED)
+				tcp_deliver(tcp.rbuf, len - n);
+		}
+		memmove(&r[0], &r[1], --tcp.ooo_count * sizeof(*r));
+	}
+}
+
+/* Handle the data and FIN in a segment, returning true if in order */
+static bool tcp_data(u32 seq, const uchar *data, u32 len, bool fin)
+{
+	bool progress = false;
+	u32 skip;
+
+	/* Drop what we already have and what is beyond the window */
+	if (tcp_before(seq, tcp.rcv_nxt)) {
+		skip = min(tcp.rcv_nxt - seq, len);
+		seq += skip;
+		data += skip;
+		len -= skip;
+	}
+	if (seq - tcp.rcv_nxt + len > tcp.rsize) {
+		if (seq - tcp.rcv_nxt >= tcp.rsize)
+			len = 0;
+		else
+			len = tcp.rsize - (seq - tcp.rcv_nxt);
+		fin = false;
+	}
+
+	if (len && seq == tcp.rcv_nxt) {
+		tcp_deliver(data, len);
+		tcp_ooo_deliver();
+		progress = true;
+	} else if (len) {
+		tcp_rbuf_put(seq, data, len);
+		tcp_ooo_add(seq, seq + len);
+	}
+	if (tcp.state == TCP_CLOSED)
+		return progress;
+
+	/* Only take the FIN once everything before it is here */
+	if (fin && seq + len != tcp.rcv_nxt) {
+		tcp.rcv_fin = true;
+		tcp.fin_seq = seq + len;
+	}
+	if ((fin && seq + len == tcp.rcv_nxt) ||
+	    (tcp.rcv_fin && tcp.fin_seq == tcp.rcv_nxt)) {
+		tcp.rcv_fin = false;
+		fin = true;
+		tcp.rcv_nxt++;
+		progress = true;
+		if (tcp.state == TCP_ESTABLISHED)
+			tcp_set_state(TCP_CLOSE_WAIT, TCP_EVENT_CLOSED);
+		else if (tcp.state == TCP_FIN_WAIT_1)
+			tcp_set_state(TCP_CLOSING, TCP_EVENT_CLOSED);
+		else if (tcp.state == TCP_FIN_WAIT_2)
+			tcp_set_state(TCP_TIME_WAIT, TCP_EVENT_CLOSED);
+		if (tcp.state == TCP_TIME_WAIT)
+			tcp.event(TCP_EVENT_FINISHED);
+	}
+
+	/*
+	 * ACK every segment. An out-of-order one gets a duplicate ACK, which
+	 * tells the peer to retransmit the missing segment straight away.
+	 */
+	if (tcp.state != TCP_CLOSED || fin)
+		tcp_send_ack();
+
+	return progress;
+}
+
+static void tcp_parse_options(const uchar *opt, int len)
+{
+	bool wscale = false;
+
+	while (len > 0 && opt[0] != TCPOPT_EOL) {
+		if (opt[0] == TCPOPT_NOP) {
+			opt++;
+			len--;
+			continue;
+		}
+		if (len < 2 || opt[1] < 2 || opt[1] > len)
+			break;
+		if (opt[0] == TCPOPT_MSS && opt[1] == 4) {
+			tcp.snd_mss = clamp(get_unaligned_be16(opt + 2),
+					    (u16)64, (u16)TCP_MSS);
+		} else if (opt[0] == TCPOPT_WSCALE && opt[1] == 3) {
+			tcp.snd_shift = min_t(u8, opt[2], TCP_MAX_SHIFT);
+			wscale = true;
+		}
+		len -= opt[1];
+		opt += opt[1];
+	}
+
+	/* Scaling is only used if both sides asked for it */
+	if (!wscale)
+		tcp.rcv_shift = 0;
+}
+
+static void tcp_syn_sent(struct ip_tcp_hdr *hdr, u32 seq, u32 ack, u8 flags,
+			 int hlen)
+{
+	if (!(flags & TCP_ACK))
+		return;
+	if (ack != tcp.iss + 1) {
+		if (!(flags & TCP_RST))
+			tcp_send_segment(TCP_RST, ack, NULL, 0);
+		return;
+	}
+	if (flags & TCP_RST) {
+		tcp_set_state(TCP_CLOSED, TCP_EVENT_RESET);
+		return;
+	}
+	if (!(flags & TCP_SYN))
+		return;
+
+	tcp_parse_options((uchar *)hdr + IP_TCP_HDR_SIZE, hlen - TCP_HDR_SIZE);
+	tcp.rcv_nxt = seq + 1;
+	tcp.snd_una = ack;
+	tcp.snd_wnd = ntohs(hdr->tcp_win);
+	tcp.retries = 0;
+	if (tcp.rtt_timing) {
+		tcp.rtt_timing = false;
+		tcp_update_rtt(get_timer(tcp.rtt_start));
+	}
+	tcp_set_timer();
+	tcp_send_ack();
+	tcp_set_state(TCP_ESTABLISHED, TCP_EVENT_CONNECTED);
+	tcp_output();
+}
+
+void tcp_receive(struct ip_tcp_hdr *hdr, unsigned int len)
+{
+	u32 seq, ack, plen;
+	int hlen;
+	u8 flags;
+	bool progress;
+
+	if (len < IP_TCP_HDR_SIZE)
+		return;
+	hlen = (hdr->tcp_hlen >> 4) * 4;
+	if (hlen < TCP_HDR_SIZE || IP_HDR_SIZE + hlen > len)
+		return;
+	if (net_read_ip(&hdr->ip_src).s_addr != tcp.ip.s_addr ||
+	    ntohs(hdr->tcp_src) != tcp.dport ||
+	    ntohs(hdr->tcp_dst) != tcp.sport)
+		return;
+	if (tcp_checksum(hdr, len - IP_HDR_SIZE)) {
+		debug("%s: bad checksum\n", __func__);
+		return;
+	}
+
+	seq = get_unaligned_be32(&hdr->tcp_seq);
+	ack = get_unaligned_be32(&hdr->tcp_ack);
+	flags = hdr->tcp_flags;
+	plen = len - IP_HDR_SIZE - hlen;
+	debug_cond(DEBUG_DEV_PKT, "TCP seq %u ack %u flags %02x len %u\n",
+		   seq, ack, flags, plen);
+
+	switch (tcp.state) {
+	case TCP_CLOSED:
+		return;
+	case TCP_TIME_WAIT:
+		if (flags & TCP_RST) {
+			tcp_set_state(TCP_CLOSED, -1);
+		} else if (flags & TCP_FIN) {
+			/* The peer missed our last ACK, send it again */
+			tcp_set_state(TCP_TIME_WAIT, -1);
+			tcp_send_ack();
+		}
+		return;
+	case TCP_SYN_SENT:
+		tcp_syn_sent(hdr, seq, ack, flags, hlen);
+		return;
+	default:
+		break;
+	}
+
+	if (flags & TCP_RST) {
+		/* Only believe a reset which is inside the window */
+		if (!tcp_before(seq, tcp.rcv_nxt) &&
+		    tcp_before(seq, tcp.rcv_nxt + tcp.rsize))
+			tcp_set_state(TCP_CLOSED, TCP_EVENT_RESET);
+		return;
+	}
+	if (flags & TCP_SYN) {
+		/* Our ACK of the peer's SYN was lost */
+		tcp_send_ack();
+		return;
+	}
+	if (!(flags & TCP_ACK))
+		return;
+
+	progress = tcp_ack(ack, ntohs(hdr->tcp_win));
+	if (tcp_finished())
+		return;
+	if (plen || (flags & TCP_FIN))
+		progress |= tcp_data(seq, (uchar *)hdr + IP_HDR_SIZE + hlen,
+				     plen, flags & TCP_FIN);
+	if (tcp_finished())
+		return;
+
+	/* Restart the timer whenever the connection moves on */
+	if (progress) {
+		tcp.retries = 0;
+		tcp_set_timer();
+	}
+	tcp_output();
+}
+
+int tcp_connect(struct in_addr dest, int dport, tcp_rx_handler *rx,
+		tcp_event_handler *event)
+{
+	u32 size = CONFIG_TCP_RX_WINDOW;
+
+	free(tcp.rbuf);
+	memset(&tcp, '\0', sizeof(tcp));
+	tcp.rbuf = malloc(size);
+	if (!tcp.rbuf)
+		return -ENOMEM;
+	tcp.rsize = size;
+	while (tcp.rcv_shift < TCP_MAX_SHIFT &&
+	       (size >> tcp.rcv_shift) > 0xffff)
+		tcp.rcv_shift++;
+
+	tcp.ip = dest;
+	tcp.dport = dport;
+	/* The peer may still hold the last connection in TIME_WAIT */
+	tcp.sport = 49152 + get_timer(0) % 16384;
+	if (tcp.sport == tcp_last_sport)
+		tcp.sport = 49152 + (tcp.sport - 49152 + 1) % 16384;
+	tcp_last_sport = tcp.sport;
+	tcp.rx = rx;
+	tcp.event = event;
+	tcp.iss = (u32)get_ticks();
+	tcp.snd_una = tcp.iss;
+	tcp.snd_nxt = tcp.iss + 1;
+	tcp.snd_mss = TCP_MSS_DEFAULT;
+	tcp.rto = TCP_RTO_INIT;
+	tcp.state = TCP_SYN_SENT;
+
+	tcp.rtt_timing = true;
+	tcp.rtt_seq = tcp.snd_nxt;
+	tcp.rtt_start = get_timer(0);
+	tcp_send_segment(TCP_SYN, tcp.iss, NULL, 0);
+	tcp_set_timer();
+
+	return 0;
+}
+
+int tcp_send(const void *data, int len)
+{
+	if (tcp.state != TCP_ESTABLISHED && tcp.state != TCP_CLOSE_WAIT)
+		return -ENOTCONN;
+
+	len = min_t(int, len, TCP_SEND_BUF - tcp.slen);
+	memcpy(tcp.sbuf + tcp.slen, data, len);
+	tcp.slen += len;
+	tcp_output();
+
+	return len;
+}
+
+void tcp_close(void)
+{
+	switch (tcp.state) {
+	case TCP_SYN_SENT:
+		tcp_set_state(TCP_CLOSED, -1);
+		return;
+	case TCP_ESTABLISHED:
+		tcp.state = TCP_FIN_WAIT_1;
+		break;
+	case TCP_CLOSE_WAIT:
+		tcp.state = TCP_LAST_ACK;
+		break;
+	default:
+		return;
+	}
+	tcp.fin_queued = true;
+	tcp_output();
+}
+
+void tcp_abort(void)
+{
+	if (tcp.state == TCP_CLOSED)
+		return;
+	if (tcp.state != TCP_SYN_SENT && tcp.state != TCP_TIME_WAIT)
+		tcp_send_segment(TCP_RST | TCP_ACK, tcp.snd_nxt, NULL, 0);
+	tcp_set_state(TCP_CLOSED, -1);
+}
@@ -134,34 +134,123 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 window size: the number of blocks the server sends before it
+ * waits for an ACK. This stays at 1 (lock-step, as in RFC 1350) unless the
+ * server acknowledges the option.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+
+static unsigned short tftp_windowsize = 1;
+static unsigned short tftp_windowsize_option = TFTP_WINDOWSIZE;
+/* block number which completes the current window and must be ACKed */
+static ulong	tftp_next_ack;
+/* last in-order block we re-ACKed after a lost or reordered block */
+static ulong	tftp_last_nack;
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
+/* Initial size of the received-block bitmap in bytes, doubled as needed */
 #define MTFTP_BITMAPSIZE	0x1000
-static unsigned *tftp_mcast_bitmap;
-static int tftp_mcast_prev_hole;
-static int tftp_mcast_bitmap_size = MTFTP_BITMAPSIZE;
+static uchar *tftp_mcast_bitmap;
+static ulong tftp_mcast_bitmap_size;
+/* every block before this one (counting from 0) has been received */
+static ulong tftp_mcast_prev_hole;
 static int tftp_mcast_disabled;
 static int tftp_mcast_master_client;
 static int tftp_mcast_active;
 static int tftp_mcast_port;
+/* highest block number seen, used to undo the 16-bit wrap */
+static ulong tftp_mcast_highest;
+/* number of different blocks received */
+static ulong tftp_mcast_received;
 /* can get 'last' block before done..*/
 static ulong tftp_mcast_ending_block;
+/* where to send the request again if the group goes quiet */
+static int tftp_mcast_server_port;
 
-static void parse_multicast_oack(char *pkt, int len);
+static int parse_multicast_oack(char *pkt, int len);
 
 static void mcast_cleanup(void)
 {
-	if (net_mcast_addr)
+	if (net_mcast_addr.s_addr)
 		eth_mcast_join(net_mcast_addr, 0);
-	if (tftp_mcast_bitmap)
-		free(tftp_mcast_bitmap);
+	free(tftp_mcast_bitmap);
 	tftp_mcast_bitmap = NULL;
 	net_mcast_addr.s_addr = 0;
 	tftp_mcast_active = 0;
+	tftp_mcast_master_client = 0;
 	tftp_mcast_port = 0;
 	tftp_mcast_ending_block = -1;
 }
 
+static int mcast_test_block(ulong nr)
+{
+	return tftp_mcast_bitmap[nr >> 3] & (1 << (nr & 7));
+}
+
+static void mcast_set_block(ulong nr)
+{
+	tftp_mcast_bitmap[nr >> 3] |= 1 << (nr & 7);
+}
+
+/* Find the first block from @nr on which has not been received */
+static ulong mcast_next_hole(ulong nr)
+{
+	ulong bits = tftp_mcast_bitmap_size * 8;
+
+	while (nr < bits && mcast_test_block(nr)) {
+		if (!(nr & 7) && tftp_mcast_bitmap[nr >> 3] == 0xff)
+			nr += 8;
+		else
+			nr++;
+	}
+
+	return nr;
+}
+
+/* Make room in the bitmap for block @nr */
+static int mcast_bitmap_grow(ulong nr)
+{
+	ulong size = tftp_mcast_bitmap_size;
+	uchar *map;
+
+	while (nr >= size * 8)
+		size <<= 1;
+	map = realloc(tftp_mcast_bitmap, size);
+	if (!map)
+		return -ENOMEM;
+	memset(map + tftp_mcast_bitmap_size, 0,
+	       size - tftp_mcast_bitmap_size);
+	tftp_mcast_bitmap = map;
+	tftp_mcast_bitmap_size = size;
+
+	return 0;
+}
+
+/*
+ * Block numbers are only 16 bits and a passive client can see blocks in any
+ * order, so take the number nearest to the highest block seen so far.
+ */
+static ulong mcast_block_number(unsigned short block)
+{
+	ulong nr = (tftp_mcast_highest & ~(TFTP_SEQUENCE_SIZE - 1)) | block;
+
+	if (nr + TFTP_SEQUENCE_SIZE / 2 < tftp_mcast_highest)
+		nr += TFTP_SEQUENCE_SIZE;
+	else if (nr > tftp_mcast_highest + TFTP_SEQUENCE_SIZE / 2 &&
+		 nr >= TFTP_SEQUENCE_SIZE)
+		nr -= TFTP_SEQUENCE_SIZE;
+	if (nr > tftp_mcast_highest)
+		tftp_mcast_highest = nr;
+
+	return nr;
+}
+
 #endif	/* CONFIG_MCAST_TFTP */
 
 static inline void store_block(int block, uchar *src, unsigned len)
@@ -196,11 +285,6 @@ static inline void store_block(int block, uchar *src, unsigned len)
 		memcpy(ptr, src, len);
 		unmap_sysmem(ptr);
 	}
-#ifdef CONFIG_MCAST_TFTP
-	if (tftp_mcast_active)
-		ext2_set_bit(block, tftp_mcast_bitmap);
-#endif
-
 	if (net_boot_file_size < newsize)
 		net_boot_file_size = newsize;
 }
@@ -211,6 +295,8 @@ static void new_transfer(void)
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_next_ack = tftp_windowsize;
+	tftp_last_nack = TFTP_SEQUENCE_SIZE;
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -303,6 +389,25 @@ static void update_block_number(void)
 	}
 }
 
+/*
+ * A block of the current window was lost or arrived out of order. Re-ACK
+ * the last block received in order so the server resends the window from
+ * the block after it. Only do this once per gap: the rest of the window
+ * will arrive out of order too, and each further ACK would make the server
+ * restart the window again.
+ */
+static void tftp_nack(void)
+{
+	if (tftp_last_nack == tftp_prev_block)
+		return;
+
+	debug("Lost block after %lu, re-ACK\n", tftp_prev_block);
+	tftp_last_nack = tftp_prev_block;
+	tftp_cur_block = tftp_prev_block;
+	tftp_next_ack = (unsigned short)(tftp_prev_block + tftp_windowsize);
+	tftp_send();
+}
+
 /* The TFTP get or put is complete */
 static void tftp_complete(void)
 {
@@ -372,17 +477,14 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* and for more than one block in flight */
+		if (tftp_windowsize_option > 1 && !tftp_put_active)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_windowsize_option, 0);
 #ifdef CONFIG_MCAST_TFTP
-		/* Check all preconditions before even trying the option */
-		if (!tftp_mcast_disabled) {
-			tftp_mcast_bitmap = malloc(tftp_mcast_bitmap_size);
-			if (tftp_mcast_bitmap && eth_get_dev()->mcast) {
-				free(tftp_mcast_bitmap);
-				tftp_mcast_bitmap = NULL;
-				pkt += sprintf((char *)pkt, "multicast%c%c",
-					0, 0);
-			}
-		}
+		/* Offer to join a group unless that failed before */
+		if (!tftp_mcast_disabled)
+			pkt += sprintf((char *)pkt, "multicast%c%c", 0, 0);
 #endif /* CONFIG_MCAST_TFTP */
 		len = pkt - xp;
 		break;
@@ -391,9 +493,7 @@ static void tftp_send(void)
 #ifdef CONFIG_MCAST_TFTP
 		/* My turn!  Start at where I need blocks I missed. */
 		if (tftp_mcast_active)
-			tftp_cur_block = ext2_find_next_zero_bit(
-				tftp_mcast_bitmap,
-				tftp_mcast_bitmap_size * 8, 0);
+			tftp_cur_block = tftp_mcast_prev_hole;
 		/* fall through */
 #endif
 
@@ -457,17 +557,86 @@ static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 }
 #endif
 
+#ifdef CONFIG_MCAST_TFTP
+/* We have every block: tell the server and leave the group */
+static void mcast_done(void)
+{
+	uchar *pkt;
+	__be16 *s;
+
+	if (tftp_mcast_master_client) {
+		/* ACK the last block, the server then picks a new master */
+		tftp_cur_block = tftp_mcast_ending_block;
+		tftp_send();
+	} else {
+		/* Ask the server to drop us from its list of clients */
+		pkt = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+		s = (__be16 *)pkt;
+		*s++ = htons(TFTP_ERROR);
+		*s++ = htons(TFTP_ERR_UNDEFINED);
+		strcpy((char *)s, "Done");
+		net_send_udp_packet(net_server_ethaddr, tftp_remote_ip,
+				    tftp_remote_port, tftp_our_port,
+				    4 + 4 /*strlen("Done")*/ + 1);
+	}
+	mcast_cleanup();
+	tftp_complete();
+}
+
+/*
+ * A data block of a multicast transfer. Passive clients only collect
+ * blocks, in whatever order they come. The master client acknowledges the
+ * last block before its first hole, so the server sends what it is missing
+ * next; the other clients pick those blocks up too.
+ */
+static void mcast_data(unsigned short block, uchar *data, unsigned len)
+{
+	ulong nr = mcast_block_number(block);
+
+	if (!nr)
+		return;
+	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+
+	if (nr - 1 >= tftp_mcast_bitmap_size * 8 &&
+	    mcast_bitmap_grow(nr - 1)) {
+		puts("\nNo memory for the multicast bitmap\n");
+		mcast_cleanup();
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+	if (len < tftp_block_size)
+		tftp_mcast_ending_block = nr;
+	if (!mcast_test_block(nr - 1)) {
+		store_block(nr - 1, data, len);
+		mcast_set_block(nr - 1);
+		tftp_cur_block = ++tftp_mcast_received;
+		show_block_marker();
+	}
+
+	tftp_mcast_prev_hole = mcast_next_hole(tftp_mcast_prev_hole);
+	if (tftp_mcast_prev_hole >= tftp_mcast_ending_block) {
+		mcast_done();
+		return;
+	}
+	if (tftp_mcast_master_client) {
+		tftp_cur_block = tftp_mcast_prev_hole;
+		tftp_send();
+	}
+}
+#endif /* CONFIG_MCAST_TFTP */
+
 static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			 unsigned src, unsigned len)
 {
 	__be16 proto;
 	__be16 *s;
+	unsigned short block;
+	ulong win = 0;
 	int i;
 
 	if (dest != tftp_our_port) {
 #ifdef CONFIG_MCAST_TFTP
-		if (tftp_mcast_active &&
-		    (!tftp_mcast_port || dest != tftp_mcast_port))
+		if (!tftp_mcast_active || dest != tftp_mcast_port)
 #endif
 			return;
 	}
@@ -540,6 +709,12 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				win = simple_strtoul((char *)pkt + i + 11,
+						     NULL, 10);
+				debug("Windowsize ack: %s, %lu\n",
+				      (char *)pkt + i + 11, win);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -549,11 +724,24 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			}
 #endif
 		}
+		if (win >= 1 && win <= tftp_windowsize_option)
+			tftp_windowsize = win;
+		else
+			tftp_windowsize = 1;
+		tftp_next_ack = tftp_windowsize;
 #ifdef CONFIG_MCAST_TFTP
-		parse_multicast_oack((char *)pkt, len - 1);
-		if ((tftp_mcast_active) && (!tftp_mcast_master_client))
+		if (parse_multicast_oack((char *)pkt, len))
+			break;
+		if (tftp_mcast_active && !tftp_mcast_master_client) {
 			tftp_state = STATE_DATA;	/* passive.. */
-		else
+			break;
+		}
+		/* Made master client after we already got everything */
+		if (tftp_mcast_active &&
+		    tftp_mcast_prev_hole >= tftp_mcast_ending_block) {
+			mcast_done();
+			break;
+		}
 #endif
 #ifdef CONFIG_CMD_TFTPPUT
 		if (tftp_put_active) {
@@ -568,40 +756,59 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
-		tftp_cur_block = ntohs(*(__be16 *)pkt);
-
-		update_block_number();
+		block = ntohs(*(__be16 *)pkt);
 
+#ifdef CONFIG_MCAST_TFTP
+		if (tftp_mcast_active) {
+			mcast_data(block, pkt + 2, len);
+			break;
+		}
+#endif
 		if (tftp_state == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
 
 		if (tftp_state == STATE_SEND_RRQ || tftp_state == STATE_OACK ||
 		    tftp_state == STATE_RECV_WRQ) {
+			if (block != 1 && tftp_windowsize > 1) {
+				/* first block of the first window was lost */
+				tftp_nack();
+				break;
+			}
+
 			/* first block received */
 			tftp_state = STATE_DATA;
 			tftp_remote_port = src;
 			new_transfer();
 
-#ifdef CONFIG_MCAST_TFTP
-			if (tftp_mcast_active) { /* start!=1 common if mcast */
-				tftp_prev_block = tftp_cur_block - 1;
-			} else
-#endif
-			if (tftp_cur_block != 1) {	/* Assertion */
+			if (block != 1) {	/* Assertion */
 				puts("\nTFTP error: ");
-				printf("First block is not block 1 (%ld)\n",
-				       tftp_cur_block);
+				printf("First block is not block 1 (%d)\n",
+				       block);
 				puts("Starting again\n\n");
 				net_start_again();
 				break;
 			}
 		}
 
-		if (tftp_cur_block == tftp_prev_block) {
+		if (block == tftp_prev_block) {
 			/* Same block again; ignore it. */
 			break;
 		}
 
+		if (block != (unsigned short)(tftp_prev_block + 1)) {
+			/*
+			 * Blocks from before the last in-order one are
+			 * retransmissions and are dropped. A later one means
+			 * we lost part of the window.
+			 */
+			if ((short)(block - (tftp_prev_block + 1)) > 0)
+				tftp_nack();
+			break;
+		}
+
+		tftp_cur_block = block;
+		update_block_number();
+
 		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
@@ -612,44 +819,16 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		 *	Acknowledge the block just received, which will prompt
 		 *	the remote for the next one.
 		 */
-#ifdef CONFIG_MCAST_TFTP
-		/* if I am the MasterClient, actively calculate what my next
-		 * needed block is; else I'm passive; not ACKING
+		/*
+		 * With a window, only the last block of each window (or of
+		 * the file) is acknowledged.
 		 */
-		if (tftp_mcast_active) {
-			if (len < tftp_block_size)  {
-				tftp_mcast_ending_block = tftp_cur_block;
-			} else if (tftp_mcast_master_client) {
-				tftp_mcast_prev_hole = ext2_find_next_zero_bit(
-					tftp_mcast_bitmap,
-					tftp_mcast_bitmap_size * 8,
-					tftp_mcast_prev_hole);
-				tftp_cur_block = tftp_mcast_prev_hole;
-				if (tftp_cur_block >
-				    ((tftp_mcast_bitmap_size * 8) - 1)) {
-					debug("tftpfile too big\n");
-					/* try to double it and retry */
-					tftp_mcast_bitmap_size <<= 1;
-					mcast_cleanup();
-					net_start_again();
-					return;
-				}
-				tftp_prev_block = tftp_cur_block;
-			}
+		if (tftp_cur_block == tftp_next_ack || len < tftp_block_size) {
+			tftp_next_ack = (unsigned short)(tftp_cur_block +
+							 tftp_windowsize);
+			tftp_send();
 		}
-#endif
-		tftp_send();
 
-#ifdef CONFIG_MCAST_TFTP
-		if (tftp_mcast_active) {
-			if (tftp_mcast_master_client &&
-			    (tftp_cur_block >= tftp_mcast_ending_block)) {
-				puts("\nMulticast tftp done\n");
-				mcast_cleanup();
-				net_set_state(NETLOOP_SUCCESS);
-			}
-		} else
-#endif
 		if (len < tftp_block_size)
 			tftp_complete();
 		break;
@@ -690,6 +869,21 @@ static void tftp_timeout_handler(void)
 	} else {
 		puts("T ");
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		/* the server resends the whole window after our ACK */
+		if (tftp_state == STATE_DATA && !tftp_put_active)
+			tftp_next_ack = (unsigned short)(tftp_cur_block +
+							 tftp_windowsize);
+#ifdef CONFIG_MCAST_TFTP
+		/*
+		 * A passive client does not ACK. Once the group has gone
+		 * quiet, ask the server again so that it makes us the master
+		 * client and sends the blocks we missed.
+		 */
+		if (tftp_mcast_active && !tftp_mcast_master_client) {
+			tftp_state = STATE_SEND_RRQ;
+			tftp_remote_port = tftp_mcast_server_port;
+		}
+#endif
 		if (tftp_state != STATE_RECV_WRQ)
 			tftp_send();
 	}
@@ -700,6 +894,7 @@ void tftp_start(enum proto_t protocol)
 {
 #if CONFIG_NET_TFTP_VARS
 	char *ep;             /* Environment pointer */
+	long win;
 
 	/*
 	 * Allow the user to choose TFTP blocksize and timeout.
@@ -710,6 +905,17 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = getenv("tftpwindowsize");
+	if (ep != NULL) {
+		win = simple_strtol(ep, NULL, 10);
+		if (win < 1 || win > 65535) {
+			printf("TFTP windowsize (%ld) out of range, set to 1\n",
+			       win);
+			win = 1;
+		}
+		tftp_windowsize_option = win;
+	}
+
 	ep = getenv("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -731,8 +937,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_windowsize_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (net_boot_file_name[0] == '\0') {
@@ -805,6 +1011,7 @@ void tftp_start(enum proto_t protocol)
 		printf("Load address: 0x%lx\n", load_addr);
 		puts("Loading: *\b");
 		tftp_state = STATE_SEND_RRQ;
+		new_transfer();
 		efi_set_bootdev("Net", "", tftp_filename);
 	}
 
@@ -828,13 +1035,18 @@ void tftp_start(enum proto_t protocol)
 	ep = getenv("tftpsrcp");
 	if (ep != NULL)
 		tftp_our_port = simple_strtol(ep, NULL, 10);
+#endif
+#ifdef CONFIG_MCAST_TFTP
+	tftp_mcast_server_port = tftp_remote_port;
 #endif
 	tftp_cur_block = 0;
 
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_windowsize to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_windowsize = 1;
+	tftp_next_ack = tftp_windowsize;
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -862,10 +1074,15 @@ void tftp_start_server(void)
 	timeout_ms = TIMEOUT;
 	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_windowsize to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_windowsize = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
+#ifdef CONFIG_MCAST_TFTP
+	/* A transfer stopped by ctrl-C leaves the group port open */
+	mcast_cleanup();
+#endif
 
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
@@ -894,88 +1111,89 @@ void tftp_start_server(void)
  * The multicast addr/port becomes what I listen to, and if 'mc' is '1' then
  * I am the new master-client so must send ACKs to DataBlocks.  If I am not
  * master-client, I'm a passive client, gathering what DataBlocks I may and
- * making note of which ones I got in my bitmask.
- * In theory, I never go from master->passive..
+ * making note of which ones I got in my bitmask. The server may leave out
+ * the address and port once they have been sent.
  * .. this comes in with pkt already pointing just past opc
+ *
+ * Returns -1 if the transfer is restarted without multicast, else 0.
  */
-static void parse_multicast_oack(char *pkt, int len)
+static int parse_multicast_oack(char *pkt, int len)
 {
-	int i;
+	char *end = pkt + len;
 	struct in_addr addr;
 	char *mc_adr;
 	char *port;
 	char *mc;
+	char *opt;
 
+	/* Options come in name, value pairs */
 	mc_adr = NULL;
-	port = NULL;
-	mc = NULL;
-	/* march along looking for 'multicast\0', which has to start at least
-	 * 14 bytes back from the end.
-	 */
-	for (i = 0; i < len - 14; i++)
-		if (strcmp(pkt + i, "multicast") == 0)
+	while (pkt < end) {
+		opt = pkt;
+		pkt += strlen(pkt) + 1;
+		if (pkt >= end)
+			break;
+		if (strcmp(opt, "multicast") == 0) {
+			mc_adr = pkt;
 			break;
-	if (i >= (len - 14)) /* non-Multicast OACK, ign. */
-		return;
-
-	i += 10; /* strlen multicast */
-	mc_adr = pkt + i;
-	for (; i < len; i++) {
-		if (*(pkt + i) == ',') {
-			*(pkt + i) = '\0';
-			if (port) {
-				mc = pkt + i + 1;
-				break;
-			} else {
-				port = pkt + i + 1;
-			}
 		}
+		pkt += strlen(pkt) + 1;
 	}
-	if (!port || !mc_adr || !mc)
-		return;
-	if (tftp_mcast_active && tftp_mcast_master_client) {
-		printf("I got a OACK as master Client, WRONG!\n");
-		return;
-	}
+	if (!mc_adr) /* non-Multicast OACK, ign. */
+		return 0;
+
+	port = strchr(mc_adr, ',');
+	mc = port ? strchr(port + 1, ',') : NULL;
+	if (!mc)
+		return 0;
+	*port++ = '\0';
+	*mc++ = '\0';
+
 	/* ..I now accept packets destined for this MCAST addr, port */
 	if (!tftp_mcast_active) {
-		if (tftp_mcast_bitmap) {
-			printf("Internal failure! no mcast.\n");
-			free(tftp_mcast_bitmap);
-			tftp_mcast_bitmap = NULL;
-			tftp_mcast_disabled = 1;
-			return;
-		}
-		/* I malloc instead of pre-declare; so that if the file ends
-		 * up being too big for this bitmap I can retry
-		 */
-		tftp_mcast_bitmap = malloc(tftp_mcast_bitmap_size);
+		/* The bitmap grows if the file turns out to be larger */
+		tftp_mcast_bitmap = malloc(MTFTP_BITMAPSIZE);
 		if (!tftp_mcast_bitmap) {
 			printf("No bitmap, no multicast. Sorry.\n");
-			tftp_mcast_disabled = 1;
-			return;
+			goto revert;
 		}
-		memset(tftp_mcast_bitmap, 0, tftp_mcast_bitmap_size);
+		memset(tftp_mcast_bitmap, 0, MTFTP_BITMAPSIZE);
+		tftp_mcast_bitmap_size = MTFTP_BITMAPSIZE;
 		tftp_mcast_prev_hole = 0;
+		tftp_mcast_highest = 0;
+		tftp_mcast_received = 0;
+		tftp_mcast_ending_block = -1;
 		tftp_mcast_active = 1;
 	}
-	addr = string_to_ip(mc_adr);
-	if (net_mcast_addr.s_addr != addr.s_addr) {
-		if (net_mcast_addr.s_addr)
-			eth_mcast_join(net_mcast_addr, 0);
-		net_mcast_addr = addr;
-		if (eth_mcast_join(net_mcast_addr, 1)) {
-			printf("Fail to set mcast, revert to TFTP\n");
-			tftp_mcast_disabled = 1;
-			mcast_cleanup();
-			net_start_again();
+	if (*mc_adr) {
+		addr = string_to_ip(mc_adr);
+		if (net_mcast_addr.s_addr != addr.s_addr) {
+			if (net_mcast_addr.s_addr)
+				eth_mcast_join(net_mcast_addr, 0);
+			net_mcast_addr = addr;
+			if (eth_mcast_join(net_mcast_addr, 1)) {
+				printf("Fail to set mcast, revert to TFTP\n");
+				goto revert;
+			}
 		}
 	}
-	tftp_mcast_master_client = simple_strtoul((char *)mc, NULL, 10);
-	tftp_mcast_port = (unsigned short)simple_strtoul(port, NULL, 10);
-	printf("Multicast: %s:%d [%d]\n", mc_adr, tftp_mcast_port,
-	       tftp_mcast_master_client);
-	return;
+	if (*port)
+		tftp_mcast_port = (unsigned short)simple_strtoul(port, NULL,
+								 10);
+	if (!net_mcast_addr.s_addr || !tftp_mcast_port)
+		goto revert;
+	tftp_mcast_master_client = simple_strtoul(mc, NULL, 10);
+	printf("\nMulticast: %pI4:%d [%d]\n\t ", &net_mcast_addr,
+	       tftp_mcast_port, tftp_mcast_master_client);
+
+	return 0;
+
+revert:
+	tftp_mcast_disabled = 1;
+	mcast_cleanup();
+	net_start_again();
+
+	return -1;
 }
 
 #endif /* Multicast TFTP */
@@ -0,0 +1,396 @@
+/*
+ * HTTP/1.1 download over TCP
+ *
+ * Sends one GET request and stores the body of the response at the load
+ * address, or writes it to a file as it arrives. The end of the body is
+ * found from Content-Length, from the chunked transfer coding or by the
+ * server closing the connection.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <fs.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <net/wget.h>
+#include <linux/ctype.h>
+
+#define HASHES_PER_LINE	65		/* "Loading" hashes per line */
+#define WGET_HASH_SIZE	(64 << 10)	/* Bytes per hash */
+#define WGET_HDR_MAX	2048		/* Longest response header */
+
+enum wget_state {
+	WGET_HEADER,		/* Reading the response header */
+	WGET_BODY,		/* Not chunked */
+	WGET_CHUNK_SIZE,	/* Reading the line before a chunk */
+	WGET_CHUNK_DATA,
+	WGET_CHUNK_END,		/* Reading the CRLF after a chunk */
+	WGET_CLOSING,		/* All received, closing the connection */
+	WGET_DONE,
+};
+
+static enum wget_state wget_state;
+static struct in_addr wget_server_ip;
+static int wget_port;
+static char wget_path[1024];
+static char wget_hdr[WGET_HDR_MAX + 1];
+static unsigned int wget_hdr_len;
+static bool wget_length_known;
+static ulong wget_length;
+static ulong wget_chunk_left;
+static bool wget_chunk_ext;	/* Skipping the rest of the chunk line */
+static ulong wget_start_time;
+static ulong wget_hash_next;
+static int wget_hash_count;
+
+/* Writing to a file, wget_fs_done bytes have been written so far */
+static const char *wget_fs_ifname;
+static const char *wget_fs_dev_part;
+static const char *wget_fs_name;
+static ulong wget_fs_done;
+
+static void wget_fail(const char *msg)
+{
+	printf("\n%s\n", msg);
+	wget_state = WGET_DONE;
+	tcp_abort();
+	net_set_state(NETLOOP_FAIL);
+}
+
+/* Write out what is in the buffer */
+static int wget_flush(void)
+{
+	ulong len = net_boot_file_size - wget_fs_done;
+	loff_t actwrite;
+
+	if (!len && wget_fs_done)
+		return 0;
+	if (fs_set_blk_dev(wget_fs_ifname, wget_fs_dev_part, FS_TYPE_ANY) ||
+	    fs_write(wget_fs_name, load_addr, wget_fs_done, len, &actwrite) < 0)
+		return -1;
+	wget_fs_done += len;
+
+	return 0;
+}
+
+static void wget_show_progress(void)
+{
+	while (wget_hash_next <= net_boot_file_size) {
+		if (wget_hash_count && !(wget_hash_count % HASHES_PER_LINE))
+			puts("\n\t ");
+		putc('#');
+		wget_hash_count++;
+		wget_hash_next += WGET_HASH_SIZE;
+	}
+}
+
+static int wget_store(const uchar *data, ulong len)
+{
+	ulong used, n;
+	void *ptr;
+
+	while (len) {
+		used = net_boot_file_size - wget_fs_done;
+		n = len;
+		if (wget_fs_name)
+			n = min(n, CONFIG_WGET_FS_BUF_SIZE - used);
+		ptr = map_sysmem(load_addr + used, n);
+		memcpy(ptr, data, n);
+		unmap_sysmem(ptr);
+		net_boot_file_size += n;
+		data += n;
+		len -= n;
+
+		if (wget_fs_name && used + n == CONFIG_WGET_FS_BUF_SIZE &&
+		    wget_flush()) {
+			wget_fail("** Unable to write file **");
+			return -1;
+		}
+	}
+	wget_show_progress();
+
+	return 0;
+}
+
+static void wget_done(void)
+{
+	ulong time;
+
+	if (wget_fs_name && wget_flush()) {
+		wget_fail("** Unable to write file **");
+		return;
+	}
+	time = get_timer(wget_start_time);
+	if (time > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(net_boot_file_size / time * 1000, "/s");
+	}
+	puts("\ndone\n");
+	wget_state = WGET_CLOSING;
+	tcp_close();
+}
+
+static char *wget_skip_spaces(char *p)
+{
+	while (*p == ' ' || *p == '\t')
+		p++;
+
+	return p;
+}
+
+/* Check the status line and find how the body is sent */
+static int wget_header(void)
+{
+	char *line, *next, *p;
+	int status;
+
+	next = strstr(wget_hdr, "\r\n");
+	*next = '\0';
+	if (strncmp(wget_hdr, "HTTP/1.", 7) || wget_hdr[8] != ' ') {
+		printf("\nBad response '%s'\n", wget_hdr);
+		return -1;
+	}
+	status = simple_strtoul(wget_hdr + 9, NULL, 10);
+	if (status != 200) {
+		printf("\nServer error '%s'\n", wget_hdr);
+		return -1;
+	}
+
+	wget_state = WGET_BODY;
+	for (line = next + 2; *line; line = next + 2) {
+		next = strstr(line, "\r\n");
+		*next = '\0';
+		p = strchr(line, ':');
+		if (!p)
+			continue;
+		*p++ = '\0';
+		p = wget_skip_spaces(p);
+		if (!strcasecmp(line, "Content-Length")) {
+			wget_length = simple_strtoul(p, NULL, 10);
+			wget_length_known = true;
+		} else if (!strcasecmp(line, "Transfer-Encoding") &&
+			   strcasecmp(p, "identity")) {
+			if (strcasecmp(p, "chunked")) {
+				printf("\nUnsupported encoding '%s'\n", p);
+				return -1;
+			}
+			wget_state = WGET_CHUNK_SIZE;
+		}
+	}
+	/* The length is ignored for a chunked body */
+	if (wget_state == WGET_CHUNK_SIZE)
+		wget_length_known = false;
+
+	return 0;
+}
+
+/* Collect the response header, returning the number of bytes used */
+static unsigned int wget_header_rx(const uchar *data, unsigned int len)
+{
+	unsigned int start = wget_hdr_len > 3 ? wget_hdr_len - 3 : 0;
+	unsigned int n = min(len, WGET_HDR_MAX - wget_hdr_len);
+	char *end;
+
+	memcpy(wget_hdr + wget_hdr_len, data, n);
+	wget_hdr_len += n;
+	wget_hdr[wget_hdr_len] = '\0';
+
+	end = strstr(wget_hdr + start, "\r\n\r\n");
+	if (!end) {
+		if (wget_hdr_len == WGET_HDR_MAX)
+			wget_fail("Response header too long");
+		return n;
+	}
+	/* Keep one CRLF so every header line ends in one */
+	end[2] = '\0';
+	n -= wget_hdr_len - (end + 4 - wget_hdr);
+	if (wget_header()) {
+		wget_fail("HTTP request failed");
+		return n;
+	}
+	if (wget_length_known && !wget_length)
+		wget_done();
+
+	return n;
+}
+
+static void wget_rx(const uchar *data, unsigned int len)
+{
+	unsigned int n;
+	uchar c;
+
+	while (len && wget_state != WGET_DONE) {
+		switch (wget_state) {
+		case WGET_HEADER:
+			n = wget_header_rx(data, len);
+			break;
+		case WGET_BODY:
+			n = len;
+			if (wget_length_known)
+				n = min_t(ulong, n,
+					  wget_length - net_boot_file_size);
+			if (wget_store(data, n))
+				return;
+			if (wget_length_known &&
+			    net_boot_file_size == wget_length)
+				wget_done();
+			break;
+		case WGET_CHUNK_SIZE:
+			n = 1;
+			c = *data;
+			if (c == '\n') {
+				wget_chunk_ext = false;
+				wget_state = WGET_CHUNK_DATA;
+				/* Trailers after the last chunk are ignored */
+				if (!wget_chunk_left)
+					wget_done();
+			} else if (!wget_chunk_ext && isxdigit(c)) {
+				c = isdigit(c) ? c - '0' : tolower(c) - 'a' + 10;
+				wget_chunk_left = wget_chunk_left * 16 + c;
+			} else {
+				wget_chunk_ext = true;
+			}
+			break;
+		case WGET_CHUNK_DATA:
+			n = min_t(ulong, len, wget_chunk_left);
+			if (wget_store(data, n))
+				return;
+			wget_chunk_left -= n;
+			if (!wget_chunk_left)
+				wget_state = WGET_CHUNK_END;
+			break;
+		case WGET_CHUNK_END:
+			n = 1;
+			if (*data == '\n')
+				wget_state = WGET_CHUNK_SIZE;
+			break;
+		default:
+			return;
+		}
+		data += n;
+		len -= n;
+	}
+}
+
+static void wget_send_request(void)
+{
+	char req[sizeof(wget_path) + 128];
+	int len;
+
+	len = sprintf(req, "GET %s HTTP/1.1\r\nHost: %pI4", wget_path,
+		      &wget_server_ip);
+	if (wget_port != HTTP_SERVICE_PORT)
+		len += sprintf(req + len, ":%d", wget_port);
+	len += sprintf(req + len,
+		       "\r\nUser-Agent: U-Boot\r\nConnection: close\r\n\r\n");
+
+	if (tcp_send(req, len) != len)
+		wget_fail("Cannot send request");
+}
+
+static void wget_event(enum tcp_event event)
+{
+	if (wget_state == WGET_DONE)
+		return;
+	if (wget_state == WGET_CLOSING) {
+		/* The file is complete whether or not the close is clean */
+		if (event != TCP_EVENT_CLOSED) {
+			wget_state = WGET_DONE;
+			net_set_state(NETLOOP_SUCCESS);
+		}
+		return;
+	}
+
+	switch (event) {
+	case TCP_EVENT_CONNECTED:
+		wget_send_request();
+		break;
+	case TCP_EVENT_CLOSED:
+		/* Without a length the body ends when the server closes */
+		if (wget_state == WGET_BODY && !wget_length_known)
+			wget_done();
+		else
+			wget_fail("Connection closed by server");
+		break;
+	case TCP_EVENT_RESET:
+		wget_fail("Connection refused or reset");
+		break;
+	case TCP_EVENT_TIMEOUT:
+		wget_fail("Retry count exceeded");
+		break;
+	case TCP_EVENT_FINISHED:
+		break;
+	}
+}
+
+void wget_set_file(const char *ifname, const char *dev_part,
+		   const char *filename)
+{
+	wget_fs_ifname = ifname;
+	wget_fs_dev_part = dev_part;
+	wget_fs_name = filename;
+}
+
+void wget_start(void)
+{
+	char *path = net_boot_file_name;
+
+	wget_server_ip = net_server_ip;
+	if (strchr(path, ':')) {
+		wget_server_ip = string_to_ip(net_boot_file_name);
+		path = strchr(path, ':') + 1;
+	}
+	if (!*path && path == net_boot_file_name) {
+		puts("*** ERROR: no path given\n");
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+	snprintf(wget_path, sizeof(wget_path), "%s%s",
+		 *path == '/' ? "" : "/", path);
+	wget_port = getenv_ulong("httpdstp", 10, HTTP_SERVICE_PORT);
+
+	printf("Using %s device\n", eth_get_name());
+	printf("HTTP from server %pI4; our IP address is %pI4",
+	       &wget_server_ip, &net_ip);
+
+	/* Check if we need to send across this subnet */
+	if (net_gateway.s_addr && net_netmask.s_addr) {
+		struct in_addr our_net;
+		struct in_addr server_net;
+
+		our_net.s_addr = net_ip.s_addr & net_netmask.s_addr;
+		server_net.s_addr = wget_server_ip.s_addr & net_netmask.s_addr;
+		if (our_net.s_addr != server_net.s_addr)
+			printf("; sending through gateway %pI4", &net_gateway);
+	}
+	putc('\n');
+
+	printf("Path '%s'.\n", wget_path);
+	if (wget_fs_name)
+		printf("Writing to %s %s '%s', buffer at 0x%lx\n",
+		       wget_fs_ifname, wget_fs_dev_part, wget_fs_name,
+		       load_addr);
+	else
+		printf("Load address: 0x%lx\n", load_addr);
+	puts("Loading: *\b");
+
+	wget_state = WGET_HEADER;
+	wget_hdr_len = 0;
+	wget_length_known = false;
+	wget_length = 0;
+	wget_chunk_left = 0;
+	wget_chunk_ext = false;
+	wget_hash_next = WGET_HASH_SIZE;
+	wget_hash_count = 0;
+	wget_fs_done = 0;
+	wget_start_time = get_timer(0);
+
+	net_set_udp_handler(NULL);
+	if (tcp_connect(wget_server_ip, wget_port, wget_rx, wget_event)) {
+		puts("\nOut of memory\n");
+		net_set_state(NETLOOP_FAIL);
+	}
+}
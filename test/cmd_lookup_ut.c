@@ -0,0 +1,140 @@
+/*
+ * Checks that find_cmd() resolves command names and abbreviations in the
+ * same way as a linear search of the command table, and reports the speed
+ * of both and of running a long script.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+
+#define BENCH_PASSES		200
+/* A multiple of ARRAY_SIZE(script_lines), so the last line sets ut_lookup */
+#define SCRIPT_LINES		10000
+
+static const char *const script_lines[] = {
+	"setenv ut_lookup",
+	"true",
+	"true; true",
+	"setenv ut_lookup 1",
+};
+
+/* Check one name against a linear search, returning 1 if it differs */
+static int check_name(const char *name, cmd_tbl_t *start, int count)
+{
+	cmd_tbl_t *expect, *cmdtp;
+
+	expect = find_cmd_tbl(name, start, count);
+	cmdtp = find_cmd(name);
+	if (cmdtp != expect) {
+		printf("%s: '%s' found %s, expected %s\n", __func__, name,
+		       cmdtp ? cmdtp->name : "nothing",
+		       expect ? expect->name : "nothing");
+		return 1;
+	}
+
+	return 0;
+}
+
+static int test_cmd_lookup_names(cmd_tbl_t *start, int count)
+{
+	static const char *const others[] = {
+		"", ".", ".b", "zzzz", "md.l", "mw.q", "helpme", "?",
+	};
+	cmd_tbl_t *cmdtp;
+	char name[64];
+	int fails = 0;
+	int i, len;
+
+	/* Every command, every abbreviation of it and a length modifier */
+	for (cmdtp = start; cmdtp != start + count; cmdtp++) {
+		strlcpy(name, cmdtp->name, sizeof(name));
+		for (len = strlen(name); len > 0; len--) {
+			name[len] = '\0';
+			fails += check_name(name, start, count);
+		}
+		snprintf(name, sizeof(name), "%s.b", cmdtp->name);
+		fails += check_name(name, start, count);
+		snprintf(name, sizeof(name), "%sx", cmdtp->name);
+		fails += check_name(name, start, count);
+	}
+	for (i = 0; i < ARRAY_SIZE(others); i++)
+		fails += check_name(others[i], start, count);
+
+	return fails ? -EINVAL : 0;
+}
+
+static void test_cmd_lookup_speed(cmd_tbl_t *start, int count)
+{
+	ulong begin, linear_us, index_us;
+	cmd_tbl_t *cmdtp;
+	int pass;
+
+	begin = timer_get_us();
+	for (pass = 0; pass < BENCH_PASSES; pass++) {
+		for (cmdtp = start; cmdtp != start + count; cmdtp++)
+			find_cmd_tbl(cmdtp->name, start, count);
+	}
+	linear_us = max(timer_get_us() - begin, 1UL);
+
+	begin = timer_get_us();
+	for (pass = 0; pass < BENCH_PASSES; pass++) {
+		for (cmdtp = start; cmdtp != start + count; cmdtp++)
+			find_cmd(cmdtp->name);
+	}
+	index_us = max(timer_get_us() - begin, 1UL);
+
+	printf("%s: %d lookups of %d commands: linear %lu us, find_cmd() %lu us\n",
+	       __func__, BENCH_PASSES * count, count, linear_us, index_us);
+}
+
+static int test_cmd_lookup_script(void)
+{
+	const int count = ARRAY_SIZE(script_lines);
+	char *script, *p;
+	ulong begin;
+	int size = 0;
+	int ret, i;
+
+	for (i = 0; i < SCRIPT_LINES; i++)
+		size += strlen(script_lines[i % count]) + 1;
+	script = malloc(size + 1);
+	if (!script)
+		return -ENOMEM;
+	for (p = script, i = 0; i < SCRIPT_LINES; i++)
+		p += sprintf(p, "%s\n", script_lines[i % count]);
+
+	/* The last line sets the variable, so it is only set if all ran */
+	setenv("ut_lookup", NULL);
+	begin = timer_get_us();
+	ret = run_command_list(script, -1, 0);
+	printf("%s: %d lines in %lu us\n", __func__, SCRIPT_LINES,
+	       timer_get_us() - begin);
+	free(script);
+	if (ret || !getenv("ut_lookup")) {
+		printf("%s: script failed (%d)\n", __func__, ret);
+		return -EINVAL;
+	}
+	setenv("ut_lookup", NULL);
+
+	return 0;
+}
+
+int do_ut_cmd_lookup(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	cmd_tbl_t *start = ll_entry_start(cmd_tbl_t, cmd);
+	const int count = ll_entry_count(cmd_tbl_t, cmd);
+	int ret = 0;
+
+	ret |= test_cmd_lookup_names(start, count);
+	test_cmd_lookup_speed(start, count);
+	ret |= test_cmd_lookup_script();
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
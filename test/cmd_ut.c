@@ -13,12 +13,30 @@ static int do_ut_all(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
 static cmd_tbl_t cmd_ut_sub[] = {
 	U_BOOT_CMD_MKENT(all, CONFIG_SYS_MAXARGS, 1, do_ut_all, "", ""),
+#ifdef CONFIG_UT_CMD_LOOKUP
+	U_BOOT_CMD_MKENT(cmd_lookup, CONFIG_SYS_MAXARGS, 1, do_ut_cmd_lookup,
+			 "", ""),
+#endif
+#ifdef CONFIG_UT_CRC32
+	U_BOOT_CMD_MKENT(crc32, CONFIG_SYS_MAXARGS, 1, do_ut_crc32, "", ""),
+#endif
 #if defined(CONFIG_UT_DM)
 	U_BOOT_CMD_MKENT(dm, CONFIG_SYS_MAXARGS, 1, do_ut_dm, "", ""),
 #endif
+#ifdef CONFIG_UT_EFI_DISK
+	U_BOOT_CMD_MKENT(efi_disk, CONFIG_SYS_MAXARGS, 1, do_ut_efi_disk, "",
+			 ""),
+#endif
+#ifdef CONFIG_UT_EFI_MEMORY
+	U_BOOT_CMD_MKENT(efi_memory, CONFIG_SYS_MAXARGS, 1, do_ut_efi_memory,
+			 "", ""),
+#endif
 #if defined(CONFIG_UT_ENV)
 	U_BOOT_CMD_MKENT(env, CONFIG_SYS_MAXARGS, 1, do_ut_env, "", ""),
 #endif
+#ifdef CONFIG_UT_LMB
+	U_BOOT_CMD_MKENT(lmb, CONFIG_SYS_MAXARGS, 1, do_ut_lmb, "", ""),
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	U_BOOT_CMD_MKENT(overlay, CONFIG_SYS_MAXARGS, 1, do_ut_overlay, "", ""),
 #endif
@@ -65,12 +83,27 @@ static int do_ut(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #ifdef CONFIG_SYS_LONGHELP
 static char ut_help_text[] =
 	"all - execute all enabled tests\n"
+#ifdef CONFIG_UT_CMD_LOOKUP
+	"ut cmd_lookup - Test and benchmark command lookup\n"
+#endif
+#ifdef CONFIG_UT_CRC32
+	"ut crc32 - Test and benchmark crc32()\n"
+#endif
 #ifdef CONFIG_UT_DM
 	"ut dm [test-name]\n"
 #endif
+#ifdef CONFIG_UT_EFI_DISK
+	"ut efi_disk - Test EFI block I/O read-ahead\n"
+#endif
+#ifdef CONFIG_UT_EFI_MEMORY
+	"ut efi_memory - Test and benchmark the EFI memory map\n"
+#endif
 #ifdef CONFIG_UT_ENV
 	"ut env [test-name]\n"
 #endif
+#ifdef CONFIG_UT_LMB
+	"ut lmb - Test and benchmark the lmb allocator\n"
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	"ut overlay [test-name]\n"
 #endif
@@ -11,8 +11,11 @@
 #include <command.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <workq.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
+#include <u-boot/xxhash.h>
 #include <u-boot/zlib.h>
 #include <bzlib.h>
 
@@ -117,8 +120,26 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+/* zstd -19 -c /tmp/plain.txt > /tmp/plain.zst */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x64\x5e\x00\xad\x05\x00\x42\x4e\x26\x17\x90\x3b"
+	"\x07\x04\x5a\x13\x8b\xa7\x65\x34\x12\x21\x6d\xb0\x39\xbb\xae\xe8"
+	"\xba\xc9\xcd\x5e\x02\x49\xd0\x2b\xa9\xfa\x96\x92\xe7\x1f\x19\x19"
+	"\x7c\x8f\xf1\x9d\x54\x37\xfc\xd6\x0a\xf3\x0c\x93\x56\xc7\x52\x4f"
+	"\x0a\x62\x3e\xd1\xa5\x83\x17\x31\xab\x5d\x8f\x57\xf3\xcc\x3b\x58"
+	"\xf8\x91\x8c\xf1\x2a\x5c\x89\xdd\xf2\x9b\x15\xb7\x92\x5b\xbe\xba"
+	"\xab\xd5\xd1\x34\xdf\xf0\x02\x0e\x61\xcd\x7b\xd6\x01\xfc\xc2\xa7"
+	"\xd4\xd1\x3d\x26\x9c\x10\x49\xb8\x5b\xcd\xba\x7c\xf7\xac\x4b\xad"
+	"\xb7\x31\x1c\xbc\xf9\xcb\x62\x8e\x2e\x9b\x0f\xd3\x87\x57\x45\x12"
+	"\x16\xfa\x3a\x79\xde\x65\xf8\xcc\x48\xd5\x43\xa6\xbd\xc3\x91\x29"
+	"\x65\x29\xa7\x5b\x9a\x08\x08\x00\x60\x13\x00\x63\xa3\x8e\x28\x94"
+	"\x79\x41\x2a\x78\xc2\x91\x70\x9f\xaa\x6a\x21\x7a\xa1\xaa\x0c\xe4"
+	"\xf4\x6e\xfa";
+static const unsigned long zstd_compressed_size = 195;
+
 
 #define TEST_BUFFER_SIZE	512
+#define TEST_TIMING_LOOPS	1000
 
 typedef int (*mutate_func)(void *, unsigned long, void *, unsigned long,
 			   unsigned long *);
@@ -282,6 +303,38 @@ static int uncompress_using_lz4(void *in, unsigned long in_size,
 	return (ret != 0);
 }
 
+static int compress_using_zstd(void *in, unsigned long in_size,
+			       void *out, unsigned long out_max,
+			       unsigned long *out_size)
+{
+	/* There is no zstd compression in u-boot, so fake it. */
+	assert(in_size == strlen(plain));
+	assert(memcmp(plain, in, in_size) == 0);
+
+	if (zstd_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, zstd_compressed, zstd_compressed_size);
+	if (out_size)
+		*out_size = zstd_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_zstd(void *in, unsigned long in_size,
+				 void *out, unsigned long out_max,
+				 unsigned long *out_size)
+{
+	int ret;
+	size_t output_size = out_max;
+
+	ret = zstd_decompress(in, in_size, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return (ret != 0);
+}
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -295,7 +348,8 @@ static int run_test(char *name, mutate_func compress, mutate_func uncompress)
 	void *compressed_buf = NULL;
 	void *uncompressed_buf = NULL;
 	void *compare_buf = NULL;
-	int ret;
+	ulong start;
+	int ret, i;
 
 	printf(" testing %s ...\n", name);
 
@@ -340,6 +394,18 @@ static int run_test(char *name, mutate_func compress, mutate_func uncompress)
 	errcheck(memcmp(orig_buf, uncompressed_buf, orig_size) == 0);
 	errcheck(((char *)uncompressed_buf)[orig_size] == 'A');
 
+	/* Rough decompression speed, to compare the formats with each other */
+	start = timer_get_us();
+	for (i = 0; i < TEST_TIMING_LOOPS; i++) {
+		errcheck(uncompress(compressed_buf, compressed_size,
+				    uncompressed_buf, orig_size,
+				    &uncompressed_size) == 0);
+		errcheck(uncompressed_size == orig_size);
+	}
+	printf("\tuncompress: %lu us for %d runs\n",
+	       timer_get_us() - start, TEST_TIMING_LOOPS);
+	errcheck(memcmp(orig_buf, uncompressed_buf, orig_size) == 0);
+
 	/* Make sure compression does not over-run. */
 	memset(compare_buf, 'A', TEST_BUFFER_SIZE);
 	ret = compress(orig_buf, orig_size,
@@ -371,6 +437,553 @@ out:
 	return ret;
 }
 
+/* Sizes of the blocks in a multi-block LZ4 frame, 64KB maximum */
+#define LZ4_FRAME_BLOCKS	64
+#define LZ4_BLOCK_SIZE		(64 << 10)
+#define LZ4_LAST_SIZE		10000
+#define LZ4_FRAME_SIZE	\
+	((LZ4_FRAME_BLOCKS - 1) * LZ4_BLOCK_SIZE + LZ4_LAST_SIZE)
+
+static u8 *lz4_put_length(u8 *p, size_t len)
+{
+	for (len -= 15; len >= 255; len -= 255)
+		*p++ = 255;
+	*p++ = len;
+
+	return p;
+}
+
+/*
+ * Make an LZ4 block of size bytes: 1KB of random literals, a match
+ * repeating them over most of the block and 64 more literals at the end.
+ */
+static u8 *lz4_make_block(u8 *p, u8 *plain, size_t size, u32 *seed)
+{
+	const size_t lits = 1024, tail = 64;
+	size_t match = size - lits - tail;
+	u8 *start = p;
+	int i;
+
+	for (i = 0; i < lits; i++) {
+		*seed = *seed * 1103515245 + 12345;
+		plain[i] = *seed >> 16;
+	}
+	for (i = 0; i < match; i++)
+		plain[lits + i] = plain[i];
+	for (i = 0; i < tail; i++)
+		plain[lits + match + i] = i;
+
+	p += sizeof(u32);
+	*p++ = 0xff;
+	p = lz4_put_length(p, lits);
+	memcpy(p, plain, lits);
+	p += lits;
+	put_unaligned_le16(lits, p);
+	p += 2;
+	p = lz4_put_length(p, match - 4);
+	*p++ = 0xf0;
+	p = lz4_put_length(p, tail);
+	memcpy(p, plain + lits + match, tail);
+	p += tail;
+	put_unaligned_le32(p - start - sizeof(u32), start);
+
+	return p;
+}
+
+/* Make a frame with independent blocks, one of them stored uncompressed */
+static size_t lz4_make_frame(u8 *frame, u8 *plain, size_t short_size)
+{
+	static const u8 header[] = { 0x04, 0x22, 0x4d, 0x18, 0x60, 0x40, 0x82 };
+	u8 *p = frame;
+	u32 seed = 1;
+	size_t size;
+	int i;
+
+	memcpy(p, header, sizeof(header));
+	p += sizeof(header);
+	for (i = 0; i < LZ4_FRAME_BLOCKS; i++) {
+		size = i == LZ4_FRAME_BLOCKS - 1 ? LZ4_LAST_SIZE :
+			LZ4_BLOCK_SIZE;
+		if (i == 3)
+			size = short_size;
+		if (i == 5) {
+			memcpy(plain, plain - LZ4_BLOCK_SIZE, size);
+			put_unaligned_le32(size | 1U << 31, p);
+			memcpy(p + sizeof(u32), plain, size);
+			p += sizeof(u32) + size;
+		} else {
+			p = lz4_make_block(p, plain, size, &seed);
+		}
+		plain += size;
+	}
+	put_unaligned_le32(0, p);
+
+	return p + sizeof(u32) - frame;
+}
+
+static int lz4_frame_check(const char *what, u8 *frame, size_t frame_size,
+			   u8 *plain, size_t plain_size, u8 *out)
+{
+	size_t out_size = LZ4_FRAME_SIZE;
+	ulong start;
+	int ret;
+
+	memset(out, 'A', LZ4_FRAME_SIZE);
+	start = timer_get_us();
+	ret = ulz4fn(frame, frame_size, out, &out_size);
+	printf("	%s: %lu us\n", what, timer_get_us() - start);
+	if (ret || out_size != plain_size || memcmp(out, plain, plain_size)) {
+		printf("	%s: bad output, ret %d, size %zu\n", what, ret,
+		       out_size);
+		return 1;
+	}
+
+	/* One byte short must fail without writing past the end */
+	out_size = plain_size - 1;
+	memset(out, 'A', LZ4_FRAME_SIZE);
+	ret = ulz4fn(frame, frame_size, out, &out_size);
+	if (!ret || out[plain_size - 1] != 'A') {
+		printf("	%s: output overrun\n", what);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Decode a multi-block LZ4 frame, in parallel if possible */
+static int run_lz4_frame_test(void)
+{
+	u8 *frame, *plain, *out, *p;
+	size_t frame_size;
+	int ret = 1;
+#if CONFIG_IS_ENABLED(WORKQ)
+	int cpus = workq_cpus();
+#endif
+
+	printf(" testing lz4 frame ...\n");
+	frame = malloc(LZ4_FRAME_SIZE + 1024);
+	plain = malloc(LZ4_FRAME_SIZE);
+	out = malloc(LZ4_FRAME_SIZE);
+	if (!frame || !plain || !out)
+		goto out;
+
+	frame_size = lz4_make_frame(frame, plain, LZ4_BLOCK_SIZE);
+	printf("	frame_size:%zu\n", frame_size);
+#if CONFIG_IS_ENABLED(WORKQ)
+	workq_set_cpus(1);
+	if (lz4_frame_check("1 cpu", frame, frame_size, plain,
+			    LZ4_FRAME_SIZE, out))
+		goto out;
+	workq_set_cpus(cpus);
+	printf("	%d cpus ...\n", cpus);
+#endif
+	if (lz4_frame_check("decode", frame, frame_size, plain,
+			    LZ4_FRAME_SIZE, out))
+		goto out;
+
+	/* A short block which is not the last rules out a parallel decode */
+	frame_size = lz4_make_frame(frame, plain, LZ4_BLOCK_SIZE - 100);
+	if (lz4_frame_check("short block", frame, frame_size, plain,
+			    LZ4_FRAME_SIZE - 100, out))
+		goto out;
+
+	/*
+	 * Point the match in the second block before the start of the block.
+	 * It follows the block header, the token, four length bytes and the
+	 * literals.
+	 */
+	frame_size = lz4_make_frame(frame, plain, LZ4_BLOCK_SIZE);
+	p = frame + 7;
+	p += sizeof(u32) + get_unaligned_le32(p);
+	put_unaligned_le16(0xffff, p + sizeof(u32) + 1 + 4 + 1024);
+	memset(out, 0, LZ4_FRAME_SIZE);
+	ret = uncompress_using_lz4(frame, frame_size, out, LZ4_FRAME_SIZE,
+				   NULL);
+	if (!ret)
+		printf("	corrupt frame not detected\n");
+	ret = !ret;
+
+out:
+#if CONFIG_IS_ENABLED(WORKQ)
+	workq_set_cpus(cpus);
+#endif
+	printf(" lz4 frame: %s\n", ret == 0 ? "ok" : "FAILED");
+	free(out);
+	free(plain);
+	free(frame);
+
+	return ret;
+}
+
+/* Frame flags for lz4_compress_frame() */
+#define LZ4F_VERSION		0x40
+#define LZ4F_INDEPENDENT	0x20
+#define LZ4F_BLOCK_CSUM		0x10
+#define LZ4F_CONTENT_SIZE	0x08
+#define LZ4F_CONTENT_CSUM	0x04
+
+#define LZ4_HASH_BITS		12
+
+/* Size of the data for the speed test, about that of a kernel */
+#define LZ4_BENCH_SIZE		(16 << 20)
+
+/*
+ * Greedy LZ4 block compressor, good enough to make test frames. Matches
+ * may go back as far as lowest, so up to 64KB into earlier blocks for a
+ * frame with linked blocks. The table holds positions relative to base,
+ * plus one.
+ */
+static size_t lz4_compress_block(const u8 *base, const u8 *lowest,
+				 const u8 *in, size_t len, u8 *out,
+				 u32 *table)
+{
+	const u8 *ip = in, *anchor = in, *end = in + len;
+	u8 *op = out;
+	size_t lits, mlen;
+
+	while (len > 12 && ip < end - 12) {
+		u32 seq = get_unaligned_le32(ip);
+		u32 hash = (seq * 2654435761U) >> (32 - LZ4_HASH_BITS);
+		const u8 *ref = base + table[hash] - 1;
+		const u8 *m;
+
+		table[hash] = ip - base + 1;
+		if (ref + 1 == base || ref < lowest || ip - ref > 0xffff ||
+		    get_unaligned_le32(ref) != seq) {
+			ip++;
+			continue;
+		}
+		/* The last five bytes must be literals */
+		for (m = ip + 4; m < end - 5 && *m == ref[m - ip]; m++)
+			;
+		lits = ip - anchor;
+		mlen = m - ip - 4;
+		*op++ = min(lits, (size_t)15) << 4 | min(mlen, (size_t)15);
+		if (lits >= 15)
+			op = lz4_put_length(op, lits);
+		memcpy(op, anchor, lits);
+		op += lits;
+		put_unaligned_le16(ip - ref, op);
+		op += 2;
+		if (mlen >= 15)
+			op = lz4_put_length(op, mlen);
+		ip = anchor = m;
+	}
+	lits = end - anchor;
+	*op++ = min(lits, (size_t)15) << 4;
+	if (lits >= 15)
+		op = lz4_put_length(op, lits);
+	memcpy(op, anchor, lits);
+	op += lits;
+
+	return op - out;
+}
+
+/* Make an LZ4 frame with the given flags and maximum block size id */
+static size_t lz4_compress_frame(const u8 *in, size_t len, u8 *out,
+				 int flags, int block_size_id)
+{
+	size_t block_size = 1 << (2 * block_size_id + 8);
+	const u8 *pos;
+	u8 *op = out;
+	size_t n, size;
+	u32 *table;
+
+	table = calloc(1 << LZ4_HASH_BITS, sizeof(*table));
+	if (!table)
+		return 0;
+	put_unaligned_le32(0x184d2204, op);
+	op[4] = LZ4F_VERSION | flags;
+	op[5] = block_size_id << 4;
+	op += 6;
+	if (flags & LZ4F_CONTENT_SIZE) {
+		put_unaligned_le64(len, op);
+		op += sizeof(u64);
+	}
+	*op = xxh32(out + 4, op - out - 4, 0) >> 8;
+	op++;
+
+	for (pos = in; pos < in + len; pos += n) {
+		n = min(block_size, (size_t)(in + len - pos));
+		if (flags & LZ4F_INDEPENDENT)
+			memset(table, '\0', sizeof(*table) << LZ4_HASH_BITS);
+		size = lz4_compress_block(in, flags & LZ4F_INDEPENDENT ?
+					  pos : in, pos, n, op + sizeof(u32),
+					  table);
+		if (size < n) {
+			put_unaligned_le32(size, op);
+		} else {
+			/* Store the block if it does not get smaller */
+			size = n;
+			memcpy(op + sizeof(u32), pos, n);
+			put_unaligned_le32(size | 1U << 31, op);
+		}
+		op += sizeof(u32);
+		if (flags & LZ4F_BLOCK_CSUM) {
+			put_unaligned_le32(xxh32(op, size, 0), op + size);
+			op += sizeof(u32);
+		}
+		op += size;
+	}
+	put_unaligned_le32(0, op);
+	op += sizeof(u32);
+	if (flags & LZ4F_CONTENT_CSUM) {
+		put_unaligned_le32(xxh32(in, len, 0), op);
+		op += sizeof(u32);
+	}
+	free(table);
+
+	return op - out;
+}
+
+/*
+ * Fill buf with data which compresses with LZ4 roughly as well as a kernel
+ * image: instruction-like words, text, zeroes, repeats and a little noise.
+ */
+static void lz4_make_plain(u8 *buf, size_t len)
+{
+	static const char *const words[] = {
+		"static ", "int ", "return ", "struct ", "device", "error",
+		"\n\t", "();", "0x", "NULL", "const ", "if (", "unsigned ",
+		"%s: ", "driver", "_init",
+	};
+	u8 *p = buf, *end = buf + len;
+	u32 seed = 1;
+	int i, n;
+
+	while (p < end - 64) {
+		seed = seed * 1103515245 + 12345;
+		n = 4 + (seed >> 8 & 15);
+		switch (seed >> 29) {
+		case 0 ... 2:
+			for (i = 0; i < n; i++, p += 4) {
+				seed = seed * 1103515245 + 12345;
+				put_unaligned_le32(0x91000000 +
+						   (seed >> 20 & 7) * 0x10001,
+						   p);
+			}
+			break;
+		case 3:
+			/* Repeat something from not too far back */
+			seed = seed * 1103515245 + 12345;
+			if (p - buf > 0x8000) {
+				memcpy(p, p - 0x40 - (seed >> 17), n * 4);
+				p += n * 4;
+			}
+			break;
+		case 4 ... 5:
+			for (i = 0; i < n; i++) {
+				seed = seed * 1103515245 + 12345;
+				strcpy((char *)p, words[seed >> 28]);
+				p += strlen(words[seed >> 28]);
+			}
+			break;
+		case 6:
+			memset(p, '\0', n * 4);
+			p += n * 4;
+			break;
+		default:
+			for (i = 0; i < n; i++) {
+				seed = seed * 1103515245 + 12345;
+				*p++ = seed >> 24;
+			}
+			break;
+		}
+	}
+	memset(p, '\0', end - p);
+}
+
+/* Decode a frame a few times, reporting the best time */
+static int lz4_bench(const char *what, u8 *frame, size_t frame_size,
+		     u8 *plain, u8 *out)
+{
+	ulong start, time, best = ~0UL;
+	size_t out_size;
+	int ret, i;
+
+	for (i = 0; i < 5; i++) {
+		memset(out, '\0', LZ4_BENCH_SIZE);
+		out_size = LZ4_BENCH_SIZE;
+		start = timer_get_us();
+		ret = ulz4fn(frame, frame_size, out, &out_size);
+		time = timer_get_us() - start;
+		if (ret || out_size != LZ4_BENCH_SIZE ||
+		    memcmp(out, plain, LZ4_BENCH_SIZE)) {
+			printf("\t%s: bad output, ret %d, size %zu\n", what,
+			       ret, out_size);
+			return 1;
+		}
+		best = min(best, time);
+	}
+	printf("\t%s: %lu us, %lu MB/s\n", what, best,
+	       best ? LZ4_BENCH_SIZE / best : 0);
+
+	return 0;
+}
+
+static int lz4_expect(const char *what, u8 *frame, size_t frame_size,
+		      u8 *out, size_t size, int expect)
+{
+	int ret;
+
+	ret = ulz4fn(frame, frame_size, out, &size);
+	if (ret != expect) {
+		printf("\t%s: got %d, expected %d\n", what, ret, expect);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Check that the checksums of a frame are verified */
+static int run_lz4_checksum_test(void)
+{
+	const size_t size = 256 << 10;
+	u8 *plain, *frame, *out, *sum;
+	size_t frame_size;
+	int ret = 1;
+
+	printf(" testing lz4 checksums ...\n");
+	plain = malloc(size);
+	frame = malloc(size * 2);
+	out = malloc(size);
+	if (!plain || !frame || !out)
+		goto out;
+	lz4_make_plain(plain, size);
+
+	frame_size = lz4_compress_frame(plain, size, frame, LZ4F_BLOCK_CSUM |
+					LZ4F_CONTENT_SIZE | LZ4F_CONTENT_CSUM,
+					4);
+	if (lz4_expect("good frame", frame, frame_size, out, size, 0))
+		goto out;
+	if (memcmp(out, plain, size)) {
+		printf("\tgood frame: bad output\n");
+		goto out;
+	}
+
+	/* The header checksum, after the flags and the content size */
+	frame[14] ^= 1;
+	if (lz4_expect("header checksum", frame, frame_size, out, size,
+		       -EPROTO))
+		goto out;
+	frame[14] ^= 1;
+
+	/* The checksum of the first block */
+	sum = frame + 15 + 4 + (get_unaligned_le32(frame + 15) & 0x7fffffff);
+	*sum ^= 1;
+	if (lz4_expect("block checksum", frame, frame_size, out, size,
+		       -EPROTO))
+		goto out;
+	*sum ^= 1;
+
+	frame[frame_size - 1] ^= 1;
+	if (lz4_expect("content checksum", frame, frame_size, out, size,
+		       -EPROTO))
+		goto out;
+	frame[frame_size - 1] ^= 1;
+
+	/* A content size that does not match; fix up the header checksum */
+	frame[6]++;
+	frame[14] = xxh32(frame + 4, 10, 0) >> 8;
+	if (lz4_expect("content size", frame, frame_size, out, size,
+		       -EPROTO))
+		goto out;
+
+	/* Frames which need a dictionary are not supported */
+	frame_size = lz4_compress_frame(plain, size, frame, 0, 4);
+	frame[4] |= 1;
+	if (lz4_expect("dictionary", frame, frame_size, out, size,
+		       -EPROTONOSUPPORT))
+		goto out;
+	ret = 0;
+
+out:
+	printf(" lz4 checksums: %s\n", ret == 0 ? "ok" : "FAILED");
+	free(out);
+	free(frame);
+	free(plain);
+
+	return ret;
+}
+
+/* Decode speed of a kernel-sized frame, with the frame options lz4 offers */
+static int run_lz4_speed_test(void)
+{
+	static const struct {
+		const char *name;
+		int flags;
+		int block_size_id;
+	} tests[] = {
+		{ "4MB blocks", LZ4F_INDEPENDENT, 7 },
+		{ "4MB blocks, content checksum",
+			LZ4F_INDEPENDENT | LZ4F_CONTENT_CSUM, 7 },
+		{ "64KB blocks", LZ4F_INDEPENDENT, 4 },
+		{ "64KB blocks, block checksums",
+			LZ4F_INDEPENDENT | LZ4F_BLOCK_CSUM, 4 },
+		{ "64KB linked blocks", 0, 4 },
+		{ "4MB linked blocks, content size and checksum",
+			LZ4F_CONTENT_SIZE | LZ4F_CONTENT_CSUM, 7 },
+	};
+	u8 *plain = map_sysmem(0x1000000, LZ4_BENCH_SIZE);
+	u8 *frame = map_sysmem(0x2000000, LZ4_BENCH_SIZE);
+	u8 *out = map_sysmem(0x3000000, LZ4_BENCH_SIZE);
+	size_t frame_size;
+	int ret = 0;
+	int i;
+#if CONFIG_IS_ENABLED(WORKQ)
+	int cpus = workq_cpus();
+#endif
+
+	printf(" testing lz4 speed ...\n");
+	lz4_make_plain(plain, LZ4_BENCH_SIZE);
+	for (i = 0; i < ARRAY_SIZE(tests) && !ret; i++) {
+		frame_size = lz4_compress_frame(plain, LZ4_BENCH_SIZE, frame,
+						tests[i].flags,
+						tests[i].block_size_id);
+		printf("\t%s, %zu bytes\n", tests[i].name, frame_size);
+#if CONFIG_IS_ENABLED(WORKQ)
+		if (tests[i].flags & LZ4F_INDEPENDENT && cpus > 1) {
+			workq_set_cpus(1);
+			ret |= lz4_bench("1 cpu", frame, frame_size, plain,
+					 out);
+			workq_set_cpus(cpus);
+		}
+#endif
+		ret |= lz4_bench("decode", frame, frame_size, plain, out);
+	}
+	printf(" lz4 speed: %s\n", ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
+/* Check that every truncated copy of a zstd frame is rejected */
+static int run_zstd_truncated_test(void)
+{
+	char out[TEST_BUFFER_SIZE];
+	size_t out_size;
+	size_t len;
+	void *in;
+	int ret = 0;
+
+	printf(" testing truncated zstd ...\n");
+	for (len = 0; len < zstd_compressed_size && !ret; len++) {
+		/* Copy so that reading past the end leaves the buffer */
+		in = malloc(len ? len : 1);
+		if (!in)
+			return 1;
+		memcpy(in, zstd_compressed, len);
+		out_size = sizeof(out);
+		if (!zstd_decompress(in, len, out, &out_size)) {
+			printf("\tFailed: %zu bytes accepted\n", len);
+			ret = 1;
+		}
+		free(in);
+	}
+	printf(" truncated zstd: %s\n", ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
 static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 			     char *const argv[])
 {
@@ -381,6 +994,11 @@ static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 	err += run_test("lzma", compress_using_lzma, uncompress_using_lzma);
 	err += run_test("lzo", compress_using_lzo, uncompress_using_lzo);
 	err += run_test("lz4", compress_using_lz4, uncompress_using_lz4);
+	err += run_lz4_frame_test();
+	err += run_lz4_checksum_test();
+	err += run_lz4_speed_test();
+	err += run_test("zstd", compress_using_zstd, uncompress_using_zstd);
+	err += run_zstd_truncated_test();
 
 	printf("ut_compression %s\n", err == 0 ? "ok" : "FAILED");
 
@@ -458,6 +1076,7 @@ static int do_ut_image_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
 	err |= run_bootm_test(IH_COMP_LZMA, compress_using_lzma);
 	err |= run_bootm_test(IH_COMP_LZO, compress_using_lzo);
 	err |= run_bootm_test(IH_COMP_LZ4, compress_using_lz4);
+	err |= run_bootm_test(IH_COMP_ZSTD, compress_using_zstd);
 	err |= run_bootm_test(IH_COMP_NONE, compress_using_none);
 
 	printf("ut_image_decomp %s\n", err == 0 ? "ok" : "FAILED");
@@ -467,7 +1086,7 @@ static int do_ut_image_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
 
 U_BOOT_CMD(
 	ut_compression,	5,	1,	do_ut_compression,
-	"Basic test of compressors: gzip bzip2 lzma lzo", ""
+	"Basic test of compressors: gzip bzip2 lzma lzo lz4 zstd", ""
 );
 
 U_BOOT_CMD(
@@ -0,0 +1,148 @@
+/*
+ * Checks crc32() against a simple bit-wise implementation and compares its
+ * speed with byte-wise table lookup.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <u-boot/crc.h>
+
+#define CRC32_POLY		0xedb88320
+#define BENCH_BUF_SIZE		(1 << 20)
+#define BENCH_PASSES		16
+
+static uint32_t ref_table[256];
+
+static uint32_t crc32_bitwise(uint32_t crc, const uchar *buf, uint len)
+{
+	int k;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *buf++;
+		for (k = 0; k < 8; k++)
+			crc = crc & 1 ? (crc >> 1) ^ CRC32_POLY : crc >> 1;
+	}
+
+	return ~crc;
+}
+
+static uint32_t crc32_bytewise(uint32_t crc, const uchar *buf, uint len)
+{
+	crc = ~crc;
+	while (len--)
+		crc = ref_table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+static int test_crc32_vectors(void)
+{
+	static const char check[] = "123456789";
+	uint32_t crc;
+
+	crc = crc32(0, (const uchar *)check, strlen(check));
+	if (crc != 0xcbf43926) {
+		printf("%s: crc32 of \"%s\" is %08x, expected cbf43926\n",
+		       __func__, check, crc);
+		return -EINVAL;
+	}
+	if (crc32(0, NULL, 0) != 0) {
+		printf("%s: crc32 of an empty buffer is not 0\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int test_crc32_align(const uchar *buf)
+{
+	uint32_t expect, crc;
+	uint start, len;
+
+	/* Every alignment and a range of lengths around the 8-byte steps */
+	for (start = 0; start < 16; start++) {
+		for (len = 0; len < 80; len++) {
+			expect = crc32_bitwise(0, buf + start, len);
+			crc = crc32(0, buf + start, len);
+			if (crc != expect) {
+				printf("%s: start=%u, len=%u: got %08x, expected %08x\n",
+				       __func__, start, len, crc, expect);
+				return -EINVAL;
+			}
+		}
+	}
+
+	/* Chained calls must give the same result as a single call */
+	expect = crc32(0, buf, 1000);
+	crc = crc32(crc32(crc32(0, buf, 3), buf + 3, 500), buf + 503, 497);
+	if (crc != expect) {
+		printf("%s: chained crc32 %08x, expected %08x\n", __func__,
+		       crc, expect);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int test_crc32_speed(const uchar *buf)
+{
+	uint32_t crc_ref = 0, crc = 0;
+	ulong start, ref_us, us;
+	int i;
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_PASSES; i++)
+		crc_ref = crc32_bytewise(crc_ref, buf, BENCH_BUF_SIZE);
+	ref_us = max(timer_get_us() - start, 1UL);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_PASSES; i++)
+		crc = crc32(crc, buf, BENCH_BUF_SIZE);
+	us = max(timer_get_us() - start, 1UL);
+
+	printf("%s: %d MiB: byte-wise %lu us (%lu MiB/s), crc32() %lu us (%lu MiB/s)\n",
+	       __func__, BENCH_PASSES, ref_us, BENCH_PASSES * 1000000UL / ref_us,
+	       us, BENCH_PASSES * 1000000UL / us);
+	if (crc != crc_ref) {
+		printf("%s: crc32 %08x, expected %08x\n", __func__, crc,
+		       crc_ref);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int do_ut_crc32(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	uint32_t c, seed = 1;
+	uchar *buf;
+	int ret = 0;
+	int i, k;
+
+	buf = malloc(BENCH_BUF_SIZE);
+	if (!buf)
+		return CMD_RET_FAILURE;
+	for (i = 0; i < BENCH_BUF_SIZE; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+	for (i = 0; i < 256; i++) {
+		for (c = i, k = 0; k < 8; k++)
+			c = c & 1 ? (c >> 1) ^ CRC32_POLY : c >> 1;
+		ref_table[i] = c;
+	}
+
+	ret |= test_crc32_vectors();
+	ret |= test_crc32_align(buf);
+	ret |= test_crc32_speed(buf);
+	free(buf);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -6,6 +6,9 @@
 
 #include <common.h>
 #include <dm.h>
+#include <malloc.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
 #include <dm/test.h>
@@ -94,3 +97,177 @@ static int dm_test_blk_usb(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_usb, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define ASYNC_TEST_FILE		"blk_async_test.img"
+/* Large enough that each request goes to the host's AIO */
+#define ASYNC_TEST_BLKS		1024
+#define ASYNC_TEST_REQS		4
+
+static void blk_async_complete(struct blk_req *req)
+{
+	int *count = req->priv;
+
+	(*count)++;
+}
+
+static int blk_async_submit(struct blk_desc *desc, struct blk_req *req,
+			    enum blk_req_op op, lbaint_t start,
+			    lbaint_t blkcnt, void *buf, int *count)
+{
+	req->op = op;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = buf;
+	req->complete = blk_async_complete;
+	req->priv = count;
+
+	return blk_submit(desc, req);
+}
+
+static int blk_async_run(struct unit_test_state *uts, struct blk_desc *desc,
+			 enum blk_req_op op, u8 *buf, int *count)
+{
+	struct blk_req req[ASYNC_TEST_REQS];
+	lbaint_t blkcnt = ASYNC_TEST_BLKS / ASYNC_TEST_REQS;
+	int i;
+
+	/* Have all the requests in flight at once */
+	for (i = 0; i < ASYNC_TEST_REQS; i++) {
+		ut_assertok(blk_async_submit(desc, &req[i], op, i * blkcnt,
+					     blkcnt,
+					     buf + i * blkcnt * desc->blksz,
+					     count));
+	}
+	for (i = 0; i < ASYNC_TEST_REQS; i++) {
+		ut_asserteq(blkcnt, blk_wait(&req[i]));
+		ut_assert(req[i].done);
+	}
+
+	return 0;
+}
+
+/* Test asynchronous reads and writes on a host-file block device */
+static int dm_test_blk_async(struct unit_test_state *uts)
+{
+	int size = ASYNC_TEST_BLKS * 512;
+	struct blk_desc *desc;
+	struct blk_req req;
+	u8 *wbuf, *rbuf;
+	int count = 0;
+	int fd, i;
+
+	wbuf = malloc(size);
+	rbuf = malloc(size);
+	ut_assertnonnull(wbuf);
+	ut_assertnonnull(rbuf);
+	memset(rbuf, '\0', size);
+	for (i = 0; i < size; i++)
+		wbuf[i] = i * 7 + (i >> 9);
+
+	fd = os_open(ASYNC_TEST_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(size, os_write(fd, rbuf, size));
+	os_close(fd);
+	ut_assertok(host_dev_bind(0, ASYNC_TEST_FILE));
+	desc = blk_get_devnum_by_type(IF_TYPE_HOST, 0);
+	ut_assertnonnull(desc);
+
+	ut_assertok(blk_async_run(uts, desc, BLK_REQ_WRITE, wbuf, &count));
+	ut_asserteq(ASYNC_TEST_REQS, count);
+	ut_assertok(blk_async_run(uts, desc, BLK_REQ_READ, rbuf, &count));
+	ut_asserteq(2 * ASYNC_TEST_REQS, count);
+	ut_assertok(memcmp(wbuf, rbuf, size));
+
+	/* The data must also be there for synchronous reads */
+	memset(rbuf, '\0', size);
+	ut_asserteq(ASYNC_TEST_BLKS, blk_dread(desc, 0, ASYNC_TEST_BLKS, rbuf));
+	ut_assertok(memcmp(wbuf, rbuf, size));
+
+	/* Requests too small for the host's AIO complete the same way */
+	ut_assertok(blk_async_submit(desc, &req, BLK_REQ_READ, 8, 4, rbuf,
+				     &count));
+	ut_asserteq(4, blk_wait(&req));
+	ut_assertok(memcmp(wbuf + 8 * 512, rbuf, 4 * 512));
+
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink(ASYNC_TEST_FILE);
+	free(rbuf);
+	free(wbuf);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async, DM_TESTF_SCAN_PDATA);
+
+/*
+ * Read, overwrite and read again 'blkcnt' blocks, with all three requests in
+ * flight together. They must take effect in the order they were submitted,
+ * and the block cache must not be left holding the overwritten data.
+ */
+static int blk_async_order(struct unit_test_state *uts, lbaint_t blkcnt)
+{
+	/* Keep clear of the blocks read by the partition scan when binding */
+	lbaint_t start = 1024;
+	int size = blkcnt * 512;
+	u8 *buf[3], *before, *after;
+	struct blk_req req[3];
+	struct blk_desc *desc;
+	int count = 0;
+	int fd, i;
+
+	for (i = 0; i < 3; i++) {
+		buf[i] = malloc(size);
+		ut_assertnonnull(buf[i]);
+	}
+	before = buf[0];
+	after = buf[2];
+	for (i = 0; i < size; i++)
+		buf[1][i] = i * 13 + (i >> 9);
+
+	fd = os_open(ASYNC_TEST_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	memset(before, 0xa5, size);
+	for (i = 0; i < start + blkcnt; i += blkcnt)
+		ut_asserteq(size, os_write(fd, before, size));
+	os_close(fd);
+	ut_assertok(host_dev_bind(0, ASYNC_TEST_FILE));
+	desc = blk_get_devnum_by_type(IF_TYPE_HOST, 0);
+	ut_assertnonnull(desc);
+
+	memset(before, '\0', size);
+	memset(after, '\0', size);
+	ut_assertok(blk_async_submit(desc, &req[0], BLK_REQ_READ, start,
+				     blkcnt, before, &count));
+	ut_assertok(blk_async_submit(desc, &req[1], BLK_REQ_WRITE, start,
+				     blkcnt, buf[1], &count));
+	ut_assertok(blk_async_submit(desc, &req[2], BLK_REQ_READ, start,
+				     blkcnt, after, &count));
+	for (i = 0; i < 3; i++)
+		ut_asserteq(blkcnt, blk_wait(&req[i]));
+	ut_asserteq(3, count);
+	for (i = 0; i < size; i++)
+		ut_asserteq(0xa5, before[i]);
+	ut_assertok(memcmp(buf[1], after, size));
+
+	memset(after, '\0', size);
+	ut_asserteq(blkcnt, blk_dread(desc, start, blkcnt, after));
+	ut_assertok(memcmp(buf[1], after, size));
+
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink(ASYNC_TEST_FILE);
+	for (i = 0; i < 3; i++)
+		free(buf[i]);
+
+	return 0;
+}
+
+/* Test ordering of overlapping asynchronous requests */
+static int dm_test_blk_async_order(struct unit_test_state *uts)
+{
+	/* Small enough to go through the block cache */
+	ut_assertok(blk_async_order(uts, 4));
+	/* Large enough to go to the host's AIO */
+	ut_assertok(blk_async_order(uts, ASYNC_TEST_BLKS / ASYNC_TEST_REQS));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async_order, DM_TESTF_SCAN_PDATA);
@@ -12,6 +12,7 @@
 #include <fdtdec.h>
 #include <malloc.h>
 #include <dm/device-internal.h>
+#include <dm/lists.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/test.h>
@@ -672,6 +673,89 @@ static int dm_test_uclass_before_ready(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_uclass_before_ready, 0);
 
+/* Test that uclass lookups agree with the list of uclasses */
+static int dm_test_uclass_find(struct unit_test_state *uts)
+{
+	struct uclass *uc, *found;
+#if CONFIG_IS_ENABLED(DM_STATS)
+	unsigned long steps;
+#endif
+	int id;
+
+	list_for_each_entry(uc, &gd->uclass_root, sibling_node)
+		ut_asserteq_ptr(uc, uclass_find(uc->uc_drv->id));
+
+	for (id = 0; id < UCLASS_COUNT; id++) {
+		found = uclass_find(id);
+		if (found)
+			ut_asserteq(id, found->uc_drv->id);
+	}
+
+	/* A destroyed uclass must no longer be found */
+	ut_assertok(uclass_get(UCLASS_TEST, &uc));
+	ut_asserteq_ptr(uc, uclass_find(UCLASS_TEST));
+	ut_assertok(uclass_destroy(uc));
+	ut_asserteq_ptr(NULL, uclass_find(UCLASS_TEST));
+
+	/* Getting it again creates a new one */
+	ut_assertok(uclass_get(UCLASS_TEST, &uc));
+	ut_asserteq_ptr(uc, uclass_find(UCLASS_TEST));
+
+#if CONFIG_IS_ENABLED(DM_STATS)
+	steps = gd->uclass_list_steps;
+	gd->uclass_lookups = 0;
+	uclass_find(UCLASS_TEST);
+	ut_asserteq(1, gd->uclass_lookups);
+	if (CONFIG_IS_ENABLED(DM_UCLASS_TABLE)) {
+		ut_asserteq(steps, gd->uclass_list_steps);
+	} else {
+		ut_assert(gd->uclass_list_steps > steps);
+	}
+#endif
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_find, DM_TESTF_SCAN_PDATA);
+
+/* Test that each compatible string finds the first driver declaring it */
+static int dm_test_lists_compat(struct unit_test_state *uts)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_match, *id, *first_id;
+	struct driver *entry, *drv, *first;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_match = entry->of_match;
+		     of_match && of_match->compatible; of_match++) {
+			first = NULL;
+			first_id = NULL;
+			for (drv = driver; !first && drv != driver + n_ents;
+			     drv++) {
+				for (id = drv->of_match;
+				     id && id->compatible; id++) {
+					if (!strcmp(id->compatible,
+						    of_match->compatible)) {
+						first = drv;
+						first_id = id;
+						break;
+					}
+				}
+			}
+			ut_asserteq_ptr(first,
+					lists_driver_lookup_compat(
+						of_match->compatible, &id));
+			ut_asserteq_ptr(first_id, id);
+		}
+	}
+
+	ut_asserteq_ptr(NULL, lists_driver_lookup_compat("not,a-driver", &id));
+	ut_asserteq_ptr(NULL, lists_driver_lookup_compat("", &id));
+
+	return 0;
+}
+DM_TEST(dm_test_lists_compat, 0);
+
 static int dm_test_uclass_devices_find(struct unit_test_state *uts)
 {
 	struct udevice *dev;
@@ -259,3 +259,83 @@ static int dm_test_net_retry(struct unit_test_state *uts)
 	return retval;
 }
 DM_TEST(dm_test_net_retry, DM_TESTF_SCAN_FDT);
+
+static int rx_ring_packets;
+
+static void rx_ring_handler(uchar *pkt, unsigned dport,
+			    struct in_addr sip, unsigned sport,
+			    unsigned len)
+{
+	rx_ring_packets++;
+}
+
+/* The asserts include a return on fail; cleanup in the caller */
+static int _dm_test_eth_rx_ring(struct unit_test_state *uts)
+{
+	uchar packet[ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + 4] = { 0 };
+	struct eth_stats *stats;
+	struct udevice *dev;
+	int len, i;
+
+	setenv("ethact", "eth@10002000");
+	ut_assertok(eth_init());
+	dev = eth_get_dev();
+	ut_assertnonnull(dev);
+	stats = eth_get_stats(dev);
+
+	len = net_set_ether(packet, eth_get_ethaddr(), PROT_IP);
+	net_set_udp_header(packet + len, net_ip, 1234, 4321, 4);
+	len += IP_UDP_HDR_SIZE + 4;
+
+	/* A burst fills the ring, further packets are lost */
+	for (i = 0; i < PKTBUFSRX; i++)
+		ut_assertok(sandbox_eth_recv_packet(dev, packet, len));
+	ut_asserteq(-ENOBUFS, sandbox_eth_recv_packet(dev, packet, len));
+	ut_asserteq(-ENOBUFS, sandbox_eth_recv_packet(dev, packet, len));
+	ut_asserteq(2, stats->rx_dropped);
+	ut_asserteq(2, stats->rx_overruns);
+
+	/* One poll passes the whole ring to the stack */
+	rx_ring_packets = 0;
+	ut_assertok(eth_rx());
+	ut_asserteq(PKTBUFSRX, rx_ring_packets);
+	ut_asserteq(PKTBUFSRX, stats->rx_packets);
+	ut_asserteq(PKTBUFSRX * len, stats->rx_bytes);
+
+	/* All buffers were given back to the driver */
+	for (i = 0; i < PKTBUFSRX; i++)
+		ut_assertok(sandbox_eth_recv_packet(dev, packet, len));
+	ut_assertok(eth_rx());
+	ut_asserteq(2 * PKTBUFSRX, rx_ring_packets);
+	ut_asserteq(2, stats->rx_dropped);
+	ut_asserteq(2, stats->rx_overruns);
+
+	/* The stack drops truncated and corrupt packets, whatever the driver */
+	ut_assertok(sandbox_eth_recv_packet(dev, packet, ETHER_HDR_SIZE - 1));
+	ut_assertok(sandbox_eth_recv_packet(dev, packet, len - 1));
+	packet[ETHER_HDR_SIZE + 10] ^= 0xff;
+	ut_assertok(sandbox_eth_recv_packet(dev, packet, len));
+	ut_assertok(eth_rx());
+	ut_asserteq(2 * PKTBUFSRX, rx_ring_packets);
+	ut_asserteq(2 * PKTBUFSRX + 3, stats->rx_packets);
+	ut_asserteq(5, stats->rx_dropped);
+	ut_asserteq(2, stats->rx_overruns);
+
+	return 0;
+}
+
+static int dm_test_eth_rx_ring(struct unit_test_state *uts)
+{
+	int retval;
+
+	net_ip = string_to_ip("1.1.2.3");
+	net_set_udp_handler(rx_ring_handler);
+
+	retval = _dm_test_eth_rx_ring(uts);
+
+	net_set_udp_handler(NULL);
+	eth_halt();
+
+	return retval;
+}
+DM_TEST(dm_test_eth_rx_ring, DM_TESTF_SCAN_FDT);
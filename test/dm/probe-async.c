@@ -0,0 +1,273 @@
+/*
+ * Tests for drivers which finish probing in the background
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/ut.h>
+#include <asm/test.h>
+
+/* How many times probe_complete() reports -EAGAIN before the device is ready */
+#define PROBE_POLLS		5
+
+struct probe_async_pdata {
+	int polls;		/* -1 to never become ready */
+	int fail;		/* Error for probe_complete() to return */
+};
+
+/* Order of events, in calls to probe() and ready reports of all devices */
+struct probe_async_priv {
+	int start_seq;		/* When probe() was called */
+	int ready_seq;		/* When probe_complete() reported ready */
+	int polls;		/* Calls to probe_complete() so far */
+};
+
+static int probe_async_seq;
+static int probe_async_removed;
+
+static int probe_async_probe(struct udevice *dev)
+{
+	struct probe_async_priv *priv = dev_get_priv(dev);
+
+	priv->start_seq = ++probe_async_seq;
+
+	return 0;
+}
+
+static int probe_async_complete(struct udevice *dev)
+{
+	struct probe_async_pdata *pdata = dev_get_platdata(dev);
+	struct probe_async_priv *priv = dev_get_priv(dev);
+
+	if (pdata->polls < 0 || priv->polls++ < pdata->polls)
+		return -EAGAIN;
+	if (pdata->fail)
+		return pdata->fail;
+	priv->ready_seq = ++probe_async_seq;
+
+	return 0;
+}
+
+static int probe_async_remove(struct udevice *dev)
+{
+	probe_async_removed++;
+
+	return 0;
+}
+
+U_BOOT_DRIVER(probe_async) = {
+	.name	= "probe_async",
+	.id	= UCLASS_TEST_FDT,
+	.probe	= probe_async_probe,
+	.probe_complete = probe_async_complete,
+	.remove	= probe_async_remove,
+	.priv_auto_alloc_size = sizeof(struct probe_async_priv),
+};
+
+static const struct probe_async_pdata pdata_delay = {
+	.polls		= PROBE_POLLS,
+};
+
+static const struct probe_async_pdata pdata_slow = {
+	.polls		= 3 * PROBE_POLLS,
+};
+
+static const struct probe_async_pdata pdata_fail = {
+	.polls		= PROBE_POLLS,
+	.fail		= -EIO,
+};
+
+static const struct probe_async_pdata pdata_never = {
+	.polls		= -1,
+};
+
+static int bind_async(struct unit_test_state *uts, struct udevice *parent,
+		      const struct probe_async_pdata *pdata,
+		      struct udevice **devp)
+{
+	struct driver_info info = {
+		.name		= "probe_async",
+		.platdata	= pdata,
+	};
+
+	ut_assertok(device_bind_by_name(parent, false, &info, devp));
+
+	return 0;
+}
+
+static struct probe_async_priv *async_priv(struct udevice *dev)
+{
+	return dev->priv;
+}
+
+/* Probing a list of devices overlaps their delays */
+static int dm_test_probe_async(struct unit_test_state *uts)
+{
+	struct udevice *serial[4], *parallel[4];
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		ut_assertok(bind_async(uts, dm_root(), &pdata_delay,
+				       &serial[i]));
+		ut_assertok(bind_async(uts, dm_root(), &pdata_delay,
+				       &parallel[i]));
+	}
+
+	/* device_probe() waits for each device before the next starts */
+	for (i = 0; i < 4; i++)
+		ut_assertok(device_probe(serial[i]));
+	for (i = 1; i < 4; i++) {
+		ut_assert(async_priv(serial[i])->start_seq >
+			  async_priv(serial[i - 1])->ready_seq);
+	}
+
+	/* device_probe_list() starts them all before any is ready */
+	ut_assertok(device_probe_list(parallel, 4));
+	for (i = 0; i < 4; i++) {
+		ut_assert(async_priv(parallel[i])->start_seq <
+			  async_priv(parallel[0])->ready_seq);
+	}
+
+	for (i = 0; i < 4; i++) {
+		ut_assert(device_active(serial[i]));
+		ut_assert(device_active(parallel[i]));
+		ut_assert(!(parallel[i]->flags & DM_FLAG_PROBE_PENDING));
+		ut_asserteq(PROBE_POLLS + 1, async_priv(parallel[i])->polls);
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async, 0);
+
+/* A child is only started once its parent is ready */
+static int dm_test_probe_async_tree(struct unit_test_state *uts)
+{
+	struct udevice *parent, *child, *other;
+	struct udevice *devs[2];
+
+	ut_assertok(bind_async(uts, dm_root(), &pdata_delay, &parent));
+	ut_assertok(bind_async(uts, parent, &pdata_delay, &child));
+	ut_assertok(bind_async(uts, dm_root(), &pdata_slow, &other));
+
+	devs[0] = child;
+	devs[1] = other;
+	ut_assertok(device_probe_list(devs, 2));
+
+	ut_assert(device_active(parent));
+	ut_assert(device_active(child));
+	ut_assert(device_active(other));
+	ut_assert(async_priv(child)->start_seq >
+		  async_priv(parent)->ready_seq);
+	/* The parent and then the child run while the other device settles */
+	ut_assert(async_priv(other)->start_seq <
+		  async_priv(parent)->ready_seq);
+	ut_assert(async_priv(other)->ready_seq >
+		  async_priv(child)->ready_seq);
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_tree, 0);
+
+/* Failures, waiting for and removing pending devices */
+static int dm_test_probe_async_pending(struct unit_test_state *uts)
+{
+	struct udevice *good, *bad, *dev;
+	struct udevice *devs[2];
+
+	ut_assertok(bind_async(uts, dm_root(), &pdata_delay, &good));
+	ut_assertok(bind_async(uts, dm_root(), &pdata_fail, &bad));
+	devs[0] = bad;
+	devs[1] = good;
+	ut_asserteq(-EIO, device_probe_list(devs, 2));
+	ut_assert(device_active(good));
+	ut_assert(!device_active(bad));
+	ut_assert(!(bad->flags & DM_FLAG_PROBE_PENDING));
+	ut_assert(!bad->priv);
+
+	/* A pending device is not active; device_probe() waits for it */
+	ut_assertok(bind_async(uts, dm_root(), &pdata_delay, &dev));
+	ut_assertok(device_probe_start(dev));
+	ut_assert(dev->flags & DM_FLAG_PROBE_PENDING);
+	ut_assert(!device_active(dev));
+	ut_asserteq(-EAGAIN, device_probe_poll(dev));
+	/* Starting it again neither restarts nor polls it */
+	ut_assertok(device_probe_start(dev));
+	ut_asserteq(1, async_priv(dev)->polls);
+	ut_asserteq(-EINVAL, device_unbind(dev));
+	ut_assertok(device_probe(dev));
+	ut_assert(device_active(dev));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+	ut_asserteq(PROBE_POLLS + 1, async_priv(dev)->polls);
+	ut_assert(async_priv(dev)->ready_seq);
+
+	/* Removing a pending device lets its probe finish first */
+	ut_assertok(device_remove(dev));
+	ut_assertok(device_probe_start(dev));
+	ut_assert(dev->flags & DM_FLAG_PROBE_PENDING);
+	probe_async_removed = 0;
+	ut_assertok(device_remove(dev));
+	ut_asserteq(1, probe_async_removed);
+	ut_assert(!device_active(dev));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_pending, 0);
+
+/* A device which never becomes ready fails once the timeout passes */
+static int dm_test_probe_async_timeout(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	ut_assertok(bind_async(uts, dm_root(), &pdata_never, &dev));
+	ut_assertok(device_probe_start(dev));
+	ut_asserteq(-EAGAIN, device_probe_poll(dev));
+	ut_assert(dev->flags & DM_FLAG_PROBE_PENDING);
+
+	probe_async_removed = 0;
+	sandbox_timer_add_offset(CONFIG_DM_PROBE_ASYNC_TIMEOUT);
+	ut_asserteq(-ETIMEDOUT, device_probe_poll(dev));
+	ut_asserteq(1, probe_async_removed);
+	ut_assert(!device_active(dev));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+	ut_assert(!dev->priv);
+
+	/* device_probe() gives up too, rather than waiting for ever */
+	ut_assertok(device_probe_start(dev));
+	sandbox_timer_add_offset(CONFIG_DM_PROBE_ASYNC_TIMEOUT);
+	ut_asserteq(-ETIMEDOUT, device_probe(dev));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_timeout, 0);
+
+/* uclass_probe_all() probes every device in the uclass */
+static int dm_test_probe_async_uclass(struct unit_test_state *uts)
+{
+	struct udevice *dev, *first;
+	struct uclass *uc;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		ut_assertok(bind_async(uts, dm_root(), &pdata_delay, &dev));
+
+	ut_assertok(uclass_probe_all(UCLASS_TEST_FDT));
+
+	ut_assertok(uclass_get(UCLASS_TEST_FDT, &uc));
+	first = list_first_entry(&uc->dev_head, struct udevice, uclass_node);
+	uclass_foreach_dev(dev, uc) {
+		ut_assert(device_active(dev));
+		ut_assert(async_priv(dev)->start_seq <
+			  async_priv(first)->ready_seq);
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_uclass, 0);
@@ -266,3 +266,107 @@ static int dm_test_fdt_offset(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_fdt_offset, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define PHANDLE_TEST_NODES	1000
+#define PHANDLE_TEST_SIZE	(256 << 10)
+
+/* Build a large device tree, with phandles in a different order to nodes */
+static int make_phandle_fdt(struct unit_test_state *uts, void *fdt)
+{
+	char name[20];
+	int i, node;
+
+	ut_assertok(fdt_create_empty_tree(fdt, PHANDLE_TEST_SIZE));
+	for (i = 0; i < PHANDLE_TEST_NODES; i++) {
+		snprintf(name, sizeof(name), "node@%x", i);
+		node = fdt_add_subnode(fdt, 0, name);
+		ut_assert(node >= 0);
+		ut_assertok(fdt_setprop_string(fdt, node, "compatible",
+					       "denx,u-boot-fdt-test"));
+		ut_assertok(fdt_setprop_u32(fdt, node, "reg", i));
+		ut_assertok(fdt_setprop_u32(fdt, node, "phandle",
+					    i * 7 % PHANDLE_TEST_NODES + 1));
+	}
+
+	return 0;
+}
+
+static int check_phandle_cache(struct unit_test_state *uts, void *fdt)
+{
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+	struct fdtdec_phandle_cache *cache;
+#endif
+	ulong start, ref_us, us;
+	uint32_t phandle;
+	int node;
+
+	for (phandle = 1; phandle <= PHANDLE_TEST_NODES; phandle++) {
+		node = fdt_node_offset_by_phandle(fdt, phandle);
+		ut_assert(node > 0);
+		ut_asserteq(node, fdtdec_node_offset_by_phandle(fdt, phandle));
+	}
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_node_offset_by_phandle(fdt, PHANDLE_TEST_NODES + 1));
+
+	start = timer_get_us();
+	for (phandle = 1; phandle <= PHANDLE_TEST_NODES; phandle++)
+		fdt_node_offset_by_phandle(fdt, phandle);
+	ref_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (phandle = 1; phandle <= PHANDLE_TEST_NODES; phandle++)
+		fdtdec_node_offset_by_phandle(fdt, phandle);
+	us = timer_get_us() - start;
+	printf("%s: %d lookups: libfdt %lu us, fdtdec %lu us\n", __func__,
+	       PHANDLE_TEST_NODES, ref_us, us);
+
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+	/* Misses and invalidation must reuse the table, not reallocate it */
+	cache = gd->fdt_phandle_cache;
+	ut_assertnonnull(cache);
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_node_offset_by_phandle(fdt, PHANDLE_TEST_NODES * 3));
+	fdtdec_phandle_cache_invalidate();
+	ut_asserteq(fdt_node_offset_by_phandle(fdt, 1),
+		    fdtdec_node_offset_by_phandle(fdt, 1));
+	ut_asserteq_ptr(cache, gd->fdt_phandle_cache);
+#endif
+
+	/* Moving nodes around must not return stale offsets */
+	node = fdt_node_offset_by_phandle(fdt, 1);
+	ut_assertok(fdt_del_node(fdt, node));
+	node = fdt_add_subnode(fdt, 0, "extra");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_u32(fdt, node, "phandle",
+				    PHANDLE_TEST_NODES + 1));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_node_offset_by_phandle(fdt, 1));
+	for (phandle = 2; phandle <= PHANDLE_TEST_NODES + 1; phandle++) {
+		ut_asserteq(fdt_node_offset_by_phandle(fdt, phandle),
+			    fdtdec_node_offset_by_phandle(fdt, phandle));
+	}
+
+	return 0;
+}
+
+/* Test that phandle lookups in the control FDT match libfdt */
+static int dm_test_fdt_phandle_cache(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	void *fdt;
+	int ret;
+
+	fdt = malloc(PHANDLE_TEST_SIZE);
+	ut_assertnonnull(fdt);
+	ret = make_phandle_fdt(uts, fdt);
+	if (!ret) {
+		gd->fdt_blob = fdt;
+		fdtdec_phandle_cache_invalidate();
+		ret = check_phandle_cache(uts, fdt);
+		gd->fdt_blob = blob;
+		fdtdec_phandle_cache_invalidate();
+	}
+	free(fdt);
+
+	return ret;
+}
+DM_TEST(dm_test_fdt_phandle_cache, 0);
@@ -0,0 +1,364 @@
+/*
+ * Tests for TCP loss recovery and closing, by running wget against a
+ * server mocked in the sandbox Ethernet driver which loses and reorders
+ * segments to order.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <net/wget.h>
+#include <dm/test.h>
+#include <asm/eth.h>
+#include <asm/unaligned.h>
+#include <test/ut.h>
+
+#define WGET_TEST_SIZE		20000
+#define WGET_TEST_MSS		1000
+/* Segments in flight, few enough to fit in the receive ring */
+#define WGET_TEST_WINDOW	2
+/* The sequence numbers of the response wrap around */
+#define WGET_TEST_ISS		0xffffc000
+
+/* The mock server; offsets are into the response, 0 is the first byte */
+static struct wget_test_srv {
+	uchar mac[ARP_HLEN];
+	uchar client_mac[ARP_HLEN];
+	u16 cport;		/* Client port */
+	u32 rcv_nxt;		/* Next sequence number from the client */
+	bool got_req;
+	bool client_fin;
+	u32 una;		/* First offset not acknowledged */
+	u32 nxt;		/* Next offset to send */
+	bool fin_sent;
+	bool fin_acked;
+	bool close_first;	/* Close after the response, not the client */
+
+	/* Losses, each happening once */
+	bool drop_req;		/* The request */
+	u32 drop_at;		/* The segment at this offset, if not 0 */
+	u32 hold_at;		/* Send the segment after the next, if not 0 */
+	bool drop_fin;
+	u8 stale;		/* TCP_FIN or TCP_ACK, to send on a ping */
+
+	int retransmits;
+	int rsts;		/* Resets from the client */
+	int segs;		/* Segments from the client */
+
+	char resp[WGET_TEST_SIZE + 128];
+	u32 len;
+} srv;
+
+static uchar wget_test_body(int i)
+{
+	return i * 7 + (i >> 8);
+}
+
+static void wget_test_send(struct udevice *dev, u8 flags, u32 seq,
+			   const void *data, int len)
+{
+	uchar pkt[PKTSIZE];
+	struct ethernet_hdr *eth = (struct ethernet_hdr *)pkt;
+	struct ip_tcp_hdr *tcp = (struct ip_tcp_hdr *)(pkt + ETHER_HDR_SIZE);
+	int hlen = TCP_HDR_SIZE + (flags & TCP_SYN ? 4 : 0);
+	uchar *opt = (uchar *)tcp + IP_TCP_HDR_SIZE;
+	struct {
+		struct in_addr src;
+		struct in_addr dst;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} pseudo;
+
+	memcpy(eth->et_dest, srv.client_mac, ARP_HLEN);
+	memcpy(eth->et_src, srv.mac, ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+
+	net_set_ip_header((uchar *)tcp, net_ip, net_server_ip);
+	tcp->ip_len = htons(IP_HDR_SIZE + hlen + len);
+	tcp->ip_p = IPPROTO_TCP;
+	tcp->ip_sum = compute_ip_checksum(tcp, IP_HDR_SIZE);
+
+	tcp->tcp_src = htons(HTTP_SERVICE_PORT);
+	tcp->tcp_dst = htons(srv.cport);
+	put_unaligned_be32(seq, &tcp->tcp_seq);
+	put_unaligned_be32(srv.rcv_nxt, &tcp->tcp_ack);
+	tcp->tcp_hlen = hlen << 2;
+	tcp->tcp_flags = flags;
+	tcp->tcp_win = htons(0xffff);
+	tcp->tcp_xsum = 0;
+	tcp->tcp_urg = 0;
+	if (flags & TCP_SYN) {
+		opt[0] = 2;	/* MSS */
+		opt[1] = 4;
+		put_unaligned_be16(WGET_TEST_MSS, opt + 2);
+	}
+	memcpy((uchar *)tcp + IP_HDR_SIZE + hlen, data, len);
+
+	net_copy_ip(&pseudo.src, &tcp->ip_src);
+	net_copy_ip(&pseudo.dst, &tcp->ip_dst);
+	pseudo.zero = 0;
+	pseudo.proto = IPPROTO_TCP;
+	pseudo.len = htons(hlen + len);
+	tcp->tcp_xsum = add_ip_checksums(sizeof(pseudo),
+				compute_ip_checksum(&pseudo, sizeof(pseudo)),
+				compute_ip_checksum(&tcp->tcp_src, hlen + len));
+
+	/* A full receive ring loses it, like any other loss */
+	sandbox_eth_recv_packet(dev, pkt,
+				ETHER_HDR_SIZE + IP_HDR_SIZE + hlen + len);
+}
+
+static void wget_test_send_data(struct udevice *dev, u32 off)
+{
+	wget_test_send(dev, TCP_ACK, WGET_TEST_ISS + 1 + off, srv.resp + off,
+		       min_t(u32, srv.len - off, WGET_TEST_MSS));
+}
+
+static void wget_test_send_fin(struct udevice *dev)
+{
+	wget_test_send(dev, TCP_FIN | TCP_ACK, WGET_TEST_ISS + 1 + srv.len,
+		       NULL, 0);
+}
+
+/* Sends what the window allows, losing and holding back segments */
+static void wget_test_output(struct udevice *dev)
+{
+	u32 held = 0;
+	u32 off;
+
+	while (srv.got_req && srv.nxt < srv.len &&
+	       srv.nxt - srv.una < WGET_TEST_WINDOW * WGET_TEST_MSS) {
+		off = srv.nxt;
+		srv.nxt += min_t(u32, srv.len - off, WGET_TEST_MSS);
+		if (off == srv.drop_at) {
+			srv.drop_at = 0;
+			continue;
+		}
+		if (off == srv.hold_at) {
+			srv.hold_at = 0;
+			held = off;
+			continue;
+		}
+		wget_test_send_data(dev, off);
+	}
+	if (held)
+		wget_test_send_data(dev, held);
+
+	if (srv.nxt == srv.len && !srv.fin_sent &&
+	    (srv.close_first || srv.client_fin)) {
+		srv.fin_sent = true;
+		if (srv.drop_fin)
+			srv.drop_fin = false;
+		else
+			wget_test_send_fin(dev);
+	}
+}
+
+static bool wget_test_tx(struct udevice *dev, void *packet, int length)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *tcp = packet + ETHER_HDR_SIZE;
+	u32 seq, off, plen;
+	bool ack_needed = false;
+	int hlen;
+
+	if (ntohs(eth->et_protlen) != PROT_IP)
+		return false;
+	if (tcp->ip_p == IPPROTO_ICMP && srv.stale) {
+		/* A late segment of the last connection, before the reply */
+		if (srv.stale == TCP_FIN)
+			wget_test_send_fin(dev);
+		else
+			wget_test_send_data(dev, 0);
+		srv.stale = 0;
+	}
+	if (tcp->ip_p != IPPROTO_TCP)
+		return false;
+	srv.segs++;
+	memcpy(srv.mac, eth->et_dest, ARP_HLEN);
+	memcpy(srv.client_mac, eth->et_src, ARP_HLEN);
+	hlen = (tcp->tcp_hlen >> 4) * 4;
+	plen = ntohs(tcp->ip_len) - IP_HDR_SIZE - hlen;
+	seq = get_unaligned_be32(&tcp->tcp_seq);
+	off = get_unaligned_be32(&tcp->tcp_ack) - (WGET_TEST_ISS + 1);
+
+	if (tcp->tcp_flags & TCP_RST) {
+		srv.rsts++;
+		return true;
+	}
+	if (tcp->tcp_flags & TCP_SYN) {
+		srv.cport = ntohs(tcp->tcp_src);
+		srv.rcv_nxt = seq + 1;
+		wget_test_send(dev, TCP_SYN | TCP_ACK, WGET_TEST_ISS, NULL, 0);
+		return true;
+	}
+	if (ntohs(tcp->tcp_src) != srv.cport)
+		return true;
+
+	if (plen) {
+		if (seq == srv.rcv_nxt && srv.drop_req) {
+			srv.drop_req = false;
+			return true;
+		}
+		if (seq == srv.rcv_nxt) {
+			srv.rcv_nxt += plen;
+			srv.got_req = true;
+		}
+		ack_needed = true;
+	}
+	if ((tcp->tcp_flags & TCP_FIN) && seq + plen == srv.rcv_nxt) {
+		srv.rcv_nxt++;
+		srv.client_fin = true;
+		ack_needed = true;
+	}
+
+	if (off > srv.una && off <= srv.len + srv.fin_sent) {
+		srv.una = min(off, srv.len);
+		srv.fin_acked = off > srv.len;
+	} else if (!ack_needed && off == srv.una && srv.una < srv.nxt) {
+		/* A duplicate ACK: the client is missing this segment */
+		wget_test_send_data(dev, srv.una);
+		srv.retransmits++;
+	} else if (!ack_needed && off == srv.len && srv.fin_sent &&
+		   !srv.fin_acked) {
+		wget_test_send_fin(dev);
+		srv.retransmits++;
+	}
+
+	if (ack_needed)
+		wget_test_send(dev, TCP_ACK,
+			       WGET_TEST_ISS + 1 + srv.nxt + srv.fin_sent,
+			       NULL, 0);
+	wget_test_output(dev);
+
+	return true;
+}
+
+static void wget_test_setup(bool close_first)
+{
+	int i;
+
+	memset(&srv, '\0', sizeof(srv));
+	srv.close_first = close_first;
+	srv.len = sprintf(srv.resp, "HTTP/1.1 200 OK\r\n");
+	if (!close_first)
+		srv.len += sprintf(srv.resp + srv.len,
+				   "Content-Length: %d\r\n", WGET_TEST_SIZE);
+	srv.len += sprintf(srv.resp + srv.len, "\r\n");
+	for (i = 0; i < WGET_TEST_SIZE; i++)
+		srv.resp[srv.len++] = wget_test_body(i);
+}
+
+/* Downloads the file and checks it */
+static int wget_test_run(struct unit_test_state *uts)
+{
+	uchar *buf;
+	int i;
+
+	ut_asserteq(WGET_TEST_SIZE, net_loop(WGET));
+	buf = map_sysmem(load_addr, WGET_TEST_SIZE);
+	for (i = 0; i < WGET_TEST_SIZE; i++)
+		ut_asserteq(wget_test_body(i), buf[i]);
+	unmap_sysmem(buf);
+
+	/* Both sides closed cleanly */
+	ut_assert(srv.client_fin);
+	ut_assert(srv.fin_acked);
+	ut_asserteq(0, srv.rsts);
+
+	return 0;
+}
+
+/* Pings the server, which sends a segment of the last connection first */
+static int wget_test_stale(struct unit_test_state *uts, u8 flags)
+{
+	int segs = srv.segs;
+
+	srv.stale = flags;
+	net_ping_ip = net_server_ip;
+	ut_assertok(net_loop(PING));
+	ut_asserteq(0, srv.stale);
+	/* The client neither answered nor reset */
+	ut_asserteq(segs, srv.segs);
+
+	return 0;
+}
+
+/* The client closes first, and goes through FIN_WAIT_2 and TIME_WAIT */
+static int _dm_test_wget_loss(struct unit_test_state *uts)
+{
+	wget_test_setup(false);
+	srv.drop_req = true;
+	srv.drop_at = 4 * WGET_TEST_MSS;
+	srv.hold_at = 9 * WGET_TEST_MSS;
+	srv.drop_fin = true;
+	ut_assertok(wget_test_run(uts));
+	ut_assert(srv.retransmits >= 2);
+
+	/* The connection left TIME_WAIT when wget finished */
+	ut_assertok(wget_test_stale(uts, TCP_FIN));
+
+	return 0;
+}
+
+/* The server closes first, which ends the body, and the client LAST_ACK */
+static int _dm_test_wget_close(struct unit_test_state *uts)
+{
+	u16 cport;
+
+	wget_test_setup(true);
+	srv.drop_fin = true;
+	ut_assertok(wget_test_run(uts));
+	cport = srv.cport;
+
+	/* The next connection does not reuse the port */
+	wget_test_setup(true);
+	ut_assertok(wget_test_run(uts));
+	ut_assert(srv.cport != cport);
+
+	/* Once wget is done, segments of its connection are ignored */
+	ut_assertok(wget_test_stale(uts, TCP_ACK));
+
+	return 0;
+}
+
+static int dm_test_wget(struct unit_test_state *uts,
+			int (*test)(struct unit_test_state *uts))
+{
+	ulong addr = load_addr;
+	int retval;
+
+	setenv("ethact", "eth@10002000");
+	setenv("httpdstp", NULL);
+	net_ip = string_to_ip("1.1.2.3");
+	net_server_ip = string_to_ip("1.1.2.2");
+	strcpy(net_boot_file_name, "/file");
+	load_addr = 0x1000000;
+	sandbox_eth_set_tx_handler(0, wget_test_tx);
+
+	retval = test(uts);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	eth_halt();
+	load_addr = addr;
+	net_server_ip.s_addr = 0;
+
+	return retval;
+}
+
+static int dm_test_wget_loss(struct unit_test_state *uts)
+{
+	return dm_test_wget(uts, _dm_test_wget_loss);
+}
+DM_TEST(dm_test_wget_loss, DM_TESTF_SCAN_FDT);
+
+static int dm_test_wget_close(struct unit_test_state *uts)
+{
+	return dm_test_wget(uts, _dm_test_wget_close);
+}
+DM_TEST(dm_test_wget_close, DM_TESTF_SCAN_FDT);
@@ -0,0 +1,193 @@
+/*
+ * Checks which reads through the EFI block I/O read-ahead window are served
+ * from the window and which go to the device, by changing the backing file
+ * of a host block device behind the window's back.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <command.h>
+#include <efi_loader.h>
+#include <errno.h>
+#include <malloc.h>
+#include <os.h>
+#include <sandboxblockdev.h>
+
+#define TEST_FILE		"efi_disk_test.img"
+#define TEST_BLKS		32768
+#define BLKSZ			512
+/* Blocks in the read-ahead window */
+#define WINDOW			(CONFIG_EFI_LOADER_DISK_READAHEAD * 1024 / BLKSZ)
+
+/* Fills the backing file, each word holding its block number and gen */
+static int write_file(int gen)
+{
+	u32 *buf = malloc(TEST_BLKS * BLKSZ);
+	int fd, i, ret = -EIO;
+
+	if (!buf)
+		return -ENOMEM;
+	for (i = 0; i < TEST_BLKS * BLKSZ / 4; i++)
+		buf[i] = (i / (BLKSZ / 4)) << 8 | gen;
+	fd = os_open(TEST_FILE, OS_O_RDWR | OS_O_CREAT);
+	if (fd >= 0) {
+		if (os_write(fd, buf, TEST_BLKS * BLKSZ) == TEST_BLKS * BLKSZ)
+			ret = 0;
+		os_close(fd);
+	}
+	free(buf);
+
+	/* The file changed behind U-Boot's back, so the cache is stale */
+	blkcache_invalidate(IF_TYPE_HOST, 0);
+
+	return ret;
+}
+
+/* Reads blocks through the window and checks that they hold gen */
+static int read_check(struct efi_disk_ra *ra, struct blk_desc *desc,
+		      lbaint_t lba, lbaint_t blocks, int gen)
+{
+	u32 *buf = malloc(blocks * BLKSZ);
+	int i, ret = 0;
+
+	if (!buf)
+		return -ENOMEM;
+	if (efi_disk_ra_read(ra, desc, lba, blocks, buf) != blocks) {
+		printf("%s: reading %lu+%lu failed\n", __func__, (ulong)lba,
+		       (ulong)blocks);
+		ret = -EIO;
+		goto out;
+	}
+	for (i = 0; i < blocks * BLKSZ / 4; i++) {
+		if (buf[i] != ((lba + i / (BLKSZ / 4)) << 8 | gen)) {
+			printf("%s: reading %lu+%lu gave %x at word %d, expected generation %d\n",
+			       __func__, (ulong)lba, (ulong)blocks, buf[i], i,
+			       gen);
+			ret = -EINVAL;
+			break;
+		}
+	}
+out:
+	free(buf);
+
+	return ret;
+}
+
+static int test_efi_disk_ra(struct blk_desc *desc)
+{
+	struct efi_disk_ra *ra;
+	u8 buf[BLKSZ];
+
+	ra = efi_disk_ra_get(desc);
+	if (!ra || efi_disk_ra_get(desc) != ra) {
+		printf("%s: no window for the device\n", __func__);
+		return -EINVAL;
+	}
+	efi_disk_ra_invalidate_all();
+
+	/* A miss fills the window with blocks 10 onwards */
+	if (read_check(ra, desc, 10, 1, 0) || write_file(1))
+		return -EINVAL;
+
+	/* Hits inside the window, up to its last block */
+	if (read_check(ra, desc, 11, 4, 0) ||
+	    read_check(ra, desc, 10 + WINDOW - 1, 1, 0))
+		return -EINVAL;
+
+	/* Misses just past the window and just before it refill it */
+	if (read_check(ra, desc, 10 + WINDOW - 1, 2, 1) ||
+	    read_check(ra, desc, 9, 1, 1) ||
+	    read_check(ra, desc, 10, 1, 1))
+		return -EINVAL;
+
+	/* Reads as large as the window bypass it and leave it alone */
+	if (write_file(2) ||
+	    read_check(ra, desc, 0, WINDOW, 2) ||
+	    read_check(ra, desc, 12, 2, 1))
+		return -EINVAL;
+
+	/* A write through EFI drops the window of the device */
+	efi_disk_ra_invalidate(ra);
+	if (read_check(ra, desc, 12, 2, 2))
+		return -EINVAL;
+
+	/* Registering the disks again drops every window */
+	if (write_file(3) || read_check(ra, desc, 13, 1, 2))
+		return -EINVAL;
+	efi_disk_ra_invalidate_all();
+	if (read_check(ra, desc, 13, 1, 3))
+		return -EINVAL;
+
+	/* The window stops at the end of the disk */
+	if (read_check(ra, desc, TEST_BLKS - 2, 1, 3) || write_file(4) ||
+	    read_check(ra, desc, TEST_BLKS - 1, 1, 3))
+		return -EINVAL;
+	if (efi_disk_ra_read(ra, desc, TEST_BLKS, 1, buf) == 1 ||
+	    efi_disk_ra_read(ra, desc, TEST_BLKS - 1, 2, buf) == 2) {
+		printf("%s: read past the end of the disk\n", __func__);
+		return -EINVAL;
+	}
+
+	/* Without a window every read goes to the device */
+	efi_disk_ra_invalidate(NULL);
+	if (read_check(NULL, desc, TEST_BLKS - 1, 1, 4))
+		return -EINVAL;
+
+	return 0;
+}
+
+/* Times reading the whole disk in small pieces with and without a window */
+static int test_efi_disk_ra_speed(struct blk_desc *desc, lbaint_t blocks)
+{
+	struct efi_disk_ra *ra = efi_disk_ra_get(desc);
+	u8 buf[8 * BLKSZ];
+	ulong start, us[2];
+	lbaint_t lba;
+	int pass;
+
+	for (pass = 0; pass < 2; pass++) {
+		efi_disk_ra_invalidate(ra);
+		blkcache_invalidate(IF_TYPE_HOST, 0);
+		start = timer_get_us();
+		for (lba = 0; lba < TEST_BLKS; lba += blocks) {
+			if (efi_disk_ra_read(pass ? ra : NULL, desc, lba, blocks,
+					     buf) != blocks) {
+				printf("%s: reading %lu+%lu failed\n", __func__,
+				       (ulong)lba, (ulong)blocks);
+				return -EIO;
+			}
+		}
+		us[pass] = timer_get_us() - start;
+	}
+	printf("%s: %lu-block reads: %lu us, %lu us without the window\n",
+	       __func__, (ulong)blocks, us[1], us[0]);
+
+	return 0;
+}
+
+int do_ut_efi_disk(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct blk_desc *desc;
+	int ret;
+
+	ret = write_file(0);
+	if (!ret)
+		ret = host_dev_bind(0, TEST_FILE);
+	if (ret) {
+		printf("Cannot set up %s: %d\n", TEST_FILE, ret);
+		return CMD_RET_FAILURE;
+	}
+	desc = blk_get_devnum_by_type(IF_TYPE_HOST, 0);
+	ret = desc ? test_efi_disk_ra(desc) : -ENODEV;
+	if (!ret)
+		ret = test_efi_disk_ra_speed(desc, 1) ||
+		      test_efi_disk_ra_speed(desc, 8);
+	host_dev_bind(0, NULL);
+	os_unlink(TEST_FILE);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
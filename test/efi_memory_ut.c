@@ -0,0 +1,470 @@
+/*
+ * Checks how the EFI memory map splits and merges entries, finds free pages
+ * and hands out pool allocations, and reports the speed of many small pool
+ * allocations.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <efi_loader.h>
+#include <errno.h>
+#include <malloc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Pages which are only entered in the map, never accessed */
+#define TEST_BASE		0x40000000ULL
+#define TEST_PAGES		512
+/* Pages covered by the random test, the page map is one byte per page */
+#define MAP_PAGES		256
+#define RANDOM_OPS		20000
+/* Real memory for pool allocations */
+#define POOL_PAGES		512
+#define POOL_ALLOCS		200
+#define BENCH_ALLOCS		3000
+
+#define PAGE_ADDR(p)		(TEST_BASE + ((u64)(p) << EFI_PAGE_SHIFT))
+
+static u8 pool_ram[POOL_PAGES << EFI_PAGE_SHIFT] __aligned(EFI_PAGE_SIZE);
+
+static uint32_t seed = 1;
+
+static uint rand_below(uint limit)
+{
+	seed = seed * 1103515245 + 12345;
+
+	return (seed >> 8) % limit;
+}
+
+/* Returns a copy of the memory map, which the caller must free */
+static struct efi_mem_desc *get_map(int *countp)
+{
+	struct efi_mem_desc *map;
+	unsigned long size = 0, key;
+
+	efi_get_memory_map(&size, NULL, &key, NULL, NULL);
+	map = malloc(size ? size : 1);
+	if (!map ||
+	    efi_get_memory_map(&size, map, &key, NULL, NULL) != EFI_SUCCESS) {
+		free(map);
+		return NULL;
+	}
+	*countp = size / sizeof(*map);
+
+	return map;
+}
+
+static u64 desc_end(struct efi_mem_desc *desc)
+{
+	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
+}
+
+/*
+ * Checks that the map is sorted, has no empty or overlapping entries and
+ * no free entries which should have been merged. Returns the number of
+ * entries within [start, end), or -EINVAL.
+ */
+static int check_map(u64 start, u64 end)
+{
+	struct efi_mem_desc *map, *prev;
+	int count, i, in_range = 0;
+
+	map = get_map(&count);
+	if (!map)
+		return -EINVAL;
+	for (i = 0; i < count; i++) {
+		if (!map[i].num_pages) {
+			printf("%s: entry %d is empty\n", __func__, i);
+			goto err;
+		}
+		if (map[i].physical_start >= start && desc_end(&map[i]) <= end)
+			in_range++;
+		if (!i)
+			continue;
+		prev = &map[i - 1];
+		if (desc_end(prev) > map[i].physical_start) {
+			printf("%s: entries %d and %d overlap\n", __func__,
+			       i - 1, i);
+			goto err;
+		}
+		if (desc_end(prev) == map[i].physical_start &&
+		    prev->type == EFI_CONVENTIONAL_MEMORY &&
+		    map[i].type == EFI_CONVENTIONAL_MEMORY &&
+		    prev->attribute == map[i].attribute) {
+			printf("%s: free entries %d and %d are not merged\n",
+			       __func__, i - 1, i);
+			goto err;
+		}
+	}
+	free(map);
+
+	return in_range;
+err:
+	free(map);
+
+	return -EINVAL;
+}
+
+/* Returns the type of the entry holding addr, or -1 */
+static int type_at(u64 addr)
+{
+	struct efi_mem_desc *map;
+	int count, i, type = -1;
+
+	map = get_map(&count);
+	if (!map)
+		return -1;
+	for (i = 0; i < count; i++) {
+		if (addr >= map[i].physical_start && addr < desc_end(&map[i]))
+			type = map[i].type;
+	}
+	free(map);
+
+	return type;
+}
+
+/* Reserving inside a free entry splits it, freeing merges it again */
+static int test_efi_mem_split_merge(void)
+{
+	u64 addr;
+
+	efi_add_memory_map(TEST_BASE, TEST_PAGES, EFI_CONVENTIONAL_MEMORY,
+			   false);
+	if (check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 1) {
+		printf("%s: free area not entered\n", __func__);
+		return -EINVAL;
+	}
+
+	/* [ free | data 16-19 | free ] */
+	addr = PAGE_ADDR(16);
+	if (efi_allocate_pages(EFI_ALLOCATE_ADDRESS, EFI_LOADER_DATA, 4,
+			       &addr) != EFI_SUCCESS ||
+	    check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 3 ||
+	    type_at(PAGE_ADDR(16)) != EFI_LOADER_DATA ||
+	    type_at(PAGE_ADDR(19)) != EFI_LOADER_DATA ||
+	    type_at(PAGE_ADDR(20)) != EFI_CONVENTIONAL_MEMORY) {
+		printf("%s: allocation did not split the free area\n",
+		       __func__);
+		return -EINVAL;
+	}
+
+	/* Pages which are partly in use cannot be allocated */
+	addr = PAGE_ADDR(18);
+	if (efi_allocate_pages(EFI_ALLOCATE_ADDRESS, EFI_LOADER_DATA, 4,
+			       &addr) != EFI_OUT_OF_RESOURCES ||
+	    check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 3 ||
+	    type_at(PAGE_ADDR(21)) != EFI_CONVENTIONAL_MEMORY) {
+		printf("%s: overlapping allocation changed the map\n",
+		       __func__);
+		return -EINVAL;
+	}
+
+	/* [ free | data 16 | bs data 17 | data 18-19 | free ] */
+	efi_add_memory_map(PAGE_ADDR(17), 1, EFI_BOOT_SERVICES_DATA, false);
+	if (check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 5 ||
+	    type_at(PAGE_ADDR(17)) != EFI_BOOT_SERVICES_DATA ||
+	    type_at(PAGE_ADDR(18)) != EFI_LOADER_DATA) {
+		printf("%s: entry not split in three\n", __func__);
+		return -EINVAL;
+	}
+
+	/* A freed page between two used ones stays on its own */
+	if (efi_free_pages(PAGE_ADDR(17), 1) != EFI_SUCCESS ||
+	    check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 5) {
+		printf("%s: free page merged with used pages\n", __func__);
+		return -EINVAL;
+	}
+
+	/* Freeing the rest leaves a single free entry again */
+	if (efi_free_pages(PAGE_ADDR(16), 1) != EFI_SUCCESS ||
+	    check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 3 ||
+	    efi_free_pages(PAGE_ADDR(18), 2) != EFI_SUCCESS ||
+	    check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 1) {
+		printf("%s: free pages not merged\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Allocations take the highest free pages below the limit */
+static int test_efi_mem_find_free(void)
+{
+	u64 addr, a, b, c;
+	int p;
+
+	a = PAGE_ADDR(100);
+	b = PAGE_ADDR(100);
+	c = PAGE_ADDR(85);
+	if (efi_allocate_pages(EFI_ALLOCATE_MAX_ADDRESS, EFI_LOADER_DATA, 10,
+			       &a) != EFI_SUCCESS ||
+	    efi_allocate_pages(EFI_ALLOCATE_MAX_ADDRESS, EFI_LOADER_DATA, 10,
+			       &b) != EFI_SUCCESS ||
+	    efi_allocate_pages(EFI_ALLOCATE_MAX_ADDRESS, EFI_LOADER_DATA, 10,
+			       &c) != EFI_SUCCESS ||
+	    a != PAGE_ADDR(90) || b != PAGE_ADDR(80) || c != PAGE_ADDR(70)) {
+		printf("%s: allocated %llx %llx %llx\n", __func__,
+		       (unsigned long long)a, (unsigned long long)b,
+		       (unsigned long long)c);
+		return -EINVAL;
+	}
+
+	/* Too large */
+	addr = PAGE_ADDR(TEST_PAGES);
+	if (efi_allocate_pages(EFI_ALLOCATE_MAX_ADDRESS, EFI_LOADER_DATA,
+			       TEST_PAGES, &addr) != EFI_NOT_FOUND) {
+		printf("%s: allocated more than is free\n", __func__);
+		return -EINVAL;
+	}
+
+	if (efi_free_pages(a, 10) != EFI_SUCCESS ||
+	    efi_free_pages(c, 10) != EFI_SUCCESS ||
+	    efi_free_pages(b, 10) != EFI_SUCCESS ||
+	    check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 1) {
+		printf("%s: free pages not merged\n", __func__);
+		return -EINVAL;
+	}
+
+	/* Only single free pages below page 64 */
+	for (p = 0; p < 64; p += 2) {
+		addr = PAGE_ADDR(p);
+		if (efi_allocate_pages(EFI_ALLOCATE_ADDRESS, EFI_LOADER_DATA, 1,
+				       &addr) != EFI_SUCCESS) {
+			printf("%s: cannot allocate page %d\n", __func__, p);
+			return -EINVAL;
+		}
+	}
+	addr = PAGE_ADDR(64);
+	if (efi_allocate_pages(EFI_ALLOCATE_MAX_ADDRESS, EFI_LOADER_DATA, 2,
+			       &addr) != EFI_NOT_FOUND) {
+		printf("%s: two pages allocated from single free pages\n",
+		       __func__);
+		return -EINVAL;
+	}
+	if (efi_allocate_pages(EFI_ALLOCATE_MAX_ADDRESS, EFI_LOADER_DATA, 1,
+			       &addr) != EFI_SUCCESS || addr != PAGE_ADDR(63)) {
+		printf("%s: single page allocated at %llx\n", __func__,
+		       (unsigned long long)addr);
+		return -EINVAL;
+	}
+	for (p = 0; p < 64; p++)
+		efi_free_pages(PAGE_ADDR(p), 1);
+	if (check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 1) {
+		printf("%s: free pages not merged\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Returns the first page of the highest len free pages below max, or -1 */
+static int find_free_page(const char *map, int len, int max)
+{
+	int p, run = 0;
+
+	for (p = max - 1; p >= 0; p--) {
+		run = map[p] ? 0 : run + 1;
+		if (run == len)
+			return p;
+	}
+
+	return -1;
+}
+
+/* Random allocations and frees, checked against a page map */
+static int test_efi_mem_random(void)
+{
+	char map[MAP_PAGES] = {};
+	uint i, p;
+
+	for (i = 0; i < RANDOM_OPS; i++) {
+		uint start = rand_below(MAP_PAGES);
+		uint count = 1 + rand_below(min(8U, MAP_PAGES - start));
+		u64 addr = PAGE_ADDR(start);
+		efi_status_t r;
+		int all_free = 1;
+		int expect;
+
+		for (p = start; p < start + count; p++)
+			all_free &= !map[p];
+		switch (rand_below(3)) {
+		case 0:
+			r = efi_allocate_pages(EFI_ALLOCATE_ADDRESS,
+					       EFI_LOADER_DATA, count, &addr);
+			if (r != (all_free ? EFI_SUCCESS :
+				  EFI_OUT_OF_RESOURCES)) {
+				printf("%s: op %u: allocating %u+%u gave %lx\n",
+				       __func__, i, start, count, (ulong)r);
+				return -EINVAL;
+			}
+			if (all_free)
+				memset(map + start, 1, count);
+			break;
+		case 1:
+			/* Search below the first page of the range */
+			expect = find_free_page(map, count, start);
+			r = efi_allocate_pages(EFI_ALLOCATE_MAX_ADDRESS,
+					       EFI_LOADER_DATA, count, &addr);
+			if (expect < 0 ? r != EFI_NOT_FOUND :
+			    r != EFI_SUCCESS || addr != PAGE_ADDR(expect)) {
+				printf("%s: op %u: %u pages below %u gave %lx at %llx, expected page %d\n",
+				       __func__, i, count, start, (ulong)r,
+				       (unsigned long long)addr, expect);
+				return -EINVAL;
+			}
+			if (expect >= 0)
+				memset(map + expect, 1, count);
+			break;
+		default:
+			if (efi_free_pages(addr, count) != EFI_SUCCESS) {
+				printf("%s: op %u: free failed\n", __func__, i);
+				return -EINVAL;
+			}
+			memset(map + start, 0, count);
+			break;
+		}
+		if (i % 64)
+			continue;
+		if (check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) < 0)
+			return -EINVAL;
+		for (p = 0; p < MAP_PAGES; p++) {
+			if ((type_at(PAGE_ADDR(p)) == EFI_CONVENTIONAL_MEMORY) ==
+			    map[p]) {
+				printf("%s: op %u: page %u should%s be free\n",
+				       __func__, i, p, map[p] ? " not" : "");
+				return -EINVAL;
+			}
+		}
+	}
+
+	efi_free_pages(TEST_BASE, MAP_PAGES);
+	if (check_map(TEST_BASE, PAGE_ADDR(TEST_PAGES)) != 1) {
+		printf("%s: free pages not merged\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static bool in_pool_ram(void *ptr, unsigned long size)
+{
+	return (u8 *)ptr >= pool_ram &&
+	       (u8 *)ptr + size <= pool_ram + sizeof(pool_ram);
+}
+
+/* Pool allocations, small ones sharing pages, checked for overlaps */
+static int test_efi_mem_pool(void)
+{
+	u64 pool_base = (uintptr_t)pool_ram;
+	u64 pool_end = pool_base + sizeof(pool_ram);
+	void *ptr[POOL_ALLOCS], *big, **bench;
+	unsigned long size[POOL_ALLOCS];
+	int i, type, entries;
+	int ret = -EINVAL;
+	ulong start, us;
+	u8 *p;
+
+	/* Pool allocations take any free pages below the stack */
+	efi_add_memory_map(pool_base, POOL_PAGES, EFI_CONVENTIONAL_MEMORY,
+			   false);
+
+	for (i = 0; i < POOL_ALLOCS; i++) {
+		type = i & 1 ? EFI_LOADER_DATA : EFI_BOOT_SERVICES_DATA;
+		size[i] = 1 + rand_below(1100);
+		if (efi_allocate_pool(type, size[i], &ptr[i]) != EFI_SUCCESS ||
+		    !in_pool_ram(ptr[i], size[i]) ||
+		    (uintptr_t)ptr[i] & 7 ||
+		    type_at((uintptr_t)ptr[i]) != type) {
+			printf("%s: bad allocation %d of %lu bytes at %p\n",
+			       __func__, i, size[i], ptr[i]);
+			return -EINVAL;
+		}
+		memset(ptr[i], i, size[i]);
+	}
+
+	/* Larger requests get pages of their own */
+	if (efi_allocate_pool(EFI_LOADER_DATA, 5000, &big) != EFI_SUCCESS ||
+	    ((uintptr_t)big & EFI_PAGE_MASK) != sizeof(u64) ||
+	    !in_pool_ram(big, 5000)) {
+		printf("%s: bad page allocation at %p\n", __func__, big);
+		return -EINVAL;
+	}
+	memset(big, 0xff, 5000);
+
+	for (i = 0; i < POOL_ALLOCS; i++) {
+		for (p = ptr[i]; p < (u8 *)ptr[i] + size[i]; p++) {
+			if (*p != (u8)i) {
+				printf("%s: allocation %d overwritten\n",
+				       __func__, i);
+				return -EINVAL;
+			}
+		}
+	}
+
+	/* Free in a different order, the pages go back once unused */
+	for (i = 1; i < POOL_ALLOCS; i += 2)
+		efi_free_pool(ptr[i]);
+	efi_free_pool(big);
+	for (i = 0; i < POOL_ALLOCS; i += 2) {
+		if (efi_free_pool(ptr[i]) != EFI_SUCCESS) {
+			printf("%s: cannot free allocation %d\n", __func__, i);
+			return -EINVAL;
+		}
+	}
+	if (check_map(pool_base, pool_end) != 1) {
+		printf("%s: pool pages not returned\n", __func__);
+		return -EINVAL;
+	}
+
+	/* Many small requests, as a payload such as GRUB makes */
+	bench = calloc(BENCH_ALLOCS, sizeof(*bench));
+	if (!bench)
+		return -ENOMEM;
+	start = timer_get_us();
+	for (i = 0; i < BENCH_ALLOCS; i++) {
+		if (efi_allocate_pool(EFI_BOOT_SERVICES_DATA,
+				      100 + rand_below(300), &bench[i]) !=
+		    EFI_SUCCESS) {
+			printf("%s: pool allocation %d failed\n", __func__, i);
+			goto out;
+		}
+	}
+	us = timer_get_us() - start;
+	entries = check_map(pool_base, pool_end);
+	printf("%s: %d pool allocations: %lu us, %d map entries\n", __func__,
+	       BENCH_ALLOCS, us, entries);
+	if (entries < 0)
+		goto out;
+	ret = 0;
+out:
+	for (i = 0; i < BENCH_ALLOCS && bench[i]; i++)
+		efi_free_pool(bench[i]);
+	free(bench);
+	if (!ret && check_map(pool_base, pool_end) != 1) {
+		printf("%s: pool pages not returned\n", __func__);
+		ret = -EINVAL;
+	}
+
+	return ret;
+}
+
+int do_ut_efi_memory(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	ulong old_sp = gd->start_addr_sp;
+	int ret = 0;
+
+	gd->start_addr_sp = (uintptr_t)pool_ram + sizeof(pool_ram);
+
+	ret |= test_efi_mem_split_merge();
+	ret |= test_efi_mem_find_free();
+	ret |= test_efi_mem_random();
+	ret |= test_efi_mem_pool();
+
+	gd->start_addr_sp = old_sp;
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
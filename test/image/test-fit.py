@@ -47,6 +47,9 @@ base_its = '''
                         compression = "none";
                         load = <0x40000>;
                         entry = <0x8>;
+                        hash@1 {
+                                algo = "sha1";
+                        };
                 };
                 kernel@2 {
                         data = /incbin/("%(loadables1)s");
@@ -77,6 +80,9 @@ base_its = '''
                         os = "linux";
                         %(ramdisk_load)s
                         compression = "none";
+                        hash@1 {
+                                algo = "crc32";
+                        };
                 };
                 ramdisk@2 {
                         description = "snow";
@@ -194,7 +200,7 @@ def make_its(params):
         print >>fd, base_its % params
     return its
 
-def make_fit(mkimage, params):
+def make_fit(mkimage, params, args=[]):
     """Make a sample .fit file ready for loading
 
     This creates a .its script with the selected parameters and uses mkimage to
@@ -203,12 +209,13 @@ def make_fit(mkimage, params):
     Args:
         mkimage: Filename of 'mkimage' utility
         params: Dictionary containing parameters to embed in the %() strings
+        args: List of extra arguments for mkimage
     Return:
         Filename of .fit file created
     """
     fit = make_fname('test.fit')
     its = make_its(params)
-    command.Output(mkimage, '-f', its, fit)
+    command.Output(mkimage, *(args + ['-f', its, fit]))
     with open(make_fname('u-boot.dts'), 'w') as fd:
         print >>fd, base_fdt
     return fit
@@ -436,6 +443,53 @@ def run_fit_test(mkimage, u_boot):
     if read_file(loadables2) != read_file(loadables2_out):
         fail('Loadables2 (ramdisk) not loaded', stdout)
 
+    # Read the image data from the file as it is needed, checking the hashes
+    # as it is read
+    set_test('Streamed Kernel + FDT + Ramdisk load + Loadables')
+    fit = make_fit(mkimage, params, ['-E'])
+    stream_cmd = cmd.replace('sb load hostfs 0', 'fitload hostfs 0', 1)
+    stdout = command.Output(u_boot, '-d', control_dtb, '-c', stream_cmd)
+    debug_stdout(stdout)
+    if 'Verifying Hash Integrity while loading ... sha1+ OK' not in stdout:
+        fail('Kernel not verified while loading', stdout)
+    if read_file(kernel) != read_file(kernel_out):
+        fail('Kernel not loaded', stdout)
+    if read_file(control_dtb) != read_file(fdt_out):
+        fail('FDT not loaded', stdout)
+    if read_file(ramdisk) != read_file(ramdisk_out):
+        fail('Ramdisk not loaded', stdout)
+    if read_file(loadables1) != read_file(loadables1_out):
+        fail('Loadables1 (kernel) not loaded', stdout)
+    if read_file(loadables2) != read_file(loadables2_out):
+        fail('Loadables2 (ramdisk) not loaded', stdout)
+
+    # The same with the image data at fixed positions in the file
+    set_test('Streamed Kernel + FDT + Ramdisk load at fixed positions')
+    fit = make_fit(mkimage, params, ['-E', '-p', '0x1000'])
+    stdout = command.Output(u_boot, '-d', control_dtb, '-c', stream_cmd)
+    debug_stdout(stdout)
+    if 'Verifying Hash Integrity while loading ... sha1+ OK' not in stdout:
+        fail('Kernel not verified while loading', stdout)
+    if read_file(kernel) != read_file(kernel_out):
+        fail('Kernel not loaded', stdout)
+    if read_file(control_dtb) != read_file(fdt_out):
+        fail('FDT not loaded', stdout)
+    if read_file(ramdisk) != read_file(ramdisk_out):
+        fail('Ramdisk not loaded', stdout)
+
+    # Corrupt the kernel data in the file, which should be detected
+    set_test('Streamed Kernel with bad data')
+    data = read_file(fit)
+    pos = data.find('this kernel 42 is')
+    with open(fit, 'w') as fd:
+        fd.write(data[:pos] + 'that' + data[pos + 4:])
+    stdout = command.Output(u_boot, '-d', control_dtb, '-c', stream_cmd)
+    debug_stdout(stdout)
+    if 'Bad Data Hash' not in stdout:
+        fail('Bad kernel data not detected', stdout)
+    if "can't get kernel image" not in stdout:
+        fail('Kernel with bad data was accepted', stdout)
+
 def run_tests():
     """Parse options, run the FIT tests and print the result"""
     global base_path, base_dir
@@ -0,0 +1,248 @@
+/*
+ * Checks the lmb region bookkeeping and allocator against a simple page map
+ * and reports the speed of allocating with many reserved regions.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <lmb.h>
+
+#define RAM_BASE		0x40000000
+#define RAM_SIZE		0x10000000
+#define PAGE			0x1000
+/* Pages covered by the random test, the page map is one byte per page */
+#define MAP_PAGES		512
+#define RANDOM_OPS		20000
+#define BENCH_REGIONS		2000
+#define BENCH_ALLOCS		500
+
+static uint32_t seed = 1;
+
+static uint rand_below(uint limit)
+{
+	seed = seed * 1103515245 + 12345;
+
+	return (seed >> 8) % limit;
+}
+
+/* Regions must be sorted, non-empty and neither overlap nor touch */
+static int check_regions(struct lmb_region *rgn, const char *name)
+{
+	unsigned long i;
+
+	for (i = 0; i < rgn->cnt; i++) {
+		struct lmb_property *r = &rgn->region[i];
+
+		if (!r->size) {
+			printf("%s: %s region %lu is empty\n", __func__, name,
+			       i);
+			return -EINVAL;
+		}
+		if (i && rgn->region[i - 1].base + rgn->region[i - 1].size >=
+		    r->base) {
+			printf("%s: %s regions %lu and %lu overlap or touch\n",
+			       __func__, name, i - 1, i);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int test_lmb_simple(void)
+{
+	struct lmb lmb = {};
+	phys_addr_t a, b, c;
+	int ret = -EINVAL;
+
+	lmb_init(&lmb);
+	lmb_add(&lmb, RAM_BASE, RAM_SIZE);
+	lmb_reserve(&lmb, RAM_BASE + RAM_SIZE - 0x100000, 0x100000);
+
+	/* Allocations come from the top, below the reserved area */
+	a = lmb_alloc(&lmb, 0x10000, PAGE);
+	b = lmb_alloc(&lmb, 0x10000, PAGE);
+	c = lmb_alloc_base(&lmb, 0x10000, PAGE, RAM_BASE + 0x100000);
+	if (a != RAM_BASE + RAM_SIZE - 0x110000 || b != a - 0x10000 ||
+	    c != RAM_BASE + 0xf0000) {
+		printf("%s: allocated %llx %llx %llx\n", __func__,
+		       (unsigned long long)a, (unsigned long long)b,
+		       (unsigned long long)c);
+		goto out;
+	}
+	/* The first two allocations merged with the reserved area */
+	if (lmb.reserved.cnt != 2 || lmb.reserved.region[1].base != b) {
+		printf("%s: %lu reserved regions\n", __func__,
+		       lmb.reserved.cnt);
+		goto out;
+	}
+	if (!lmb_is_reserved(&lmb, c) || lmb_is_reserved(&lmb, c - 1) ||
+	    lmb_is_reserved(&lmb, c + 0x10000) ||
+	    !lmb_is_reserved(&lmb, RAM_BASE + RAM_SIZE - 1)) {
+		printf("%s: lmb_is_reserved() is wrong\n", __func__);
+		goto out;
+	}
+
+	/* Freeing splits a region, freeing across a gap fails */
+	if (lmb_free(&lmb, a, 0x1000) || lmb.reserved.cnt != 3 ||
+	    lmb_free(&lmb, c, 0x20000) != -1) {
+		printf("%s: lmb_free() is wrong\n", __func__);
+		goto out;
+	}
+
+	/* Too large */
+	if (__lmb_alloc_base(&lmb, RAM_SIZE, PAGE, 0)) {
+		printf("%s: allocated more than is free\n", __func__);
+		goto out;
+	}
+	ret = 0;
+out:
+	lmb_exit(&lmb);
+
+	return ret;
+}
+
+/* A region at the very top of the address space */
+static int test_lmb_top(void)
+{
+	phys_addr_t top = (phys_addr_t)-0x100000;
+	struct lmb lmb = {};
+	int ret = -EINVAL;
+
+	lmb_init(&lmb);
+	lmb_add(&lmb, top, 0x100000);
+	if (lmb_alloc(&lmb, 0x1000, PAGE) != (phys_addr_t)-0x1000 ||
+	    !lmb_is_reserved(&lmb, (phys_addr_t)-1) ||
+	    lmb_reserve(&lmb, top, 0x1000) < 0 ||
+	    lmb_reserve(&lmb, top + 0x1000, 0x1000) != 1 ||
+	    lmb.reserved.cnt != 2 || lmb_is_reserved(&lmb, top + 0x2000)) {
+		printf("%s: wrong bookkeeping at the top of memory\n",
+		       __func__);
+		goto out;
+	}
+	ret = 0;
+out:
+	lmb_exit(&lmb);
+
+	return ret;
+}
+
+/* Random reserve and free calls, checked against a page map */
+static int test_lmb_random(void)
+{
+	char map[MAP_PAGES] = {};
+	struct lmb lmb = {};
+	unsigned long max = 0;
+	int ret = -EINVAL;
+	uint i, p;
+
+	lmb_init(&lmb);
+	for (i = 0; i < RANDOM_OPS; i++) {
+		uint start = rand_below(MAP_PAGES);
+		uint count = 1 + rand_below(min(8U, MAP_PAGES - start));
+		phys_addr_t base = RAM_BASE + (phys_addr_t)start * PAGE;
+		int all = 1;
+		long rc;
+
+		for (p = start; p < start + count; p++)
+			all &= map[p];
+		if (rand_below(2)) {
+			if (lmb_reserve(&lmb, base, count * PAGE) < 0) {
+				printf("%s: lmb_reserve() failed\n", __func__);
+				goto out;
+			}
+			memset(map + start, 1, count);
+		} else {
+			rc = lmb_free(&lmb, base, count * PAGE);
+			/* Freeing must work only if the range is reserved */
+			if (rc != (all ? 0 : -1)) {
+				printf("%s: lmb_free(%u, %u) gave %ld\n",
+				       __func__, start, count, rc);
+				goto out;
+			}
+			if (all)
+				memset(map + start, 0, count);
+		}
+		if (check_regions(&lmb.reserved, "reserved"))
+			goto out;
+		max = max(max, lmb.reserved.cnt);
+		if (i % 64)
+			continue;
+		for (p = 0; p < MAP_PAGES; p++) {
+			base = RAM_BASE + (phys_addr_t)p * PAGE;
+			if (lmb_is_reserved(&lmb, base) != map[p] ||
+			    lmb_is_reserved(&lmb, base + PAGE - 1) != map[p]) {
+				printf("%s: op %u: page %u should%s be reserved\n",
+				       __func__, i, p, map[p] ? "" : " not");
+				goto out;
+			}
+		}
+	}
+	if (max <= MAX_LMB_REGIONS) {
+		printf("%s: only %lu regions used\n", __func__, max);
+		goto out;
+	}
+	ret = 0;
+out:
+	lmb_exit(&lmb);
+
+	return ret;
+}
+
+/* Allocate with many small reserved regions in the way */
+static int test_lmb_speed(void)
+{
+	struct lmb lmb = {};
+	phys_addr_t base;
+	ulong start, us;
+	int ret = -EINVAL;
+	int i;
+
+	lmb_init(&lmb);
+	lmb_add(&lmb, RAM_BASE, RAM_SIZE);
+	for (i = 0; i < BENCH_REGIONS; i++) {
+		/* Leave 3-page holes, too small for the allocations below */
+		base = RAM_BASE + RAM_SIZE - (phys_addr_t)(i + 1) * 4 * PAGE;
+		if (lmb_reserve(&lmb, base, PAGE) < 0) {
+			printf("%s: lmb_reserve() failed\n", __func__);
+			goto out;
+		}
+	}
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_ALLOCS; i++) {
+		base = __lmb_alloc_base(&lmb, 4 * PAGE, PAGE, 0);
+		if (base >= RAM_BASE + RAM_SIZE - BENCH_REGIONS * 4 * PAGE) {
+			printf("%s: allocated %llx inside the reserved regions\n",
+			       __func__, (unsigned long long)base);
+			goto out;
+		}
+	}
+	us = timer_get_us() - start;
+	printf("%s: %d allocations past %d regions: %lu us\n", __func__,
+	       BENCH_ALLOCS, BENCH_REGIONS, us);
+	if (check_regions(&lmb.reserved, "reserved"))
+		goto out;
+	ret = 0;
+out:
+	lmb_exit(&lmb);
+
+	return ret;
+}
+
+int do_ut_lmb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret = 0;
+
+	ret |= test_lmb_simple();
+	ret |= test_lmb_top();
+	ret |= test_lmb_random();
+	ret |= test_lmb_speed();
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
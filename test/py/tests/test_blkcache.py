@@ -0,0 +1,107 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Block cache test and benchmark
+
+"""
+This tests the block cache against FAT and ext4 filesystem images attached
+to sandbox's host block device:
+
+- Create an image holding a directory with many small files
+- List the directory with the cache disabled, then twice with it enabled
+- Check that the second cached pass is served from the cache
+- Check that writing to the device invalidates its cached blocks
+
+The hit rate and listing times are written to the log so the effect of the
+cache can be compared between the two filesystems.
+"""
+
+import os
+import pytest
+import re
+import u_boot_utils as util
+
+# Number of files in the test directory, enough for a multi-block directory
+NUM_FILES = 2000
+
+def make_image(cons, fs_type, fn):
+    """Create a filesystem image with a large directory
+
+    Args:
+        cons: U-Boot console
+        fs_type: 'ext4' or 'fat'
+        fn: Filename of image to create
+    """
+    srcdir = cons.config.persistent_data_dir + '/blkcache-src'
+    if not os.path.exists(srcdir + '/dir'):
+        os.makedirs(srcdir + '/dir')
+        for i in range(NUM_FILES):
+            with open('%s/dir/file%d.txt' % (srcdir, i), 'w') as fd:
+                fd.write('%d\n' % i)
+
+    if os.path.exists(fn):
+        os.remove(fn)
+    if fs_type == 'ext4':
+        util.run_and_log(cons, ['mkfs.ext4', '-q', '-F', '-d', srcdir, fn,
+                                '64M'])
+    else:
+        util.run_and_log(cons, ['dd', 'if=/dev/zero', 'of=' + fn, 'bs=1M',
+                                'count=64'])
+        util.run_and_log(cons, ['mkfs.vfat', '-F', '32', fn])
+        util.run_and_log(cons, ['mcopy', '-s', '-i', fn, srcdir + '/dir',
+                                '::/'])
+
+def list_dir(cons, fs_type):
+    """List the test directory and return the elapsed time and statistics
+
+    Args:
+        cons: U-Boot console
+        fs_type: 'ext4' or 'fat'
+
+    Returns:
+        Tuple (elapsed time in seconds, dict of 'blkcache show' fields)
+    """
+    output = cons.run_command('time %sls host 0 /dir' % fs_type)
+    assert('file%d.txt' % (NUM_FILES - 1) in output)
+    elapsed = float(re.search(r'time: ([0-9.]+) seconds', output).group(1))
+
+    stats = {}
+    output = cons.run_command('blkcache show')
+    for line in output.splitlines():
+        name, _, value = line.partition(':')
+        if value:
+            stats[name.strip()] = value.strip()
+    return elapsed, stats
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_block_cache')
+@pytest.mark.parametrize('fs_type', ['ext4', 'fat'])
+def test_blkcache(u_boot_console, fs_type):
+    """Test and benchmark the block cache on a filesystem image."""
+    cons = u_boot_console
+    fn = cons.config.persistent_data_dir + '/blkcache-%s.img' % fs_type
+    make_image(cons, fs_type, fn)
+
+    cons.run_command('host bind 0 %s' % fn)
+
+    cons.run_command('blkcache configure 0 0')
+    uncached, stats = list_dir(cons, fs_type)
+    assert(stats['hits'] == '0')
+    assert(stats['cached blocks'] == '0')
+
+    cons.run_command('blkcache configure 8 0x100000')
+    cold, stats = list_dir(cons, fs_type)
+    warm, stats = list_dir(cons, fs_type)
+    assert(stats['misses'] == '0')
+    assert(int(stats['hits']) > 0)
+    assert(int(stats['cached blocks']) > 0)
+
+    cons.log.info('%s: uncached %.3fs, cold %.3fs, warm %.3fs, hit rate %s' %
+                  (fs_type, uncached, cold, warm, stats['hit rate']))
+
+    # A write must drop the cached blocks of the device
+    cons.run_command('save host 0 0 /new 10')
+    cons.run_command('blkcache show')
+    elapsed, stats = list_dir(cons, fs_type)
+    assert(int(stats['misses']) > 0)
+
+    cons.run_command('host bind 0')
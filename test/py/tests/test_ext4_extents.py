@@ -0,0 +1,115 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# ext4 extent mapping test and benchmark
+
+"""
+This tests reading files through the ext4 extent tree on sandbox:
+
+- Create an ext4 image holding a large contiguous file, a sparse file and
+  a file fragmented enough to need a multi-level extent tree
+- Load each file (whole and partially) and check its CRC32
+- Log the load time of the large files
+"""
+
+import os
+import pytest
+import re
+import u_boot_utils as util
+import zlib
+
+# Size of the large contiguous file, in MiB
+BIG_SIZE_MB = 32
+
+def crc32(data):
+    return '%08x' % (zlib.crc32(data) & 0xffffffff)
+
+def make_image(cons, fn):
+    """Create the test image
+
+    Args:
+        cons: U-Boot console
+        fn: Filename of image to create
+
+    Returns:
+        Dict mapping file names in the image to their contents
+    """
+    datadir = cons.config.persistent_data_dir + '/ext4-extents'
+    srcdir = datadir + '/src'
+    if not os.path.exists(srcdir):
+        os.makedirs(srcdir)
+
+    files = {}
+    files['big'] = os.urandom(BIG_SIZE_MB * 1024 * 1024)
+    # Holes before, between and after the data
+    sparse = bytearray(12 * 1024 * 1024)
+    sparse[5000000:5100000] = os.urandom(100000)
+    sparse[11000000:11000777] = os.urandom(777)
+    files['sparse'] = bytes(sparse)
+    for name in ['big', 'sparse']:
+        with open('%s/%s' % (srcdir, name), 'wb') as fd:
+            fd.write(files[name])
+
+    util.run_and_log(cons, ['mkfs.ext4', '-q', '-F', '-d', srcdir, fn,
+                            '128M'])
+
+    # Fill the image with small files and delete every other one, so that
+    # the next file written is split into many extents
+    small = datadir + '/small'
+    with open(small, 'wb') as fd:
+        fd.write(os.urandom(4096))
+    cmds = datadir + '/cmds'
+    with open(cmds, 'w') as fd:
+        for i in range(3000):
+            fd.write('write %s s%d\n' % (small, i))
+        for i in range(0, 3000, 2):
+            fd.write('rm s%d\n' % i)
+    util.run_and_log(cons, ['debugfs', '-w', '-f', cmds, fn])
+
+    files['frag'] = os.urandom(8 * 1024 * 1024)
+    with open(datadir + '/frag', 'wb') as fd:
+        fd.write(files['frag'])
+    util.run_and_log(cons, ['debugfs', '-w', '-R',
+                            'write %s/frag frag' % datadir, fn])
+
+    return files
+
+def load_and_check(cons, name, data, offset=0, size=0):
+    """Load (part of) a file and check its contents
+
+    Returns:
+        Elapsed time reported by the 'time' command, in seconds
+    """
+    addr = util.find_ram_base(cons)
+    if not size:
+        size = len(data) - offset
+    output = cons.run_command('time ext4load host 0 %x %s %x %x' %
+                              (addr, name, size, offset))
+    assert('%d bytes read' % size in output)
+    elapsed = float(re.search(r'time: ([0-9.]+) seconds', output).group(1))
+
+    output = cons.run_command('crc32 %x %x' % (addr, size))
+    assert(crc32(data[offset:offset + size]) in output)
+    return elapsed
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_ext4')
+def test_ext4_extents(u_boot_console):
+    """Test and benchmark ext4 file reads through the extent tree."""
+    cons = u_boot_console
+    fn = cons.config.persistent_data_dir + '/ext4-extents.img'
+    files = make_image(cons, fn)
+
+    cons.run_command('host bind 0 %s' % fn)
+
+    for name in ['big', 'frag']:
+        elapsed = load_and_check(cons, name, files[name])
+        cons.log.info('%s: %d bytes in %.3fs' %
+                      (name, len(files[name]), elapsed))
+    load_and_check(cons, 'sparse', files['sparse'])
+
+    # Partial reads starting and ending in the middle of blocks and runs
+    load_and_check(cons, 'sparse', files['sparse'], 4999500, 1000)
+    load_and_check(cons, 'sparse', files['sparse'], 10999999, 1000)
+    load_and_check(cons, 'frag', files['frag'], 12347, 500000)
+
+    cons.run_command('host bind 0')
@@ -0,0 +1,198 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# FAT fragmented file test and benchmark
+
+"""
+This tests reading fragmented files from a FAT32 filesystem on sandbox:
+
+- Create a FAT32 image holding a contiguous file and a file whose cluster
+  chain hops between distant parts of the FAT
+- Load each file (whole and partially) and check its CRC32, also into a
+  misaligned buffer, which FAT reads without read-ahead
+- Log the load times
+
+The image is laid out here rather than with mkfs.vfat/mcopy, so that the
+cluster chain of the fragmented file is known exactly.
+"""
+
+import os
+import pytest
+import re
+import struct
+import u_boot_utils as util
+import zlib
+
+SECT_SIZE = 512
+# One sector per cluster, so that the FAT is large and chains are long
+CLUST_SECTS = 1
+RESERVED_SECTS = 32
+IMAGE_SECTS = 128 * 1024
+
+# Size of each file, in KiB
+FILE_SIZE_KB = 4096
+
+# The fragmented file is stored in runs of RUN_CLUSTERS clusters, taken in
+# turn from REGIONS areas of the disk spaced evenly across the FAT
+RUN_CLUSTERS = 4
+REGIONS = 3
+
+FAT_EOC = 0x0fffffff
+
+def crc32(data):
+    return '%08x' % (zlib.crc32(data) & 0xffffffff)
+
+def fat_layout():
+    """Work out the FAT size and number of clusters of the image
+
+    Returns:
+        Tuple (sectors per FAT, number of clusters)
+    """
+    fat_sects = 1
+    while True:
+        clusters = ((IMAGE_SECTS - RESERVED_SECTS - 2 * fat_sects) //
+                    CLUST_SECTS)
+        need = ((clusters + 2) * 4 + SECT_SIZE - 1) // SECT_SIZE
+        if need <= fat_sects:
+            return fat_sects, clusters
+        fat_sects = need
+
+def dir_entry(name, clust, size):
+    """Build a short-name directory entry for a file"""
+    base, ext = name.upper().split('.') if '.' in name else (name.upper(), '')
+    short = ('%-8s%-3s' % (base, ext)).encode('ascii')
+    return struct.pack('<11sBBBHHHHHHHI', short, 0x20, 0, 0, 0, 0, 0,
+                       clust >> 16, 0, 0, clust & 0xffff, size)
+
+def make_image(fn, files, chains):
+    """Create a FAT32 image
+
+    Args:
+        fn: Filename of image to create
+        files: List of (name, contents) tuples for the root directory
+        chains: List of cluster lists, one per file
+    """
+    fat_sects, clusters = fat_layout()
+    data_start = RESERVED_SECTS + 2 * fat_sects
+    clust_size = CLUST_SECTS * SECT_SIZE
+
+    fat = [0] * (clusters + 2)
+    fat[0] = 0x0ffffff8
+    fat[1] = FAT_EOC
+    fat[2] = FAT_EOC    # root directory
+    for chain in chains:
+        for cur, nxt in zip(chain, chain[1:] + [FAT_EOC]):
+            fat[cur] = nxt
+    free = fat.count(0)
+
+    boot = bytearray(SECT_SIZE)
+    boot[0:3] = b'\xeb\x58\x90'
+    boot[3:11] = b'MSWIN4.1'
+    struct.pack_into('<HBHBHHBHHHII', boot, 11, SECT_SIZE, CLUST_SECTS,
+                     RESERVED_SECTS, 2, 0, 0, 0xf8, 0, 32, 64, 0,
+                     IMAGE_SECTS)
+    struct.pack_into('<IHHIHH', boot, 36, fat_sects, 0, 0, 2, 1, 6)
+    struct.pack_into('<BBBI11s8s', boot, 64, 0x80, 0, 0x29, 0x12345678,
+                     b'FATFRAG    ', b'FAT32   ')
+    boot[510:512] = b'\x55\xaa'
+
+    info = bytearray(SECT_SIZE)
+    struct.pack_into('<I', info, 0, 0x41615252)
+    struct.pack_into('<III', info, 484, 0x61417272, free, 3)
+    struct.pack_into('<I', info, 508, 0xaa550000)
+
+    fat_data = struct.pack('<%dI' % len(fat), *fat)
+    root = b''.join(dir_entry(name, chain[0], len(data))
+                    for (name, data), chain in zip(files, chains))
+
+    with open(fn, 'wb') as fd:
+        fd.truncate(IMAGE_SECTS * SECT_SIZE)
+        for sect in [0, 6]:
+            fd.seek(sect * SECT_SIZE)
+            fd.write(boot)
+            fd.write(info)
+        for i in range(2):
+            fd.seek((RESERVED_SECTS + i * fat_sects) * SECT_SIZE)
+            fd.write(fat_data)
+        fd.seek(data_start * SECT_SIZE)
+        fd.write(root)
+        for (name, data), chain in zip(files, chains):
+            for i, clust in enumerate(chain):
+                fd.seek((data_start + (clust - 2) * CLUST_SECTS) * SECT_SIZE)
+                fd.write(data[i * clust_size:(i + 1) * clust_size])
+
+def frag_chain(first, count, clusters):
+    """Build a chain which hops between REGIONS areas of the disk
+
+    Args:
+        first: First cluster available to the chain
+        count: Number of clusters in the chain
+        clusters: Number of clusters in the filesystem
+
+    Returns:
+        List of clusters
+    """
+    span = (clusters + 2 - first) // REGIONS
+    next_free = [first + r * span for r in range(REGIONS)]
+    chain = []
+    region = 0
+    while len(chain) < count:
+        run = min(RUN_CLUSTERS, count - len(chain))
+        chain += range(next_free[region], next_free[region] + run)
+        next_free[region] += run
+        region = (region + 1) % REGIONS
+    return chain
+
+def load_and_check(cons, name, data, offset=0, size=0, misalign=0):
+    """Load (part of) a file and check its contents
+
+    Args:
+        misalign: Bytes to add to the (aligned) load address. A misaligned
+            buffer is read a run at a time without read-ahead.
+
+    Returns:
+        Elapsed time reported by the 'time' command, in seconds
+    """
+    addr = util.find_ram_base(cons) + misalign
+    if not size:
+        size = len(data) - offset
+    output = cons.run_command('time fatload host 0:0 %x %s %x %x' %
+                              (addr, name, size, offset))
+    assert('%d bytes read' % size in output)
+    elapsed = float(re.search(r'time: ([0-9.]+) seconds', output).group(1))
+
+    output = cons.run_command('crc32 %x %x' % (addr, size))
+    assert(crc32(data[offset:offset + size]) in output)
+    return elapsed
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_fat')
+def test_fat_frag(u_boot_console):
+    """Test and benchmark FAT reads of fragmented files."""
+    cons = u_boot_console
+    fn = cons.config.persistent_data_dir + '/fat-frag.img'
+
+    size = FILE_SIZE_KB * 1024
+    count = size // (CLUST_SECTS * SECT_SIZE)
+    clusters = fat_layout()[1]
+    contig = list(range(3, 3 + count))
+    frag = frag_chain(3 + count, count, clusters)
+    files = [('contig', os.urandom(size)), ('frag', os.urandom(size))]
+    make_image(fn, files, [contig, frag])
+
+    cons.run_command('host bind 0 %s' % fn)
+
+    for name, data in files:
+        elapsed = load_and_check(cons, name, data)
+        cons.log.info('%s: %d bytes in %.3fs' % (name, len(data), elapsed))
+
+    # Partial reads starting and ending in the middle of clusters and runs
+    frag_data = files[1][1]
+    load_and_check(cons, 'frag', frag_data, 12347, 500000)
+    load_and_check(cons, 'frag', frag_data, size - 3000, 2999)
+    load_and_check(cons, 'contig', files[0][1], 1, 511)
+
+    # The same data with and without read-ahead
+    load_and_check(cons, 'frag', frag_data, 12347, 100000)
+    load_and_check(cons, 'frag', frag_data, 12347, 100000, misalign=1)
+
+    cons.run_command('host bind 0')
@@ -0,0 +1,139 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# gzwrite test and benchmark
+
+"""
+This tests gzwrite, which decompresses a gzip image from memory and writes it
+to a block device, using a file attached to sandbox's host block device:
+
+- Write a compressed image and check the device holds the uncompressed data
+- Write the same image at an offset and check the blocks before it are intact
+- Check that an image too large for the device is refused
+
+The time taken is written to the log alongside the time for just
+decompressing the image (unzip) and for just writing it (gzwrite of an image
+stored without compression), to show where the time goes.
+"""
+
+import gzip
+import os
+import pytest
+import random
+import re
+
+# Size of the uncompressed image and of the block device
+IMAGE_SIZE = 32 << 20
+DEV_SIZE = 48 << 20
+
+# Load address of the compressed image and where unzip puts its output
+LOAD_ADDR = 0x100000
+UNZIP_ADDR = 0x2000000
+
+def make_data(fn):
+    """Create some text-like data which compresses about 2:1
+
+    Args:
+        fn: Filename to write the data to
+
+    Returns:
+        The data
+    """
+    if os.path.exists(fn) and os.path.getsize(fn) == IMAGE_SIZE:
+        with open(fn, 'rb') as fd:
+            return fd.read()
+    rand = random.Random(0)
+    words = [bytes(rand.choice(b'abcdefghijklmnop')
+                   for i in range(rand.randint(2, 9))) for j in range(5000)]
+    data = bytearray()
+    while len(data) < IMAGE_SIZE:
+        data += b' '.join(rand.choice(words) for i in range(64)) + b'\n'
+    data = bytes(data[:IMAGE_SIZE])
+    with open(fn, 'wb') as fd:
+        fd.write(data)
+    return data
+
+def make_gzip(data, fn, level):
+    """Write a gzip image of the data
+
+    Args:
+        data: Data to compress
+        fn: Filename of image to create
+        level: Compression level, 0 to store the data uncompressed
+    """
+    with open(fn, 'wb') as fd:
+        fd.write(gzip.compress(data, level))
+
+def new_device(cons, fn):
+    """Create an empty device image and attach it as host device 0
+
+    Args:
+        cons: U-Boot console
+        fn: Filename of the device image
+    """
+    cons.run_command('host bind 0')
+    with open(fn, 'wb') as fd:
+        fd.truncate(DEV_SIZE)
+    cons.run_command('host bind 0 %s' % fn)
+
+def gzwrite(cons, fn, offset=0):
+    """Load a gzip image and write it to host device 0
+
+    Args:
+        cons: U-Boot console
+        fn: Filename of the gzip image
+        offset: Byte offset on the device to write to
+
+    Returns:
+        Time taken for the write in seconds
+    """
+    cons.run_command('host load hostfs - %x %s' % (LOAD_ADDR, fn))
+    output = cons.run_command('gzwrite host 0 %x $filesize 100000 %x' %
+                              (LOAD_ADDR, offset))
+    match = re.search(r'(\d+) bytes written in (\d+) ms', output)
+    assert match
+    assert int(match.group(1)) == IMAGE_SIZE
+    return int(match.group(2)) / 1000.0
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_unzip')
+def test_gzwrite(u_boot_console):
+    """Test and benchmark gzwrite to a host block device."""
+    cons = u_boot_console
+    base = cons.config.persistent_data_dir + '/gzwrite'
+    data = make_data(base + '.raw')
+    make_gzip(data, base + '.gz', 6)
+    make_gzip(data, base + '-stored.gz', 0)
+    dev = base + '.img'
+
+    new_device(cons, dev)
+    total = gzwrite(cons, base + '.gz')
+    with open(dev, 'rb') as fd:
+        assert fd.read(IMAGE_SIZE) == data
+
+    # Write again further in, leaving a marker in the block before it
+    offset = 1 << 20
+    new_device(cons, dev)
+    with open(dev, 'r+b') as fd:
+        fd.seek(offset - 512)
+        fd.write(b'\xa5' * 512)
+    gzwrite(cons, base + '.gz', offset)
+    with open(dev, 'rb') as fd:
+        fd.seek(offset - 512)
+        assert fd.read(512) == b'\xa5' * 512
+        assert fd.read(IMAGE_SIZE) == data
+
+    # The image does not fit at the end of the device
+    output = cons.run_command('gzwrite host 0 %x $filesize 100000 %x' %
+                              (LOAD_ADDR, DEV_SIZE - offset))
+    assert 'exceeds device size' in output
+
+    # Time the two halves of the work on their own
+    output = cons.run_command('time unzip %x %x' % (LOAD_ADDR, UNZIP_ADDR))
+    inflate = float(re.search(r'time: ([0-9.]+) seconds', output).group(1))
+    new_device(cons, dev)
+    write = gzwrite(cons, base + '-stored.gz')
+
+    cons.log.info('gzwrite %.3fs, unzip only %.3fs, write only %.3fs' %
+                  (total, inflate, write))
+
+    cons.run_command('host bind 0')
@@ -0,0 +1,159 @@
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Hush parse cache test and benchmark
+
+"""
+This tests the cache of parsed scripts which hush keeps for 'run':
+
+- Run scripts which change themselves, loop, exit early or have syntax
+  errors, and check that they behave the same with and without the cache
+- Run the distro boot scripts over two host block devices, each with
+  several bootable FAT partitions, and check they do the same both ways
+
+The time taken for repeated distro boot scans is written to the log so the
+effect of the cache can be seen.
+"""
+
+import os
+import pytest
+import re
+import struct
+import u_boot_utils as util
+
+# Scripts which exercise the cache, run one line at a time
+SCRIPTS = [
+    "setenv n; setenv a 'echo A1; setenv n ${n}x'; run a; run a; "
+        "setenv a 'echo A2'; run a; echo n=${n}",
+    "setenv loop 'for i in 1 2 3; do echo i=${i}; done'; run loop; run loop",
+    "setenv self 'echo self; setenv self echo changed; run self'; "
+        'run self; run self',
+    "setenv ex 'echo before; exit; echo after'; run ex; run ex",
+    "setenv bad 'if true; then echo x'; run bad; run bad",
+    "setenv pre 'echo k=${k}'; k=5; run pre; k=6; run pre",
+]
+
+# Number of bootable partitions on each disk, and number of scans to time
+NUM_PARTS = 4
+NUM_SCANS = 100
+PART_SIZE = 16 << 20
+
+def make_disk(cons, fn):
+    """Create a disk image with bootable empty FAT partitions
+
+    Args:
+        cons: U-Boot console
+        fn: Filename of image to create
+    """
+    part_fn = fn + '.part'
+    if os.path.exists(part_fn):
+        os.remove(part_fn)
+    util.run_and_log(cons, ['mkfs.vfat', '-C', part_fn,
+                            str(PART_SIZE // 1024)])
+    with open(part_fn, 'rb') as fd:
+        part = fd.read()
+    os.remove(part_fn)
+
+    mbr = bytearray(512)
+    start = 2048
+    for i in range(NUM_PARTS):
+        struct.pack_into('<B3sB3sII', mbr, 446 + 16 * i, 0x80, b'\0' * 3,
+                         0x06, b'\0' * 3, start + i * PART_SIZE // 512,
+                         PART_SIZE // 512)
+    mbr[510:512] = b'\x55\xaa'
+    with open(fn, 'wb') as fd:
+        fd.write(mbr)
+        fd.seek(start * 512)
+        for i in range(NUM_PARTS):
+            fd.write(part)
+
+def hush_cache_vars(cons):
+    """Get the variables which the hush_cache callback is bound to
+
+    Args:
+        cons: U-Boot console
+
+    Returns:
+        List of variable names
+    """
+    output = cons.run_command('env callbacks')
+    active = output.split('Active callback bindings:')[1]
+    return re.findall(r'^\s*(\S+)\s+hush_cache\s*$', active, re.M)
+
+def run_both(cons, cmd):
+    """Run a command with the cache enabled and disabled
+
+    Args:
+        cons: U-Boot console
+        cmd: Command to run
+
+    Returns:
+        Tuple (output with cache, output without cache)
+    """
+    cons.run_command('HUSH_NO_CACHE=0')
+    cached = cons.run_command(cmd)
+    cons.run_command('HUSH_NO_CACHE=1')
+    uncached = cons.run_command(cmd)
+    cons.run_command('HUSH_NO_CACHE=0')
+    return cached, uncached
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('hush_parse_cache')
+def test_hush_cache(u_boot_console):
+    """Test that cached scripts behave the same as parsing them each time."""
+    cons = u_boot_console
+    for cmd in SCRIPTS:
+        cached, uncached = run_both(cons, cmd)
+        assert cached == uncached
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('hush_parse_cache')
+def test_hush_cache_callback(u_boot_console):
+    """Test that only cached variables get the hush_cache callback."""
+    cons = u_boot_console
+    cons.run_command('HUSH_NO_CACHE=0')
+    cons.run_command("setenv cb1 'echo cb1'; setenv cb2 'echo cb2'")
+    assert 'cb1' not in hush_cache_vars(cons)
+
+    cons.run_command('run cb1')
+    bound = hush_cache_vars(cons)
+    assert 'cb1' in bound
+    assert 'cb2' not in bound
+
+    # Changing the variable drops it from the cache, and the callback too
+    cons.run_command("setenv cb1 'echo new'")
+    assert 'cb1' not in hush_cache_vars(cons)
+    assert cons.run_command('run cb1') == 'new'
+    assert 'cb1' in hush_cache_vars(cons)
+
+    cons.run_command('setenv cb1; setenv cb2')
+    assert 'cb1' not in hush_cache_vars(cons)
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('hush_parse_cache')
+@pytest.mark.buildconfigspec('cmd_part')
+def test_hush_cache_distro(u_boot_console):
+    """Test and benchmark the cache with the distro boot scripts."""
+    cons = u_boot_console
+    fn = cons.config.persistent_data_dir + '/hush-cache.img'
+    make_disk(cons, fn)
+    cons.run_command('host bind 0 %s' % fn)
+    cons.run_command('host bind 1 %s' % fn)
+
+    cached, uncached = run_both(cons, 'run distro_bootcmd')
+    assert cached == uncached
+    assert cached.count('Scanning host') == 2 * NUM_PARTS
+
+    cons.run_command("setenv bench 'for i in %s; do run distro_bootcmd; done'"
+                     % ' '.join(str(i) for i in range(NUM_SCANS)))
+    times = []
+    for nocache in (0, 1):
+        cons.run_command('HUSH_NO_CACHE=%d' % nocache)
+        output = cons.run_command('time run bench')
+        times.append(float(re.search(r'time: ([0-9.]+) seconds',
+                                     output).group(1)))
+    cons.run_command('HUSH_NO_CACHE=0')
+    cons.log.info('%d distro boot scans: cached %.3fs, uncached %.3fs' %
+                  (NUM_SCANS, times[0], times[1]))
+
+    cons.run_command('host bind 0')
+    cons.run_command('host bind 1')
@@ -48,10 +48,39 @@ env__net_tftp_readable_file = {
     "crc32": "c2244b26",
 }
 
-# Details regarding a file that may be read from a NFS server. This variable
-# may be omitted or set to None if NFS testing is not possible or desired.
-env__net_nfs_readable_file = {
+# TFTP window sizes (RFC 7440) to try when downloading
+# env__net_tftp_readable_file. The TFTP server must support the windowsize
+# option. This variable may be omitted to skip the window size test.
+env__net_tftp_window_sizes = [1, 8, 16]
+
+# Details regarding a file that may be read from a TFTP server which supports
+# multicast (RFC 2090), e.g. tools/mtftpd.py. This variable may be omitted or
+# set to None if multicast TFTP testing is not possible or desired.
+env__net_mcast_tftp_readable_file = {
+    "fn": "ubtest-readable.bin",
+    "addr": 0x10000000,
+    "size": 5058624,
+    "crc32": "c2244b26",
+}
+
+# Details regarding a file that may be read from an HTTP server on $serverip.
+# A local "python3 -m http.server" is enough. "port" may be omitted if the
+# server listens on port 80. This variable may be omitted or set to None if
+# HTTP testing is not possible or desired.
+env__net_http_readable_file = {
     "fn": "ubtest-readable.bin",
+    "port": 8000,
+    "addr": 0x10000000,
+    "size": 5058624,
+    "crc32": "c2244b26",
+}
+
+# Details regarding a file that may be read from a NFS server, e.g.
+# tools/nfsd.py, which can also drop, truncate and reorder read replies. "fn"
+# is the absolute path on the server. This variable may be omitted or set to
+# None if NFS testing is not possible or desired.
+env__net_nfs_readable_file = {
+    "fn": "/srv/nfs/ubtest-readable.bin",
     "addr": 0x10000000,
     "size": 5058624,
     "crc32": "c2244b26",
@@ -167,6 +196,145 @@ def test_net_tftpboot(u_boot_console):
     output = u_boot_console.run_command('crc32 %x $filesize' % addr)
     assert expected_crc in output
 
+@pytest.mark.buildconfigspec('cmd_net')
+@pytest.mark.buildconfigspec('net_tftp_vars')
+def test_net_tftpboot_windowsize(u_boot_console):
+    """Test the tftpboot command with several TFTP window sizes.
+
+    The file from test_net_tftpboot is downloaded once per window size listed
+    in env__net_tftp_window_sizes, and its size and CRC32 are validated. The
+    transfer rate reported for each window size is logged for comparison.
+    """
+
+    if not net_set_up:
+        pytest.skip('Network not initialized')
+
+    f = u_boot_console.config.env.get('env__net_tftp_readable_file', None)
+    if not f:
+        pytest.skip('No TFTP readable file to read')
+
+    window_sizes = u_boot_console.config.env.get('env__net_tftp_window_sizes',
+                                                 None)
+    if not window_sizes:
+        pytest.skip('No TFTP window sizes to test')
+
+    addr = f.get('addr', None)
+    if not addr:
+        addr = u_boot_utils.find_ram_base(u_boot_console) + (1024 * 1024 * 4)
+
+    fn = f['fn']
+    expected_crc = f.get('crc32', None)
+    if u_boot_console.config.buildconfig.get('config_cmd_crc32', 'n') != 'y':
+        expected_crc = None
+
+    for window_size in window_sizes:
+        u_boot_console.run_command('setenv tftpwindowsize %d' % window_size)
+        output = u_boot_console.run_command('tftpboot %x %s' % (addr, fn))
+        expected_text = 'Bytes transferred = '
+        sz = f.get('size', None)
+        if sz:
+            expected_text += '%d' % sz
+        assert expected_text in output
+        for line in output.splitlines():
+            if line.strip().endswith('/s'):
+                u_boot_console.log.info('windowsize %d: %s' %
+                                        (window_size, line.strip()))
+
+        if expected_crc:
+            output = u_boot_console.run_command('crc32 %x $filesize' % addr)
+            assert expected_crc in output
+
+    u_boot_console.run_command('setenv tftpwindowsize')
+
+@pytest.mark.buildconfigspec('cmd_net')
+@pytest.mark.buildconfigspec('mcast_tftp')
+def test_net_tftpboot_mcast(u_boot_console):
+    """Test the tftpboot command with a multicast TFTP server.
+
+    A file is downloaded through a multicast group, its size and optionally
+    its CRC32 are validated.
+
+    The details of the file to download are provided by the boardenv_* file;
+    see the comment at the beginning of this file.
+    """
+
+    if not net_set_up:
+        pytest.skip('Network not initialized')
+
+    f = u_boot_console.config.env.get('env__net_mcast_tftp_readable_file',
+                                      None)
+    if not f:
+        pytest.skip('No multicast TFTP readable file to read')
+
+    addr = f.get('addr', None)
+    if not addr:
+        addr = u_boot_utils.find_ram_base(u_boot_console) + (1024 * 1024 * 4)
+
+    fn = f['fn']
+    output = u_boot_console.run_command('tftpboot %x %s' % (addr, fn))
+    assert 'Multicast: ' in output
+    expected_text = 'Bytes transferred = '
+    sz = f.get('size', None)
+    if sz:
+        expected_text += '%d' % sz
+    assert expected_text in output
+
+    expected_crc = f.get('crc32', None)
+    if not expected_crc:
+        return
+
+    if u_boot_console.config.buildconfig.get('config_cmd_crc32', 'n') != 'y':
+        return
+
+    output = u_boot_console.run_command('crc32 %x $filesize' % addr)
+    assert expected_crc in output
+
+@pytest.mark.buildconfigspec('cmd_wget')
+def test_net_wget(u_boot_console):
+    """Test the wget command.
+
+    A file is downloaded from the HTTP server, its size and optionally its
+    CRC32 are validated. The transfer rate is logged for comparison with
+    TFTP.
+
+    The details of the file to download are provided by the boardenv_* file;
+    see the comment at the beginning of this file.
+    """
+
+    if not net_set_up:
+        pytest.skip('Network not initialized')
+
+    f = u_boot_console.config.env.get('env__net_http_readable_file', None)
+    if not f:
+        pytest.skip('No HTTP readable file to read')
+
+    addr = f.get('addr', None)
+    if not addr:
+        addr = u_boot_utils.find_ram_base(u_boot_console) + (1024 * 1024 * 4)
+
+    u_boot_console.run_command('setenv httpdstp %d' % f.get('port', 80))
+    fn = f['fn']
+    output = u_boot_console.run_command('wget %x %s' % (addr, fn))
+    u_boot_console.run_command('setenv httpdstp')
+    expected_text = 'Bytes transferred = '
+    sz = f.get('size', None)
+    if sz:
+        expected_text += '%d' % sz
+    assert expected_text in output
+    for line in output.splitlines():
+        if line.strip().endswith('/s'):
+            u_boot_console.log.info('wget: %s' % line.strip())
+
+    expected_crc = f.get('crc32', None)
+    if not expected_crc:
+        return
+
+    if u_boot_console.config.buildconfig.get('config_cmd_crc32', 'n') != 'y':
+        return
+
+    output = u_boot_console.run_command('crc32 %x $filesize' % addr)
+    assert expected_crc in output
+
 @pytest.mark.buildconfigspec('cmd_nfs')
 def test_net_nfs(u_boot_console):
     """Test the nfs command.
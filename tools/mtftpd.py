@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Minimal multicast TFTP server (RFC 2090) for testing CONFIG_MCAST_TFTP
+#
+# Usage:
+#    tools/mtftpd.py [-a addr] [-g group:port] [-l loss] directory
+#
+# Serves read requests for files in directory. Clients which send the
+# "multicast" option join one transfer per file: the data goes to the
+# group, paced by the ACKs of the master client. When the master client has
+# the whole file, the next client in the list becomes master and asks for
+# the blocks it missed. Other clients get a plain lock-step transfer.
+#
+# -l drops that fraction of the data packets, to exercise the recovery of
+# missing blocks. For example, with the server on a veth pair:
+#
+#    ip link add vtest0 type veth peer name vtest1
+#    ip addr add 192.168.77.1/24 dev vtest0
+#    ip link set vtest0 up; ip link set vtest1 up
+#    tools/mtftpd.py -a 192.168.77.1 -l 0.01 /tftpboot
+#
+# and several sandbox instances using eth-raw on vtest1, each with its own
+# ethaddr and ipaddr, running "tftpboot" for the same file.
+
+import argparse
+import os
+import random
+import select
+import socket
+import struct
+import sys
+import time
+
+RRQ, WRQ, DATA, ACK, ERROR, OACK = range(1, 7)
+TIMEOUT = 1.0
+RETRIES = 5
+
+
+def error_packet(code, msg):
+    return struct.pack('>HH', ERROR, code) + msg.encode() + b'\0'
+
+
+class Transfer:
+    """One file being sent, to a multicast group or to a single client"""
+
+    def __init__(self, server, name, data, blksize, group):
+        self.server = server
+        self.name = name
+        self.data = data
+        self.blksize = blksize
+        self.nblocks = len(data) // blksize + 1
+        self.group = group
+        self.clients = []       # (addr, options), master first
+        self.acked = 0          # all blocks up to here are at the master
+        self.last = None        # packet to resend on timeout
+        self.last_to = None
+        self.sent_at = 0
+        self.retries = 0
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind((server.addr, 0))
+        if group:
+            self.sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF,
+                                 socket.inet_aton(server.addr))
+            self.sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL,
+                                 1)
+        self.dest = group
+
+    def log(self, msg):
+        print('%s: %s' % (self.name, msg))
+        sys.stdout.flush()
+
+    def send(self, pkt, to):
+        self.sock.sendto(pkt, to)
+        self.last = pkt
+        self.last_to = to
+        self.sent_at = time.time()
+
+    def oack(self, client, opts):
+        """Send the option acknowledgment, making client master if first"""
+        reply = []
+        if 'blksize' in opts:
+            reply += ['blksize', str(self.blksize)]
+        if 'tsize' in opts:
+            reply += ['tsize', str(len(self.data))]
+        if self.group:
+            master = int(client == self.clients[0][0])
+            reply += ['multicast', '%s,%d,%d' % (self.group[0],
+                                                 self.group[1], master)]
+        if not reply:
+            # Plain RFC 1350 transfer, start with the first block
+            self.acked = 0
+            self.send_block(1)
+            return
+        pkt = struct.pack('>H', OACK)
+        pkt += b''.join(s.encode() + b'\0' for s in reply)
+        if client == self.clients[0][0]:
+            self.send(pkt, client)
+        else:
+            # Only the master's packets are resent on timeout
+            self.sock.sendto(pkt, client)
+
+    def add_client(self, client, opts):
+        if client not in [c for c, o in self.clients]:
+            self.clients.append((client, opts))
+            self.log('client %s:%d joined, %d clients' %
+                     (client[0], client[1], len(self.clients)))
+        if client == self.clients[0][0]:
+            self.acked = 0
+            self.retries = 0
+        self.oack(client, opts)
+
+    def drop_client(self, client, why):
+        was_master = self.clients and self.clients[0][0] == client
+        self.clients = [(c, o) for c, o in self.clients if c != client]
+        self.log('client %s:%d %s, %d left' % (client[0], client[1], why,
+                                               len(self.clients)))
+        if was_master:
+            self.new_master()
+
+    def new_master(self):
+        self.acked = 0
+        self.retries = 0
+        if self.clients:
+            client, opts = self.clients[0]
+            self.log('master is now %s:%d' % client)
+            self.oack(client, opts)
+
+    def send_block(self, block):
+        offset = (block - 1) * self.blksize
+        pkt = struct.pack('>HH', DATA, block & 0xffff)
+        pkt += self.data[offset:offset + self.blksize]
+        to = self.dest or self.clients[0][0]
+        if random.random() < self.server.loss:
+            # Pretend it was sent, the timeout or a later ACK recovers
+            self.last = pkt
+            self.last_to = to
+            self.sent_at = time.time()
+            return
+        self.send(pkt, to)
+
+    def packet(self, pkt, client):
+        if len(pkt) < 4:
+            return
+        op, num = struct.unpack('>HH', pkt[:4])
+        if op == ERROR:
+            self.drop_client(client, 'left (%s)' % pkt[4:-1].decode())
+            return
+        if op != ACK or not self.clients or client != self.clients[0][0]:
+            return
+        # Undo the 16-bit wrap, taking the number nearest to the last ACK
+        full = (self.acked & ~0xffff) | num
+        if full + 0x8000 < self.acked:
+            full += 0x10000
+        elif full > self.acked + 0x8000 and full >= 0x10000:
+            full -= 0x10000
+        self.acked = full
+        self.retries = 0
+        if full >= self.nblocks:
+            self.drop_client(client, 'has the file')
+        else:
+            self.send_block(full + 1)
+
+    def timeout(self):
+        if not self.clients or time.time() - self.sent_at < TIMEOUT:
+            return
+        self.retries += 1
+        if self.retries > RETRIES:
+            self.drop_client(self.clients[0][0], 'timed out')
+        elif self.last:
+            self.send(self.last, self.last_to)
+
+
+class Server:
+    def __init__(self, args):
+        self.addr = args.addr
+        self.root = args.directory
+        self.loss = args.loss
+        host, port = args.group.split(':')
+        self.group = (host, int(port))
+        self.transfers = {}
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind((self.addr, args.port))
+
+    def request(self, pkt, client):
+        if len(pkt) < 2 or struct.unpack('>H', pkt[:2])[0] != RRQ:
+            self.sock.sendto(error_packet(4, 'Only reading is supported'),
+                             client)
+            return
+        parts = pkt[2:].split(b'\0')
+        name = parts[0].decode().lstrip('/')
+        opts = {}
+        for i in range(2, len(parts) - 1, 2):
+            opts[parts[i].decode().lower()] = parts[i + 1].decode()
+        try:
+            data = open(os.path.join(self.root, name), 'rb').read()
+        except IOError:
+            self.sock.sendto(error_packet(1, 'File not found'), client)
+            return
+        blksize = min(int(opts.get('blksize', 512)), 1468)
+        if 'multicast' not in opts:
+            xfer = Transfer(self, name, data, blksize, None)
+            self.transfers[(name, client)] = xfer
+        else:
+            xfer = self.transfers.get(name)
+            if not xfer or xfer.data != data:
+                xfer = Transfer(self, name, data, blksize, self.group)
+                self.transfers[name] = xfer
+        xfer.add_client(client, opts)
+
+    def run(self):
+        while True:
+            socks = [self.sock] + [t.sock for t in self.transfers.values()]
+            ready = select.select(socks, [], [], TIMEOUT / 4)[0]
+            for sock in ready:
+                pkt, client = sock.recvfrom(65536)
+                if sock == self.sock:
+                    self.request(pkt, client)
+                    continue
+                for xfer in self.transfers.values():
+                    if xfer.sock == sock:
+                        xfer.packet(pkt, client)
+            for key, xfer in list(self.transfers.items()):
+                xfer.timeout()
+                if not xfer.clients:
+                    xfer.log('done')
+                    xfer.sock.close()
+                    del self.transfers[key]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Multicast TFTP server')
+    parser.add_argument('-a', '--addr', default='0.0.0.0',
+                        help='address to listen on and send from')
+    parser.add_argument('-p', '--port', type=int, default=69,
+                        help='port for requests (default 69)')
+    parser.add_argument('-g', '--group', default='239.255.69.1:1758',
+                        help='multicast group and port for the data')
+    parser.add_argument('-l', '--loss', type=float, default=0,
+                        help='fraction of data packets to drop')
+    parser.add_argument('directory', help='directory to serve files from')
+    Server(parser.parse_args()).run()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,337 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: GPL-2.0+
+#
+# Minimal read-only NFS server (NFSv2 and NFSv3 over UDP) for testing the
+# nfs command
+#
+# Usage:
+#    tools/nfsd.py [-a addr] [-3] [-l loss] [-t trunc] [-r] [-d delay] directory
+#
+# Answers portmapper, MOUNT and NFS calls on one UDP socket per program.
+# Clients mount the absolute path of directory (or a directory below it)
+# and may look up, read and follow symbolic links to the files in it.
+# Nothing else is implemented.
+#
+# -3 refuses NFSv2, so that clients fall back to NFSv3. -l drops and -t
+# truncates that fraction of the READ replies, and -r sends READ replies in
+# pairs, in the reverse order, to exercise the recovery and reordering of
+# the client's read window. -d holds each READ reply back for that many
+# seconds, like a link with a long round trip. For example, with the server on a veth pair:
+#
+#    ip link add vtest0 type veth peer name vtest1
+#    ip addr add 192.168.77.1/24 dev vtest0
+#    ip link set vtest0 up; ip link set vtest1 up
+#    tools/nfsd.py -a 192.168.77.1 -l 0.01 -r /srv/nfs
+#
+# and sandbox using eth-raw on vtest1 running
+# "nfs 1000000 192.168.77.1:/srv/nfs/file". The portmapper needs port 111,
+# so this must run as root.
+
+import argparse
+import collections
+import os
+import random
+import select
+import socket
+import stat
+import struct
+import sys
+import time
+
+PROG_PORTMAP, PROG_NFS, PROG_MOUNT = 100000, 100003, 100005
+PORTMAP_PORT = 111
+MSG_CALL, MSG_REPLY = 0, 1
+SUCCESS, PROG_UNAVAIL, PROG_MISMATCH, PROC_UNAVAIL, GARBAGE_ARGS = range(5)
+
+NFS_OK, NFSERR_NOENT, NFSERR_ACCES, NFSERR_NOTDIR, NFSERR_INVAL = \
+        0, 2, 13, 20, 22
+NFSERR_STALE = 70
+FHSIZE = 32
+FH_MAGIC = b'UBNF'
+
+# NFSv2 procedures, then their NFSv3 numbers
+NFS2_LOOKUP, NFS2_READLINK, NFS2_READ = 4, 5, 6
+NFS3_LOOKUP, NFS3_READLINK, NFS3_READ = 3, 5, 6
+MOUNT_MNT, MOUNT_UMNTALL = 1, 4
+
+
+class Unpacker:
+    """Reads XDR items from a call"""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def uint(self):
+        if self.pos + 4 > len(self.data):
+            raise ValueError('short call')
+        val = struct.unpack('>I', self.data[self.pos:self.pos + 4])[0]
+        self.pos += 4
+        return val
+
+    def uhyper(self):
+        return self.uint() << 32 | self.uint()
+
+    def fixed(self, size):
+        if self.pos + size > len(self.data):
+            raise ValueError('short call')
+        val = self.data[self.pos:self.pos + size]
+        self.pos += (size + 3) & ~3
+        return val
+
+    def opaque(self):
+        return self.fixed(self.uint())
+
+
+def uint(val):
+    return struct.pack('>I', val)
+
+
+def uhyper(val):
+    return struct.pack('>Q', val)
+
+
+def opaque(data):
+    return uint(len(data)) + data + b'\0' * (-len(data) % 4)
+
+
+class Server:
+    def __init__(self, args):
+        self.addr = args.addr
+        self.root = os.path.abspath(args.directory)
+        self.v2 = not args.v3_only
+        self.loss = args.loss
+        self.trunc = args.trunc
+        self.reorder = args.reorder
+        self.held = None        # READ reply waiting to be sent after the next
+        self.delay = args.delay
+        self.delayed = collections.deque()  # (when, reply, client)
+        self.paths = [self.root]
+        self.socks = {}
+        for prog, port in ((PROG_PORTMAP, PORTMAP_PORT), (PROG_MOUNT, 0),
+                           (PROG_NFS, args.port)):
+            sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+            sock.bind((self.addr, port))
+            self.socks[prog] = sock
+
+    def log(self, msg):
+        print(msg)
+        sys.stdout.flush()
+
+    def port(self, prog):
+        return self.socks[prog].getsockname()[1]
+
+    def handle(self, path):
+        if path not in self.paths:
+            self.paths.append(path)
+        fh = FH_MAGIC + uint(self.paths.index(path))
+        return fh + b'\0' * (FHSIZE - len(fh))
+
+    def path(self, fh):
+        """Find the path of a handle, None if it is stale"""
+        # NFSv3 clients may send the NFSv2 handle from MOUNT with its length
+        pos = fh.find(FH_MAGIC)
+        if pos < 0 or pos + 8 > len(fh):
+            return None
+        index = struct.unpack('>I', fh[pos + 4:pos + 8])[0]
+        return self.paths[index] if index < len(self.paths) else None
+
+    def inside(self, path):
+        return path == self.root or path.startswith(self.root + '/')
+
+    def fattr(self, path, vers):
+        st = os.lstat(path)
+        if stat.S_ISDIR(st.st_mode):
+            ftype = 2
+        elif stat.S_ISLNK(st.st_mode):
+            ftype = 5
+        else:
+            ftype = 1
+        mode = stat.S_IMODE(st.st_mode)
+        fileid = self.paths.index(path) + 1 if path in self.paths else 0
+        if vers == 2:
+            return b''.join(uint(v) for v in (
+                ftype, mode, st.st_nlink, 0, 0, st.st_size, 4096, 0,
+                (st.st_size + 511) // 512, 1, fileid,
+                int(st.st_atime), 0, int(st.st_mtime), 0,
+                int(st.st_ctime), 0))
+        return (b''.join(uint(v) for v in (ftype, mode, st.st_nlink, 0, 0)) +
+                uhyper(st.st_size) + uhyper(st.st_blocks * 512) +
+                uhyper(0) + uhyper(1) + uhyper(fileid) +
+                b''.join(uint(v) for v in (int(st.st_atime), 0,
+                                           int(st.st_mtime), 0,
+                                           int(st.st_ctime), 0)))
+
+    def post_op_attr(self, path):
+        return uint(1) + self.fattr(path, 3)
+
+    def portmap(self, vers, proc, args):
+        if proc == 0:
+            return SUCCESS, b''
+        if proc != 3:   # GETPORT
+            return PROC_UNAVAIL, b''
+        prog = args.uint()
+        args.uint()
+        port = self.port(prog) if prog in (PROG_MOUNT, PROG_NFS) else 0
+        return SUCCESS, uint(port)
+
+    def mount(self, vers, proc, args):
+        if proc == 0 or proc == MOUNT_UMNTALL:
+            return SUCCESS, b''
+        if proc != MOUNT_MNT:
+            return PROC_UNAVAIL, b''
+        path = os.path.normpath(args.opaque().decode())
+        if not self.inside(path) or not os.path.isdir(path):
+            self.log('mount %s refused' % path)
+            return SUCCESS, uint(NFSERR_ACCES)
+        self.log('mount %s (v%d)' % (path, vers))
+        if vers == 3:
+            return SUCCESS, uint(NFS_OK) + opaque(self.handle(path)) + \
+                    uint(1) + uint(1)
+        return SUCCESS, uint(NFS_OK) + self.handle(path)
+
+    def nfs(self, vers, proc, args):
+        if vers == 2 and not self.v2:
+            return PROG_MISMATCH, uint(3) + uint(3)
+        if proc == 0:
+            return SUCCESS, b''
+        fh = args.fixed(FHSIZE) if vers == 2 else args.opaque()
+        path = self.path(fh)
+        if not path:
+            return SUCCESS, uint(NFSERR_STALE)
+        if vers == 2 and proc == NFS2_LOOKUP or vers == 3 and \
+                proc == NFS3_LOOKUP:
+            return SUCCESS, self.lookup(vers, path, args.opaque().decode())
+        if proc == NFS2_READLINK:
+            return SUCCESS, self.readlink(vers, path)
+        if proc == NFS2_READ:
+            offset = args.uint() if vers == 2 else args.uhyper()
+            return SUCCESS, self.read(vers, path, offset, args.uint())
+        return PROC_UNAVAIL, b''
+
+    def lookup(self, vers, dirpath, name):
+        path = os.path.normpath(os.path.join(dirpath, name))
+        if not self.inside(path) or not os.path.lexists(path):
+            self.log('lookup %s: not found' % path)
+            if vers == 2:
+                return uint(NFSERR_NOENT)
+            return uint(NFSERR_NOENT) + self.post_op_attr(dirpath)
+        fh = self.handle(path)
+        if vers == 2:
+            return uint(NFS_OK) + fh + self.fattr(path, 2)
+        return (uint(NFS_OK) + opaque(fh) + self.post_op_attr(path) +
+                self.post_op_attr(dirpath))
+
+    def readlink(self, vers, path):
+        if not os.path.islink(path):
+            return uint(NFSERR_INVAL)
+        target = os.readlink(path).encode()
+        self.log('readlink %s -> %s' % (path, target.decode()))
+        if vers == 2:
+            return uint(NFS_OK) + opaque(target)
+        return uint(NFS_OK) + self.post_op_attr(path) + opaque(target)
+
+    def read(self, vers, path, offset, count):
+        if os.path.islink(path) or os.path.isdir(path):
+            # The client then tries READLINK
+            return uint(NFSERR_INVAL)
+        with open(path, 'rb') as fd:
+            fd.seek(offset)
+            data = fd.read(count)
+        if vers == 2:
+            return uint(NFS_OK) + self.fattr(path, 2) + opaque(data)
+        eof = offset + len(data) >= os.path.getsize(path)
+        return (uint(NFS_OK) + self.post_op_attr(path) + uint(len(data)) +
+                uint(eof) + opaque(data))
+
+    def call(self, prog, pkt, client):
+        args = Unpacker(pkt)
+        try:
+            xid, mtype, rpcvers, cprog, vers, proc = [args.uint()
+                                                      for i in range(6)]
+            if mtype != MSG_CALL or rpcvers != 2:
+                return
+            args.uint()
+            args.opaque()   # credential
+            args.uint()
+            args.opaque()   # verifier
+            if cprog != prog:
+                astat, res = PROG_UNAVAIL, b''
+            elif prog == PROG_PORTMAP:
+                astat, res = self.portmap(vers, proc, args)
+            elif prog == PROG_MOUNT:
+                astat, res = self.mount(vers, proc, args)
+            else:
+                astat, res = self.nfs(vers, proc, args)
+        except ValueError:
+            astat, res = GARBAGE_ARGS, b''
+        reply = b''.join(uint(v) for v in (xid, MSG_REPLY, 0, 0, 0, astat))
+        reply += res
+        sock = self.socks[prog]
+        if prog != PROG_NFS or proc != NFS2_READ or astat != SUCCESS:
+            sock.sendto(reply, client)
+            return
+        if random.random() < self.loss:
+            return
+        if random.random() < self.trunc:
+            reply = reply[:random.randrange(len(reply))]
+        if not self.reorder:
+            self.send_read(reply, client)
+        elif self.held:
+            self.send_read(reply, client)
+            self.send_read(*self.held)
+            self.held = None
+        else:
+            self.held = (reply, client)
+
+    def send_read(self, reply, client):
+        if self.delay:
+            self.delayed.append((time.monotonic() + self.delay, reply, client))
+        else:
+            self.socks[PROG_NFS].sendto(reply, client)
+
+    def run(self):
+        self.log('serving %s: mount port %d, nfs port %d' %
+                 (self.root, self.port(PROG_MOUNT), self.port(PROG_NFS)))
+        progs = dict((sock, prog) for prog, sock in self.socks.items())
+        while True:
+            timeout = 0.01
+            if self.delayed:
+                timeout = min(timeout,
+                              max(0, self.delayed[0][0] - time.monotonic()))
+            ready = select.select(list(progs), [], [], timeout)[0]
+            for sock in ready:
+                pkt, client = sock.recvfrom(65536)
+                self.call(progs[sock], pkt, client)
+            if not ready and self.held:
+                # Nothing followed, so send the held reply on its own
+                self.send_read(*self.held)
+                self.held = None
+            while self.delayed and self.delayed[0][0] <= time.monotonic():
+                self.socks[PROG_NFS].sendto(*self.delayed.popleft()[1:])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Read-only NFS server')
+    parser.add_argument('-a', '--addr', default='0.0.0.0',
+                        help='address to listen on')
+    parser.add_argument('-p', '--port', type=int, default=2049,
+                        help='port for NFS calls (default 2049)')
+    parser.add_argument('-3', '--v3-only', action='store_true',
+                        help='refuse NFSv2')
+    parser.add_argument('-l', '--loss', type=float, default=0,
+                        help='fraction of READ replies to drop')
+    parser.add_argument('-t', '--trunc', type=float, default=0,
+                        help='fraction of READ replies to truncate')
+    parser.add_argument('-r', '--reorder', action='store_true',
+                        help='swap pairs of READ replies')
+    parser.add_argument('-d', '--delay', type=float, default=0,
+                        help='seconds to hold back each READ reply')
+    parser.add_argument('directory', help='directory to export')
+    Server(parser.parse_args()).run()
+
+
+if __name__ == '__main__':
+    main()